@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+static proc_stats_t *bandwidth_stats;
+static uint32_t bandwidth_stressor;
+
+/*
+ *  bandwidth_init()
+ *	set the stressor and per process stats that
+ *	bandwidth_add() accounts against
+ */
+void bandwidth_init(const uint32_t stressor, proc_stats_t *stats)
+{
+	bandwidth_stressor = stressor;
+	bandwidth_stats = stats;
+}
+
+/*
+ *  bandwidth_add()
+ *	account bytes read and written by a stressor method and the
+ *	time taken, per process and per method across all instances
+ */
+void bandwidth_add(
+	const char *method,
+	const uint64_t bytes_read,
+	const uint64_t bytes_written,
+	const double duration)
+{
+	size_t i;
+
+	if (!bandwidth_stats)
+		return;
+
+	bandwidth_stats->bytes_read += bytes_read;
+	bandwidth_stats->bytes_written += bytes_written;
+	bandwidth_stats->bytes_duration += duration;
+
+#if defined(HAVE_LIB_PTHREAD)
+	if (pthread_spin_lock(&shared->bandwidth.lock))
+		return;
+#endif
+	for (i = 0; i < STRESS_BANDWIDTH_MAX; i++) {
+		stress_bandwidth_t *bw = &shared->bandwidth.method[i];
+
+		if (!*bw->method) {
+			/* copied, the parent reads it after the child exits */
+			(void)strncpy(bw->method, method, sizeof(bw->method) - 1);
+			bw->stressor = bandwidth_stressor;
+		} else if ((bw->stressor != bandwidth_stressor) ||
+			   strncmp(bw->method, method, sizeof(bw->method) - 1)) {
+			continue;
+		}
+		bw->bytes_read += bytes_read;
+		bw->bytes_written += bytes_written;
+		bw->duration += duration;
+		break;
+	}
+#if defined(HAVE_LIB_PTHREAD)
+	(void)pthread_spin_unlock(&shared->bandwidth.lock);
+#endif
+}
+
+/*
+ *  bandwidth_rate()
+ *	bytes per second in GB/s
+ */
+static inline double bandwidth_rate(const uint64_t bytes, const double duration)
+{
+	return (duration > 0.0) ? ((double)bytes / duration) / (double)GB : 0.0;
+}
+
+/*
+ *  bandwidth_dump()
+ *	dump bandwidth per method and per instance for
+ *	each stressor that accounted any bytes
+ */
+void bandwidth_dump(
+	FILE *yaml,
+	const stress_t stressors[],
+	const proc_info_t procs[STRESS_MAX],
+	const int32_t max_procs)
+{
+	uint32_t i;
+	bool dumped_heading = false;
+
+	for (i = 0; i < STRESS_MAX; i++) {
+		int32_t j;
+		size_t k;
+		bool used = false;
+		char *munged;
+
+		for (j = 0; j < procs[i].started_procs; j++) {
+			const int32_t n = (i * max_procs) + j;
+
+			if (shared->stats[n].bytes_read ||
+			    shared->stats[n].bytes_written)
+				used = true;
+		}
+		if (!used)
+			continue;
+
+		if (!dumped_heading) {
+			dumped_heading = true;
+			pr_inf(stdout, "%-13s %-13s %10s %10s %10s\n",
+				"stressor", "method", "read GB/s",
+				"write GB/s", "total GB/s");
+			pr_yaml(yaml, "bandwidth:\n");
+		}
+		munged = munge_underscore(stressors[i].name);
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+
+		pr_yaml(yaml, "      methods:\n");
+		for (k = 0; k < STRESS_BANDWIDTH_MAX; k++) {
+			const stress_bandwidth_t *bw = &shared->bandwidth.method[k];
+
+			if (!*bw->method)
+				break;
+			if (bw->stressor != i)
+				continue;
+
+			pr_inf(stdout, "%-13s %-13s %10.3f %10.3f %10.3f\n",
+				munged, bw->method,
+				bandwidth_rate(bw->bytes_read, bw->duration),
+				bandwidth_rate(bw->bytes_written, bw->duration),
+				bandwidth_rate(bw->bytes_read + bw->bytes_written,
+					bw->duration));
+			pr_yaml(yaml, "        - method: %s\n", bw->method);
+			pr_yaml(yaml, "          bytes-read: %" PRIu64 "\n",
+				bw->bytes_read);
+			pr_yaml(yaml, "          bytes-written: %" PRIu64 "\n",
+				bw->bytes_written);
+			pr_yaml(yaml, "          duration: %f\n", bw->duration);
+			pr_yaml(yaml, "          read-gb-per-second: %f\n",
+				bandwidth_rate(bw->bytes_read, bw->duration));
+			pr_yaml(yaml, "          write-gb-per-second: %f\n",
+				bandwidth_rate(bw->bytes_written, bw->duration));
+		}
+
+		pr_yaml(yaml, "      instances:\n");
+		for (j = 0; j < procs[i].started_procs; j++) {
+			const int32_t n = (i * max_procs) + j;
+			const proc_stats_t *stats = &shared->stats[n];
+			char instance[32];
+
+			snprintf(instance, sizeof(instance), "instance %" PRId32, j);
+			pr_inf(stdout, "%-13s %-13s %10.3f %10.3f %10.3f\n",
+				munged, instance,
+				bandwidth_rate(stats->bytes_read, stats->bytes_duration),
+				bandwidth_rate(stats->bytes_written, stats->bytes_duration),
+				bandwidth_rate(stats->bytes_read + stats->bytes_written,
+					stats->bytes_duration));
+			pr_yaml(yaml, "        - instance: %" PRId32 "\n", j);
+			pr_yaml(yaml, "          bytes-read: %" PRIu64 "\n",
+				stats->bytes_read);
+			pr_yaml(yaml, "          bytes-written: %" PRIu64 "\n",
+				stats->bytes_written);
+			pr_yaml(yaml, "          duration: %f\n",
+				stats->bytes_duration);
+			pr_yaml(yaml, "          read-gb-per-second: %f\n",
+				bandwidth_rate(stats->bytes_read, stats->bytes_duration));
+			pr_yaml(yaml, "          write-gb-per-second: %f\n",
+				bandwidth_rate(stats->bytes_written, stats->bytes_duration));
+		}
+		pr_yaml(yaml, "\n");
+	}
+}
@@ -30,11 +30,11 @@
 #endif
 
 /*
- * append @element to array @path (which has len @len)
+ * append @element to array @path (which has len @len),
+ * truncating to fit the array
  */
 #define MK_PATH(path, len, element) 			\
-	memset((path) + len, '\0', sizeof(path) - len);	\
-	strncpy((path) + len, element, strlen(element))
+	(void)snprintf((path) + (len), sizeof(path) - (len), "%s", element)
 
 static const struct generic_map cache_type_map[] = {
 	{"data"        , CACHE_TYPE_DATA},
@@ -43,9 +43,6 @@ static const struct generic_map cache_type_map[] = {
 	{ NULL         , CACHE_TYPE_UNKNOWN}
 };
 
-static const char *get_cache_name(cache_type_t type)
-	__attribute__((unused));
-
 /**
  *
  * cache_get_cpu()
@@ -54,8 +51,14 @@ static const char *get_cache_name(cache_type_t type)
 static inline unsigned int cache_get_cpu(const cpus_t *cpus)
 {
 	const unsigned int cpu = stress_get_cpu();
+	uint32_t i;
 
-	return (cpu >= cpus->count) ? 0 : cpu;
+	/* cpus are in glob order (cpu0, cpu1, cpu10..), so look up by number */
+	for (i = 0; i < cpus->count; i++) {
+		if (cpus->cpus[i].num == cpu)
+			return i;
+	}
+	return 0;
 }
 
 /**
@@ -204,6 +207,68 @@ out:
 	return bytes;
 }
 
+/*
+ * cpu_list_to_set()
+ * @str: list of CPUs, such as "0-3,8,10-11".
+ * @set: cpu set to fill in.
+ * Convert a /sys CPU list into a cpu set.
+ *
+ * Returns: number of CPUs in @set.
+ */
+static uint32_t cpu_list_to_set(const char *str, cpu_set_t *set)
+{
+	const char *ptr = str;
+
+	CPU_ZERO(set);
+	if (!str)
+		return 0;
+
+	while (*ptr) {
+		char *end;
+		unsigned long lo, hi, i;
+
+		lo = strtoul(ptr, &end, 10);
+		if (end == ptr)
+			break;
+		hi = lo;
+		ptr = end;
+		if (*ptr == '-') {
+			ptr++;
+			hi = strtoul(ptr, &end, 10);
+			if (end == ptr)
+				break;
+			ptr = end;
+		}
+		for (i = lo; (i <= hi) && (i < CPU_SETSIZE); i++)
+			CPU_SET(i, set);
+		if (*ptr != ',')
+			break;
+		ptr++;
+	}
+	return (uint32_t)CPU_COUNT(set);
+}
+
+/*
+ * get_int_from_file()
+ * @path: file to read an integer from.
+ * @value: default if @path cannot be read.
+ *
+ * Returns: integer contents of @path, or @value on error.
+ */
+static int32_t get_int_from_file(const char *path, const int32_t value)
+{
+	char *contents;
+	int32_t ret;
+
+	contents = get_string_from_file(path);
+	if (!contents)
+		return value;
+	ret = (int32_t)atoi(contents);
+	free(contents);
+
+	return ret;
+}
+
 /* get_cache_type()
  * @name: human-readable cache type.
  * Convert a human-readable cache type into a cache_type_t.
@@ -273,7 +338,11 @@ static int add_cpu_cache_detail(cpu_cache_t *cache, const char *index_path)
 	}
 
 	len = strlen(index_path);
-	strncpy(path, index_path, len);
+	if (len >= sizeof(path)) {
+		pr_dbg(stderr, "%s: index path too long\n", __func__);
+		goto out;
+	}
+	(void)snprintf(path, sizeof(path), "%s", index_path);
 
 	MK_PATH(path, len, "/type");
 	contents = get_string_from_file(path);
@@ -316,6 +385,15 @@ static int add_cpu_cache_detail(cpu_cache_t *cache, const char *index_path)
 	 * way-based.
 	 */
 	cache->ways = contents ? atoi(contents) : 0;
+	free(contents);
+
+	/* Older kernels don't provide the cache id or sharing details */
+	MK_PATH(path, len, "/id");
+	cache->id = get_int_from_file(path, -1);
+
+	MK_PATH(path, len, "/shared_cpu_list");
+	contents = get_string_from_file(path);
+	cache->shared_count = cpu_list_to_set(contents, &cache->shared_cpus);
 
 	ret = EXIT_SUCCESS;
 
@@ -427,7 +505,7 @@ cpu_cache_t * get_cpu_cache(const cpus_t *cpus, const uint16_t cache_level)
 static int get_cpu_cache_details(cpu_t *cpu, const char *cpu_path)
 {
 	uint32_t   i;
-	size_t     len, len2;
+	size_t     len;
 	glob_t     globbuf;
 	char       glob_path[PATH_MAX] = { 0 };
 	char     **results;
@@ -445,12 +523,9 @@ static int get_cpu_cache_details(cpu_t *cpu, const char *cpu_path)
 		return ret;
 	}
 
-	len = strlen(cpu_path);
-	strncat(glob_path, cpu_path, len);
-
-	len2 = strlen(SYS_CPU_CACHE_DIR);
-	strncat(glob_path, SYS_CPU_CACHE_DIR, len2);
-	len += len2;
+	(void)snprintf(glob_path, sizeof(glob_path), "%s%s",
+		cpu_path, SYS_CPU_CACHE_DIR);
+	len = strlen(glob_path);
 
 	ret2 = file_exists(glob_path);
 	if (!ret2) {
@@ -470,8 +545,7 @@ static int get_cpu_cache_details(cpu_t *cpu, const char *cpu_path)
 		return ret;
 	}
 
-	strncat(glob_path, GLOB_PATTERN_INDEX_PREFIX,
-		sizeof(glob_path) - len - 1);
+	MK_PATH(glob_path, len, GLOB_PATTERN_INDEX_PREFIX);
 	ret2 = glob(glob_path, GLOB_ONLYDIR, NULL, &globbuf);
 
 	if (ret2 != 0) {
@@ -516,6 +590,47 @@ err:
 	return ret;
 }
 
+/*
+ * get_cpu_topology()
+ * @cpu: cpu to fill in.
+ * @cpu_path: Full /sys path to cpu which will be represented by @cpu.
+ * Populate the package, core, SMT siblings and NUMA node of @cpu,
+ * leaving them as unknown (-1) if not available.
+ */
+static void get_cpu_topology(cpu_t *cpu, const char *cpu_path)
+{
+	char path[PATH_MAX] = { 0 };
+	char *contents;
+	glob_t globbuf;
+	const size_t len = strlen(cpu_path);
+
+	if (len >= sizeof(path) - 32)
+		return;
+	(void)snprintf(path, sizeof(path), "%s", cpu_path);
+
+	MK_PATH(path, len, "/topology/physical_package_id");
+	cpu->package = get_int_from_file(path, -1);
+
+	MK_PATH(path, len, "/topology/core_id");
+	cpu->core = get_int_from_file(path, -1);
+
+	MK_PATH(path, len, "/topology/thread_siblings_list");
+	contents = get_string_from_file(path);
+	if (!cpu_list_to_set(contents, &cpu->siblings))
+		CPU_SET(cpu->num, &cpu->siblings);
+	free(contents);
+
+	/* The cpu directory has a nodeN link on NUMA kernels */
+	MK_PATH(path, len, "/node[0-9]*");
+	memset(&globbuf, 0, sizeof(globbuf));
+	if (glob(path, 0, NULL, &globbuf) == 0) {
+		if (globbuf.gl_pathc > 0)
+			(void)sscanf(strrchr(globbuf.gl_pathv[0], '/'),
+				"/node%" SCNd32, &cpu->node);
+	}
+	globfree(&globbuf);
+}
+
 /*
  * get_all_cpu_cache_details()
  * Obtain information on all cpus caches on the system.
@@ -531,7 +646,6 @@ cpus_t * get_all_cpu_cache_details(void)
 	char     **results;
 	cpus_t    *cpus = NULL;
 	size_t     cpu_count;
-	size_t     len;
 
 	memset(&globbuf, 0, sizeof(globbuf));
 
@@ -580,15 +694,17 @@ cpus_t * get_all_cpu_cache_details(void)
 		cpu_t *cpu;
 
 		cpu = &cpus->cpus[i];
-		cpu->num = i;
+		if (sscanf(strrchr(results[i], '/'), "/cpu%" SCNu32, &cpu->num) != 1)
+			cpu->num = i;
+		cpu->package = -1;
+		cpu->core = -1;
+		cpu->node = -1;
 
-		if (i == 0) {
+		if (cpu->num == 0) {
 			/* 1st CPU cannot be taken offline */
 			cpu->online = 1;
 		} else {
-			len = strlen(results[i]);
-			strncpy(path, results[i], len);
-			MK_PATH(path, len, "/online");
+			(void)snprintf(path, sizeof(path), "%s/online", results[i]);
 
 			contents = get_string_from_file(path);
 			if (!contents)
@@ -596,7 +712,11 @@ cpus_t * get_all_cpu_cache_details(void)
 			cpu->online = atoi(contents);
 			free(contents);
 		}
+		/* Offline CPUs have no topology or cache details */
+		if (!cpu->online)
+			continue;
 
+		get_cpu_topology(cpu, results[i]);
 		ret = get_cpu_cache_details(&cpus->cpus[i], results[i]);
 		if (ret != EXIT_SUCCESS) {
 			free(cpus->cpus);
@@ -635,4 +755,245 @@ void free_cpu_caches(cpus_t *cpus)
 	free(cpus);
 }
 
+/*
+ * get_cpu_by_num()
+ * @cpus: array of cpus to query.
+ * @num: cpu number.
+ *
+ * Returns: cpu_t pointer for cpu @num, or NULL if not found.
+ */
+cpu_t *get_cpu_by_num(const cpus_t *cpus, const uint32_t num)
+{
+	uint32_t i;
+
+	if (!cpus)
+		return NULL;
+
+	for (i = 0; i < cpus->count; i++) {
+		if (cpus->cpus[i].num == num)
+			return &cpus->cpus[i];
+	}
+	return NULL;
+}
+
+/*
+ * get_cpu_cache_by_num()
+ * @cpus: array of cpus to query.
+ * @num: cpu number.
+ * @cache_level: numeric cache level (1-indexed).
+ * Obtain the data or unified cache of level @cache_level of cpu @num,
+ * which may differ between cpus on hybrid systems.
+ *
+ * Returns: cpu_cache_t pointer, or NULL on error.
+ */
+cpu_cache_t *get_cpu_cache_by_num(
+	const cpus_t *cpus,
+	const uint32_t num,
+	const uint16_t cache_level)
+{
+	return get_cache_by_cpu(get_cpu_by_num(cpus, num), cache_level);
+}
+
+/*
+ * cache_is_first_sharer()
+ * @cpu: cpu to check.
+ * @cache: cache of @cpu.
+ * Each cache instance is counted once, against the lowest
+ * numbered cpu that shares it.
+ *
+ * Returns: true if @cpu is the lowest numbered cpu sharing @cache.
+ */
+static bool cache_is_first_sharer(const cpu_t *cpu, const cpu_cache_t *cache)
+{
+	uint32_t i;
+
+	if (!cache->shared_count)
+		return true;
+
+	for (i = 0; i < cpu->num && i < CPU_SETSIZE; i++) {
+		if (CPU_ISSET(i, &cache->shared_cpus))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * get_cpu_cache_count()
+ * @cpus: array of cpus to query.
+ * @cache_level: numeric cache level (1-indexed).
+ *
+ * Returns: number of distinct data or unified caches at
+ * @cache_level across the online cpus, e.g. the number of
+ * last level caches on a multi-chiplet cpu.
+ */
+uint32_t get_cpu_cache_count(const cpus_t *cpus, const uint16_t cache_level)
+{
+	uint32_t i, count = 0;
+
+	if (!cpus)
+		return 0;
+
+	for (i = 0; i < cpus->count; i++) {
+		const cpu_t *cpu = &cpus->cpus[i];
+		const cpu_cache_t *cache = get_cache_by_cpu(cpu, cache_level);
+
+		if (cpu->online && cache && cache_is_first_sharer(cpu, cache))
+			count++;
+	}
+	return count;
+}
+
+/*
+ * get_cpu_cache_total_size()
+ * @cpus: array of cpus to query.
+ * @cache_level: numeric cache level (1-indexed).
+ *
+ * Returns: total size in bytes of all the distinct data or
+ * unified caches at @cache_level across the online cpus.
+ */
+uint64_t get_cpu_cache_total_size(const cpus_t *cpus, const uint16_t cache_level)
+{
+	uint32_t i;
+	uint64_t size = 0;
+
+	if (!cpus)
+		return 0;
+
+	for (i = 0; i < cpus->count; i++) {
+		const cpu_t *cpu = &cpus->cpus[i];
+		const cpu_cache_t *cache = get_cache_by_cpu(cpu, cache_level);
+
+		if (cpu->online && cache && cache_is_first_sharer(cpu, cache))
+			size += cache->size;
+	}
+	return size;
+}
+
+/*
+ * get_cpu_package_count()
+ * @cpus: array of cpus to query.
+ *
+ * Returns: number of distinct physical packages of the online cpus.
+ */
+uint32_t get_cpu_package_count(const cpus_t *cpus)
+{
+	uint32_t i, j, count = 0;
+
+	if (!cpus)
+		return 0;
+
+	for (i = 0; i < cpus->count; i++) {
+		const cpu_t *cpu = &cpus->cpus[i];
+
+		if (!cpu->online)
+			continue;
+		for (j = 0; j < i; j++) {
+			if (cpus->cpus[j].online &&
+			    (cpus->cpus[j].package == cpu->package))
+				break;
+		}
+		if (j == i)
+			count++;
+	}
+	return count;
+}
+
+/*
+ * get_cpu_core_count()
+ * @cpus: array of cpus to query.
+ *
+ * Returns: number of physical cores of the online cpus, counting
+ * SMT siblings once.
+ */
+uint32_t get_cpu_core_count(const cpus_t *cpus)
+{
+	uint32_t i, j, count = 0;
+
+	if (!cpus)
+		return 0;
+
+	for (i = 0; i < cpus->count; i++) {
+		const cpu_t *cpu = &cpus->cpus[i];
+
+		if (!cpu->online)
+			continue;
+		for (j = 0; j < i; j++) {
+			if (cpus->cpus[j].online &&
+			    (cpus->cpus[j].package == cpu->package) &&
+			    (cpus->cpus[j].core == cpu->core))
+				break;
+		}
+		if (j == i)
+			count++;
+	}
+	return count;
+}
+
+/*
+ * get_cpu_node_count()
+ * @cpus: array of cpus to query.
+ *
+ * Returns: number of distinct NUMA nodes of the online cpus.
+ */
+uint32_t get_cpu_node_count(const cpus_t *cpus)
+{
+	uint32_t i, j, count = 0;
+
+	if (!cpus)
+		return 0;
+
+	for (i = 0; i < cpus->count; i++) {
+		const cpu_t *cpu = &cpus->cpus[i];
+
+		if (!cpu->online)
+			continue;
+		for (j = 0; j < i; j++) {
+			if (cpus->cpus[j].online &&
+			    (cpus->cpus[j].node == cpu->node))
+				break;
+		}
+		if (j == i)
+			count++;
+	}
+	return count;
+}
+
+/*
+ * log_cpu_topology()
+ * @name: stressor name.
+ * @cpus: array of cpus to log.
+ * Log the packages, cores, nodes and the data and unified
+ * caches of the current cpu and how many cpus share them.
+ */
+void log_cpu_topology(const char *name, const cpus_t *cpus)
+{
+	uint32_t i, online = 0;
+	const cpu_t *cpu;
+
+	if (!cpus)
+		return;
+
+	for (i = 0; i < cpus->count; i++)
+		online += cpus->cpus[i].online;
+
+	pr_dbg(stderr, "%s: %" PRIu32 " online CPUs, %" PRIu32 " packages, "
+		"%" PRIu32 " cores, %" PRIu32 " NUMA nodes\n", name, online,
+		get_cpu_package_count(cpus), get_cpu_core_count(cpus),
+		get_cpu_node_count(cpus));
+
+	cpu = &cpus->cpus[cache_get_cpu(cpus)];
+	for (i = 0; i < cpu->cache_count; i++) {
+		const cpu_cache_t *cache = &cpu->caches[i];
+
+		if (cache->type == CACHE_TYPE_INSTRUCTION)
+			continue;
+		pr_dbg(stderr, "%s: L%" PRIu16 " %s cache: %" PRIu32 " x %"
+			PRIu64 "K, shared by %" PRIu32 " CPUs\n",
+			name, cache->level, get_cache_name(cache->type),
+			get_cpu_cache_count(cpus, cache->level),
+			cache->size / 1024, cache->shared_count ?
+			cache->shared_count : 1);
+	}
+}
+
 #endif /* __linux__ */
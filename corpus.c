@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+/*
+ *  stress_corpus_open()
+ *	map a corpus file read only so stressors can
+ *	use it as input without copying it, returns -1
+ *	if it cannot be mapped
+ */
+int stress_corpus_open(
+	const char *opt,
+	const char *filename,
+	stress_corpus_t *corpus)
+{
+	struct stat buf;
+	void *data;
+	int fd;
+
+	memset(corpus, 0, sizeof(*corpus));
+
+	if ((fd = open(filename, O_RDONLY)) < 0) {
+		fprintf(stderr, "%s: cannot open %s, errno=%d (%s)\n",
+			opt, filename, errno, strerror(errno));
+		return -1;
+	}
+	if (fstat(fd, &buf) < 0) {
+		fprintf(stderr, "%s: cannot stat %s, errno=%d (%s)\n",
+			opt, filename, errno, strerror(errno));
+		(void)close(fd);
+		return -1;
+	}
+	if (!S_ISREG(buf.st_mode) || (buf.st_size == 0) ||
+	    ((uint64_t)buf.st_size > (uint64_t)SIZE_MAX)) {
+		fprintf(stderr, "%s: %s must be a non-empty regular file\n",
+			opt, filename);
+		(void)close(fd);
+		return -1;
+	}
+	data = mmap(NULL, (size_t)buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	(void)close(fd);
+	if (data == MAP_FAILED) {
+		fprintf(stderr, "%s: cannot mmap %s, errno=%d (%s)\n",
+			opt, filename, errno, strerror(errno));
+		return -1;
+	}
+#if defined(MADV_SEQUENTIAL)
+	(void)madvise(data, (size_t)buf.st_size, MADV_SEQUENTIAL);
+#endif
+	corpus->data = (const uint8_t *)data;
+	corpus->size = (size_t)buf.st_size;
+	corpus->filename = filename;
+
+	return 0;
+}
+
+/*
+ *  stress_corpus_next()
+ *	the next chunk of up to size bytes, in place in the
+ *	mapping, wrapping to the start at the end of the file
+ */
+const uint8_t *stress_corpus_next(
+	stress_corpus_t *corpus,
+	const size_t size,
+	size_t *len)
+{
+	const uint8_t *ptr;
+
+	if (corpus->offset >= corpus->size)
+		corpus->offset = 0;
+	ptr = corpus->data + corpus->offset;
+	*len = STRESS_MINIMUM(size, corpus->size - corpus->offset);
+	corpus->offset += *len;
+
+	return ptr;
+}
+
+/*
+ *  stress_corpus_copy()
+ *	fill buf with the next size bytes, for users that
+ *	need to modify or terminate the data
+ */
+void stress_corpus_copy(
+	stress_corpus_t *corpus,
+	void *buf,
+	const size_t size)
+{
+	uint8_t *ptr = (uint8_t *)buf;
+	size_t left = size;
+
+	while (left) {
+		size_t len;
+		const uint8_t *src = stress_corpus_next(corpus, left, &len);
+
+		(void)memcpy(ptr, src, len);
+		ptr += len;
+		left -= len;
+	}
+}
+
+/*
+ *  stress_corpus_line()
+ *	the next non-empty line of at most max bytes, in place
+ *	in the mapping and without the newline, the length is
+ *	zero if the corpus only has empty lines
+ */
+const char *stress_corpus_line(
+	stress_corpus_t *corpus,
+	const size_t max,
+	size_t *len)
+{
+	size_t scanned = 0;
+
+	while (scanned < corpus->size) {
+		const uint8_t *ptr, *nl;
+		size_t n;
+
+		ptr = stress_corpus_next(corpus, max, &n);
+		nl = memchr(ptr, '\n', n);
+		if (nl) {
+			/* carry on after the newline next time */
+			corpus->offset -= n - (size_t)(nl - ptr) - 1;
+			n = (size_t)(nl - ptr);
+			scanned++;
+		}
+		scanned += n;
+		if (n) {
+			*len = n;
+			return (const char *)ptr;
+		}
+	}
+	*len = 0;
+
+	return (const char *)corpus->data;
+}
+
+/*
+ *  stress_corpus_close()
+ *	unmap a corpus file
+ */
+void stress_corpus_close(stress_corpus_t *corpus)
+{
+	if (corpus->data)
+		(void)munmap((void *)corpus->data, corpus->size);
+	memset(corpus, 0, sizeof(*corpus));
+}
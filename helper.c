@@ -511,6 +511,70 @@ const char *stress_strsignal(const int signum)
 }
 
 
+/*
+ *  stress_set_len_dist()
+ *	parse a string length distribution name, returns
+ *	a STRESS_LEN_DIST_* value or -1 if not recognised
+ */
+int stress_set_len_dist(const char *opt, const char *name)
+{
+	static const char *dists[] = {
+		"fixed", "uniform", "lognormal"
+	};
+	size_t i;
+
+	for (i = 0; i < SIZEOF_ARRAY(dists); i++) {
+		if (!strcmp(dists[i], name))
+			return (int)i;
+	}
+
+	fprintf(stderr, "%s must be one of:", opt);
+	for (i = 0; i < SIZEOF_ARRAY(dists); i++)
+		fprintf(stderr, " %s", dists[i]);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_len_dist()
+ *	draw a length with a mean of len from the given
+ *	distribution, clamped to min..max
+ */
+size_t stress_len_dist(
+	const int dist,
+	const size_t len,
+	const size_t min,
+	const size_t max)
+{
+	double l;
+
+	switch (dist) {
+	case STRESS_LEN_DIST_UNIFORM:
+		/* 1 .. 2 * len - 1 */
+		l = 1.0 + (double)(mwc32() % (2 * len - 1));
+		break;
+	case STRESS_LEN_DIST_LOGNORMAL: {
+		/* sigma of 0.75, mu chosen so that the mean is len */
+		const double sigma = 0.75;
+		const double u1 = ((double)mwc32() + 1.0) / 4294967297.0;
+		const double u2 = (double)mwc32() / 4294967296.0;
+		const double z = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+
+		l = exp(log((double)len) - (sigma * sigma / 2.0) + sigma * z);
+		break;
+	}
+	default:
+		l = (double)len;
+		break;
+	}
+	if (l < (double)min)
+		return min;
+	if (l > (double)max)
+		return max;
+	return (size_t)l;
+}
+
 /*
  *  stress_strnrnd()
  *	fill string with random chars
@@ -591,6 +655,7 @@ int stress_cache_alloc(const char *name)
 	cpus_t *cpu_caches;
 	cpu_cache_t *cache = NULL;
 	uint16_t max_cache_level = 0;
+	uint32_t i;
 #endif
 
 #if !defined(__linux__)
@@ -605,6 +670,7 @@ int stress_cache_alloc(const char *name)
 		goto init_done;
 	}
 
+	log_cpu_topology(name, cpu_caches);
 	max_cache_level = get_max_cache_level(cpu_caches);
 
 	if (shared->mem_cache_level > max_cache_level) {
@@ -615,7 +681,18 @@ int stress_cache_alloc(const char *name)
 		shared->mem_cache_level = max_cache_level;
 	}
 
-	cache = get_cpu_cache(cpu_caches, shared->mem_cache_level);
+	/*
+	 *  Hybrid CPUs have different sized caches at the same level,
+	 *  so size the buffer for the largest one; instances on any
+	 *  CPU then still fill their cache
+	 */
+	for (i = 0; i < cpu_caches->count; i++) {
+		cpu_cache_t *c = get_cpu_cache_by_num(cpu_caches,
+			cpu_caches->cpus[i].num, shared->mem_cache_level);
+
+		if (c && (!cache || (c->size > cache->size)))
+			cache = c;
+	}
 	if (!cache) {
 		if (warn_once(WARN_ONCE_CACHE_NONE))
 			pr_inf(stderr, "%s: using built-in defaults as no suitable "
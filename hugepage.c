@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+#if defined(MAP_HUGETLB) && !defined(MAP_HUGE_2MB) && defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_2MB	(21 << MAP_HUGE_SHIFT)
+#endif
+#if defined(MAP_HUGETLB) && !defined(MAP_HUGE_1GB) && defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_1GB	(30 << MAP_HUGE_SHIFT)
+#endif
+
+enum {
+	HUGEPAGE_DEFAULT = 0,		/* leave it to the kernel */
+	HUGEPAGE_NONE,			/* base pages only */
+	HUGEPAGE_THP,			/* transparent huge pages */
+	HUGEPAGE_HUGETLB_2M,		/* 2MB hugetlb pages */
+	HUGEPAGE_HUGETLB_1G,		/* 1GB hugetlb pages */
+};
+
+typedef struct {
+	const char *name;		/* --vm-hugepage name */
+	const int mode;			/* HUGEPAGE_* mode */
+	const size_t size;		/* hugetlb page size, 0 = base page */
+} hugepage_info_t;
+
+static const hugepage_info_t hugepages[] = {
+	{ "none",	HUGEPAGE_NONE,		0 },
+	{ "thp",	HUGEPAGE_THP,		0 },
+	{ "hugetlb-2M",	HUGEPAGE_HUGETLB_2M,	2 * MB },
+	{ "hugetlb-1G",	HUGEPAGE_HUGETLB_1G,	1 * GB },
+	{ NULL,		0,			0 }
+};
+
+static const hugepage_info_t *opt_hugepage = NULL;
+
+/*
+ *  stress_set_vm_hugepage()
+ *	set the page backing used by the vm, mmap and stream stressors
+ */
+int stress_set_vm_hugepage(const char *name)
+{
+	const hugepage_info_t *info;
+
+	for (info = hugepages; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_hugepage = info;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "vm-hugepage must be one of:");
+	for (info = hugepages; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_hugepage_enabled()
+ *	true if a page backing was chosen with --vm-hugepage
+ */
+bool stress_hugepage_enabled(void)
+{
+	return opt_hugepage != NULL;
+}
+
+/*
+ *  stress_hugepage_name()
+ *	name of the page backing, "default" if not set
+ */
+const char *stress_hugepage_name(void)
+{
+	return opt_hugepage ? opt_hugepage->name : "default";
+}
+
+/*
+ *  stress_hugepage_size()
+ *	size of the pages backing a mapping; hugetlb mappings
+ *	must be mapped, unmapped and released in multiples of this
+ */
+size_t stress_hugepage_size(void)
+{
+	if (opt_hugepage && opt_hugepage->size)
+		return opt_hugepage->size;
+	return stress_get_pagesize();
+}
+
+/*
+ *  stress_hugepage_align()
+ *	round size up to the size of the backing pages
+ */
+size_t stress_hugepage_align(const size_t sz)
+{
+	const size_t page_size = stress_hugepage_size();
+
+	return (sz + page_size - 1) & ~(page_size - 1);
+}
+
+/*
+ *  stress_hugepage_mmap()
+ *	mmap with the --vm-hugepage backing. hugetlb mappings fall
+ *	back to base pages if no huge pages are available, and thp
+ *	mappings are advised with MADV_HUGEPAGE
+ */
+void *stress_hugepage_mmap(
+	void *addr,
+	const size_t length,
+	const int prot,
+	int flags,
+	const int fd,
+	const off_t offset)
+{
+	void *ptr;
+	bool populate = false;
+	const int mode = opt_hugepage ? opt_hugepage->mode : HUGEPAGE_DEFAULT;
+
+#if defined(MAP_HUGETLB) && defined(MAP_ANONYMOUS)
+	if (((mode == HUGEPAGE_HUGETLB_2M) || (mode == HUGEPAGE_HUGETLB_1G)) &&
+	    (flags & MAP_ANONYMOUS)) {
+		int huge = MAP_HUGETLB;
+
+#if defined(MAP_HUGE_2MB)
+		if (mode == HUGEPAGE_HUGETLB_2M)
+			huge |= MAP_HUGE_2MB;
+#endif
+#if defined(MAP_HUGE_1GB)
+		if (mode == HUGEPAGE_HUGETLB_1G)
+			huge |= MAP_HUGE_1GB;
+#endif
+		ptr = mmap(addr, length, prot, flags | huge, fd, offset);
+		if (ptr != MAP_FAILED)
+			return ptr;
+		if (warn_once(WARN_ONCE_HUGEPAGE))
+			pr_inf(stderr, "%s mmap failed, errno=%d (%s), falling "
+				"back to base pages, check /proc/sys/vm/nr_hugepages\n",
+				opt_hugepage->name, errno, strerror(errno));
+	}
+#endif
+#if defined(MADV_HUGEPAGE) && defined(MAP_ANONYMOUS)
+	/*
+	 *  Shared anonymous memory only gets transparent huge
+	 *  pages if shmem_enabled allows it, so make thp mappings
+	 *  private; callers must not share these across a fork
+	 */
+	if ((mode == HUGEPAGE_THP) && (flags & MAP_ANONYMOUS) && (flags & MAP_SHARED)) {
+		flags &= ~MAP_SHARED;
+		flags |= MAP_PRIVATE;
+		if (warn_once(WARN_ONCE_THP_PRIVATE))
+			pr_inf(stderr, "%s: shared anonymous mappings are "
+				"mapped private to get transparent huge pages\n",
+				opt_hugepage->name);
+	}
+#endif
+#if defined(MAP_POPULATE)
+	/*
+	 *  Pages populated before the madvise would already be
+	 *  faulted in with the kernel's default page size
+	 */
+	if ((mode == HUGEPAGE_THP) || (mode == HUGEPAGE_NONE)) {
+		populate = !!(flags & MAP_POPULATE);
+		flags &= ~MAP_POPULATE;
+	}
+#endif
+	ptr = mmap(addr, length, prot, flags, fd, offset);
+	if (ptr == MAP_FAILED)
+		return ptr;
+
+#if defined(MADV_HUGEPAGE)
+	if (mode == HUGEPAGE_THP)
+		(void)madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+#if defined(MADV_NOHUGEPAGE)
+	if (mode == HUGEPAGE_NONE)
+		(void)madvise(ptr, length, MADV_NOHUGEPAGE);
+#endif
+#if defined(MADV_POPULATE_WRITE)
+	if (populate && (prot & PROT_WRITE))
+		(void)madvise(ptr, length, MADV_POPULATE_WRITE);
+#endif
+	(void)populate;
+
+	return ptr;
+}
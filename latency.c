@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+/*
+ *  Latencies are binned into a log-linear histogram, each power of
+ *  two of nanoseconds is split into STRESS_LATENCY_SUB linear sub
+ *  buckets, so a percentile is accurate to within 1/16 of its value
+ *  over the whole 64 bit range in a fixed 8K of counters.
+ */
+#define STRESS_LATENCY_SUB_BITS	(4)
+#define STRESS_LATENCY_SUB	(1U << STRESS_LATENCY_SUB_BITS)
+
+static uint32_t latency_stressor;
+
+/*
+ *  latency_init()
+ *	set the stressor that latency_merge() accounts against
+ */
+void latency_init(const uint32_t stressor)
+{
+	latency_stressor = stressor;
+}
+
+/*
+ *  latency_now()
+ *	monotonic time in nanoseconds
+ */
+uint64_t latency_now(void)
+{
+#if defined(HAVE_LIB_RT) && defined(CLOCK_MONOTONIC)
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == 0)
+		return ((uint64_t)now.tv_sec * 1000000000ULL) +
+			(uint64_t)now.tv_nsec;
+#endif
+	return (uint64_t)(time_now() * 1000000000.0);
+}
+
+/*
+ *  latency_bucket()
+ *	histogram bucket for a latency of ns nanoseconds
+ */
+static inline size_t latency_bucket(const uint64_t ns)
+{
+	uint32_t msb, shift;
+
+	if (ns < STRESS_LATENCY_SUB)
+		return (size_t)ns;
+
+	msb = 63 - (uint32_t)__builtin_clzll(ns);
+	shift = msb - STRESS_LATENCY_SUB_BITS;
+
+	return ((size_t)(shift + 1) * STRESS_LATENCY_SUB) +
+		(size_t)((ns >> shift) & (STRESS_LATENCY_SUB - 1));
+}
+
+/*
+ *  latency_bucket_ns()
+ *	mid point latency in nanoseconds of a histogram bucket
+ */
+static inline uint64_t latency_bucket_ns(const size_t bucket)
+{
+	uint32_t shift;
+	uint64_t mantissa;
+
+	if (bucket < STRESS_LATENCY_SUB)
+		return (uint64_t)bucket;
+
+	shift = (uint32_t)(bucket / STRESS_LATENCY_SUB) - 1;
+	mantissa = STRESS_LATENCY_SUB + (bucket % STRESS_LATENCY_SUB);
+
+	return (mantissa << shift) + (((1ULL << shift) - 1) / 2);
+}
+
+/*
+ *  latency_add()
+ *	account one operation of bytes bytes that took ns nanoseconds
+ */
+void latency_add(stress_latency_t *lat, const uint64_t ns, const uint64_t bytes)
+{
+	lat->bucket[latency_bucket(ns)]++;
+	lat->count++;
+	lat->bytes += bytes;
+	lat->total_ns += ns;
+	if (ns > lat->max_ns)
+		lat->max_ns = ns;
+}
+
+/*
+ *  latency_percentile()
+ *	latency in nanoseconds that percent % of the operations
+ *	completed within, 0 if there were no operations
+ */
+uint64_t latency_percentile(const stress_latency_t *lat, const double percent)
+{
+	uint64_t target, sum = 0;
+	size_t i;
+
+	if (!lat->count)
+		return 0;
+
+	target = (uint64_t)(((double)lat->count * percent) / 100.0);
+	if (target < 1)
+		target = 1;
+	if (target > lat->count)
+		target = lat->count;
+
+	for (i = 0; i < STRESS_LATENCY_BUCKETS; i++) {
+		sum += lat->bucket[i];
+		if (sum >= target)
+			return STRESS_MINIMUM(latency_bucket_ns(i), lat->max_ns);
+	}
+	return lat->max_ns;
+}
+
+/*
+ *  latency_rate()
+ *	operations and MB per second of a set of latencies
+ */
+static inline void latency_rate(
+	const stress_latency_t *lat,
+	double *ops_rate,
+	double *mb_rate)
+{
+	if (lat->duration > 0.0) {
+		*ops_rate = (double)lat->count / lat->duration;
+		*mb_rate = ((double)lat->bytes / lat->duration) / (double)MB;
+	} else {
+		*ops_rate = 0.0;
+		*mb_rate = 0.0;
+	}
+}
+
+/*
+ *  latency_report()
+ *	report the rates and latency percentiles of one instance
+ */
+void latency_report(
+	const char *name,
+	const uint32_t instance,
+	const char *method,
+	const stress_latency_t *lat)
+{
+	double ops_rate, mb_rate;
+
+	if (!lat->count)
+		return;
+
+	latency_rate(lat, &ops_rate, &mb_rate);
+	pr_inf(stderr, "%s: instance %" PRIu32 ": %-14s %10.0f IOPS, "
+		"%9.2f MB/s, latency p50 %.2f us, p99 %.2f us, "
+		"p99.9 %.2f us\n",
+		name, instance, method, ops_rate, mb_rate,
+		(double)latency_percentile(lat, 50.0) / 1000.0,
+		(double)latency_percentile(lat, 99.0) / 1000.0,
+		(double)latency_percentile(lat, 99.9) / 1000.0);
+}
+
+/*
+ *  latency_merge()
+ *	fold an instance's latencies into the per stressor method
+ *	totals; the method name is copied as it is read back by
+ *	the parent process after the instance has exited
+ */
+void latency_merge(const char *method, const stress_latency_t *lat)
+{
+	double ops_rate, mb_rate;
+	size_t i, j;
+
+	if (!lat->count)
+		return;
+
+	latency_rate(lat, &ops_rate, &mb_rate);
+#if defined(HAVE_LIB_PTHREAD)
+	if (pthread_spin_lock(&shared->latency.lock))
+		return;
+#endif
+	for (i = 0; i < STRESS_LATENCY_MAX; i++) {
+		stress_latency_method_t *lm = &shared->latency.method[i];
+
+		if (!*lm->method) {
+			(void)strncpy(lm->method, method, sizeof(lm->method) - 1);
+			lm->stressor = latency_stressor;
+		} else if ((lm->stressor != latency_stressor) ||
+			   strncmp(lm->method, method, sizeof(lm->method) - 1)) {
+			continue;
+		}
+		/* instances run concurrently, so their rates add up */
+		lm->ops_rate += ops_rate;
+		lm->mb_rate += mb_rate;
+		lm->lat.count += lat->count;
+		lm->lat.bytes += lat->bytes;
+		lm->lat.total_ns += lat->total_ns;
+		lm->lat.duration += lat->duration;
+		if (lat->max_ns > lm->lat.max_ns)
+			lm->lat.max_ns = lat->max_ns;
+		for (j = 0; j < STRESS_LATENCY_BUCKETS; j++)
+			lm->lat.bucket[j] += lat->bucket[j];
+		break;
+	}
+#if defined(HAVE_LIB_PTHREAD)
+	(void)pthread_spin_unlock(&shared->latency.lock);
+#endif
+}
+
+/*
+ *  latency_dump()
+ *	dump the rates and latency percentiles of each
+ *	stressor method across all of its instances
+ */
+void latency_dump(FILE *yaml, const stress_t stressors[])
+{
+	size_t i;
+
+	for (i = 0; i < STRESS_LATENCY_MAX; i++) {
+		const stress_latency_method_t *lm = &shared->latency.method[i];
+		const char *munged;
+		double p50, p99, p999, mean;
+
+		if (!*lm->method)
+			break;
+
+		if (!i) {
+			pr_inf(stdout, "%-13s %-14s %10s %9s %9s %9s %9s %9s\n",
+				"stressor", "method", "IOPS", "MB/s",
+				"p50 us", "p99 us", "p99.9 us", "max us");
+			pr_yaml(yaml, "latency:\n");
+		}
+		munged = munge_underscore(stressors[lm->stressor].name);
+		p50 = (double)latency_percentile(&lm->lat, 50.0) / 1000.0;
+		p99 = (double)latency_percentile(&lm->lat, 99.0) / 1000.0;
+		p999 = (double)latency_percentile(&lm->lat, 99.9) / 1000.0;
+		mean = lm->lat.count ?
+			((double)lm->lat.total_ns / (double)lm->lat.count) / 1000.0 : 0.0;
+
+		pr_inf(stdout, "%-13s %-14s %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+			munged, lm->method, lm->ops_rate, lm->mb_rate,
+			p50, p99, p999, (double)lm->lat.max_ns / 1000.0);
+
+		pr_yaml(yaml, "    - stressor: %s\n", munged);
+		pr_yaml(yaml, "      method: %s\n", lm->method);
+		pr_yaml(yaml, "      ops: %" PRIu64 "\n", lm->lat.count);
+		pr_yaml(yaml, "      bytes: %" PRIu64 "\n", lm->lat.bytes);
+		pr_yaml(yaml, "      ops-per-second: %f\n", lm->ops_rate);
+		pr_yaml(yaml, "      mb-per-second: %f\n", lm->mb_rate);
+		pr_yaml(yaml, "      latency-mean-us: %f\n", mean);
+		pr_yaml(yaml, "      latency-p50-us: %f\n", p50);
+		pr_yaml(yaml, "      latency-p99-us: %f\n", p99);
+		pr_yaml(yaml, "      latency-p99.9-us: %f\n", p999);
+		pr_yaml(yaml, "      latency-max-us: %f\n",
+			(double)lm->lat.max_ns / 1000.0);
+	}
+	if (i)
+		pr_yaml(yaml, "\n");
+}
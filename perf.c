@@ -70,6 +70,18 @@ typedef struct {
 #define STRESS_GOT(x) _SNG_PERF_COUNT_ ## x
 
 #define UNRESOLVED				(~0UL)
+
+#define PERF_HW_CACHE(cache, op, result)	\
+	((PERF_COUNT_HW_CACHE_ ## cache) |	\
+	 (PERF_COUNT_HW_CACHE_OP_ ## op << 8) |	\
+	 (PERF_COUNT_HW_CACHE_RESULT_ ## result << 16))
+
+#define PERF_COUNT_HW_CACHE_L1D_LOADS		PERF_HW_CACHE(L1D, READ, ACCESS)
+#define PERF_COUNT_HW_CACHE_L1D_LOAD_MISSES	PERF_HW_CACHE(L1D, READ, MISS)
+#define PERF_COUNT_HW_CACHE_DTLB_LOADS		PERF_HW_CACHE(DTLB, READ, ACCESS)
+#define PERF_COUNT_HW_CACHE_DTLB_LOAD_MISSES	PERF_HW_CACHE(DTLB, READ, MISS)
+#define PERF_COUNT_HW_CACHE_DTLB_STORE_MISSES	PERF_HW_CACHE(DTLB, WRITE, MISS)
+
 #define PERF_COUNT_TP_SYSCALLS_ENTER		UNRESOLVED
 #define PERF_COUNT_TP_SYSCALLS_EXIT		UNRESOLVED
 #define PERF_COUNT_TP_TLB_FLUSH			UNRESOLVED
@@ -130,6 +142,15 @@ static perf_info_t perf_info[STRESS_PERF_MAX + 1] = {
 #if STRESS_GOT(HW_REF_CPU_CYCLES)
 	PERF_INFO(HARDWARE, HW_REF_CPU_CYCLES,		"Total Cycles"),
 #endif
+#if STRESS_GOT(HW_CACHE_L1D)
+	PERF_INFO(HW_CACHE, HW_CACHE_L1D_LOADS,	"L1D Loads"),
+	PERF_INFO(HW_CACHE, HW_CACHE_L1D_LOAD_MISSES,	"L1D Load Misses"),
+#endif
+#if STRESS_GOT(HW_CACHE_DTLB)
+	PERF_INFO(HW_CACHE, HW_CACHE_DTLB_LOADS,	"dTLB Loads"),
+	PERF_INFO(HW_CACHE, HW_CACHE_DTLB_LOAD_MISSES,	"dTLB Load Misses"),
+	PERF_INFO(HW_CACHE, HW_CACHE_DTLB_STORE_MISSES,	"dTLB Store Misses"),
+#endif
 
 #if STRESS_GOT(SW_PAGE_FAULTS_MIN)
 	PERF_INFO(SOFTWARE, SW_PAGE_FAULTS_MIN,		"Page Faults Minor"),
@@ -0,0 +1,20 @@
+    PER_LINUX,
+    PER_SVR4,
+    PER_SVR3,
+    PER_SCOSVR3,
+    PER_OSR5,
+    PER_WYSEV386,
+    PER_ISCR4,
+    PER_BSD,
+    PER_SUNOS,
+    PER_XENIX,
+    PER_LINUX32,
+    PER_IRIX32,
+    PER_IRIXN32,
+    PER_IRIX64,
+    PER_RISCOS,
+    PER_SOLARIS,
+    PER_UW7,
+    PER_OSF4,
+    PER_HPUX,
+    PER_MASK,
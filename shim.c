@@ -255,6 +255,71 @@ int shim_membarrier(int cmd, int flags)
 #endif
 }
 
+/*
+ *  shim_io_uring_setup()
+ *	wrapper for linux io_uring_setup(), params
+ *	is a struct io_uring_params
+ */
+int shim_io_uring_setup(unsigned int entries, void *params)
+{
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+	return (int)syscall(__NR_io_uring_setup, entries, params);
+#else
+	(void)entries;
+	(void)params;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *  shim_io_uring_enter()
+ *	wrapper for linux io_uring_enter()
+ */
+int shim_io_uring_enter(
+	int fd,
+	unsigned int to_submit,
+	unsigned int min_complete,
+	unsigned int flags)
+{
+#if defined(__linux__) && defined(__NR_io_uring_enter)
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit,
+		min_complete, flags, NULL, 0);
+#else
+	(void)fd;
+	(void)to_submit;
+	(void)min_complete;
+	(void)flags;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ *  shim_io_uring_register()
+ *	wrapper for linux io_uring_register()
+ */
+int shim_io_uring_register(
+	int fd,
+	unsigned int opcode,
+	void *arg,
+	unsigned int nr_args)
+{
+#if defined(__linux__) && defined(__NR_io_uring_register)
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+#else
+	(void)fd;
+	(void)opcode;
+	(void)arg;
+	(void)nr_args;
+
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
 int shim_memfd_create(const char *name, unsigned int flags)
 {
 #if defined(__linux__) && defined(__NR_memfd_create)
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+#include <math.h>
+
+typedef struct {
+	const char *name;		/* --sort-dist name */
+	const int dist;			/* SORT_DIST_* */
+} sort_dist_info_t;
+
+typedef struct {
+	const char *name;		/* --sort-key name */
+	const size_t size;		/* element size in bytes */
+	const stress_sort_cmp_func cmp;	/* ascending comparison */
+	const stress_sort_cmp_func rcmp;/* descending comparison */
+} sort_key_info_t;
+
+enum {
+	SORT_DIST_RANDOM = 0,		/* uniform random */
+	SORT_DIST_SORTED,		/* already in order */
+	SORT_DIST_REVERSED,		/* in reverse order */
+	SORT_DIST_NEARLY_SORTED,	/* in order apart from 1% swaps */
+	SORT_DIST_FEW_UNIQUE,		/* 16 distinct values */
+	SORT_DIST_ZIPFIAN,		/* rank k with probability ~ 1/k */
+};
+
+/* records with a 64 bit key and a payload */
+typedef struct {
+	uint64_t key;
+	uint8_t payload[8];
+} sort_rec16_t;
+
+typedef struct {
+	uint64_t key;
+	uint8_t payload[56];
+} sort_rec64_t;
+
+static const sort_dist_info_t sort_dists[] = {
+	{ "random",		SORT_DIST_RANDOM },
+	{ "sorted",		SORT_DIST_SORTED },
+	{ "reversed",		SORT_DIST_REVERSED },
+	{ "nearly-sorted",	SORT_DIST_NEARLY_SORTED },
+	{ "few-unique",		SORT_DIST_FEW_UNIQUE },
+	{ "zipfian",		SORT_DIST_ZIPFIAN },
+	{ NULL,			0 }
+};
+
+#define SORT_CMP(type, name, field)				\
+static int name(const void *p1, const void *p2)			\
+{								\
+	const type *e1 = (const type *)p1;			\
+	const type *e2 = (const type *)p2;			\
+								\
+	if (e1->field > e2->field)				\
+		return 1;					\
+	else if (e1->field < e2->field)				\
+		return -1;					\
+	else							\
+		return 0;					\
+}								\
+								\
+static int name ## _rev(const void *p1, const void *p2)		\
+{								\
+	return name(p2, p1);					\
+}
+
+typedef struct { int32_t v; } sort_int32_t;
+typedef struct { int64_t v; } sort_int64_t;
+typedef struct { double v; } sort_double_t;
+
+SORT_CMP(sort_int32_t, sort_cmp_int32, v)
+SORT_CMP(sort_int64_t, sort_cmp_int64, v)
+SORT_CMP(sort_double_t, sort_cmp_double, v)
+SORT_CMP(sort_rec16_t, sort_cmp_rec16, key)
+SORT_CMP(sort_rec64_t, sort_cmp_rec64, key)
+
+static const sort_key_info_t sort_keys[] = {
+	{ "int32",	sizeof(int32_t),	sort_cmp_int32,	sort_cmp_int32_rev },
+	{ "int64",	sizeof(int64_t),	sort_cmp_int64,	sort_cmp_int64_rev },
+	{ "double",	sizeof(double),		sort_cmp_double, sort_cmp_double_rev },
+	{ "rec16",	sizeof(sort_rec16_t),	sort_cmp_rec16,	sort_cmp_rec16_rev },
+	{ "rec64",	sizeof(sort_rec64_t),	sort_cmp_rec64,	sort_cmp_rec64_rev },
+	{ NULL,		0,			NULL,		NULL }
+};
+
+static const sort_dist_info_t *opt_sort_dist = &sort_dists[0];
+static const sort_key_info_t *opt_sort_key = &sort_keys[0];
+static stress_corpus_t sort_corpus;
+
+/*
+ *  stress_set_sort_dist()
+ *	set the input distribution of the sort stressors
+ */
+int stress_set_sort_dist(const char *name)
+{
+	const sort_dist_info_t *info;
+
+	for (info = sort_dists; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_sort_dist = info;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "sort-dist must be one of:");
+	for (info = sort_dists; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_set_sort_key()
+ *	set the key type of the sort stressors
+ */
+int stress_set_sort_key(const char *name)
+{
+	const sort_key_info_t *info;
+
+	for (info = sort_keys; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_sort_key = info;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "sort-key must be one of:");
+	for (info = sort_keys; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_set_sort_corpus()
+ *	take the elements of the sort stressors from a file
+ */
+int stress_set_sort_corpus(const char *filename)
+{
+	stress_corpus_close(&sort_corpus);
+	return stress_corpus_open("sort-corpus", filename, &sort_corpus);
+}
+
+/*
+ *  stress_sort_size()
+ *	size in bytes of one element
+ */
+size_t stress_sort_size(void)
+{
+	return opt_sort_key->size;
+}
+
+/*
+ *  stress_sort_cmp()
+ *	comparison function for the key type
+ */
+stress_sort_cmp_func stress_sort_cmp(const bool reverse)
+{
+	return reverse ? opt_sort_key->rcmp : opt_sort_key->cmp;
+}
+
+/*
+ *  stress_sort_int32()
+ *	true if the elements are plain int32 values
+ */
+bool stress_sort_int32(void)
+{
+	return opt_sort_key == &sort_keys[0];
+}
+
+/*
+ *  stress_sort_value()
+ *	the i'th of n values drawn from the input distribution
+ */
+static inline uint64_t stress_sort_value(const size_t i, const size_t n)
+{
+	switch (opt_sort_dist->dist) {
+	case SORT_DIST_SORTED:
+	case SORT_DIST_NEARLY_SORTED:
+		return i;
+	case SORT_DIST_REVERSED:
+		return n - i;
+	case SORT_DIST_FEW_UNIQUE:
+		return mwc32() % 16;
+	case SORT_DIST_ZIPFIAN: {
+		/* exp(u * ln(n)) puts rank k with probability ~ 1/k */
+		const double u = (double)mwc32() / 4294967296.0;
+
+		return (uint64_t)exp(u * log((double)n + 1.0));
+	}
+	default:
+		return mwc64();
+	}
+}
+
+/*
+ *  stress_sort_shuffle()
+ *	nearly sorted input has 1% of the elements
+ *	swapped with a random partner
+ */
+static void stress_sort_shuffle(void *data, const size_t n, const size_t size)
+{
+	uint8_t tmp[size];
+	size_t i;
+
+	if ((opt_sort_dist->dist != SORT_DIST_NEARLY_SORTED) || (n < 2))
+		return;
+
+	for (i = 0; i < n / 100; i++) {
+		uint8_t *p1 = (uint8_t *)data + (size * (mwc64() % n));
+		uint8_t *p2 = (uint8_t *)data + (size * (mwc64() % n));
+
+		(void)memcpy(tmp, p1, size);
+		(void)memcpy(p1, p2, size);
+		(void)memcpy(p2, tmp, size);
+	}
+}
+
+/*
+ *  stress_sort_corpus_fill()
+ *	fill data with the next bytes of the corpus, each
+ *	instance starts at a different place in the corpus
+ */
+static void stress_sort_corpus_fill(void *data, const size_t size)
+{
+	if (!sort_corpus.offset)
+		sort_corpus.offset = (size_t)(mwc64() % sort_corpus.size);
+	stress_corpus_copy(&sort_corpus, data, size);
+}
+
+/*
+ *  stress_sort_fill()
+ *	fill data with n elements of the key type drawn
+ *	from the input distribution
+ */
+void stress_sort_fill(void *data, const size_t n)
+{
+	const size_t size = opt_sort_key->size;
+	uint8_t *ptr = (uint8_t *)data;
+	size_t i;
+
+	/* a corpus supplies the raw bytes of the elements */
+	if (sort_corpus.data) {
+		stress_sort_corpus_fill(data, n * size);
+		/*
+		 *  NaNs compare neither less nor greater than anything,
+		 *  they would make the order (and the check) undefined
+		 */
+		if (opt_sort_key->cmp == sort_cmp_double) {
+			for (i = 0; i < n; i++, ptr += size)
+				if (isnan(((sort_double_t *)ptr)->v))
+					((sort_double_t *)ptr)->v = 0.0;
+		}
+		return;
+	}
+	for (i = 0; i < n; i++, ptr += size) {
+		const uint64_t v = stress_sort_value(i, n);
+
+		switch (size) {
+		case sizeof(int32_t):
+			((sort_int32_t *)ptr)->v = (int32_t)v;
+			break;
+		case sizeof(sort_rec16_t):
+			((sort_rec16_t *)ptr)->key = v;
+			memset(((sort_rec16_t *)ptr)->payload, (int)i,
+				sizeof(((sort_rec16_t *)ptr)->payload));
+			break;
+		case sizeof(sort_rec64_t):
+			((sort_rec64_t *)ptr)->key = v;
+			memset(((sort_rec64_t *)ptr)->payload, (int)i,
+				sizeof(((sort_rec64_t *)ptr)->payload));
+			break;
+		default:
+			if (opt_sort_key->cmp == sort_cmp_double)
+				((sort_double_t *)ptr)->v = (double)v;
+			else
+				((sort_int64_t *)ptr)->v = (int64_t)v;
+			break;
+		}
+	}
+	stress_sort_shuffle(data, n, size);
+}
+
+/*
+ *  stress_sort_fill_int32()
+ *	fill data with n int32 values drawn from the input
+ *	distribution, whatever the key type is
+ */
+void stress_sort_fill_int32(int32_t *data, const size_t n)
+{
+	size_t i;
+
+	if (sort_corpus.data) {
+		stress_sort_corpus_fill(data, n * sizeof(*data));
+		return;
+	}
+	for (i = 0; i < n; i++)
+		data[i] = (int32_t)stress_sort_value(i, n);
+	stress_sort_shuffle(data, n, sizeof(*data));
+}
+
+/*
+ *  stress_sort_check()
+ *	check n elements are in ascending (or descending) order
+ */
+bool stress_sort_check(const void *data, const size_t n, const bool reverse)
+{
+	const stress_sort_cmp_func cmp = stress_sort_cmp(reverse);
+	const size_t size = opt_sort_key->size;
+	const uint8_t *ptr = (const uint8_t *)data;
+	size_t i;
+
+	for (i = 1; i < n; i++, ptr += size) {
+		if (cmp(ptr, ptr + size) > 0)
+			return false;
+	}
+	return true;
+}
+
+/*
+ *  stress_sort_dist_name()
+ *	name of the input distribution
+ */
+const char *stress_sort_dist_name(void)
+{
+	return sort_corpus.data ? "corpus" : opt_sort_dist->name;
+}
+
+/*
+ *  stress_sort_report()
+ *	report the elements sorted per second
+ */
+void stress_sort_report(
+	const char *name,
+	const uint64_t elements,
+	const double duration)
+{
+	if (!elements || (duration <= 0.0))
+		return;
+	pr_inf(stderr, "%s: %.2f M %s elements/sec, %s input\n",
+		name, (double)elements / (duration * 1000000.0),
+		opt_sort_key->name, stress_sort_dist_name());
+}
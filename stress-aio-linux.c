@@ -24,21 +24,38 @@
  */
 #include "stress-ng.h"
 
-#if defined(__linux__) &&	\
-    defined(HAVE_LIB_AIO) &&	\
-    defined(__NR_io_setup) &&	\
-    defined(__NR_io_destroy) &&	\
-    defined(__NR_io_submit) &&	\
+#if defined(__linux__) &&		\
+    defined(HAVE_LIB_AIO) &&		\
+    defined(__NR_io_setup) &&		\
+    defined(__NR_io_destroy) &&		\
+    defined(__NR_io_submit) &&		\
     defined(__NR_io_getevents)
-
 #include <libaio.h>
-
+#include <sys/eventfd.h>
 #endif
 
-#define BUFFER_SZ	(4096)
+#define BUFFER_SZ		(4096)
+
+/* completion reaping modes */
+#define AIOL_REAP_RING		(0)	/* read the user space aio ring */
+#define AIOL_REAP_SYSCALL	(1)	/* io_getevents() system call */
 
 static uint32_t opt_aio_linux_requests = DEFAULT_AIO_LINUX_REQUESTS;
 static bool set_aio_linux_requests = false;
+static uint32_t opt_aio_linux_contexts = DEFAULT_AIO_LINUX_CONTEXTS;
+static uint64_t opt_aio_linux_bytes = DEFAULT_AIO_LINUX_BYTES;
+static int opt_aio_linux_reap = AIOL_REAP_RING;
+
+typedef struct {
+	const char *name;	/* reap mode name */
+	const int reap;		/* AIOL_REAP_* */
+} aiol_reap_t;
+
+static const aiol_reap_t aiol_reaps[] = {
+	{ "ring",	AIOL_REAP_RING },
+	{ "syscall",	AIOL_REAP_SYSCALL },
+	{ NULL,		0 }
+};
 
 void stress_set_aio_linux_requests(const char *optarg)
 {
@@ -51,13 +68,87 @@ void stress_set_aio_linux_requests(const char *optarg)
 	opt_aio_linux_requests = aio_linux_requests;
 }
 
-#if defined(__linux__) &&	\
-    defined(HAVE_LIB_AIO) &&	\
-    defined(__NR_io_setup) &&	\
-    defined(__NR_io_destroy) &&	\
-    defined(__NR_io_submit) &&	\
+void stress_set_aio_linux_contexts(const char *optarg)
+{
+	opt_aio_linux_contexts = get_uint32(optarg);
+	check_range("aiol-contexts", opt_aio_linux_contexts,
+		MIN_AIO_LINUX_CONTEXTS, MAX_AIO_LINUX_CONTEXTS);
+}
+
+void stress_set_aio_linux_bytes(const char *optarg)
+{
+	opt_aio_linux_bytes = get_uint64_byte(optarg);
+	check_range("aiol-bytes", opt_aio_linux_bytes,
+		MIN_AIO_LINUX_BYTES, MAX_AIO_LINUX_BYTES);
+}
+
+/*
+ *  stress_set_aio_linux_reap()
+ *	set the completion reaping mode
+ */
+int stress_set_aio_linux_reap(const char *name)
+{
+	const aiol_reap_t *info;
+
+	for (info = aiol_reaps; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_aio_linux_reap = info->reap;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "aiol-reap must be one of:");
+	for (info = aiol_reaps; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+#if defined(__linux__) &&		\
+    defined(HAVE_LIB_AIO) &&		\
+    defined(__NR_io_setup) &&		\
+    defined(__NR_io_destroy) &&		\
+    defined(__NR_io_submit) &&		\
     defined(__NR_io_getevents)
 
+#define AIO_RING_MAGIC		(0xa10a10a1)
+
+/*
+ *  The completion ring the kernel maps at the aio context
+ *  address that libaio hands back as the io_context_t, from
+ *  fs/aio.c; it is not in the uapi or libaio headers
+ */
+typedef struct {
+	unsigned id;			/* kernel internal index */
+	unsigned nr;			/* number of io_events */
+	unsigned head;			/* consumer index */
+	unsigned tail;			/* producer index */
+	unsigned magic;			/* AIO_RING_MAGIC */
+	unsigned compat_features;
+	unsigned incompat_features;
+	unsigned header_length;		/* size of this header */
+	struct io_event io_events[0];	/* completions */
+} aiol_ring_t;
+
+/* one request, alternately writing and reading back its block */
+typedef struct {
+	struct iocb cb;			/* the request */
+	uint8_t *buf;			/* aligned I/O buffer */
+	uint64_t offset;		/* file offset of the slot's block */
+	uint64_t start_ns;		/* submission time */
+	uint8_t seed;			/* pattern of the last write */
+} aiol_slot_t;
+
+/* an aio context with its requests */
+typedef struct {
+	io_context_t ctx;		/* libaio context */
+	aiol_slot_t *slots;		/* opt_aio_linux_requests slots */
+	struct iocb **pending;		/* requests waiting for io_submit */
+	uint32_t npending;		/* number of pending requests */
+	uint32_t inflight;		/* submitted and not yet reaped */
+} aiol_ctx_t;
+
 /*
  *  aio_linux_fill_buffer()
  *	fill buffer with some known pattern
@@ -73,6 +164,118 @@ static inline void aio_linux_fill_buffer(
 		buffer[i] = (uint8_t)(request + i);
 }
 
+/*
+ *  aio_linux_check_buffer()
+ *	count the bytes that do not match the fill pattern
+ */
+static inline uint64_t aio_linux_check_buffer(
+	const int request,
+	const uint8_t *const buffer,
+	const size_t size)
+{
+	register size_t i;
+	uint64_t bad = 0;
+
+	for (i = 0; i < size; i++)
+		bad += (buffer[i] != (uint8_t)(request + i));
+	return bad;
+}
+
+/*
+ *  aio_linux_ring_reap()
+ *	copy up to max completions straight out of the aio ring the
+ *	kernel shares with user space, no system call is needed;
+ *	returns -1 if the ring layout is not the expected one
+ */
+static int aio_linux_ring_reap(
+	const io_context_t ctx,
+	struct io_event *events,
+	const int max)
+{
+	aiol_ring_t *ring = (aiol_ring_t *)ctx;
+	unsigned head, tail;
+	int n = 0;
+
+	if ((ring->magic != AIO_RING_MAGIC) || ring->incompat_features)
+		return -1;
+
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	while ((head != tail) && (n < max)) {
+		events[n++] = ring->io_events[head];
+		head = (head + 1) % ring->nr;
+	}
+	/* the events must be copied before the kernel can reuse them */
+	__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+
+	return n;
+}
+
+/*
+ *  aio_linux_slot_prep()
+ *	set up a slot's next request, a write of a fresh pattern to
+ *	a random block of its own stripe of the file, or a read back
+ *	of the block it has just written. Each slot owns every
+ *	nslots'th block so requests in flight never overlap.
+ *	Completions are signalled on the eventfd efd.
+ */
+static void aio_linux_slot_prep(
+	aiol_slot_t *slot,
+	const int fd,
+	const int efd,
+	const bool write,
+	const uint64_t slot_index,
+	const uint64_t nslots,
+	const uint64_t stripe_blocks)
+{
+	struct iocb *cb = &slot->cb;
+
+	if (write) {
+		const uint64_t block = ((mwc64() % stripe_blocks) * nslots) +
+			slot_index;
+
+		slot->seed = mwc8();
+		slot->offset = block * BUFFER_SZ;
+		aio_linux_fill_buffer(slot->seed, slot->buf, BUFFER_SZ);
+		io_prep_pwrite(cb, fd, slot->buf, BUFFER_SZ, (long long)slot->offset);
+	} else {
+		if (opt_flags & OPT_FLAGS_VERIFY)
+			memset(slot->buf, ~slot->seed, BUFFER_SZ);
+		io_prep_pread(cb, fd, slot->buf, BUFFER_SZ, (long long)slot->offset);
+	}
+	io_set_eventfd(cb, efd);
+	cb->data = slot;
+	slot->start_ns = latency_now();
+}
+
+/*
+ *  aio_linux_setup_error()
+ *	report an io_setup failure, returns the exit status
+ */
+static int aio_linux_setup_error(const char *name)
+{
+	if ((errno == EAGAIN) || (errno == EACCES)) {
+		pr_err(stderr, "%s: io_setup failed, ran out of "
+			"available events, consider increasing "
+			"/proc/sys/fs/aio-max-nr, errno=%d (%s)\n",
+			name, errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	} else if (errno == ENOMEM) {
+		pr_err(stderr, "%s: io_setup failed, ran out of "
+			"memory, errno=%d (%s)\n",
+			name, errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	} else if (errno == ENOSYS) {
+		pr_err(stderr, "%s: io_setup failed, no io_setup "
+			"system call with this kernel, "
+			"errno=%d (%s)\n",
+			name, errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	pr_fail_err(name, "io_setup");
+	return EXIT_FAILURE;
+}
+
 /*
  *  stress_aiol
  *	stress asynchronous I/O using the linux specific aio ABI
@@ -83,10 +286,21 @@ int stress_aiol(
 	const uint64_t max_ops,
 	const char *name)
 {
-	int fd, ret, rc = EXIT_FAILURE;
+	int fd = -1, efd = -1, ret, rc = EXIT_FAILURE;
 	char filename[PATH_MAX];
 	const pid_t pid = getpid();
-	io_context_t ctx = 0;
+	const uint32_t nctxs = opt_aio_linux_contexts;
+	/* the run ends opt_timeout seconds after the stressor starts */
+	const uint64_t end_ns = opt_timeout ?
+		latency_now() + (opt_timeout * 1000000000ULL) : 0;
+	uint64_t nslots, stripe_blocks, start_ns, baddata = 0, misreads = 0;
+	uint32_t i, j, ctxs_setup = 0;
+	aiol_ctx_t *ctxs = NULL;
+	struct io_event *events = NULL;
+	uint8_t *bufs = NULL;
+	stress_latency_t wr_stats, rd_stats;
+	int reap = opt_aio_linux_reap;
+	bool direct = !!(opt_flags & OPT_FLAGS_AIOL_DIRECT);
 
 	if (!set_aio_linux_requests) {
 		if (opt_flags & OPT_FLAGS_MAXIMIZE)
@@ -99,113 +313,262 @@ int stress_aiol(
 		pr_err(stderr, "%s: iol_requests out of range", name);
 		return EXIT_FAILURE;
 	}
-	ret = io_setup(opt_aio_linux_requests, &ctx);
-	if (ret < 0) {
-		/*
-		 *  The libaio interface returns -errno in the
-		 *  return value, so set errno accordingly
-		 */
-		errno = -ret;
-		if ((errno == EAGAIN) || (errno == EACCES)) {
-			pr_err(stderr, "%s: io_setup failed, ran out of "
-				"available events, consider increasing "
-				"/proc/sys/fs/aio-max-nr, errno=%d (%s)\n",
-				name, errno, strerror(errno));
-			return EXIT_NO_RESOURCE;
-		} else if (errno == ENOMEM) {
-			pr_err(stderr, "%s: io_setup failed, ran out of "
-				"memory, errno=%d (%s)\n",
-				name, errno, strerror(errno));
-			return EXIT_NO_RESOURCE;
-		} else if (errno == ENOSYS) {
-			pr_err(stderr, "%s: io_setup failed, no io_setup "
-				"system call with this kernel, "
-				"errno=%d (%s)\n",
-				name, errno, strerror(errno));
-			return EXIT_NO_RESOURCE;
-		} else {
-			pr_fail_err(name, "io_setup");
-			return EXIT_FAILURE;
+	nslots = (uint64_t)nctxs * opt_aio_linux_requests;
+	if (opt_aio_linux_bytes < nslots * BUFFER_SZ) {
+		opt_aio_linux_bytes = nslots * BUFFER_SZ;
+		pr_inf(stderr, "%s: increasing file size to %" PRIu64
+			" bytes, one block per request\n",
+			name, opt_aio_linux_bytes);
+	}
+	stripe_blocks = opt_aio_linux_bytes / (nslots * BUFFER_SZ);
+
+	memset(&wr_stats, 0, sizeof(wr_stats));
+	memset(&rd_stats, 0, sizeof(rd_stats));
+
+	ctxs = calloc(nctxs, sizeof(*ctxs));
+	events = calloc(opt_aio_linux_requests, sizeof(*events));
+	/* O_DIRECT needs block aligned buffers */
+	ret = posix_memalign((void **)&bufs, BUFFER_SZ, nslots * BUFFER_SZ);
+	if (!ctxs || !events || ret || !bufs) {
+		pr_err(stderr, "%s: cannot allocate requests\n", name);
+		rc = EXIT_NO_RESOURCE;
+		goto free;
+	}
+	for (i = 0; i < nctxs; i++) {
+		aiol_ctx_t *c = &ctxs[i];
+
+		c->slots = calloc(opt_aio_linux_requests, sizeof(*c->slots));
+		c->pending = calloc(opt_aio_linux_requests, sizeof(*c->pending));
+		if (!c->slots || !c->pending) {
+			pr_err(stderr, "%s: cannot allocate requests\n", name);
+			rc = EXIT_NO_RESOURCE;
+			goto free;
 		}
 	}
-	ret = stress_temp_dir_mk(name, pid, instance);
-	if (ret < 0)
-		return exit_status(-ret);
+	for (i = 0; i < nctxs; i++) {
+		ret = io_setup((int)opt_aio_linux_requests, &ctxs[i].ctx);
+		if (ret < 0) {
+			/*
+			 *  The libaio interface returns -errno in the
+			 *  return value, so set errno accordingly
+			 */
+			errno = -ret;
+			rc = aio_linux_setup_error(name);
+			goto destroy;
+		}
+		ctxs_setup++;
+	}
+
+	/* all the contexts signal completions on one eventfd */
+	efd = eventfd(0, 0);
+	if (efd < 0) {
+		rc = exit_status(errno);
+		pr_fail_err(name, "eventfd");
+		goto destroy;
+	}
 
+	ret = stress_temp_dir_mk(name, pid, instance);
+	if (ret < 0) {
+		rc = exit_status(-ret);
+		goto destroy;
+	}
 	(void)stress_temp_filename(filename, sizeof(filename),
 		name, pid, instance, mwc32());
 
 	(void)umask(0077);
-	if ((fd = open(filename, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR)) < 0) {
+	fd = open(filename, O_CREAT | O_RDWR | (direct ? O_DIRECT : 0),
+		S_IRUSR | S_IWUSR);
+	if ((fd < 0) && direct && (errno == EINVAL)) {
+		pr_inf(stderr, "%s: O_DIRECT not supported on this file "
+			"system, using buffered I/O\n", name);
+		direct = false;
+		fd = open(filename, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+	}
+	if (fd < 0) {
 		rc = exit_status(errno);
 		pr_fail_err(name, "open");
-		goto finish;
+		goto rm;
 	}
 	(void)unlink(filename);
+	if (ftruncate(fd, (off_t)opt_aio_linux_bytes) < 0) {
+		rc = exit_status(errno);
+		pr_fail_err(name, "ftruncate");
+		goto close;
+	}
+	pr_dbg(stderr, "%s: %" PRIu32 " contexts of %" PRIu32 " requests, "
+		"%s I/O, %s reaping\n", name, nctxs, opt_aio_linux_requests,
+		direct ? "direct" : "buffered",
+		aiol_reaps[reap].name);
+
+	for (i = 0; i < nctxs; i++) {
+		aiol_ctx_t *c = &ctxs[i];
+
+		for (j = 0; j < opt_aio_linux_requests; j++) {
+			const uint64_t n = ((uint64_t)i * opt_aio_linux_requests) + j;
+			aiol_slot_t *slot = &c->slots[j];
 
-	do {
-		struct iocb cb[opt_aio_linux_requests];
-		struct iocb *cbs[opt_aio_linux_requests];
-		struct io_event events[opt_aio_linux_requests];
-		uint8_t buffers[opt_aio_linux_requests][BUFFER_SZ];
-		uint32_t i;
-		long n;
-
-		for (i = 0; i < opt_aio_linux_requests; i++)
-			aio_linux_fill_buffer(i, buffers[i], BUFFER_SZ);
-
-		memset(cb, 0, sizeof(cb));
-		for (i = 0; i < opt_aio_linux_requests; i++) {
-			cb[i].aio_fildes = fd;
-			cb[i].aio_lio_opcode = IO_CMD_PWRITE;
-			cb[i].u.c.buf = buffers[i];
-			cb[i].u.c.offset = mwc16() * BUFFER_SZ;
-			cb[i].u.c.nbytes = BUFFER_SZ;
-			cbs[i] = &cb[i];
+			slot->buf = bufs + (n * BUFFER_SZ);
+			aio_linux_slot_prep(slot, fd, efd, true, n, nslots,
+				stripe_blocks);
+			c->pending[c->npending++] = &slot->cb;
 		}
-		ret = io_submit(ctx, (long)opt_aio_linux_requests, cbs);
-		if (ret < 0) {
-			errno = -ret;
-			if (errno == EAGAIN)
+	}
+
+	start_ns = latency_now();
+	for (;;) {
+		const bool run = opt_do_run && (!max_ops || *counter < max_ops);
+		uint32_t inflight = 0, pending = 0;
+		int reaped = 0;
+
+		/* submit each context's pending requests in one go */
+		for (i = 0; i < nctxs; i++) {
+			aiol_ctx_t *c = &ctxs[i];
+
+			if (!run || !c->npending)
 				continue;
-			pr_fail_err(name, "io_submit");
-			break;
+			ret = io_submit(c->ctx, (long)c->npending, c->pending);
+			if (ret < 0) {
+				errno = -ret;
+				if ((errno == EAGAIN) || (errno == EINTR))
+					continue;
+				pr_fail_err(name, "io_submit");
+				goto close;
+			}
+			c->npending -= (uint32_t)ret;
+			c->inflight += (uint32_t)ret;
+			if (c->npending)
+				memmove(c->pending, c->pending + ret,
+					c->npending * sizeof(*c->pending));
 		}
 
-		n = opt_aio_linux_requests;
-		do {
-			struct timespec timeout, *timeout_ptr;
-
-			if (clock_gettime(CLOCK_REALTIME, &timeout) < 0) {
-				timeout_ptr = NULL;
-			} else {
-				timeout.tv_nsec += 1000000;
-				if (timeout.tv_nsec > 1000000000) {
-					timeout.tv_nsec -= 1000000000;
-					timeout.tv_sec++;
+		/* reap whatever has completed in every context */
+		for (i = 0; i < nctxs; i++) {
+			aiol_ctx_t *c = &ctxs[i];
+			int n = -1;
+
+			if (!c->inflight)
+				continue;
+			if (reap == AIOL_REAP_RING) {
+				n = aio_linux_ring_reap(c->ctx, events,
+					(int)opt_aio_linux_requests);
+				if (n < 0) {
+					pr_inf(stderr, "%s: unexpected aio ring "
+						"layout, reaping with "
+						"io_getevents\n", name);
+					reap = AIOL_REAP_SYSCALL;
 				}
-				timeout_ptr = &timeout;
 			}
+			if (n < 0) {
+				struct timespec timeout = { 0, 0 };
 
-			ret = io_getevents(ctx, 1, n, events, timeout_ptr);
-			if (ret < 0) {
-				errno = -ret;
-				if ((errno == EINTR) && (opt_do_run))
-					continue;
-				pr_fail_err(name, "io_getevents");
-				break;
-			} else {
-				n -= ret;
+				n = io_getevents(c->ctx, 0,
+					(long)opt_aio_linux_requests,
+					events, &timeout);
+				if (n < 0) {
+					errno = -n;
+					if (errno == EINTR)
+						continue;
+					pr_fail_err(name, "io_getevents");
+					goto close;
+				}
 			}
-		} while ((n > 0) && opt_do_run);
-		(*counter)++;
-	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+			for (j = 0; j < (uint32_t)n; j++) {
+				aiol_slot_t *slot = (aiol_slot_t *)events[j].data;
+				const bool write = (slot->cb.aio_lio_opcode == IO_CMD_PWRITE);
+				const uint64_t now = latency_now();
+				const uint64_t ns = now - slot->start_ns;
+				const long res = (long)events[j].res;
+
+				if (res < 0) {
+					pr_fail_errno(name, write ?
+						"aio write" : "aio read", (int)-res);
+					goto close;
+				}
+				if (res != BUFFER_SZ)
+					misreads++;
+				if (write) {
+					latency_add(&wr_stats, ns, (uint64_t)res);
+				} else {
+					latency_add(&rd_stats, ns, (uint64_t)res);
+					if (opt_flags & OPT_FLAGS_VERIFY)
+						baddata += aio_linux_check_buffer(
+							slot->seed, slot->buf, BUFFER_SZ);
+				}
+				/*
+				 *  io_destroy() waits for the requests still in
+				 *  flight, so only reissue a request while it
+				 *  should complete before the end of the run
+				 */
+				if (run && (!end_ns || (now + ns < end_ns))) {
+					aio_linux_slot_prep(slot, fd, efd, !write,
+						((uint64_t)i * opt_aio_linux_requests) +
+						(uint64_t)(slot - c->slots),
+						nslots, stripe_blocks);
+					c->pending[c->npending++] = &slot->cb;
+				}
+				(*counter)++;
+			}
+			c->inflight -= (uint32_t)n;
+			reaped += n;
+		}
+
+		for (i = 0; i < nctxs; i++) {
+			inflight += ctxs[i].inflight;
+			pending += ctxs[i].npending;
+		}
+		/* once stopped, drain the requests in flight */
+		if (!inflight && (!run || !pending))
+			break;
+
+		/* nothing ready, sleep until any context completes a request */
+		if (!reaped && inflight) {
+			uint64_t val;
+
+			if ((read(efd, &val, sizeof(val)) < 0) &&
+			    (errno != EINTR)) {
+				pr_fail_err(name, "eventfd read");
+				goto close;
+			}
+		}
+	}
 
 	rc = EXIT_SUCCESS;
+
+	if (misreads)
+		pr_dbg(stderr, "%s: %" PRIu64 " incomplete I/Os\n",
+			name, misreads);
+	if (baddata)
+		pr_fail(stderr, "%s: incorrect data found %"
+			PRIu64 " times\n", name, baddata);
+
+	/* writes and reads run interleaved, so both span the whole run */
+	wr_stats.duration = rd_stats.duration =
+		(double)(latency_now() - start_ns) / 1000000000.0;
+close:
 	(void)close(fd);
-finish:
-	(void)io_destroy(ctx);
+rm:
 	(void)stress_temp_dir_rm(name, pid, instance);
+destroy:
+	/* io_destroy waits for any requests still in flight */
+	for (i = 0; i < ctxs_setup; i++)
+		(void)io_destroy(ctxs[i].ctx);
+	if (efd >= 0)
+		(void)close(efd);
+	latency_report(name, instance, "write", &wr_stats);
+	latency_report(name, instance, "read", &rd_stats);
+	latency_merge("write", &wr_stats);
+	latency_merge("read", &rd_stats);
+free:
+	if (ctxs) {
+		for (i = 0; i < nctxs; i++) {
+			free(ctxs[i].pending);
+			free(ctxs[i].slots);
+		}
+	}
+	free(bufs);
+	free(events);
+	free(ctxs);
 	return rc;
 }
 #else
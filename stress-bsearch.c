@@ -24,8 +24,46 @@
  */
 #include "stress-ng.h"
 
+#if defined(__x86_64__) && defined(__SSE2__)
+#define STRESS_BSEARCH_SSE2	(1)
+#include <emmintrin.h>
+#endif
+
+#define BSEARCH_METHOD_LIBC	(0)		/* libc bsearch(3) */
+#define BSEARCH_METHOD_BRANCHLESS (1)		/* branchless lower bound */
+#define BSEARCH_METHOD_EYTZINGER (2)		/* BFS layout */
+#define BSEARCH_METHOD_BTREE	(3)		/* implicit B-tree layout */
+#define BSEARCH_METHODS		(4)
+#define BSEARCH_METHOD_ALL	(4)		/* cycle through all the methods */
+
+#define BSEARCH_QUERIES		(64 * 1024)	/* keys looked up, cycled */
+#define BSEARCH_B		(16)		/* keys per B-tree node */
+#define BSEARCH_LINE		(64)		/* cache line size */
+
+typedef struct {
+	const char *name;		/* method name */
+	const int method;		/* BSEARCH_METHOD_* */
+} bsearch_method_info_t;
+
+static const bsearch_method_info_t bsearch_methods[] = {
+	{ "libc",	BSEARCH_METHOD_LIBC },
+	{ "branchless",	BSEARCH_METHOD_BRANCHLESS },
+	{ "eytzinger",	BSEARCH_METHOD_EYTZINGER },
+	{ "btree",	BSEARCH_METHOD_BTREE },
+	{ "all",	BSEARCH_METHOD_ALL },
+	{ NULL,		0 }
+};
+
+/* per method totals */
+typedef struct {
+	uint64_t lookups;		/* lookups timed */
+	double duration;		/* time taken by the lookups */
+	size_t bytes;			/* size of the layout */
+} bsearch_stats_t;
+
 static uint64_t opt_bsearch_size = DEFAULT_BSEARCH_SIZE;
 static bool set_bsearch_size = false;
+static int opt_bsearch_method = BSEARCH_METHOD_LIBC;
 
 /*
  *  stress_set_bsearch_size()
@@ -39,6 +77,29 @@ void stress_set_bsearch_size(const char *optarg)
 		MIN_BSEARCH_SIZE, MAX_BSEARCH_SIZE);
 }
 
+/*
+ *  stress_set_bsearch_method()
+ *	set the search method and array layout
+ */
+int stress_set_bsearch_method(const char *name)
+{
+	const bsearch_method_info_t *info;
+
+	for (info = bsearch_methods; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_bsearch_method = info->method;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "bsearch-method must be one of:");
+	for (info = bsearch_methods; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
 /*
  *  cmp()
  *	compare int32 values for bsearch
@@ -65,6 +126,162 @@ static int cmp(const void *p1, const void *p2)
 	prev = d[i];			\
 	i++;				\
 
+/*
+ *  bsearch_branchless()
+ *	lower bound search where the halving step is a
+ *	conditional move rather than a branch, the two
+ *	possible next probes are prefetched
+ */
+static inline const int32_t *bsearch_branchless(
+	const int32_t *data,
+	const size_t n,
+	const int32_t key)
+{
+	const int32_t *base = data;
+	size_t len = n;
+
+	while (len > 1) {
+		const size_t half = len / 2;
+
+		__builtin_prefetch(base + (len / 4));
+		__builtin_prefetch(base + half + (len / 4));
+		base = (base[half] < key) ? base + half : base;
+		len -= half;
+	}
+	base += (*base < key);
+
+	return ((base < data + n) && (*base == key)) ? base : NULL;
+}
+
+/*
+ *  bsearch_eytzinger_build()
+ *	lay the sorted data out in BFS order, e[1] is the
+ *	root and the children of e[k] are e[2k] and e[2k + 1]
+ */
+static size_t bsearch_eytzinger_build(
+	int32_t *e,
+	const int32_t *data,
+	const size_t n,
+	size_t i,
+	const size_t k)
+{
+	if (k <= n) {
+		i = bsearch_eytzinger_build(e, data, n, i, 2 * k);
+		e[k] = data[i++];
+		i = bsearch_eytzinger_build(e, data, n, i, (2 * k) + 1);
+	}
+	return i;
+}
+
+/*
+ *  bsearch_eytzinger()
+ *	descend the BFS layout, the 16 descendants four
+ *	levels down share a cache line and are prefetched,
+ *	the lower bound is where the last right turn was
+ */
+static inline const int32_t *bsearch_eytzinger(
+	const int32_t *e,
+	const size_t n,
+	const int32_t key)
+{
+	size_t k = 1;
+
+	while (k <= n) {
+		__builtin_prefetch(e + (k * BSEARCH_B));
+		k = (2 * k) + (e[k] < key);
+	}
+	k >>= __builtin_ffsl((long)~k);
+
+	return (k && (e[k] == key)) ? &e[k] : NULL;
+}
+
+/*
+ *  bsearch_btree_child()
+ *	index of child i of B-tree node k
+ */
+static inline size_t bsearch_btree_child(const size_t k, const uint32_t i)
+{
+	return (k * (BSEARCH_B + 1)) + i + 1;
+}
+
+/*
+ *  bsearch_btree_build()
+ *	in-order fill of an implicit B-tree of cache line
+ *	sized nodes, unused keys are INT32_MAX
+ */
+static size_t bsearch_btree_build(
+	int32_t *bt,
+	const size_t nodes,
+	const int32_t *data,
+	const size_t n,
+	size_t i,
+	const size_t k)
+{
+	uint32_t j;
+
+	if (k >= nodes)
+		return i;
+
+	for (j = 0; j < BSEARCH_B; j++) {
+		i = bsearch_btree_build(bt, nodes, data, n, i,
+			bsearch_btree_child(k, j));
+		bt[(k * BSEARCH_B) + j] = (i < n) ? data[i++] : INT32_MAX;
+	}
+	return bsearch_btree_build(bt, nodes, data, n, i,
+		bsearch_btree_child(k, BSEARCH_B));
+}
+
+/*
+ *  bsearch_btree_rank()
+ *	number of keys in a node less than key
+ */
+static inline uint32_t bsearch_btree_rank(const int32_t *node, const int32_t key)
+{
+#if defined(STRESS_BSEARCH_SSE2)
+	const __m128i k = _mm_set1_epi32(key);
+	const __m128i *v = (const __m128i *)node;
+	const __m128i m01 = _mm_packs_epi32(
+		_mm_cmpgt_epi32(k, _mm_load_si128(v + 0)),
+		_mm_cmpgt_epi32(k, _mm_load_si128(v + 1)));
+	const __m128i m23 = _mm_packs_epi32(
+		_mm_cmpgt_epi32(k, _mm_load_si128(v + 2)),
+		_mm_cmpgt_epi32(k, _mm_load_si128(v + 3)));
+
+	return (uint32_t)__builtin_popcount(
+		_mm_movemask_epi8(_mm_packs_epi16(m01, m23)));
+#else
+	uint32_t i, rank = 0;
+
+	for (i = 0; i < BSEARCH_B; i++)
+		rank += (node[i] < key);
+	return rank;
+#endif
+}
+
+/*
+ *  bsearch_btree()
+ *	descend the B-tree one cache line per level,
+ *	remembering the smallest key >= key seen
+ */
+static inline const int32_t *bsearch_btree(
+	const int32_t *bt,
+	const size_t nodes,
+	const int32_t key)
+{
+	const int32_t *res = NULL;
+	size_t k = 0;
+
+	while (k < nodes) {
+		const int32_t *node = bt + (k * BSEARCH_B);
+		const uint32_t i = bsearch_btree_rank(node, key);
+
+		if (i < BSEARCH_B)
+			res = &node[i];
+		k = bsearch_btree_child(k, i);
+	}
+	return (res && (*res == key)) ? res : NULL;
+}
+
 /*
  *  stress_bsearch()
  *	stress bsearch
@@ -75,14 +292,16 @@ int stress_bsearch(
 	const uint64_t max_ops,
 	const char *name)
 {
-	int32_t *data, *ptr, prev = 0;
-	size_t n, n8, i;
-
-	(void)instance;
+	bsearch_stats_t stats[BSEARCH_METHODS];
+	int32_t *data, *eytz = NULL, *btree = NULL, prev = 0;
+	int32_t *queries;
+	size_t n, n8, i, nodes = 0;
+	int method, ret = EXIT_NO_RESOURCE;
+	void *ptr;
 
 	if (!set_bsearch_size) {
 		if (opt_flags & OPT_FLAGS_MAXIMIZE)
-			opt_bsearch_size = MAX_BSEARCH_SIZE;
+			opt_bsearch_size = MAXIMIZE_BSEARCH_SIZE;
 		if (opt_flags & OPT_FLAGS_MINIMIZE)
 			opt_bsearch_size = MIN_BSEARCH_SIZE;
 	}
@@ -94,6 +313,10 @@ int stress_bsearch(
 		pr_fail_dbg(name, "malloc");
 		return EXIT_NO_RESOURCE;
 	}
+	if ((queries = calloc(BSEARCH_QUERIES, sizeof(int32_t))) == NULL) {
+		pr_fail_dbg(name, "malloc");
+		goto tidy;
+	}
 
 	/* Populate with ascending data */
 	prev = 0;
@@ -110,26 +333,107 @@ int stress_bsearch(
 		SETDATA(data, i, v, prev);
 	}
 
+	/* Keys of random elements, small enough to stay in cache */
+	for (i = 0; i < BSEARCH_QUERIES; i++)
+		queries[i] = data[mwc64() % n];
+
+	memset(stats, 0, sizeof(stats));
+	stats[BSEARCH_METHOD_LIBC].bytes = n * sizeof(*data);
+	stats[BSEARCH_METHOD_BRANCHLESS].bytes = n * sizeof(*data);
+
+	if ((opt_bsearch_method == BSEARCH_METHOD_ALL) ||
+	    (opt_bsearch_method == BSEARCH_METHOD_EYTZINGER)) {
+		if (posix_memalign(&ptr, BSEARCH_LINE, (n + 1) * sizeof(*eytz))) {
+			pr_fail_dbg(name, "posix_memalign");
+			goto tidy;
+		}
+		eytz = (int32_t *)ptr;
+		eytz[0] = INT32_MIN;
+		(void)bsearch_eytzinger_build(eytz, data, n, 0, 1);
+		stats[BSEARCH_METHOD_EYTZINGER].bytes = (n + 1) * sizeof(*eytz);
+	}
+	if ((opt_bsearch_method == BSEARCH_METHOD_ALL) ||
+	    (opt_bsearch_method == BSEARCH_METHOD_BTREE)) {
+		nodes = (n + BSEARCH_B - 1) / BSEARCH_B;
+		if (posix_memalign(&ptr, BSEARCH_LINE,
+		    nodes * BSEARCH_B * sizeof(*btree))) {
+			pr_fail_dbg(name, "posix_memalign");
+			goto tidy;
+		}
+		btree = (int32_t *)ptr;
+		(void)bsearch_btree_build(btree, nodes, data, n, 0, 0);
+		stats[BSEARCH_METHOD_BTREE].bytes = nodes * BSEARCH_B * sizeof(*btree);
+	}
+
+	ret = EXIT_SUCCESS;
+	method = (opt_bsearch_method == BSEARCH_METHOD_ALL) ?
+		BSEARCH_METHOD_LIBC : opt_bsearch_method;
 	do {
-		for (ptr = data, i = 0; i < n; i++, ptr++) {
-			int32_t *result;
-			result = bsearch(ptr, data, n, sizeof(*ptr), cmp);
+		double t = time_now();
+
+		for (i = 0; i < n; i++) {
+			const int32_t *key = &queries[i & (BSEARCH_QUERIES - 1)];
+			const int32_t *result;
+
+			switch (method) {
+			case BSEARCH_METHOD_BRANCHLESS:
+				result = bsearch_branchless(data, n, *key);
+				break;
+			case BSEARCH_METHOD_EYTZINGER:
+				result = bsearch_eytzinger(eytz, n, *key);
+				break;
+			case BSEARCH_METHOD_BTREE:
+				result = bsearch_btree(btree, nodes, *key);
+				break;
+			default:
+				result = bsearch(key, data, n, sizeof(*key), cmp);
+				break;
+			}
 			if (opt_flags & OPT_FLAGS_VERIFY) {
 				if (result == NULL)
 					pr_fail(stderr,
-						"%s: element %zu could "
-						"not be found\n",
-						name, i);
-				else if (*result != *ptr)
-					pr_fail(stderr, "%s: element %zu "
-						"found %" PRIu32
-						", expecting %" PRIu32 "\n",
-						name, i, *result, *ptr);
+						"%s: %s could not find "
+						"%" PRId32 "\n", name,
+						bsearch_methods[method].name, *key);
+				else if (*result != *key)
+					pr_fail(stderr, "%s: %s found %" PRId32
+						", expecting %" PRId32 "\n",
+						name, bsearch_methods[method].name,
+						*result, *key);
+			}
+			if (((i & (BSEARCH_QUERIES - 1)) == 0) && !opt_do_run) {
+				i++;
+				break;
 			}
 		}
+		stats[method].duration += time_now() - t;
+		stats[method].lookups += i;
+
 		(*counter)++;
+		if (opt_bsearch_method == BSEARCH_METHOD_ALL)
+			method = (method + 1) % BSEARCH_METHODS;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
 
+	if (instance == 0) {
+		for (method = 0; method < BSEARCH_METHODS; method++) {
+			const bsearch_stats_t *s = &stats[method];
+
+			if (!s->lookups || (s->duration <= 0.0))
+				continue;
+			pr_inf(stderr, "%s: %-10s %9.2f M lookups/sec, %7.2f ns/lookup, "
+				"%zu elements, %.2f MB\n", name,
+				bsearch_methods[method].name,
+				(double)s->lookups / (s->duration * 1000000.0),
+				(s->duration * 1000000000.0) / (double)s->lookups,
+				n, (double)s->bytes / (double)MB);
+		}
+	}
+
+tidy:
+	free(btree);
+	free(eytz);
+	free(queries);
 	free(data);
-	return EXIT_SUCCESS;
+
+	return ret;
 }
@@ -49,6 +49,273 @@
 			break;						\
 	}
 
+#if defined(__linux__) && defined(HAVE_LIB_PTHREAD)
+
+#define CACHE_PINGPONG_WARMUP	(1000)		/* untimed round trips */
+#define CACHE_PINGPONG_ROUNDS	(10000)		/* timed round trips */
+#define CACHE_PINGPONG_ALIGN	(128)		/* keep off adjacent lines */
+
+typedef struct {
+	volatile uint64_t *line;	/* cache line bounced between the pair */
+	uint32_t cpu;			/* CPU to pin to */
+	uint64_t turn;			/* value that hands this thread the line */
+	double duration;		/* timed round trips duration */
+	bool ok;			/* completed all round trips */
+} cache_pingpong_t;
+
+static sigset_t cache_pingpong_set;
+static volatile bool cache_pingpong_abort;
+
+/*
+ *  stress_cache_pingpong_thread()
+ *	pin to a CPU and swap the cache line with the other
+ *	thread of the pair using an atomic compare and swap
+ */
+static void *stress_cache_pingpong_thread(void *arg)
+{
+	static void *nowt = NULL;
+	cache_pingpong_t *pp = (cache_pingpong_t *)arg;
+	volatile uint64_t *line = pp->line;
+	const uint64_t turn = pp->turn;
+	cpu_set_t mask;
+	double t = 0.0;
+	uint64_t i;
+
+	(void)sigprocmask(SIG_BLOCK, &cache_pingpong_set, NULL);
+
+	CPU_ZERO(&mask);
+	CPU_SET(pp->cpu, &mask);
+	if (sched_setaffinity(0, sizeof(mask), &mask) < 0) {
+		cache_pingpong_abort = true;
+		return &nowt;
+	}
+
+	for (i = 0; i < CACHE_PINGPONG_WARMUP + CACHE_PINGPONG_ROUNDS; i++) {
+		if (i == CACHE_PINGPONG_WARMUP)
+			t = time_now();
+		while (!__sync_bool_compare_and_swap(line, turn, turn ^ 1)) {
+			if (!opt_do_run || cache_pingpong_abort)
+				return &nowt;
+		}
+	}
+	pp->duration = time_now() - t;
+	pp->ok = true;
+
+	return &nowt;
+}
+
+/*
+ *  stress_cache_pingpong_pair()
+ *	measure the average round trip time in nanoseconds of
+ *	a cache line bounced between CPUs cpu1 and cpu2, returns
+ *	a negative value if the pair could not be measured
+ */
+static double stress_cache_pingpong_pair(
+	volatile uint64_t *line,
+	const uint32_t cpu1,
+	const uint32_t cpu2)
+{
+	pthread_t pthreads[2];
+	cache_pingpong_t pp[2];
+	int ret[2] = { -1, -1 };
+	size_t i;
+
+	*line = 0;
+	cache_pingpong_abort = false;
+	memset(pp, 0, sizeof(pp));
+	for (i = 0; i < 2; i++) {
+		pp[i].line = line;
+		pp[i].cpu = i ? cpu2 : cpu1;
+		pp[i].turn = i;
+		ret[i] = pthread_create(&pthreads[i], NULL,
+			stress_cache_pingpong_thread, &pp[i]);
+		if (ret[i])
+			break;
+	}
+	if ((ret[0] == 0) && ret[1]) {
+		/* the other thread never started, so stop the first */
+		cache_pingpong_abort = true;
+	}
+	for (i = 0; i < 2; i++) {
+		if (ret[i] == 0)
+			(void)pthread_join(pthreads[i], NULL);
+	}
+	if (ret[0] || ret[1] || !pp[0].ok || !pp[1].ok)
+		return -1.0;
+
+	/* the first thread's iterations span whole round trips */
+	return (pp[0].duration * 1000000000.0) / CACHE_PINGPONG_ROUNDS;
+}
+
+/*
+ *  stress_cache_pingpong_report()
+ *	dump the CPU round trip matrix and the average latency
+ *	for SMT siblings, CPUs in the same package and CPUs in
+ *	different packages
+ */
+static void stress_cache_pingpong_report(
+	const char *name,
+	const uint32_t *cpu,
+	const uint32_t n,
+	const double *ns)
+{
+	static const char *classes[] = {
+		"SMT siblings", "same package", "cross package"
+	};
+	double sum[3] = { 0.0, 0.0, 0.0 };
+	uint32_t count[3] = { 0, 0, 0 };
+	cpus_t *cpu_caches = get_all_cpu_cache_details();
+	char buf[16 + 8 * n];
+	uint32_t i, j;
+	size_t len;
+
+	pr_inf(stderr, "%s: cache line CAS round trip latency (ns), "
+		"minimum of all passes:\n", name);
+	len = snprintf(buf, sizeof(buf), "%6s", "CPU");
+	for (j = 0; (j < n) && (len < sizeof(buf)); j++)
+		len += snprintf(buf + len, sizeof(buf) - len,
+			" %7" PRIu32, cpu[j]);
+	pr_inf(stderr, "%s: %s\n", name, buf);
+
+	for (i = 0; i < n; i++) {
+		len = snprintf(buf, sizeof(buf), "%6" PRIu32, cpu[i]);
+		/* wide latencies truncate the row rather than overflow it */
+		for (j = 0; (j < n) && (len < sizeof(buf)); j++) {
+			const double t = ns[(i * n) + j];
+
+			if (t < 0.0)
+				len += snprintf(buf + len, sizeof(buf) - len,
+					" %7s", "-");
+			else
+				len += snprintf(buf + len, sizeof(buf) - len,
+					" %7.1f", t);
+		}
+		pr_inf(stderr, "%s: %s\n", name, buf);
+	}
+
+	if (!cpu_caches)
+		return;
+	for (i = 0; i < n; i++) {
+		const cpu_t *c1 = get_cpu_by_num(cpu_caches, cpu[i]);
+
+		for (j = 0; j < n; j++) {
+			const cpu_t *c2 = get_cpu_by_num(cpu_caches, cpu[j]);
+			const double t = ns[(i * n) + j];
+			int class;
+
+			if (!c1 || !c2 || (t < 0.0))
+				continue;
+			if (CPU_ISSET(cpu[j], &c1->siblings))
+				class = 0;
+			else if (c1->package == c2->package)
+				class = 1;
+			else
+				class = 2;
+			sum[class] += t;
+			count[class]++;
+		}
+	}
+	for (i = 0; i < SIZEOF_ARRAY(classes); i++) {
+		if (count[i])
+			pr_inf(stderr, "%s: %-13s %7.1f ns average over "
+				"%" PRIu32 " CPU pairs\n", name, classes[i],
+				sum[i] / count[i], count[i]);
+	}
+	free_cpu_caches(cpu_caches);
+}
+
+/*
+ *  stress_cache_pingpong()
+ *	pin a pair of threads on every pair of allowed CPUs and
+ *	bounce a single cache line between them, each CPU pair
+ *	measured is one bogo op
+ */
+static int stress_cache_pingpong(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	const uint32_t cpus = stress_get_processors_configured();
+	cpu_set_t proc_mask;
+	uint32_t *cpu, n = 0, i, j;
+	double *ns;
+	void *line;
+	bool measured = false;
+
+	if (sched_getaffinity(0, sizeof(proc_mask), &proc_mask) < 0) {
+		pr_fail_err(name, "sched_getaffinity");
+		return EXIT_FAILURE;
+	}
+	if (CPU_COUNT(&proc_mask) < 2) {
+		if (instance == 0)
+			pr_inf(stderr, "%s: cache ping-pong needs at least "
+				"2 CPUs, skipping stressor\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+
+	cpu = calloc(cpus, sizeof(*cpu));
+	if (!cpu) {
+		pr_err(stderr, "%s: cannot allocate CPU list\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+	for (i = 0; (i < cpus) && (i < CPU_SETSIZE); i++) {
+		if (CPU_ISSET(i, &proc_mask))
+			cpu[n++] = i;
+	}
+	ns = calloc((size_t)n * n, sizeof(*ns));
+	if (!ns) {
+		pr_err(stderr, "%s: cannot allocate latency matrix\n", name);
+		free(cpu);
+		return EXIT_NO_RESOURCE;
+	}
+	if (posix_memalign(&line, CACHE_PINGPONG_ALIGN, CACHE_PINGPONG_ALIGN)) {
+		pr_err(stderr, "%s: cannot allocate cache line\n", name);
+		free(ns);
+		free(cpu);
+		return EXIT_NO_RESOURCE;
+	}
+	for (i = 0; i < n * n; i++)
+		ns[i] = -1.0;
+
+	if (instance == 0)
+		pr_dbg(stderr, "%s: measuring cache line round trips "
+			"between %" PRIu32 " CPUs\n", name, n);
+
+	(void)sigfillset(&cache_pingpong_set);
+	do {
+		for (i = 0; i < n; i++) {
+			for (j = i + 1; j < n; j++) {
+				double t;
+
+				t = stress_cache_pingpong_pair(line, cpu[i], cpu[j]);
+				if (!opt_do_run)
+					goto done;
+				if (t < 0.0)
+					continue;
+				if ((ns[(i * n) + j] < 0.0) || (t < ns[(i * n) + j])) {
+					ns[(i * n) + j] = t;
+					ns[(j * n) + i] = t;
+				}
+				measured = true;
+				(*counter)++;
+				if (max_ops && (*counter >= max_ops))
+					goto done;
+			}
+		}
+	} while (opt_do_run && (!max_ops || *counter < max_ops));
+done:
+	if ((instance == 0) && measured)
+		stress_cache_pingpong_report(name, cpu, n, ns);
+
+	free(line);
+	free(ns);
+	free(cpu);
+
+	return EXIT_SUCCESS;
+}
+#endif
+
 /*
  *  stress_cache()
  *	stress cache by psuedo-random memory read/writes and
@@ -73,6 +340,11 @@ int stress_cache(
 	uint8_t *const mem_cache = shared->mem_cache;
 	const uint64_t mem_cache_size = shared->mem_cache_size;
 
+#if defined(__linux__) && defined(HAVE_LIB_PTHREAD)
+	if (opt_flags & OPT_FLAGS_CACHE_PINGPONG)
+		return stress_cache_pingpong(counter, instance, max_ops, name);
+#endif
+
 	if (instance == 0)
 		pr_dbg(stderr, "%s: using cache buffer size of %" PRIu64 "K\n",
 			name, mem_cache_size / 1024);
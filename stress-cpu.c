@@ -57,6 +57,23 @@
 #define cabsl	cabs
 #endif
 
+/* Hardware accelerated hash and crypto instructions */
+#if defined(__x86_64__) && NEED_GNUC(4,9,0) && !defined(__clang__)
+#define STRESS_CPU_ACCEL_X86	(1)
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define STRESS_CPU_ACCEL_ARM_CRC32	(1)
+#include <arm_acle.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#define STRESS_CPU_ACCEL_ARM_CRYPTO	(1)
+#include <arm_neon.h>
+#endif
+
 /*
  *  the CPU stress test has different classes of cpu stressor
  */
@@ -73,6 +90,8 @@ typedef struct {
  *	= 0   - random duration between 0..0.5 seconds
  *	> 0   - milliseconds per busy slice
  */
+#define STRESS_CPU_LOAD_PERIOD	(0.1)	/* seconds, busy + idle period */
+
 static int32_t opt_cpu_load_slice = -64;
 static int32_t opt_cpu_load = 100;
 static const stress_cpu_stressor_info_t *opt_cpu_stressor;
@@ -92,7 +111,7 @@ void stress_set_cpu_load(const char *optarg) {
 void stress_set_cpu_load_slice(const char *optarg)
 {
 	opt_cpu_load_slice = get_int32(optarg);
-	if ((opt_cpu_load < -5000) || (opt_cpu_load > 5000)) {
+	if ((opt_cpu_load_slice < -5000) || (opt_cpu_load_slice > 5000)) {
 		fprintf(stderr, "CPU load must in the range -5000 to 5000.\n");
 		exit(EXIT_FAILURE);
 	}
@@ -1347,6 +1366,786 @@ static void stress_cpu_crc16(const char *name)
 		uint64_put(ccitt_crc16(buffer, i));
 }
 
+/*
+ *  Hardware accelerated hash and crypto methods. Each method
+ *  processes STRESS_CPU_ACCEL_LOOPS passes over a 4K buffer
+ *  using the CPU's CRC32C, AES, SHA256 and carry-less multiply
+ *  instructions if they are available, otherwise a portable
+ *  software implementation is used instead.  Throughput is
+ *  accounted per method and reported at the end of the run.
+ */
+#define STRESS_CPU_ACCEL_BUF	(4096)
+#define STRESS_CPU_ACCEL_LOOPS	(16)
+
+enum {
+	STRESS_CPU_ACCEL_CRC32C = 0,
+	STRESS_CPU_ACCEL_AES,
+	STRESS_CPU_ACCEL_SHA256,
+	STRESS_CPU_ACCEL_CLMUL,
+	STRESS_CPU_ACCEL_MAX
+};
+
+typedef struct {
+	const char *name;	/* method name */
+	uint64_t bytes;		/* bytes processed */
+	double duration;	/* time spent processing bytes */
+	bool hw;		/* true if hardware accelerated */
+} stress_cpu_accel_t;
+
+static stress_cpu_accel_t accel[STRESS_CPU_ACCEL_MAX] = {
+	{ "crc32c",	0, 0.0, false },
+	{ "aes",	0, 0.0, false },
+	{ "sha256",	0, 0.0, false },
+	{ "clmul",	0, 0.0, false },
+};
+
+static uint8_t accel_buffer[STRESS_CPU_ACCEL_BUF] ALIGN64;
+static bool accel_init = false;
+
+#if defined(STRESS_CPU_ACCEL_X86)
+#define TARGET_CRC32	__attribute__((target("sse4.2")))
+#define TARGET_AES	__attribute__((target("aes,sse2")))
+#define TARGET_SHA	__attribute__((target("sha,sse4.1,ssse3")))
+#define TARGET_PCLMUL	__attribute__((target("pclmul,sse2")))
+#endif
+
+/*
+ *  stress_cpu_accel_probe()
+ *	determine which hash and crypto instructions are
+ *	available and fill the shared buffer with random data
+ */
+static void stress_cpu_accel_probe(void)
+{
+	if (accel_init)
+		return;
+
+#if defined(STRESS_CPU_ACCEL_X86)
+	{
+		uint32_t eax, ebx, ecx, edx, max;
+
+		__cpuid(0, max, ebx, ecx, edx);
+		__cpuid(1, eax, ebx, ecx, edx);
+		accel[STRESS_CPU_ACCEL_CRC32C].hw = !!(ecx & (1 << 20));  /* SSE4.2 */
+		accel[STRESS_CPU_ACCEL_AES].hw = !!(ecx & (1 << 25));	  /* AES-NI */
+		accel[STRESS_CPU_ACCEL_CLMUL].hw = !!(ecx & (1 << 1));	  /* PCLMULQDQ */
+		if (max >= 7) {
+			/* SHA-NI plus SSSE3 and SSE4.1 for the shuffles and blends */
+			const bool sse = (ecx & (1 << 9)) && (ecx & (1 << 19));
+
+			__cpuid_count(7, 0, eax, ebx, ecx, edx);
+			accel[STRESS_CPU_ACCEL_SHA256].hw = sse && (ebx & (1 << 29));
+		}
+	}
+#endif
+#if defined(STRESS_CPU_ACCEL_ARM_CRC32)
+	accel[STRESS_CPU_ACCEL_CRC32C].hw = true;
+#endif
+#if defined(STRESS_CPU_ACCEL_ARM_CRYPTO)
+	accel[STRESS_CPU_ACCEL_AES].hw = true;
+	accel[STRESS_CPU_ACCEL_SHA256].hw = true;
+	accel[STRESS_CPU_ACCEL_CLMUL].hw = true;
+#endif
+	random_buffer(accel_buffer, sizeof(accel_buffer));
+	accel_init = true;
+}
+
+/*
+ *  stress_cpu_accel_account()
+ *	account bytes processed by a method over a duration
+ */
+static inline void stress_cpu_accel_account(
+	const int method,
+	const uint64_t bytes,
+	const double duration)
+{
+	accel[method].bytes += bytes;
+	accel[method].duration += duration;
+}
+
+/*
+ *  stress_cpu_accel_report()
+ *	report throughput of the hash and crypto methods,
+ *	only instance 0 reports to keep the output sane
+ */
+static void stress_cpu_accel_report(const char *name, const uint32_t instance)
+{
+	size_t i;
+
+	if (instance)
+		return;
+	for (i = 0; i < SIZEOF_ARRAY(accel); i++) {
+		double rate;
+
+		if (!accel[i].bytes || (accel[i].duration <= 0.0))
+			continue;
+		rate = (double)accel[i].bytes / accel[i].duration;
+		pr_inf(stderr, "%s: %s: %.2f MB per sec (%s)\n",
+			name, accel[i].name, rate / (double)MB,
+			accel[i].hw ? "hardware" : "software");
+	}
+}
+
+/*
+ *  crc32c_sw()
+ *	bitwise CRC32C (Castagnoli), reversed polynomial 0x82f63b78
+ */
+static uint32_t HOT OPTIMIZE3 crc32c_sw(uint32_t crc, const uint8_t *data, size_t n)
+{
+	crc = ~crc;
+	while (n--) {
+		int i;
+
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+#if defined(STRESS_CPU_ACCEL_X86)
+/*
+ *  crc32c_hw()
+ *	CRC32C using the SSE4.2 crc32 instruction
+ */
+static uint32_t TARGET_CRC32 HOT OPTIMIZE3 crc32c_hw(uint32_t crc, const uint8_t *data, size_t n)
+{
+	uint64_t c = ~crc;
+
+	for (; n >= 8; n -= 8, data += 8) {
+		uint64_t v;
+
+		(void)memcpy(&v, data, sizeof(v));
+		c = _mm_crc32_u64(c, v);
+	}
+	for (; n; n--)
+		c = _mm_crc32_u8((uint32_t)c, *data++);
+	return ~(uint32_t)c;
+}
+#elif defined(STRESS_CPU_ACCEL_ARM_CRC32)
+/*
+ *  crc32c_hw()
+ *	CRC32C using the ARMv8 crc32c instructions
+ */
+static uint32_t HOT OPTIMIZE3 crc32c_hw(uint32_t crc, const uint8_t *data, size_t n)
+{
+	crc = ~crc;
+	for (; n >= 8; n -= 8, data += 8) {
+		uint64_t v;
+
+		(void)memcpy(&v, data, sizeof(v));
+		crc = __crc32cd(crc, v);
+	}
+	for (; n; n--)
+		crc = __crc32cb(crc, *data++);
+	return ~crc;
+}
+#else
+#define crc32c_hw	crc32c_sw
+#endif
+
+/*
+ *  stress_cpu_crc32c()
+ *	compute CRC32C over 16 passes of a 4K buffer
+ */
+static void stress_cpu_crc32c(const char *name)
+{
+	bool hw;
+	uint32_t crc = 0;
+	double t;
+	int i;
+
+	stress_cpu_accel_probe();
+	hw = accel[STRESS_CPU_ACCEL_CRC32C].hw;
+	t = time_now_monotonic();
+	for (i = 0; i < STRESS_CPU_ACCEL_LOOPS; i++) {
+		crc = hw ? crc32c_hw(crc, accel_buffer, sizeof(accel_buffer)) :
+			   crc32c_sw(crc, accel_buffer, sizeof(accel_buffer));
+	}
+	stress_cpu_accel_account(STRESS_CPU_ACCEL_CRC32C,
+		STRESS_CPU_ACCEL_LOOPS * sizeof(accel_buffer),
+		time_now_monotonic() - t);
+	uint64_put(crc);
+
+	if (opt_flags & OPT_FLAGS_VERIFY) {
+		static const uint8_t check[] = "123456789";
+
+		if ((crc32c_sw(0, check, 9) != 0xe3069283) ||
+		    (hw && ((crc32c_hw(0, check, 9) != 0xe3069283) ||
+			    (crc32c_hw(0, accel_buffer, sizeof(accel_buffer)) !=
+			     crc32c_sw(0, accel_buffer, sizeof(accel_buffer))))))
+			pr_fail(stderr, "%s: crc32c error detected, "
+				"failed crc32c check\n", name);
+	}
+}
+
+/* AES S-box, FIPS-197 */
+static const uint8_t aes_sbox[256] = {
+	0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+	0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+	0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+	0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+	0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+	0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+	0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+	0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+	0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+	0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+	0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+	0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+	0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+	0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+	0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+	0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+#define AES_ROUNDS	(10)
+#define AES_XTIME(x)	((uint8_t)(((x) << 1) ^ (((x) >> 7) * 0x1b)))
+
+/*
+ *  aes_round_sw()
+ *	one AES encryption round, SubBytes, ShiftRows,
+ *	MixColumns (unless last round) and AddRoundKey
+ */
+static inline void HOT aes_round_sw(
+	uint8_t s[16],
+	const uint8_t key[16],
+	const bool last)
+{
+	uint8_t t[16];
+	int c, r;
+
+	for (c = 0; c < 4; c++)
+		for (r = 0; r < 4; r++)
+			t[r + (c * 4)] = aes_sbox[s[r + (((c + r) & 3) * 4)]];
+
+	for (c = 0; c < 16; c += 4) {
+		const uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3];
+
+		if (last) {
+			s[c] = a0;
+			s[c + 1] = a1;
+			s[c + 2] = a2;
+			s[c + 3] = a3;
+		} else {
+			const uint8_t x = a0 ^ a1 ^ a2 ^ a3;
+
+			s[c]     = a0 ^ x ^ AES_XTIME(a0 ^ a1);
+			s[c + 1] = a1 ^ x ^ AES_XTIME(a1 ^ a2);
+			s[c + 2] = a2 ^ x ^ AES_XTIME(a2 ^ a3);
+			s[c + 3] = a3 ^ x ^ AES_XTIME(a3 ^ a0);
+		}
+	}
+	for (c = 0; c < 16; c++)
+		s[c] ^= key[c];
+}
+
+/*
+ *  aes_encrypt_sw()
+ *	encrypt n bytes of 16 byte blocks using AES rounds
+ */
+static void HOT OPTIMIZE3 aes_encrypt_sw(
+	const uint8_t keys[AES_ROUNDS + 1][16],
+	const uint8_t *in,
+	uint8_t *out,
+	size_t n)
+{
+	for (; n >= 16; n -= 16, in += 16, out += 16) {
+		int i;
+
+		for (i = 0; i < 16; i++)
+			out[i] = in[i] ^ keys[0][i];
+		for (i = 1; i < AES_ROUNDS; i++)
+			aes_round_sw(out, keys[i], false);
+		aes_round_sw(out, keys[AES_ROUNDS], true);
+	}
+}
+
+#if defined(STRESS_CPU_ACCEL_X86)
+/*
+ *  aes_encrypt_hw()
+ *	encrypt n bytes of 16 byte blocks using AES-NI
+ */
+static void TARGET_AES HOT OPTIMIZE3 aes_encrypt_hw(
+	const uint8_t keys[AES_ROUNDS + 1][16],
+	const uint8_t *in,
+	uint8_t *out,
+	size_t n)
+{
+	__m128i k[AES_ROUNDS + 1];
+	int i;
+
+	for (i = 0; i <= AES_ROUNDS; i++)
+		k[i] = _mm_loadu_si128((const __m128i *)keys[i]);
+
+	for (; n >= 16; n -= 16, in += 16, out += 16) {
+		__m128i s = _mm_loadu_si128((const __m128i *)in);
+
+		s = _mm_xor_si128(s, k[0]);
+		for (i = 1; i < AES_ROUNDS; i++)
+			s = _mm_aesenc_si128(s, k[i]);
+		s = _mm_aesenclast_si128(s, k[AES_ROUNDS]);
+		_mm_storeu_si128((__m128i *)out, s);
+	}
+}
+#elif defined(STRESS_CPU_ACCEL_ARM_CRYPTO)
+/*
+ *  aes_encrypt_hw()
+ *	encrypt n bytes of 16 byte blocks using ARMv8 AES,
+ *	aese performs AddRoundKey first, so feed it a zero
+ *	key and xor the round key afterwards to match the
+ *	x86 and software round ordering
+ */
+static void HOT OPTIMIZE3 aes_encrypt_hw(
+	const uint8_t keys[AES_ROUNDS + 1][16],
+	const uint8_t *in,
+	uint8_t *out,
+	size_t n)
+{
+	const uint8x16_t zero = vdupq_n_u8(0);
+	uint8x16_t k[AES_ROUNDS + 1];
+	int i;
+
+	for (i = 0; i <= AES_ROUNDS; i++)
+		k[i] = vld1q_u8(keys[i]);
+
+	for (; n >= 16; n -= 16, in += 16, out += 16) {
+		uint8x16_t s = veorq_u8(vld1q_u8(in), k[0]);
+
+		for (i = 1; i < AES_ROUNDS; i++)
+			s = veorq_u8(vaesmcq_u8(vaeseq_u8(s, zero)), k[i]);
+		s = veorq_u8(vaeseq_u8(s, zero), k[AES_ROUNDS]);
+		vst1q_u8(out, s);
+	}
+}
+#else
+#define aes_encrypt_hw	aes_encrypt_sw
+#endif
+
+/*
+ *  stress_cpu_aes()
+ *	AES-128 style 10 round encryption of 16 passes
+ *	of a 4K buffer using random round keys
+ */
+static void stress_cpu_aes(const char *name)
+{
+	static uint8_t keys[AES_ROUNDS + 1][16];
+	static uint8_t out[STRESS_CPU_ACCEL_BUF] ALIGN64;
+	bool hw;
+	double t;
+	int i;
+
+	stress_cpu_accel_probe();
+	hw = accel[STRESS_CPU_ACCEL_AES].hw;
+	random_buffer((uint8_t *)keys, sizeof(keys));
+
+	t = time_now_monotonic();
+	for (i = 0; i < STRESS_CPU_ACCEL_LOOPS; i++) {
+		if (hw)
+			aes_encrypt_hw(keys, accel_buffer, out, sizeof(out));
+		else
+			aes_encrypt_sw(keys, accel_buffer, out, sizeof(out));
+	}
+	stress_cpu_accel_account(STRESS_CPU_ACCEL_AES,
+		STRESS_CPU_ACCEL_LOOPS * sizeof(out),
+		time_now_monotonic() - t);
+	uint64_put(out[mwc16() & (sizeof(out) - 1)]);
+
+	if ((opt_flags & OPT_FLAGS_VERIFY) && hw) {
+		uint8_t ref[64];
+
+		aes_encrypt_sw(keys, accel_buffer, ref, sizeof(ref));
+		if (memcmp(ref, out, sizeof(ref)))
+			pr_fail(stderr, "%s: aes error detected, hardware "
+				"and software encryption differ\n", name);
+	}
+}
+
+/* SHA-256 round constants */
+static const uint32_t sha256_k[64] ALIGN64 = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* SHA-256 initial hash values */
+static const uint32_t sha256_init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#define ROR32(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+/*
+ *  sha256_sw()
+ *	SHA-256 compression over n bytes of 64 byte blocks
+ */
+static void HOT OPTIMIZE3 sha256_sw(uint32_t state[8], const uint8_t *data, size_t n)
+{
+	for (; n >= 64; n -= 64, data += 64) {
+		uint32_t w[64], a, b, c, d, e, f, g, h;
+		int i;
+
+		for (i = 0; i < 16; i++) {
+			const uint8_t *p = data + (i * 4);
+
+			w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+			       ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+		}
+		for (i = 16; i < 64; i++) {
+			const uint32_t s0 = ROR32(w[i - 15], 7) ^
+				ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			const uint32_t s1 = ROR32(w[i - 2], 17) ^
+				ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		a = state[0]; b = state[1]; c = state[2]; d = state[3];
+		e = state[4]; f = state[5]; g = state[6]; h = state[7];
+
+		for (i = 0; i < 64; i++) {
+			const uint32_t s1 = ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25);
+			const uint32_t ch = (e & f) ^ (~e & g);
+			const uint32_t t1 = h + s1 + ch + sha256_k[i] + w[i];
+			const uint32_t s0 = ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22);
+			const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + s0 + maj;
+		}
+
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+		state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+	}
+}
+
+#if defined(STRESS_CPU_ACCEL_X86)
+/*
+ *  sha256_hw()
+ *	SHA-256 compression using the x86 SHA extensions,
+ *	the state is held as ABEF and CDGH and the message
+ *	schedule is rotated through 4 registers
+ */
+static void TARGET_SHA HOT OPTIMIZE3 sha256_hw(uint32_t state[8], const uint8_t *data, size_t n)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, tmp;
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);		/* ABEF */
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);		/* CDGH */
+
+	for (; n >= 64; n -= 64, data += 64) {
+		const __m128i abef = state0, cdgh = state1;
+		__m128i msg[4];
+		int i;
+
+		for (i = 0; i < 4; i++)
+			msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(
+				(const __m128i *)(data + (i * 16))), mask);
+
+		for (i = 0; i < 16; i++) {
+			const __m128i cur = msg[i & 3];
+			__m128i m;
+
+			m = _mm_add_epi32(cur, _mm_load_si128((const __m128i *)&sha256_k[i * 4]));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+			if ((i >= 3) && (i <= 14)) {
+				const int nxt = (i + 1) & 3;
+
+				tmp = _mm_alignr_epi8(cur, msg[(i + 3) & 3], 4);
+				msg[nxt] = _mm_add_epi32(msg[nxt], tmp);
+				msg[nxt] = _mm_sha256msg2_epu32(msg[nxt], cur);
+			}
+			m = _mm_shuffle_epi32(m, 0x0e);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+			if ((i >= 1) && (i <= 12)) {
+				const int prv = (i + 3) & 3;
+
+				msg[prv] = _mm_sha256msg1_epu32(msg[prv], cur);
+			}
+		}
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);			/* FEBA */
+	state1 = _mm_shuffle_epi32(state1, 0xb1);		/* DCHG */
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);		/* DCBA */
+	state1 = _mm_alignr_epi8(state1, tmp, 8);		/* HGFE */
+	_mm_storeu_si128((__m128i *)&state[0], state0);
+	_mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#elif defined(STRESS_CPU_ACCEL_ARM_CRYPTO)
+/*
+ *  sha256_hw()
+ *	SHA-256 compression using the ARMv8 SHA2 instructions
+ */
+static void HOT OPTIMIZE3 sha256_hw(uint32_t state[8], const uint8_t *data, size_t n)
+{
+	uint32x4_t state0 = vld1q_u32(&state[0]);
+	uint32x4_t state1 = vld1q_u32(&state[4]);
+
+	for (; n >= 64; n -= 64, data += 64) {
+		const uint32x4_t abcd = state0, efgh = state1;
+		uint32x4_t msg[4];
+		int i;
+
+		for (i = 0; i < 4; i++)
+			msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + (i * 16))));
+
+		for (i = 0; i < 16; i++) {
+			const uint32x4_t m = vaddq_u32(msg[i & 3], vld1q_u32(&sha256_k[i * 4]));
+			const uint32x4_t prev = state0;
+
+			if (i < 12)
+				msg[i & 3] = vsha256su1q_u32(
+					vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]),
+					msg[(i + 2) & 3], msg[(i + 3) & 3]);
+			state0 = vsha256hq_u32(state0, state1, m);
+			state1 = vsha256h2q_u32(state1, prev, m);
+		}
+		state0 = vaddq_u32(state0, abcd);
+		state1 = vaddq_u32(state1, efgh);
+	}
+	vst1q_u32(&state[0], state0);
+	vst1q_u32(&state[4], state1);
+}
+#else
+#define sha256_hw	sha256_sw
+#endif
+
+/*
+ *  stress_cpu_sha256()
+ *	SHA-256 compression of 16 passes of a 4K buffer
+ */
+static void stress_cpu_sha256(const char *name)
+{
+	bool hw;
+	uint32_t state[8];
+	double t;
+	int i;
+
+	stress_cpu_accel_probe();
+	hw = accel[STRESS_CPU_ACCEL_SHA256].hw;
+	(void)memcpy(state, sha256_init, sizeof(state));
+
+	t = time_now_monotonic();
+	for (i = 0; i < STRESS_CPU_ACCEL_LOOPS; i++) {
+		if (hw)
+			sha256_hw(state, accel_buffer, sizeof(accel_buffer));
+		else
+			sha256_sw(state, accel_buffer, sizeof(accel_buffer));
+	}
+	stress_cpu_accel_account(STRESS_CPU_ACCEL_SHA256,
+		STRESS_CPU_ACCEL_LOOPS * sizeof(accel_buffer),
+		time_now_monotonic() - t);
+	uint64_put(state[0]);
+
+	if ((opt_flags & OPT_FLAGS_VERIFY) && hw) {
+		uint32_t hw_state[8], sw_state[8];
+
+		(void)memcpy(hw_state, sha256_init, sizeof(hw_state));
+		(void)memcpy(sw_state, sha256_init, sizeof(sw_state));
+		sha256_hw(hw_state, accel_buffer, sizeof(accel_buffer));
+		sha256_sw(sw_state, accel_buffer, sizeof(accel_buffer));
+		if (memcmp(hw_state, sw_state, sizeof(hw_state)))
+			pr_fail(stderr, "%s: sha256 error detected, hardware "
+				"and software hashes differ\n", name);
+	}
+}
+
+/*
+ *  gf128_reduce()
+ *	reduce a 256 bit carry-less product modulo the
+ *	GHASH polynomial x^128 + x^7 + x^2 + x + 1 (this
+ *	uses the natural bit order rather than the bit
+ *	reflected order of GCM, the cost is the same)
+ */
+static inline void HOT gf128_reduce(const uint64_t p[4], uint64_t r[2])
+{
+	const uint64_t h0 = p[2], h1 = p[3];
+	const uint64_t ov = (h1 >> 63) ^ (h1 >> 62) ^ (h1 >> 57);
+	uint64_t m0, m1;
+
+	m0 = h0 ^ (h0 << 1) ^ (h0 << 2) ^ (h0 << 7);
+	m1 = h1 ^ (h1 << 1) ^ (h1 << 2) ^ (h1 << 7) ^
+	     (h0 >> 63) ^ (h0 >> 62) ^ (h0 >> 57);
+	m0 ^= ov ^ (ov << 1) ^ (ov << 2) ^ (ov << 7);
+
+	r[0] = p[0] ^ m0;
+	r[1] = p[1] ^ m1;
+}
+
+/*
+ *  clmul64_sw()
+ *	64 x 64 -> 128 bit carry-less multiply
+ */
+static inline void HOT clmul64_sw(
+	const uint64_t a,
+	const uint64_t b,
+	uint64_t *lo,
+	uint64_t *hi)
+{
+	uint64_t l = a & -(b & 1), h = 0;
+	int i;
+
+	for (i = 1; i < 64; i++) {
+		const uint64_t m = -((b >> i) & 1);
+
+		l ^= (a << i) & m;
+		h ^= (a >> (64 - i)) & m;
+	}
+	*lo = l;
+	*hi = h;
+}
+
+/*
+ *  gf128_mul_sw()
+ *	128 x 128 -> 256 bit carry-less multiply
+ */
+static inline void HOT gf128_mul_sw(const uint64_t a[2], const uint64_t b[2], uint64_t p[4])
+{
+	uint64_t l[2], h[2], m0[2], m1[2];
+
+	clmul64_sw(a[0], b[0], &l[0], &l[1]);
+	clmul64_sw(a[1], b[1], &h[0], &h[1]);
+	clmul64_sw(a[0], b[1], &m0[0], &m0[1]);
+	clmul64_sw(a[1], b[0], &m1[0], &m1[1]);
+
+	p[0] = l[0];
+	p[1] = l[1] ^ m0[0] ^ m1[0];
+	p[2] = h[0] ^ m0[1] ^ m1[1];
+	p[3] = h[1];
+}
+
+#if defined(STRESS_CPU_ACCEL_X86)
+/*
+ *  gf128_mul_hw()
+ *	128 x 128 -> 256 bit carry-less multiply using pclmulqdq
+ */
+static inline void TARGET_PCLMUL HOT gf128_mul_hw(const uint64_t a[2], const uint64_t b[2], uint64_t p[4])
+{
+	const __m128i va = _mm_loadu_si128((const __m128i *)a);
+	const __m128i vb = _mm_loadu_si128((const __m128i *)b);
+	const __m128i lo = _mm_clmulepi64_si128(va, vb, 0x00);
+	const __m128i hi = _mm_clmulepi64_si128(va, vb, 0x11);
+	const __m128i mid = _mm_xor_si128(
+		_mm_clmulepi64_si128(va, vb, 0x10),
+		_mm_clmulepi64_si128(va, vb, 0x01));
+	uint64_t l[2], m[2], h[2];
+
+	_mm_storeu_si128((__m128i *)l, lo);
+	_mm_storeu_si128((__m128i *)m, mid);
+	_mm_storeu_si128((__m128i *)h, hi);
+
+	p[0] = l[0];
+	p[1] = l[1] ^ m[0];
+	p[2] = h[0] ^ m[1];
+	p[3] = h[1];
+}
+#elif defined(STRESS_CPU_ACCEL_ARM_CRYPTO)
+/*
+ *  gf128_mul_hw()
+ *	128 x 128 -> 256 bit carry-less multiply using pmull
+ */
+static inline void HOT gf128_mul_hw(const uint64_t a[2], const uint64_t b[2], uint64_t p[4])
+{
+	const uint64x2_t lo = vreinterpretq_u64_p128(vmull_p64((poly64_t)a[0], (poly64_t)b[0]));
+	const uint64x2_t hi = vreinterpretq_u64_p128(vmull_p64((poly64_t)a[1], (poly64_t)b[1]));
+	const uint64x2_t mid = veorq_u64(
+		vreinterpretq_u64_p128(vmull_p64((poly64_t)a[0], (poly64_t)b[1])),
+		vreinterpretq_u64_p128(vmull_p64((poly64_t)a[1], (poly64_t)b[0])));
+
+	p[0] = vgetq_lane_u64(lo, 0);
+	p[1] = vgetq_lane_u64(lo, 1) ^ vgetq_lane_u64(mid, 0);
+	p[2] = vgetq_lane_u64(hi, 0) ^ vgetq_lane_u64(mid, 1);
+	p[3] = vgetq_lane_u64(hi, 1);
+}
+#else
+#define gf128_mul_hw	gf128_mul_sw
+#endif
+
+/*
+ *  ghash()
+ *	GHASH style hash, y = (y ^ block) * h in GF(2^128)
+ *	over n bytes of 16 byte blocks
+ */
+static void HOT OPTIMIZE3 ghash(
+	const bool hw,
+	const uint64_t h[2],
+	uint64_t y[2],
+	const uint8_t *data,
+	size_t n)
+{
+	for (; n >= 16; n -= 16, data += 16) {
+		uint64_t x[2], p[4];
+
+		(void)memcpy(x, data, sizeof(x));
+		x[0] ^= y[0];
+		x[1] ^= y[1];
+		if (hw)
+			gf128_mul_hw(x, h, p);
+		else
+			gf128_mul_sw(x, h, p);
+		gf128_reduce(p, y);
+	}
+}
+
+/*
+ *  stress_cpu_clmul()
+ *	GHASH of 16 passes of a 4K buffer using
+ *	carry-less multiplication
+ */
+static void stress_cpu_clmul(const char *name)
+{
+	bool hw;
+	const uint64_t h[2] = { mwc64(), mwc64() };
+	uint64_t y[2] = { 0, 0 };
+	double t;
+	int i;
+
+	stress_cpu_accel_probe();
+	hw = accel[STRESS_CPU_ACCEL_CLMUL].hw;
+	t = time_now_monotonic();
+	for (i = 0; i < STRESS_CPU_ACCEL_LOOPS; i++)
+		ghash(hw, h, y, accel_buffer, sizeof(accel_buffer));
+	stress_cpu_accel_account(STRESS_CPU_ACCEL_CLMUL,
+		STRESS_CPU_ACCEL_LOOPS * sizeof(accel_buffer),
+		time_now_monotonic() - t);
+	uint64_put(y[0] ^ y[1]);
+
+	if ((opt_flags & OPT_FLAGS_VERIFY) && hw) {
+		uint64_t y_hw[2] = { 0, 0 }, y_sw[2] = { 0, 0 };
+
+		ghash(true, h, y_hw, accel_buffer, 256);
+		ghash(false, h, y_sw, accel_buffer, 256);
+		if ((y_hw[0] != y_sw[0]) || (y_hw[1] != y_sw[1]))
+			pr_fail(stderr, "%s: clmul error detected, hardware "
+				"and software GHASH differ\n", name);
+	}
+}
+
 /*
  *  zeta()
  *	Riemann zeta function
@@ -2095,6 +2894,7 @@ static const stress_cpu_stressor_info_t cpu_methods[] = {
 	{ "all",		stress_cpu_all },	/* Special "all test */
 
 	{ "ackermann",		stress_cpu_ackermann },
+	{ "aes",		stress_cpu_aes },
 	{ "bitops",		stress_cpu_bitops },
 	{ "callfunc",		stress_cpu_callfunc },
 #if defined(__STDC_IEC_559_COMPLEX__)
@@ -2102,8 +2902,10 @@ static const stress_cpu_stressor_info_t cpu_methods[] = {
 	{ "cfloat",		stress_cpu_complex_float },
 	{ "clongdouble",	stress_cpu_complex_long_double },
 #endif /* __STDC_IEC_559_COMPLEX__ */
+	{ "clmul",		stress_cpu_clmul },
 	{ "correlate",		stress_cpu_correlate },
 	{ "crc16",		stress_cpu_crc16 },
+	{ "crc32c",		stress_cpu_crc32c },
 #if defined(HAVE_FLOAT_DECIMAL) && !defined(__clang__)
 	{ "decimal32",		stress_cpu_decimal32 },
 	{ "decimal64",		stress_cpu_decimal64 },
@@ -2167,6 +2969,7 @@ static const stress_cpu_stressor_info_t cpu_methods[] = {
 	{ "rand48",		stress_cpu_rand48 },
 	{ "rgb",		stress_cpu_rgb },
 	{ "sdbm",		stress_cpu_sdbm },
+	{ "sha256",		stress_cpu_sha256 },
 	{ "sieve",		stress_cpu_sieve },
 	{ "sqrt", 		stress_cpu_sqrt },
 	{ "trig",		stress_cpu_trig },
@@ -2199,6 +3002,28 @@ int HOT OPTIMIZE3 stress_set_cpu_method(const char *name)
 	return -1;
 }
 
+/*
+ *  stress_cpu_time()
+ *	CPU time in seconds consumed by this process
+ */
+static double stress_cpu_time(void)
+{
+#if defined(HAVE_LIB_RT) && defined(CLOCK_PROCESS_CPUTIME_ID)
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) == 0)
+		return (double)ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+#endif
+	{
+		struct rusage usage;
+
+		if (getrusage(RUSAGE_SELF, &usage) == 0)
+			return timeval_to_double(&usage.ru_utime) +
+			       timeval_to_double(&usage.ru_stime);
+	}
+	return time_now_monotonic();
+}
+
 /*
  *  stress_cpu()
  *	stress CPU by doing floating point math ops
@@ -2209,19 +3034,19 @@ int stress_cpu(
 	const uint64_t max_ops,
 	const char *name)
 {
-	double bias;
+	double load, allowance, t_begin, t_start, t_end, cpu_begin, cpu_start;
 	stress_cpu_func func = opt_cpu_stressor->func;
-
-	(void)instance;
+	const bool targeted = shared->target.cpu;
 
 	/*
 	 * Normal use case, 100% load, simple spinning on CPU
 	 */
-	if (opt_cpu_load == 100) {
+	if ((opt_cpu_load == 100) && !targeted) {
 		do {
 			(void)func(name);
 			(*counter)++;
 		} while (opt_do_run && (!max_ops || *counter < max_ops));
+		stress_cpu_accel_report(name, instance);
 		return EXIT_SUCCESS;
 	}
 
@@ -2229,69 +3054,121 @@ int stress_cpu(
 	 * It is unlikely, but somebody may request to do a zero
 	 * load stress test(!)
 	 */
-	if (opt_cpu_load == 0) {
+	if ((opt_cpu_load == 0) && !targeted) {
 		sleep((int)opt_timeout);
 		return EXIT_SUCCESS;
 	}
 
 	/*
-	 * More complex percentage CPU utilisation.  This is
-	 * not intended to be 100% accurate timing, it is good
-	 * enough for most purposes.
+	 * More complex percentage CPU utilisation. The CPU time
+	 * consumed by the busy slices is accounted against the
+	 * monotonic elapsed time and each idle period sleeps until
+	 * the accumulated load matches the requested load, so
+	 * oversleeping or being preempted by other tasks sharing
+	 * the CPU is compensated for in the following slices.
+	 * With --target-cpu the load is the duty cycle set by
+	 * the system wide utilisation controller.
 	 */
-	bias = 0.0;
+	load = targeted ? shared->target.cpu_duty :
+			  (double)opt_cpu_load / 100.0;
+	if (opt_cpu_load_slice > 0)
+		allowance = (double)opt_cpu_load_slice / 1000.0;
+	else if (opt_cpu_load_slice == 0)
+		allowance = 0.5;
+	else
+		allowance = load * STRESS_CPU_LOAD_PERIOD;
+
+	t_begin = t_start = time_now_monotonic();
+	cpu_begin = cpu_start = stress_cpu_time();
 	do {
-		double t, delay;
-		double t1, t2, t3;
-		struct timeval tv;
-
-		t1 = time_now();
-		if (opt_cpu_load_slice < 0) {
-			/* < 0 specifies number of iterations to do per slice */
-			int j;
-
-			for (j = 0; j < -opt_cpu_load_slice; j++) {
-				(void)func(name);
-				if (!opt_do_run)
-					break;
-				(*counter)++;
-			}
-			t2 = time_now();
-		} else if (opt_cpu_load_slice == 0) {
+		double t1, t2, target, cpu, slice_end;
+		int32_t j = 0;
+
+		if (targeted && (load != shared->target.cpu_duty)) {
+			/* Duty cycle changed, restart the accounting */
+			load = shared->target.cpu_duty;
+			if (opt_cpu_load_slice < 0)
+				allowance = load * STRESS_CPU_LOAD_PERIOD;
+			t_start = time_now_monotonic();
+			cpu_start = stress_cpu_time();
+		}
+		if (load <= 0.0) {
+			(void)shim_usleep((uint64_t)(STRESS_CPU_LOAD_PERIOD * 1000000.0));
+			continue;
+		}
+
+		t1 = time_now_monotonic();
+		slice_end = t1;
+		if (opt_cpu_load_slice == 0) {
 			/* == 0, random time slices */
-			double slice_end = t1 + (((double)mwc16()) / 131072.0);
-			do {
-				(void)func(name);
-				t2 = time_now();
-				if (!opt_do_run)
-					break;
-				(*counter)++;
-			} while (t2 < slice_end);
-		} else {
+			slice_end += ((double)mwc16()) / 131072.0;
+		} else if (opt_cpu_load_slice > 0) {
 			/* > 0, time slice in milliseconds */
-			double slice_end = t1 +
-				((double)opt_cpu_load_slice / 1000.0);
-			do {
-				(void)func(name);
-				t2 = time_now();
-				if (!opt_do_run)
+			slice_end += (double)opt_cpu_load_slice / 1000.0;
+		}
+
+		for (;;) {
+			double now;
+
+			(void)func(name);
+			if (!opt_do_run)
+				break;
+			(*counter)++;
+
+			/*
+			 * End the busy slice early if it has used up the
+			 * CPU time budget, this stops low loads overshooting
+			 */
+			now = time_now_monotonic();
+			cpu = stress_cpu_time() - cpu_start;
+			if (cpu > (load * (now - t_start)) + allowance)
+				break;
+			if (opt_cpu_load_slice < 0) {
+				/* < 0 specifies number of iterations to do per slice */
+				if (++j >= -opt_cpu_load_slice)
 					break;
-				(*counter)++;
-			} while (t2 < slice_end);
+			} else if (now >= slice_end) {
+				break;
+			}
+		}
+
+		cpu = stress_cpu_time() - cpu_start;
+		target = t_start + (cpu / load);
+		t2 = time_now_monotonic();
+		if (target > t2) {
+			do {
+				double delay = target - t2;
+
+				/* Sleep in short steps to track duty cycle changes */
+				if (targeted && (delay > STRESS_CPU_LOAD_PERIOD))
+					delay = STRESS_CPU_LOAD_PERIOD;
+				(void)shim_usleep((uint64_t)(delay * 1000000.0));
+				t2 = time_now_monotonic();
+			} while (targeted && opt_do_run && (t2 < target) &&
+				 (load == shared->target.cpu_duty));
+		} else if ((t2 - target) > 1.0) {
+			/*
+			 * Starved of CPU for over a second, rebase the
+			 * accounting rather than run flat out to catch up
+			 */
+			t_start = t2;
+			cpu_start += cpu;
 		}
-		t = t2 - t1;
-		/* Must not calculate this with zero % load */
-		delay = t * (((100.0 / (double) opt_cpu_load)) - 1.0);
-		delay -= bias;
-
-		tv.tv_sec = delay;
-		tv.tv_usec = (delay - tv.tv_sec) * 1000000.0;
-		select(0, NULL, NULL, NULL, &tv);
-
-		t3 = time_now();
-		/* Bias takes account of the time to do the delay */
-		bias = (t3 - t2) - delay;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
 
+	t_end = time_now_monotonic();
+	if (t_end > t_begin) {
+		const double achieved = 100.0 *
+			(stress_cpu_time() - cpu_begin) / (t_end - t_begin);
+
+		if (targeted)
+			pr_inf(stderr, "%s: achieved load %.2f%% under "
+				"--target-cpu control\n", name, achieved);
+		else
+			pr_inf(stderr, "%s: requested load %" PRId32 "%%, "
+				"achieved load %.2f%%\n", name, opt_cpu_load, achieved);
+	}
+	stress_cpu_accel_report(name, instance);
+
 	return EXIT_SUCCESS;
 }
@@ -24,10 +24,30 @@
  */
 #include "stress-ng.h"
 #include <sys/uio.h>
+#include <math.h>
+
+#if defined(__linux__) &&		\
+    defined(HAVE_LINUX_IO_URING_H) &&	\
+    defined(__NR_io_uring_setup) &&	\
+    defined(__NR_io_uring_enter) &&	\
+    defined(__NR_io_uring_register)
+#include <linux/io_uring.h>
+#define STRESS_HDD_URING	(1)
+#endif
 
 #define BUF_ALIGNMENT		(4096)
 #define HDD_IO_VEC_MAX		(16)		/* Must be power of 2 */
 
+/* I/O engines */
+#define HDD_ENGINE_SYNC		(0)		/* read/write system calls */
+#define HDD_ENGINE_IO_URING	(1)		/* linux io_uring */
+
+/* io_uring engine modes */
+#define HDD_URING_FIXED_FILES	(0x01)		/* registered file */
+#define HDD_URING_FIXED_BUFS	(0x02)		/* registered buffers */
+#define HDD_URING_SQPOLL	(0x04)		/* kernel submission thread */
+#define HDD_URING_IOPOLL	(0x08)		/* busy poll completions */
+
 /* Write and read stress modes */
 #define HDD_OPT_WR_SEQ		(0x00000001)
 #define HDD_OPT_WR_RND		(0x00000002)
@@ -52,6 +72,16 @@
 #define HDD_OPT_O_NOATIME	(0x00080000)
 #define HDD_OPT_O_MASK		(0x000f0000)
 
+/* Mixed workload offset distributions */
+#define HDD_DIST_UNIFORM	(0)		/* every block equally likely */
+#define HDD_DIST_ZIPF		(1)		/* zipfian block popularity */
+#define HDD_DIST_HOT_COLD	(2)		/* hot set takes most accesses */
+
+#define HDD_LATENCY_MIXED	(2)		/* mixed workload latencies */
+
+#define HDD_BSSPLIT_MAX		(16)		/* Max --hdd-bssplit sizes */
+#define HDD_MIX_UNIT		(4096)		/* mixed offset granularity */
+
 /* Other modes */
 #define HDD_OPT_IOVEC		(0x00100000)
 #define HDD_OPT_UTIMES		(0x00200000)
@@ -66,6 +96,59 @@ static bool set_hdd_write_size = false;
 static bool opts_set = false;
 static int opt_hdd_flags = 0;
 static int opt_hdd_oflags = 0;
+static int opt_hdd_engine = HDD_ENGINE_SYNC;
+static uint32_t opt_hdd_iodepth = DEFAULT_HDD_IODEPTH;
+static uint32_t opt_hdd_batch = DEFAULT_HDD_BATCH;
+static int opt_hdd_uring_flags = 0;
+static bool opt_hdd_mixed = false;
+static uint32_t opt_hdd_rwmix = DEFAULT_HDD_RWMIX;
+static uint64_t opt_hdd_think_time = 0;
+static int opt_hdd_dist = HDD_DIST_UNIFORM;
+static double opt_hdd_zipf_theta = 0.99;
+static uint32_t opt_hdd_hot_pct = 10;		/* percent of the file that is hot */
+static uint32_t opt_hdd_hot_access = 90;	/* percent of I/Os to the hot set */
+
+/* weighted block size distribution */
+typedef struct {
+	uint64_t size;		/* block size in bytes */
+	uint32_t weight;	/* relative frequency */
+} hdd_bssplit_t;
+
+static hdd_bssplit_t hdd_bssplit[HDD_BSSPLIT_MAX];
+static size_t hdd_bssplit_n = 0;
+
+typedef struct {
+	const char *name;	/* option name */
+	const int value;	/* HDD_ENGINE_* or HDD_URING_* */
+} hdd_name_value_t;
+
+static const hdd_name_value_t hdd_engines[] = {
+	{ "sync",	HDD_ENGINE_SYNC },
+	{ "io_uring",	HDD_ENGINE_IO_URING },
+	{ NULL,		0 }
+};
+
+static const hdd_name_value_t hdd_dists[] = {
+	{ "uniform",	HDD_DIST_UNIFORM },
+	{ "zipf",	HDD_DIST_ZIPF },
+	{ "hot-cold",	HDD_DIST_HOT_COLD },
+	{ NULL,		0 }
+};
+
+static const hdd_name_value_t hdd_uring_opts[] = {
+	{ "fixed-files", HDD_URING_FIXED_FILES },
+	{ "fixed-bufs",	HDD_URING_FIXED_BUFS },
+	{ "sqpoll",	HDD_URING_SQPOLL },
+	{ "iopoll",	HDD_URING_IOPOLL },
+	{ NULL,		0 }
+};
+
+/* per engine latency accounting method names, write then read */
+static const char *hdd_latency_methods[][2] = {
+	{ "sync-write",		"sync-read" },		/* HDD_ENGINE_SYNC */
+	{ "io_uring-write",	"io_uring-read" },	/* HDD_ENGINE_IO_URING */
+	{ "mixed-write",	"mixed-read" },		/* HDD_LATENCY_MIXED */
+};
 
 typedef struct {
 	const char *opt;	/* User option */
@@ -153,6 +236,179 @@ void stress_set_hdd_write_size(const char *optarg)
 		MIN_HDD_WRITE_SIZE, MAX_HDD_WRITE_SIZE);
 }
 
+/*
+ *  stress_set_hdd_engine()
+ *	set the I/O engine
+ */
+int stress_set_hdd_engine(const char *name)
+{
+	const hdd_name_value_t *info;
+
+	for (info = hdd_engines; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_hdd_engine = info->value;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "hdd-engine must be one of:");
+	for (info = hdd_engines; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+void stress_set_hdd_iodepth(const char *optarg)
+{
+	opt_hdd_iodepth = get_uint32(optarg);
+	check_range("hdd-iodepth", opt_hdd_iodepth,
+		MIN_HDD_IODEPTH, MAX_HDD_IODEPTH);
+}
+
+void stress_set_hdd_batch(const char *optarg)
+{
+	opt_hdd_batch = get_uint32(optarg);
+	check_range("hdd-batch", opt_hdd_batch,
+		MIN_HDD_BATCH, MAX_HDD_BATCH);
+}
+
+/*
+ *  stress_hdd_uring_opts
+ *	parse --hdd-uring-opts option(s) list
+ */
+int stress_hdd_uring_opts(char *opts)
+{
+	char *str, *token;
+
+	for (str = opts; (token = strtok(str, ",")) != NULL; str = NULL) {
+		const hdd_name_value_t *info;
+
+		for (info = hdd_uring_opts; info->name; info++) {
+			if (!strcmp(token, info->name))
+				break;
+		}
+		if (!info->name) {
+			fprintf(stderr, "hdd-uring-opts option '%s' not known, "
+				"options are:", token);
+			for (info = hdd_uring_opts; info->name; info++)
+				fprintf(stderr, "%s %s", info == hdd_uring_opts ?
+					"" : ",", info->name);
+			fprintf(stderr, "\n");
+			return -1;
+		}
+		opt_hdd_uring_flags |= info->value;
+	}
+
+	return 0;
+}
+
+void stress_set_hdd_rwmix(const char *optarg)
+{
+	opt_hdd_mixed = true;
+	opt_hdd_rwmix = get_uint32(optarg);
+	check_range("hdd-rwmix", opt_hdd_rwmix,
+		MIN_HDD_RWMIX, MAX_HDD_RWMIX);
+}
+
+void stress_set_hdd_think_time(const char *optarg)
+{
+	opt_hdd_think_time = get_uint64(optarg);
+	check_range("hdd-think-time", opt_hdd_think_time,
+		MIN_HDD_THINK_TIME, MAX_HDD_THINK_TIME);
+}
+
+/*
+ *  stress_set_hdd_bssplit()
+ *	parse a --hdd-bssplit size:weight list, e.g. 4k:70,64k:20,1m:10
+ */
+int stress_set_hdd_bssplit(char *opts)
+{
+	char *str, *token;
+
+	hdd_bssplit_n = 0;
+	for (str = opts; (token = strtok(str, ",")) != NULL; str = NULL) {
+		char *colon = strchr(token, ':');
+		hdd_bssplit_t *bs = &hdd_bssplit[hdd_bssplit_n];
+
+		if (hdd_bssplit_n >= HDD_BSSPLIT_MAX) {
+			fprintf(stderr, "hdd-bssplit allows at most %d sizes\n",
+				HDD_BSSPLIT_MAX);
+			return -1;
+		}
+		bs->weight = 1;
+		if (colon) {
+			*colon = '\0';
+			bs->weight = get_uint32(colon + 1);
+			check_range("hdd-bssplit weight", bs->weight, 1, 1000000);
+		}
+		bs->size = get_uint64_byte(token);
+		check_range("hdd-bssplit size", bs->size,
+			MIN_HDD_WRITE_SIZE, MAX_HDD_WRITE_SIZE);
+		hdd_bssplit_n++;
+	}
+	if (!hdd_bssplit_n) {
+		fprintf(stderr, "hdd-bssplit needs at least one size\n");
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ *  stress_set_hdd_dist()
+ *	parse --hdd-dist uniform, zipf[:theta] or hot-cold[:hot%:access%]
+ */
+int stress_set_hdd_dist(char *opt)
+{
+	const hdd_name_value_t *info;
+	char *params = strchr(opt, ':');
+
+	if (params)
+		*params++ = '\0';
+	for (info = hdd_dists; info->name; info++) {
+		if (!strcmp(info->name, opt))
+			break;
+	}
+	if (!info->name) {
+		fprintf(stderr, "hdd-dist must be one of:");
+		for (info = hdd_dists; info->name; info++)
+			fprintf(stderr, " %s", info->name);
+		fprintf(stderr, "\n");
+		return -1;
+	}
+	opt_hdd_dist = info->value;
+	if (!params)
+		return 0;
+
+	switch (opt_hdd_dist) {
+	case HDD_DIST_ZIPF:
+		if ((sscanf(params, "%lf", &opt_hdd_zipf_theta) != 1) ||
+		    (opt_hdd_zipf_theta <= 0.0) ||
+		    (opt_hdd_zipf_theta > 10.0) ||
+		    (opt_hdd_zipf_theta == 1.0)) {
+			fprintf(stderr, "hdd-dist zipf theta must be more than "
+				"0.0, no more than 10.0 and not 1.0\n");
+			return -1;
+		}
+		break;
+	case HDD_DIST_HOT_COLD:
+		if ((sscanf(params, "%" SCNu32 ":%" SCNu32,
+		     &opt_hdd_hot_pct, &opt_hdd_hot_access) != 2) ||
+		    (opt_hdd_hot_pct < 1) || (opt_hdd_hot_pct > 99) ||
+		    (opt_hdd_hot_access > 100)) {
+			fprintf(stderr, "hdd-dist hot-cold must be "
+				"hot-cold:H:A, H%% of the file taking A%% "
+				"of the I/Os, H 1..99, A 0..100\n");
+			return -1;
+		}
+		break;
+	default:
+		fprintf(stderr, "hdd-dist %s takes no parameters\n", opt);
+		return -1;
+	}
+	return 0;
+}
+
 /*
  *  stress_hdd_write()
  *	write with writev or write depending on mode
@@ -170,13 +426,13 @@ static ssize_t stress_hdd_write(const int fd, uint8_t *buf, size_t count)
 		struct iovec iov[HDD_IO_VEC_MAX];
 		size_t i;
 		uint8_t *data = buf;
-		const uint64_t sz = opt_hdd_write_size / HDD_IO_VEC_MAX;
+		const uint64_t sz = count / HDD_IO_VEC_MAX;
 
 		for (i = 0; i < HDD_IO_VEC_MAX; i++) {
 			iov[i].iov_base = (void *)data;
 			iov[i].iov_len = (size_t)sz;
 
-			buf += sz;
+			data += sz;
 		}
 		ret = writev(fd, iov, HDD_IO_VEC_MAX);
 	} else {
@@ -214,13 +470,13 @@ static ssize_t stress_hdd_read(const int fd, uint8_t *buf, size_t count)
 		struct iovec iov[HDD_IO_VEC_MAX];
 		size_t i;
 		uint8_t *data = buf;
-		const uint64_t sz = opt_hdd_write_size / HDD_IO_VEC_MAX;
+		const uint64_t sz = count / HDD_IO_VEC_MAX;
 
 		for (i = 0; i < HDD_IO_VEC_MAX; i++) {
 			iov[i].iov_base = (void *)data;
 			iov[i].iov_len = (size_t)sz;
 
-			buf += sz;
+			data += sz;
 		}
 		return readv(fd, iov, HDD_IO_VEC_MAX);
 	} else {
@@ -310,6 +566,860 @@ static int stress_hdd_advise(const char *name, const int fd, const int flags)
 #endif
 	return 0;
 }
+#if defined(STRESS_HDD_URING)
+
+/* a mapped io_uring */
+typedef struct {
+	int fd;				/* ring file descriptor */
+	uint32_t setup_flags;		/* IORING_SETUP_* flags */
+	uint32_t queued;		/* sqes not yet submitted */
+	unsigned *sq_head;		/* submission queue ring */
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_flags;
+	unsigned *sq_array;
+	unsigned *cq_head;		/* completion queue ring */
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_sqe *sqes;	/* submission queue entries */
+	struct io_uring_cqe *cqes;	/* completion queue entries */
+	void *sq_ring;			/* mappings */
+	void *cq_ring;
+	size_t sq_ring_size;
+	size_t cq_ring_size;
+	size_t sqes_size;
+} hdd_uring_t;
+
+/* one in flight I/O */
+typedef struct {
+	uint8_t *buf;			/* I/O buffer */
+	off_t offset;			/* file offset of the I/O */
+	uint64_t start_ns;		/* submission time */
+	struct iovec iov[HDD_IO_VEC_MAX];
+} hdd_uring_slot_t;
+
+/* state shared by all the phases of an instance */
+typedef struct {
+	const char *name;		/* stressor name */
+	hdd_uring_t ring;		/* the io_uring */
+	hdd_uring_slot_t *slots;	/* iodepth I/O slots */
+	uint32_t *free_slots;		/* stack of idle slot indices */
+	uint32_t nslots;		/* number of slots */
+	uint32_t batch;			/* sqes per submission */
+	size_t io_size;			/* bytes per I/O */
+	off_t align;			/* random offset alignment */
+	int fd;				/* file, or 0 if registered */
+	uint8_t sqe_flags;		/* IOSQE_* flags */
+	bool fixed_bufs;		/* buffers are registered */
+	bool written_seq;		/* whole file written */
+} hdd_uring_ctx_t;
+
+/*
+ *  stress_hdd_uring_free()
+ *	unmap and close an io_uring
+ */
+static void stress_hdd_uring_free(hdd_uring_t *r)
+{
+	if (r->sqes)
+		(void)munmap((void *)r->sqes, r->sqes_size);
+	if (r->cq_ring)
+		(void)munmap(r->cq_ring, r->cq_ring_size);
+	if (r->sq_ring)
+		(void)munmap(r->sq_ring, r->sq_ring_size);
+	if (r->fd >= 0)
+		(void)close(r->fd);
+	memset(r, 0, sizeof(*r));
+	r->fd = -1;
+}
+
+/*
+ *  stress_hdd_uring_setup()
+ *	create and map an io_uring with the given number of entries,
+ *	returns -1 and leaves errno set on failure
+ */
+static int stress_hdd_uring_setup(
+	hdd_uring_t *r,
+	const uint32_t entries,
+	const uint32_t setup_flags)
+{
+	struct io_uring_params p;
+	uint8_t *sq, *cq;
+	int err;
+
+	memset(r, 0, sizeof(*r));
+	memset(&p, 0, sizeof(p));
+	p.flags = setup_flags;
+	/* let the submission thread sleep after 1 second idle */
+	if (setup_flags & IORING_SETUP_SQPOLL)
+		p.sq_thread_idle = 1000;
+
+	r->fd = shim_io_uring_setup(entries, &p);
+	if (r->fd < 0)
+		return -1;
+	r->setup_flags = setup_flags;
+
+	r->sq_ring_size = p.sq_off.array + (p.sq_entries * sizeof(unsigned));
+	r->cq_ring_size = p.cq_off.cqes +
+		(p.cq_entries * sizeof(struct io_uring_cqe));
+	r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	if (r->sq_ring == MAP_FAILED) {
+		r->sq_ring = NULL;
+		goto err;
+	}
+	r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+	if (r->cq_ring == MAP_FAILED) {
+		r->cq_ring = NULL;
+		goto err;
+	}
+	r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		r->sqes = NULL;
+		goto err;
+	}
+
+	sq = (uint8_t *)r->sq_ring;
+	r->sq_head = (unsigned *)(sq + p.sq_off.head);
+	r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	r->sq_flags = (unsigned *)(sq + p.sq_off.flags);
+	r->sq_array = (unsigned *)(sq + p.sq_off.array);
+	cq = (uint8_t *)r->cq_ring;
+	r->cq_head = (unsigned *)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	return 0;
+err:
+	err = errno;
+	stress_hdd_uring_free(r);
+	errno = err;
+	return -1;
+}
+
+/*
+ *  stress_hdd_uring_sqe()
+ *	the next free submission queue entry, zeroed; the
+ *	slots limit the I/Os in flight so the ring never fills.
+ *	The kernel does not see it until it is committed
+ */
+static inline struct io_uring_sqe *stress_hdd_uring_sqe(hdd_uring_t *r)
+{
+	const unsigned idx = *r->sq_tail & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	r->sq_array[idx] = idx;
+
+	return sqe;
+}
+
+/*
+ *  stress_hdd_uring_commit()
+ *	hand the filled in sqe from stress_hdd_uring_sqe() to
+ *	the kernel by moving the submission queue tail past it
+ */
+static inline void stress_hdd_uring_commit(hdd_uring_t *r)
+{
+	/* the sqe must be visible before the kernel sees the new tail */
+	__atomic_store_n(r->sq_tail, *r->sq_tail + 1, __ATOMIC_RELEASE);
+	r->queued++;
+}
+
+/*
+ *  stress_hdd_uring_enter()
+ *	submit the queued sqes and optionally wait for a completion;
+ *	with SQPOLL the kernel thread picks up the sqes by itself and
+ *	only needs waking when it has gone idle. The kernel may take
+ *	fewer sqes than asked (or none on EAGAIN or EBUSY), those
+ *	left over stay queued and are submitted by the next call
+ */
+static int stress_hdd_uring_enter(hdd_uring_t *r, const bool wait)
+{
+	unsigned int submit = r->queued, flags = 0;
+	int ret;
+
+	if (r->setup_flags & IORING_SETUP_SQPOLL) {
+		submit = 0;
+		r->queued = 0;
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(r->sq_flags, __ATOMIC_RELAXED) &
+		    IORING_SQ_NEED_WAKEUP)
+			flags |= IORING_ENTER_SQ_WAKEUP;
+	}
+	if (wait)
+		flags |= IORING_ENTER_GETEVENTS;
+	if (!submit && !flags)
+		return 0;
+
+	ret = shim_io_uring_enter(r->fd, submit, wait ? 1 : 0, flags);
+	if (ret < 0) {
+		if ((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY))
+			return 0;
+		return -1;
+	}
+	r->queued -= STRESS_MINIMUM((unsigned int)ret, submit);
+	return 0;
+}
+
+/*
+ *  stress_hdd_uring_verify()
+ *	check a read block, the first byte of each 512 byte
+ *	sector holds the low byte of its offset, unless it is
+ *	a hole left by random writes
+ */
+static uint64_t stress_hdd_uring_verify(
+	const hdd_uring_ctx_t *ctx,
+	const hdd_uring_slot_t *slot,
+	const size_t len)
+{
+	uint64_t baddata = 0;
+	size_t j;
+
+	for (j = 0; j < len; j += 512) {
+		const uint8_t v = (slot->offset + j) & 0xff;
+		const uint8_t b = slot->buf[j];
+
+		if ((b != v) && (ctx->written_seq || (b != 0)))
+			baddata++;
+	}
+	return baddata;
+}
+
+/*
+ *  stress_hdd_uring_phase()
+ *	keep up to iodepth reads or writes of a range of the file
+ *	in flight, submitting them batch at a time, until they have
+ *	all completed or the run stops; returns -1 on an I/O error
+ *	or -2 if the file does not support the ring's I/O mode
+ */
+static int stress_hdd_uring_phase(
+	hdd_uring_ctx_t *ctx,
+	const bool write,
+	const bool rnd,
+	const uint64_t range,
+	uint64_t *const counter,
+	const uint64_t max_ops,
+	stress_latency_t *stats)
+{
+	hdd_uring_t *r = &ctx->ring;
+	uint64_t n = range / ctx->io_size, issued = 0;
+	uint64_t misreads = 0, baddata = 0;
+	uint32_t nfree = ctx->nslots, inflight = 0;
+	double t;
+	int rc = 0;
+
+	t = time_now();
+	while ((issued < n) || inflight) {
+		unsigned head, tail;
+		uint64_t now;
+
+		while ((issued < n) && nfree) {
+			const uint32_t idx = ctx->free_slots[--nfree];
+			hdd_uring_slot_t *slot = &ctx->slots[idx];
+			struct io_uring_sqe *sqe;
+
+			if (!opt_do_run || (max_ops && (*counter + inflight >= max_ops))) {
+				nfree++;
+				n = issued;
+				break;
+			}
+			slot->offset = rnd ?
+				(off_t)(mwc64() % (range - ctx->io_size + 1)) & ~(ctx->align - 1) :
+				(off_t)(issued * ctx->io_size);
+			if (write) {
+				size_t j;
+
+				for (j = 0; j < ctx->io_size; j += 512)
+					slot->buf[j] = (slot->offset + j) & 0xff;
+			}
+
+			sqe = stress_hdd_uring_sqe(r);
+			sqe->fd = ctx->fd;
+			sqe->flags = ctx->sqe_flags;
+			sqe->off = (uint64_t)slot->offset;
+			sqe->user_data = idx;
+			if (ctx->fixed_bufs) {
+				sqe->opcode = write ? IORING_OP_WRITE_FIXED :
+						      IORING_OP_READ_FIXED;
+				sqe->addr = (uint64_t)(uintptr_t)slot->buf;
+				sqe->len = ctx->io_size;
+				sqe->buf_index = idx;
+			} else {
+				const uint32_t iovs = (opt_hdd_flags & HDD_OPT_IOVEC) ?
+					HDD_IO_VEC_MAX : 1;
+
+				sqe->opcode = write ? IORING_OP_WRITEV :
+						      IORING_OP_READV;
+				sqe->addr = (uint64_t)(uintptr_t)slot->iov;
+				sqe->len = iovs;
+			}
+			slot->start_ns = latency_now();
+			stress_hdd_uring_commit(r);
+			issued++;
+			inflight++;
+			if (r->queued >= ctx->batch) {
+				if (stress_hdd_uring_enter(r, false) < 0) {
+					pr_fail_err(ctx->name, "io_uring_enter");
+					rc = -1;
+					n = issued;
+				}
+			}
+		}
+		if (!inflight)
+			break;
+
+		if (stress_hdd_uring_enter(r, true) < 0) {
+			pr_fail_err(ctx->name, "io_uring_enter");
+			/* the I/Os in flight still own their slots */
+			rc = -1;
+			break;
+		}
+
+		now = latency_now();
+		head = *r->cq_head;
+		tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+		for (; head != tail; head++) {
+			const struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+			const uint32_t idx = (uint32_t)cqe->user_data;
+			const int res = cqe->res;
+
+			ctx->free_slots[nfree++] = idx;
+			inflight--;
+			if (res < 0) {
+				if ((res == -EINTR) || (res == -EAGAIN))
+					continue;
+				/* out of space, stop writing */
+				if (write && (res == -ENOSPC)) {
+					n = issued;
+					continue;
+				}
+				/* e.g. polled I/O on a file system without it */
+				if (res == -EOPNOTSUPP) {
+					rc = -2;
+					n = issued;
+					continue;
+				}
+				if (rc != -1)
+					pr_fail_errno(ctx->name, write ?
+						"io_uring write" : "io_uring read", -res);
+				rc = -1;
+				n = issued;
+				continue;
+			}
+			if ((size_t)res != ctx->io_size)
+				misreads++;
+			if (!write && (opt_flags & OPT_FLAGS_VERIFY))
+				baddata += stress_hdd_uring_verify(ctx,
+					&ctx->slots[idx], (size_t)res);
+			latency_add(stats, now - ctx->slots[idx].start_ns,
+				(uint64_t)res);
+			(*counter)++;
+		}
+		__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+	}
+	stats->duration += time_now() - t;
+
+	if (misreads)
+		pr_dbg(stderr, "%s: %" PRIu64 " incomplete %s %s\n",
+			ctx->name, misreads, rnd ? "random" : "sequential",
+			write ? "writes" : "reads");
+	if (baddata)
+		pr_fail(stderr, "%s: incorrect data found %"
+			PRIu64 " times\n", ctx->name, baddata);
+	return rc;
+}
+
+/*
+ *  stress_hdd_uring_init()
+ *	create the ring and the I/O slots, returns -1 if
+ *	io_uring is not available
+ */
+static int stress_hdd_uring_init(
+	hdd_uring_ctx_t *ctx,
+	const char *name,
+	uint8_t *bufs)
+{
+	uint32_t setup_flags = 0, i;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->ring.fd = -1;
+	ctx->name = name;
+	ctx->nslots = opt_hdd_iodepth;
+	ctx->batch = STRESS_MINIMUM(opt_hdd_batch, opt_hdd_iodepth);
+	ctx->io_size = (size_t)opt_hdd_write_size;
+	ctx->align = ((opt_hdd_oflags & O_DIRECT) ||
+		      (opt_hdd_uring_flags & HDD_URING_IOPOLL)) ?
+		BUF_ALIGNMENT : 512;
+
+	if (opt_hdd_uring_flags & HDD_URING_SQPOLL)
+		setup_flags |= IORING_SETUP_SQPOLL;
+	if (opt_hdd_uring_flags & HDD_URING_IOPOLL)
+		setup_flags |= IORING_SETUP_IOPOLL;
+
+	if (stress_hdd_uring_setup(&ctx->ring, ctx->nslots, setup_flags) < 0) {
+		if ((errno == EPERM) && (setup_flags & IORING_SETUP_SQPOLL)) {
+			pr_inf(stderr, "%s: io_uring sqpoll not permitted, "
+				"disabling it\n", name);
+			setup_flags &= ~IORING_SETUP_SQPOLL;
+			if (stress_hdd_uring_setup(&ctx->ring, ctx->nslots,
+			    setup_flags) == 0)
+				goto ok;
+		}
+		pr_inf(stderr, "%s: io_uring not available, errno=%d (%s), "
+			"using the sync engine\n", name, errno, strerror(errno));
+		return -1;
+	}
+ok:
+	ctx->slots = calloc(ctx->nslots, sizeof(*ctx->slots));
+	ctx->free_slots = calloc(ctx->nslots, sizeof(*ctx->free_slots));
+	if (!ctx->slots || !ctx->free_slots) {
+		pr_inf(stderr, "%s: cannot allocate io_uring slots, "
+			"using the sync engine\n", name);
+		free(ctx->free_slots);
+		free(ctx->slots);
+		stress_hdd_uring_free(&ctx->ring);
+		return -1;
+	}
+	for (i = 0; i < ctx->nslots; i++) {
+		hdd_uring_slot_t *slot = &ctx->slots[i];
+		const size_t sz = ctx->io_size / HDD_IO_VEC_MAX;
+		size_t j;
+
+		slot->buf = bufs + (i * ctx->io_size);
+		stress_strnrnd((char *)slot->buf, ctx->io_size);
+		if (opt_hdd_flags & HDD_OPT_IOVEC) {
+			for (j = 0; j < HDD_IO_VEC_MAX; j++) {
+				slot->iov[j].iov_base = slot->buf + (j * sz);
+				slot->iov[j].iov_len = sz;
+			}
+		} else {
+			slot->iov[0].iov_base = slot->buf;
+			slot->iov[0].iov_len = ctx->io_size;
+		}
+		ctx->free_slots[i] = i;
+	}
+
+	if (opt_hdd_uring_flags & HDD_URING_FIXED_BUFS) {
+		struct iovec *iov = calloc(ctx->nslots, sizeof(*iov));
+
+		if (iov) {
+			for (i = 0; i < ctx->nslots; i++) {
+				iov[i].iov_base = ctx->slots[i].buf;
+				iov[i].iov_len = ctx->io_size;
+			}
+			ctx->fixed_bufs = (shim_io_uring_register(ctx->ring.fd,
+				IORING_REGISTER_BUFFERS, iov, ctx->nslots) == 0);
+			free(iov);
+		}
+		if (!ctx->fixed_bufs)
+			pr_inf(stderr, "%s: cannot register io_uring buffers, "
+				"errno=%d (%s), using unregistered buffers\n",
+				name, errno, strerror(errno));
+	}
+	return 0;
+}
+
+/*
+ *  stress_hdd_uring_deinit()
+ *	free the ring and the I/O slots
+ */
+static void stress_hdd_uring_deinit(hdd_uring_ctx_t *ctx)
+{
+	free(ctx->free_slots);
+	free(ctx->slots);
+	stress_hdd_uring_free(&ctx->ring);
+}
+
+/*
+ *  stress_hdd_uring_run()
+ *	one pass of the writes and reads selected by --hdd-opts
+ *	on an open file, returns -1 on a failure or -2 if the
+ *	file cannot do I/O this way
+ */
+static int stress_hdd_uring_run(
+	hdd_uring_ctx_t *ctx,
+	const int fd,
+	uint64_t *const counter,
+	const uint64_t max_ops,
+	stress_latency_t *wr,
+	stress_latency_t *rd)
+{
+	const char *name = ctx->name;
+	struct stat statbuf;
+	uint64_t read_size;
+	int rc = 0;
+
+	ctx->fd = fd;
+	ctx->sqe_flags = 0;
+	if (opt_hdd_uring_flags & HDD_URING_FIXED_FILES) {
+		if (shim_io_uring_register(ctx->ring.fd, IORING_REGISTER_FILES,
+		    (void *)&fd, 1) == 0) {
+			ctx->fd = 0;
+			ctx->sqe_flags = IOSQE_FIXED_FILE;
+		}
+	}
+	ctx->written_seq = (opt_hdd_flags & HDD_OPT_WR_SEQ) != 0;
+
+	/* Random Write, over a file sized up front */
+	if (opt_hdd_flags & HDD_OPT_WR_RND) {
+		if (ftruncate(fd, (off_t)opt_hdd_bytes) < 0) {
+			pr_fail_err(name, "ftruncate");
+			rc = -1;
+			goto done;
+		}
+		rc = stress_hdd_uring_phase(ctx, true, true, opt_hdd_bytes,
+			counter, max_ops, wr);
+		if (rc < 0)
+			goto done;
+	}
+	/* Sequential Write */
+	if (opt_hdd_flags & HDD_OPT_WR_SEQ) {
+		rc = stress_hdd_uring_phase(ctx, true, false, opt_hdd_bytes,
+			counter, max_ops, wr);
+		if (rc < 0)
+			goto done;
+	}
+#if _BSD_SOURCE || _XOPEN_SOURCE || _POSIX_C_SOURCE >= 200112L
+	if (opt_hdd_flags & HDD_OPT_FSYNC)
+		(void)fsync(fd);
+#endif
+#if _POSIX_C_SOURCE >= 199309L || _XOPEN_SOURCE >= 500
+	if (opt_hdd_flags & HDD_OPT_FDATASYNC)
+		(void)fdatasync(fd);
+#endif
+
+	if (fstat(fd, &statbuf) < 0) {
+		pr_fail_err(name, "fstat");
+		goto done;
+	}
+	/* Round to write size to get no partial reads */
+	read_size = (uint64_t)statbuf.st_size -
+		(statbuf.st_size % ctx->io_size);
+
+	/* Sequential Read */
+	if ((opt_hdd_flags & HDD_OPT_RD_SEQ) && read_size) {
+		rc = stress_hdd_uring_phase(ctx, false, false, read_size,
+			counter, max_ops, rd);
+		if (rc < 0)
+			goto done;
+	}
+	/* Random Read */
+	if ((opt_hdd_flags & HDD_OPT_RD_RND) && read_size)
+		rc = stress_hdd_uring_phase(ctx, false, true, read_size,
+			counter, max_ops, rd);
+done:
+	if (ctx->sqe_flags & IOSQE_FIXED_FILE)
+		(void)shim_io_uring_register(ctx->ring.fd,
+			IORING_UNREGISTER_FILES, NULL, 0);
+	return rc;
+}
+#endif
+
+/*
+ *  stress_hdd_account()
+ *	account a completed synchronous I/O started at start_ns,
+ *	the time spent in I/O is the sum of the I/O latencies
+ */
+static inline void stress_hdd_account(
+	stress_latency_t *lat,
+	const uint64_t start_ns,
+	const ssize_t ret)
+{
+	const uint64_t ns = latency_now() - start_ns;
+
+	latency_add(lat, ns, (uint64_t)ret);
+	lat->duration += (double)ns / 1000000000.0;
+}
+
+/*
+ *  stress_hdd_report()
+ *	report the IOPS, throughput and latency percentiles
+ *	of each direction and add them to the stressor totals,
+ *	methods is a HDD_ENGINE_* or HDD_LATENCY_MIXED
+ */
+static void stress_hdd_report(
+	const char *name,
+	const uint32_t instance,
+	const int methods,
+	const stress_latency_t *wr,
+	const stress_latency_t *rd)
+{
+	latency_report(name, instance, hdd_latency_methods[methods][0], wr);
+	latency_report(name, instance, hdd_latency_methods[methods][1], rd);
+	latency_merge(hdd_latency_methods[methods][0], wr);
+	latency_merge(hdd_latency_methods[methods][1], rd);
+}
+
+/*
+ *  stress_hdd_uniform()
+ *	uniformly distributed double in [0.0, 1.0)
+ */
+static inline double stress_hdd_uniform(void)
+{
+	return (double)(mwc64() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* mixed workload block and offset generator */
+typedef struct {
+	uint64_t nblocks;	/* HDD_MIX_UNIT blocks in the file */
+	uint64_t nhot;		/* blocks in the hot set */
+	uint32_t total_weight;	/* sum of the block size weights */
+	double zetan;		/* zipf zeta(nblocks, theta) */
+	double alpha;		/* zipf 1 / (1 - theta) */
+	double eta;		/* zipf scaling term */
+	double half_pow_theta;	/* zipf 0.5 ^ theta */
+} hdd_mix_t;
+
+/*
+ *  stress_hdd_zeta()
+ *	generalized harmonic number sum(1..n) 1 / i ^ theta; the tail
+ *	of very large files is approximated by its integral so set up
+ *	stays fast for the largest --hdd-bytes
+ */
+static double stress_hdd_zeta(const uint64_t n, const double theta)
+{
+	const uint64_t exact = STRESS_MINIMUM(n, 1000000);
+	double sum = 0.0;
+	uint64_t i;
+
+	for (i = 1; i <= exact; i++)
+		sum += pow((double)i, -theta);
+	if (n > exact)
+		sum += (pow((double)n, 1.0 - theta) -
+			pow((double)exact, 1.0 - theta)) / (1.0 - theta);
+	return sum;
+}
+
+/*
+ *  stress_hdd_mix_init()
+ *	precompute the offset distribution over a file of size bytes
+ */
+static void stress_hdd_mix_init(hdd_mix_t *mix, const uint64_t size)
+{
+	size_t i;
+
+	memset(mix, 0, sizeof(*mix));
+	mix->nblocks = size / HDD_MIX_UNIT;
+	if (!mix->nblocks)
+		mix->nblocks = 1;
+	for (i = 0; i < hdd_bssplit_n; i++)
+		mix->total_weight += hdd_bssplit[i].weight;
+
+	mix->nhot = (mix->nblocks * opt_hdd_hot_pct) / 100;
+	if (!mix->nhot)
+		mix->nhot = 1;
+
+	if (opt_hdd_dist == HDD_DIST_ZIPF) {
+		const double theta = opt_hdd_zipf_theta;
+		const double n = (double)mix->nblocks;
+		double zeta2;
+
+		mix->half_pow_theta = pow(0.5, theta);
+		zeta2 = 1.0 + mix->half_pow_theta;
+		mix->zetan = stress_hdd_zeta(mix->nblocks, theta);
+		mix->alpha = 1.0 / (1.0 - theta);
+		mix->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) /
+			(1.0 - (zeta2 / mix->zetan));
+	}
+}
+
+/*
+ *  stress_hdd_mix_size()
+ *	pick a block size from the weighted --hdd-bssplit list
+ */
+static inline uint64_t stress_hdd_mix_size(const hdd_mix_t *mix)
+{
+	uint32_t w = mwc32() % mix->total_weight;
+	size_t i;
+
+	for (i = 0; i < hdd_bssplit_n - 1; i++) {
+		if (w < hdd_bssplit[i].weight)
+			break;
+		w -= hdd_bssplit[i].weight;
+	}
+	return hdd_bssplit[i].size;
+}
+
+/*
+ *  stress_hdd_mix_offset()
+ *	pick a HDD_MIX_UNIT aligned offset for an I/O of size bytes
+ *	that lies within a file of file_size bytes. Zipf and hot-cold
+ *	pick a block by popularity rank, the rank is then scattered
+ *	over the file with a multiplicative bijection so the popular
+ *	blocks are not all next to each other.
+ */
+static inline off_t stress_hdd_mix_offset(
+	const hdd_mix_t *mix,
+	const uint64_t size,
+	const uint64_t file_size)
+{
+	const uint64_t n = mix->nblocks;
+	uint64_t rank, offset;
+
+	switch (opt_hdd_dist) {
+	case HDD_DIST_ZIPF: {
+		const double u = stress_hdd_uniform();
+		const double uz = u * mix->zetan;
+
+		if (uz < 1.0)
+			rank = 0;
+		else if (uz < 1.0 + mix->half_pow_theta)
+			rank = 1;
+		else
+			rank = (uint64_t)((double)n *
+				pow((mix->eta * u) - mix->eta + 1.0, mix->alpha));
+		if (rank >= n)
+			rank = n - 1;
+		break;
+	}
+	case HDD_DIST_HOT_COLD:
+		if (((mwc32() % 100) < opt_hdd_hot_access) || (mix->nhot >= n))
+			rank = mwc64() % mix->nhot;
+		else
+			rank = mix->nhot + (mwc64() % (n - mix->nhot));
+		break;
+	default:
+		/* any of the aligned offsets the I/O fits in */
+		return (off_t)((mwc64() % (((file_size - size) / HDD_MIX_UNIT) + 1)) *
+			HDD_MIX_UNIT);
+	}
+	/* 2654435761 is prime and > n, so this permutes 0..n-1 */
+	offset = ((rank * 2654435761ULL) % n) * HDD_MIX_UNIT;
+	if (offset + size > file_size)
+		offset = (file_size - size) & ~(uint64_t)(HDD_MIX_UNIT - 1);
+	return (off_t)offset;
+}
+
+/*
+ *  stress_hdd_mixed()
+ *	fill a file and then hit it with a random mix of reads and
+ *	writes of weighted block sizes and distributed offsets
+ */
+static int stress_hdd_mixed(
+	const char *name,
+	const uint32_t instance,
+	const char *filename,
+	const int flags,
+	uint8_t *buf,
+	uint64_t *const counter,
+	const uint64_t max_ops)
+{
+	stress_latency_t wr_stats, rd_stats;
+	uint64_t file_size, off, misreads = 0, baddata = 0;
+	hdd_mix_t mix;
+	double start;
+	int fd, rc = EXIT_FAILURE;
+
+	memset(&wr_stats, 0, sizeof(wr_stats));
+	memset(&rd_stats, 0, sizeof(rd_stats));
+
+	(void)umask(0077);
+	if ((fd = open(filename, flags, S_IRUSR | S_IWUSR)) < 0) {
+		pr_fail_err(name, "open");
+		return EXIT_FAILURE;
+	}
+	(void)unlink(filename);
+	if (stress_hdd_advise(name, fd, opt_hdd_flags & HDD_OPT_FADV_MASK) < 0)
+		goto close;
+
+	/* Fill the file with the verify pattern so every read hits data */
+	file_size = opt_hdd_bytes & ~(uint64_t)(HDD_MIX_UNIT - 1);
+	for (off = 0; opt_do_run && (off < file_size); ) {
+		const size_t len = (size_t)STRESS_MINIMUM(opt_hdd_write_size,
+			file_size - off);
+		ssize_t ret;
+		size_t j;
+
+		for (j = 0; j < len; j += 512)
+			buf[j] = (off + j) & 0xff;
+		ret = pwrite(fd, buf, len, (off_t)off);
+		if (ret <= 0) {
+			if ((errno == EAGAIN) || (errno == EINTR))
+				continue;
+			if (errno == ENOSPC)
+				break;
+			pr_fail_err(name, "write");
+			goto close;
+		}
+		off += (uint64_t)ret;
+	}
+	file_size = off & ~(uint64_t)(HDD_MIX_UNIT - 1);
+	if (file_size < opt_hdd_write_size) {
+		pr_inf(stderr, "%s: could only write %" PRIu64 " bytes, "
+			"too small for the mixed workload\n", name, off);
+		rc = EXIT_NO_RESOURCE;
+		goto close;
+	}
+	stress_hdd_mix_init(&mix, file_size);
+
+	/* reads and writes share the run time, including think time */
+	start = time_now_monotonic();
+	while (opt_do_run && (!max_ops || *counter < max_ops)) {
+		const bool write = (mwc32() % 100) >= opt_hdd_rwmix;
+		const uint64_t size = stress_hdd_mix_size(&mix);
+		const off_t offset = stress_hdd_mix_offset(&mix, size, file_size);
+		uint64_t t;
+		ssize_t ret;
+		size_t j;
+
+		if (write) {
+			for (j = 0; j < size; j += 512)
+				buf[j] = (offset + j) & 0xff;
+		}
+		if (lseek(fd, offset, SEEK_SET) < 0) {
+			pr_fail_err(name, "lseek");
+			goto close;
+		}
+		t = latency_now();
+		ret = write ? stress_hdd_write(fd, buf, (size_t)size) :
+			      stress_hdd_read(fd, buf, (size_t)size);
+		if (ret <= 0) {
+			if ((errno == EAGAIN) || (errno == EINTR) ||
+			    (errno == ENOSPC))
+				continue;
+			pr_fail_err(name, write ? "write" : "read");
+			goto close;
+		}
+		t = latency_now() - t;
+		if (write) {
+			latency_add(&wr_stats, t, (uint64_t)ret);
+		} else {
+			latency_add(&rd_stats, t, (uint64_t)ret);
+			if (ret != (ssize_t)size)
+				misreads++;
+			if (opt_flags & OPT_FLAGS_VERIFY) {
+				for (j = 0; j < (size_t)ret; j += 512) {
+					if (buf[j] != ((offset + j) & 0xff))
+						baddata++;
+				}
+			}
+		}
+		(*counter)++;
+		if (opt_hdd_think_time)
+			(void)shim_usleep(opt_hdd_think_time);
+	}
+	rc = EXIT_SUCCESS;
+	wr_stats.duration = rd_stats.duration = time_now_monotonic() - start;
+
+	if (misreads)
+		pr_dbg(stderr, "%s: %" PRIu64 " incomplete mixed reads\n",
+			name, misreads);
+	if (baddata)
+		pr_fail(stderr, "%s: incorrect data found %"
+			PRIu64 " times\n", name, baddata);
+close:
+	(void)close(fd);
+	stress_hdd_report(name, instance, HDD_LATENCY_MIXED,
+		&wr_stats, &rd_stats);
+	return rc;
+}
+
 /*
  *  stress_hdd
  *	stress I/O via writes
@@ -330,6 +1440,15 @@ int stress_hdd(
 	int flags = O_CREAT | O_RDWR | O_TRUNC | opt_hdd_oflags;
 	int fadvise_flags = opt_hdd_flags & HDD_OPT_FADV_MASK;
 	size_t opt_index = 0;
+	stress_latency_t wr_stats, rd_stats;
+#if defined(STRESS_HDD_URING)
+	hdd_uring_ctx_t uring;
+	uint8_t *uring_bufs = NULL;
+	bool use_uring = false;
+#endif
+
+	memset(&wr_stats, 0, sizeof(wr_stats));
+	memset(&rd_stats, 0, sizeof(rd_stats));
 
 	if (!set_hdd_bytes) {
 		if (opt_flags & OPT_FLAGS_MAXIMIZE)
@@ -345,6 +1464,39 @@ int stress_hdd(
 			opt_hdd_write_size = MIN_HDD_WRITE_SIZE;
 	}
 
+	if (opt_hdd_mixed) {
+		/* direct and iovec I/O need suitably rounded block sizes */
+		const uint64_t round = (opt_hdd_flags & HDD_OPT_O_DIRECT) ?
+			((opt_hdd_flags & HDD_OPT_IOVEC) ?
+				HDD_IO_VEC_MAX * BUF_ALIGNMENT : BUF_ALIGNMENT) : 512;
+		size_t j;
+
+		if (opt_hdd_engine != HDD_ENGINE_SYNC) {
+			pr_inf(stderr, "%s: the mixed workload uses the "
+				"sync engine\n", name);
+			opt_hdd_engine = HDD_ENGINE_SYNC;
+		}
+		if (!hdd_bssplit_n) {
+			hdd_bssplit[0].size = opt_hdd_write_size;
+			hdd_bssplit[0].weight = 1;
+			hdd_bssplit_n = 1;
+		}
+		/* the I/O buffer is sized for the largest block */
+		opt_hdd_write_size = 0;
+		for (j = 0; j < hdd_bssplit_n; j++) {
+			const uint64_t size = (hdd_bssplit[j].size + round - 1) &
+				~(round - 1);
+
+			if ((size != hdd_bssplit[j].size) && (instance == 0))
+				pr_inf(stderr, "%s: rounding block size %" PRIu64
+					" up to %" PRIu64 " bytes\n",
+					name, hdd_bssplit[j].size, size);
+			hdd_bssplit[j].size = size;
+			if (hdd_bssplit[j].size > opt_hdd_write_size)
+				opt_hdd_write_size = hdd_bssplit[j].size;
+		}
+	}
+
 	if (opt_hdd_flags & HDD_OPT_O_DIRECT) {
 		min_size = (opt_hdd_flags & HDD_OPT_IOVEC) ?
 			HDD_IO_VEC_MAX * BUF_ALIGNMENT : MIN_HDD_WRITE_SIZE;
@@ -368,6 +1520,30 @@ int stress_hdd(
 			name, opt_hdd_write_size);
 	}
 
+#if defined(STRESS_HDD_URING)
+	if (opt_hdd_engine == HDD_ENGINE_IO_URING) {
+		/* polled completions only work on direct I/O */
+		if (opt_hdd_uring_flags & HDD_URING_IOPOLL) {
+			opt_hdd_oflags |= O_DIRECT;
+			flags |= O_DIRECT;
+		}
+		/* direct I/O needs block aligned sizes and offsets */
+		remainder = opt_hdd_write_size % BUF_ALIGNMENT;
+		if ((opt_hdd_oflags & O_DIRECT) && (remainder != 0)) {
+			opt_hdd_write_size += BUF_ALIGNMENT - remainder;
+			pr_inf(stderr, "%s: increasing read/write size to %"
+				PRIu64 " bytes for direct I/O\n",
+				name, opt_hdd_write_size);
+		}
+	}
+#else
+	if (opt_hdd_engine == HDD_ENGINE_IO_URING) {
+		pr_inf(stderr, "%s: io_uring not supported, "
+			"using the sync engine\n", name);
+		opt_hdd_engine = HDD_ENGINE_SYNC;
+	}
+#endif
+
 	/* Ensure complete file size is not less than the I/O size */
 	if (opt_hdd_bytes < opt_hdd_write_size) {
 		opt_hdd_bytes = opt_hdd_write_size;
@@ -410,12 +1586,34 @@ int stress_hdd(
 
 	stress_strnrnd((char *)buf, opt_hdd_write_size);
 
+#if defined(STRESS_HDD_URING)
+	if (opt_hdd_engine == HDD_ENGINE_IO_URING) {
+		ret = posix_memalign((void **)&uring_bufs, BUF_ALIGNMENT,
+			(size_t)opt_hdd_write_size * opt_hdd_iodepth);
+		if (ret || !uring_bufs) {
+			pr_inf(stderr, "%s: cannot allocate io_uring buffers, "
+				"using the sync engine\n", name);
+			uring_bufs = NULL;
+		} else {
+			use_uring = (stress_hdd_uring_init(&uring, name,
+				uring_bufs) == 0);
+		}
+		if (!use_uring)
+			opt_hdd_engine = HDD_ENGINE_SYNC;
+	}
+#endif
+
 	(void)stress_temp_filename(filename, sizeof(filename),
 		name, pid, instance, mwc32());
+	if (opt_hdd_mixed) {
+		rc = stress_hdd_mixed(name, instance, filename, flags,
+			buf, counter, max_ops);
+		goto finish;
+	}
 	do {
 		int fd;
 		struct stat statbuf;
-		uint64_t hdd_read_size;
+		uint64_t hdd_read_size, t;
 
 		/*
 		 * aggressive option with no other option enables
@@ -451,6 +1649,30 @@ int stress_hdd(
 			goto finish;
 		}
 
+#if defined(STRESS_HDD_URING)
+		if (use_uring) {
+			ret = stress_hdd_uring_run(&uring, fd, counter, max_ops,
+				&wr_stats, &rd_stats);
+			(void)close(fd);
+			if (ret == -2) {
+				pr_inf(stderr, "%s: io_uring I/O mode not supported "
+					"on this file system, using the sync engine\n",
+					name);
+				stress_hdd_report(name, instance,
+					HDD_ENGINE_IO_URING, &wr_stats, &rd_stats);
+				stress_hdd_uring_deinit(&uring);
+				memset(&wr_stats, 0, sizeof(wr_stats));
+				memset(&rd_stats, 0, sizeof(rd_stats));
+				opt_hdd_engine = HDD_ENGINE_SYNC;
+				use_uring = false;
+				continue;
+			}
+			if (ret < 0)
+				goto finish;
+			continue;
+		}
+#endif
+
 		/* Random Write */
 		if (opt_hdd_flags & HDD_OPT_WR_RND) {
 			for (i = 0; i < opt_hdd_bytes; i += opt_hdd_write_size) {
@@ -472,6 +1694,7 @@ rnd_wr_retry:
 				for (j = 0; j < opt_hdd_write_size; j++)
 					buf[j] = (offset + j) & 0xff;
 
+				t = latency_now();
 				ret = stress_hdd_write(fd, buf, (size_t)opt_hdd_write_size);
 				if (ret <= 0) {
 					if ((errno == EAGAIN) || (errno == EINTR))
@@ -485,6 +1708,7 @@ rnd_wr_retry:
 					}
 					continue;
 				}
+				stress_hdd_account(&wr_stats, t, ret);
 				(*counter)++;
 			}
 		}
@@ -498,6 +1722,7 @@ seq_wr_retry:
 
 				for (j = 0; j < opt_hdd_write_size; j += 512)
 					buf[j] = (i + j) & 0xff;
+				t = latency_now();
 				ret = stress_hdd_write(fd, buf, (size_t)opt_hdd_write_size);
 				if (ret <= 0) {
 					if ((errno == EAGAIN) || (errno == EINTR))
@@ -511,6 +1736,7 @@ seq_wr_retry:
 					}
 					continue;
 				}
+				stress_hdd_account(&wr_stats, t, ret);
 				(*counter)++;
 			}
 		}
@@ -539,6 +1765,7 @@ seq_rd_retry:
 				if (!opt_do_run || (max_ops && *counter >= max_ops))
 					break;
 
+				t = latency_now();
 				ret = stress_hdd_read(fd, buf, (size_t)opt_hdd_write_size);
 				if (ret <= 0) {
 					if ((errno == EAGAIN) || (errno == EINTR))
@@ -550,6 +1777,7 @@ seq_rd_retry:
 					}
 					continue;
 				}
+				stress_hdd_account(&rd_stats, t, ret);
 				if (ret != (ssize_t)opt_hdd_write_size)
 					misreads++;
 
@@ -595,6 +1823,7 @@ seq_rd_retry:
 rnd_rd_retry:
 				if (!opt_do_run || (max_ops && *counter >= max_ops))
 					break;
+				t = latency_now();
 				ret = stress_hdd_read(fd, buf, (size_t)opt_hdd_write_size);
 				if (ret <= 0) {
 					if ((errno == EAGAIN) || (errno == EINTR))
@@ -606,6 +1835,7 @@ rnd_rd_retry:
 					}
 					continue;
 				}
+				stress_hdd_account(&rd_stats, t, ret);
 				if (ret != (ssize_t)opt_hdd_write_size)
 					misreads++;
 
@@ -639,6 +1869,13 @@ rnd_rd_retry:
 
 	rc = EXIT_SUCCESS;
 finish:
+	stress_hdd_report(name, instance, opt_hdd_engine,
+		&wr_stats, &rd_stats);
+#if defined(STRESS_HDD_URING)
+	if (use_uring)
+		stress_hdd_uring_deinit(&uring);
+	free(uring_bufs);
+#endif
 	free(alloc_buf);
 	(void)stress_temp_dir_rm(name, pid, instance);
 	return rc;
@@ -63,33 +63,7 @@ static void MLOCKED stress_heapsort_handler(int dummy)
 }
 
 /*
- *  stress_heapsort_cmp_1()
- *	heapsort comparison - sort on int32 values
- */
-static int stress_heapsort_cmp_1(const void *p1, const void *p2)
-{
-	const int32_t *i1 = (const int32_t *)p1;
-	const int32_t *i2 = (const int32_t *)p2;
-
-	if (*i1 > *i2)
-		return 1;
-	else if (*i1 < *i2)
-		return -1;
-	else
-		return 0;
-}
-
-/*
- *  stress_heapsort_cmp_1()
- *	heapsort comparison - reverse sort on int32 values
- */
-static int stress_heapsort_cmp_2(const void *p1, const void *p2)
-{
-	return stress_heapsort_cmp_1(p2, p1);
-}
-
-/*
- *  stress_heapsort_cmp_1()
+ *  stress_heapsort_cmp_3()
  *	heapsort comparison - sort on int8 values
  */
 static int stress_heapsort_cmp_3(const void *p1, const void *p2)
@@ -111,27 +85,34 @@ int stress_heapsort(
 	const uint64_t max_ops,
 	const char *name)
 {
-	int32_t *data, *ptr;
-	size_t n, i;
+	uint8_t *data, *orig;
+	size_t n;
+	const size_t size = stress_sort_size();
 	struct sigaction old_action;
+	volatile uint64_t elements = 0;
+	volatile double duration = 0.0;
 	int ret;
 
-	(void)instance;
-
 	if (!set_heapsort_size) {
 		if (opt_flags & OPT_FLAGS_MAXIMIZE)
-			opt_heapsort_size = MAX_HEAPSORT_SIZE;
+			opt_heapsort_size = MAXIMIZE_SORT_SIZE;
 		if (opt_flags & OPT_FLAGS_MINIMIZE)
 			opt_heapsort_size = MIN_HEAPSORT_SIZE;
 	}
 	n = (size_t)opt_heapsort_size;
 
-	if ((data = calloc(n, sizeof(int32_t))) == NULL) {
+	if ((data = calloc(n, size)) == NULL) {
 		pr_fail_dbg(name, "malloc");
 		return EXIT_FAILURE;
 	}
+	if ((orig = calloc(n, size)) == NULL) {
+		pr_fail_dbg(name, "malloc");
+		free(data);
+		return EXIT_FAILURE;
+	}
 
 	if (stress_sighandler(name, SIGALRM, stress_heapsort_handler, &old_action) < 0) {
+		free(orig);
 		free(data);
 		return EXIT_FAILURE;
 	}
@@ -146,56 +127,49 @@ int stress_heapsort(
 	}
 
 	/* This is expensive, do it once */
-	for (ptr = data, i = 0; i < n; i++)
-		*ptr++ = mwc32();
+	stress_sort_fill(orig, n);
 
 	do {
-		/* Sort "random" data */
-		heapsort(data, n, sizeof(uint32_t), stress_heapsort_cmp_1);
-		if (opt_flags & OPT_FLAGS_VERIFY) {
-			for (ptr = data, i = 0; i < n - 1; i++, ptr++) {
-				if (*ptr > *(ptr+1)) {
-					pr_fail(stderr, "%s: sort error "
-						"detected, incorrect ordering "
-						"found\n", name);
-					break;
-				}
-			}
-		}
+		double t;
+
+		/* Sort data from the input distribution */
+		(void)memcpy(data, orig, n * size);
+		t = time_now();
+		(void)heapsort(data, n, size, stress_sort_cmp(false));
+		duration += time_now() - t;
+		elements += n;
+		if ((opt_flags & OPT_FLAGS_VERIFY) &&
+		    !stress_sort_check(data, n, false))
+			pr_fail(stderr, "%s: sort error "
+				"detected, incorrect ordering "
+				"found\n", name);
 		if (!opt_do_run)
 			break;
 
 		/* Reverse sort */
-		heapsort(data, n, sizeof(uint32_t), stress_heapsort_cmp_2);
-		if (opt_flags & OPT_FLAGS_VERIFY) {
-			for (ptr = data, i = 0; i < n - 1; i++, ptr++) {
-				if (*ptr < *(ptr+1)) {
-					pr_fail(stderr, "%s: reverse sort "
-						"error detected, incorrect "
-						"ordering found\n", name);
-					break;
-				}
-			}
-		}
+		(void)heapsort(data, n, size, stress_sort_cmp(true));
+		if ((opt_flags & OPT_FLAGS_VERIFY) &&
+		    !stress_sort_check(data, n, true))
+			pr_fail(stderr, "%s: reverse sort "
+				"error detected, incorrect "
+				"ordering found\n", name);
 		if (!opt_do_run)
 			break;
-		/* And re-order by byte compare */
-		heapsort(data, n * 4, sizeof(uint8_t), stress_heapsort_cmp_3);
-
-		/* Reverse sort this again */
-		heapsort(data, n, sizeof(uint32_t), stress_heapsort_cmp_2);
-		if (opt_flags & OPT_FLAGS_VERIFY) {
-			for (ptr = data, i = 0; i < n - 1; i++, ptr++) {
-				if (*ptr < *(ptr+1)) {
-					pr_fail(stderr, "%s: reverse sort "
-						"error detected, incorrect "
-						"ordering found\n", name);
-					break;
-				}
-			}
+
+		if (stress_sort_int32()) {
+			/* And re-order by byte compare */
+			(void)heapsort(data, n * 4, sizeof(uint8_t), stress_heapsort_cmp_3);
+
+			/* Reverse sort this again */
+			(void)heapsort(data, n, size, stress_sort_cmp(true));
+			if ((opt_flags & OPT_FLAGS_VERIFY) &&
+			    !stress_sort_check(data, n, true))
+				pr_fail(stderr, "%s: reverse sort "
+					"error detected, incorrect "
+					"ordering found\n", name);
+			if (!opt_do_run)
+				break;
 		}
-		if (!opt_do_run)
-			break;
 
 		(*counter)++;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
@@ -203,6 +177,9 @@ int stress_heapsort(
 	do_jmp = false;
 	(void)stress_sigrestore(name, SIGALRM, &old_action);
 tidy:
+	if (!instance)
+		stress_sort_report(name, elements, duration);
+	free(orig);
 	free(data);
 
 	return EXIT_SUCCESS;
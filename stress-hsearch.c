@@ -25,8 +25,69 @@
 #include "stress-ng.h"
 #include <search.h>
 
+#if defined(__x86_64__) && defined(__SSE2__)
+#define STRESS_HSEARCH_SSE2	(1)
+#include <emmintrin.h>
+#endif
+
+#define HSEARCH_METHOD_HSEARCH	(0)		/* glibc hsearch(3) */
+#define HSEARCH_METHOD_LINEAR	(1)		/* grouped linear probing */
+#define HSEARCH_METHOD_ROBINHOOD (2)		/* robin hood probing */
+#define HSEARCH_METHODS		(3)
+#define HSEARCH_METHOD_ALL	(3)		/* cycle through all the methods */
+
+#define HSEARCH_GROUP		(16)		/* slots per linear probe group */
+#define HSEARCH_EMPTY		(0x80)		/* tag of an empty slot */
+#define HSEARCH_MAX_DIST	(255)		/* robin hood probe distance limit */
+
+typedef struct {
+	const char *name;		/* method name */
+	const int method;		/* HSEARCH_METHOD_* */
+} hsearch_method_info_t;
+
+static const hsearch_method_info_t hsearch_methods[] = {
+	{ "hsearch",	HSEARCH_METHOD_HSEARCH },
+	{ "linear",	HSEARCH_METHOD_LINEAR },
+	{ "robinhood",	HSEARCH_METHOD_ROBINHOOD },
+	{ "all",	HSEARCH_METHOD_ALL },
+	{ NULL,		0 }
+};
+
+/* open addressing table slot, the hash is checked before the key */
+typedef struct {
+	uint64_t hash;			/* full hash of the key */
+	const char *key;		/* the key */
+	size_t data;			/* value stored with the key */
+} hsearch_slot_t;
+
+/* native open addressing table */
+typedef struct {
+	uint8_t *tags;			/* 7 bit tags or robin hood distances */
+	hsearch_slot_t *slots;		/* the entries */
+	size_t n;			/* number of slots */
+	size_t groups;			/* number of linear probe groups */
+} hsearch_table_t;
+
+/* glibc's hcreate(3) table entry, used to size the table */
+typedef struct {
+	unsigned int used;		/* hash of the key, 0 if unused */
+	ENTRY entry;			/* the key and data */
+} hsearch_glibc_entry_t;
+
+/* per method totals */
+typedef struct {
+	uint64_t lookups;		/* lookups timed */
+	double duration;		/* time taken by the lookups */
+	size_t bytes;			/* table size */
+} hsearch_stats_t;
+
 static uint64_t opt_hsearch_size = DEFAULT_HSEARCH_SIZE;
 static bool set_hsearch_size = false;
+static uint32_t opt_hsearch_load = DEFAULT_HSEARCH_LOAD;
+static uint32_t opt_hsearch_key_size = DEFAULT_HSEARCH_KEY_SIZE;
+static uint32_t opt_hsearch_hit = DEFAULT_HSEARCH_HIT;
+static int opt_hsearch_method = HSEARCH_METHOD_HSEARCH;
+static stress_corpus_t hsearch_corpus;
 
 /*
  *  stress_set_hsearch_size()
@@ -35,14 +96,380 @@ static bool set_hsearch_size = false;
 void stress_set_hsearch_size(const char *optarg)
 {
 	set_hsearch_size = true;
-        opt_hsearch_size = get_uint64_byte(optarg);
-        check_range("hsearch-size", opt_hsearch_size,
-                MIN_TSEARCH_SIZE, MAX_TSEARCH_SIZE);
+	opt_hsearch_size = get_uint64_byte(optarg);
+	check_range("hsearch-size", opt_hsearch_size,
+		MIN_HSEARCH_SIZE, MAX_HSEARCH_SIZE);
+}
+
+/*
+ *  stress_set_hsearch_load()
+ *	set the hash table load factor percentage
+ */
+void stress_set_hsearch_load(const char *optarg)
+{
+	opt_hsearch_load = get_uint32(optarg);
+	check_range("hsearch-load", opt_hsearch_load,
+		MIN_HSEARCH_LOAD, MAX_HSEARCH_LOAD);
+}
+
+/*
+ *  stress_set_hsearch_key_size()
+ *	set the length of the keys
+ */
+void stress_set_hsearch_key_size(const char *optarg)
+{
+	opt_hsearch_key_size = get_uint32(optarg);
+	check_range("hsearch-key-size", opt_hsearch_key_size,
+		MIN_HSEARCH_KEY_SIZE, MAX_HSEARCH_KEY_SIZE);
+}
+
+/*
+ *  stress_set_hsearch_hit()
+ *	set the percentage of lookups that find their key
+ */
+void stress_set_hsearch_hit(const char *optarg)
+{
+	opt_hsearch_hit = get_uint32(optarg);
+	check_range("hsearch-hit", opt_hsearch_hit,
+		MIN_HSEARCH_HIT, MAX_HSEARCH_HIT);
+}
+
+/*
+ *  stress_set_hsearch_method()
+ *	set the hash table implementation
+ */
+int stress_set_hsearch_method(const char *name)
+{
+	const hsearch_method_info_t *info;
+
+	for (info = hsearch_methods; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_hsearch_method = info->method;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "hsearch-method must be one of:");
+	for (info = hsearch_methods; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_set_hsearch_corpus()
+ *	take the key text from a file
+ */
+int stress_set_hsearch_corpus(const char *filename)
+{
+	stress_corpus_close(&hsearch_corpus);
+	return stress_corpus_open("hsearch-corpus", filename, &hsearch_corpus);
+}
+
+/*
+ *  hsearch_hash()
+ *	FNV-1a of the key with a 64 bit finalizer so the
+ *	top bits used for the tags are well mixed
+ */
+static inline uint64_t hsearch_hash(const char *key, const size_t len)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h ^= (uint8_t)key[i];
+		h *= 0x100000001b3ULL;
+	}
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+/*
+ *  hsearch_reduce()
+ *	map the low 32 bits of a hash onto 0..n-1
+ *	without a division
+ */
+static inline size_t hsearch_reduce(const uint64_t h, const size_t n)
+{
+	return (size_t)(((h & 0xffffffffULL) * (uint64_t)n) >> 32);
+}
+
+/*
+ *  hsearch_match()
+ *	bit mask of the tags in a group equal to tag
+ */
+static inline uint32_t hsearch_match(const uint8_t *group, const uint8_t tag)
+{
+#if defined(STRESS_HSEARCH_SSE2)
+	const __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)tag)));
+#else
+	const uint64_t lsb = 0x0101010101010101ULL;
+	const uint64_t msb = 0x8080808080808080ULL;
+	uint32_t mask = 0;
+	int i;
+
+	for (i = 0; i < HSEARCH_GROUP; i += 8) {
+		uint64_t w;
+		uint64_t m;
+
+		(void)memcpy(&w, group + i, sizeof(w));
+		w ^= lsb * tag;
+		m = (w - lsb) & ~w & msb;
+		while (m) {
+			const int bit = __builtin_ctzll(m);
+
+			/* exact check, the borrow can flag a neighbour */
+			if (group[i + (bit >> 3)] == tag)
+				mask |= 1U << (i + (bit >> 3));
+			m &= m - 1;
+		}
+	}
+	return mask;
+#endif
+}
+
+/*
+ *  hsearch_hcreate_size()
+ *	number of entries glibc's hcreate(3) allocates for
+ *	nel elements, nel rounded up to an odd prime
+ */
+static size_t hsearch_hcreate_size(size_t nel)
+{
+	size_t d;
+
+	if (nel < 3)
+		nel = 3;
+	for (nel |= 1; ; nel += 2) {
+		for (d = 3; d * d <= nel; d += 2) {
+			if (!(nel % d))
+				break;
+		}
+		if (d * d > nel)
+			return nel;
+	}
+}
+
+/*
+ *  hsearch_table_alloc()
+ *	allocate a table of n slots, for linear probing
+ *	n is rounded up to a whole number of groups
+ */
+static int hsearch_table_alloc(hsearch_table_t *t, size_t n, const int method)
+{
+	if (method == HSEARCH_METHOD_LINEAR) {
+		t->groups = (n + HSEARCH_GROUP - 1) / HSEARCH_GROUP;
+		n = t->groups * HSEARCH_GROUP;
+	}
+	t->n = n;
+	t->tags = malloc(n);
+	t->slots = calloc(n, sizeof(*t->slots));
+	if (!t->tags || !t->slots) {
+		free(t->slots);
+		free(t->tags);
+		return -1;
+	}
+	(void)memset(t->tags, (method == HSEARCH_METHOD_LINEAR) ?
+		HSEARCH_EMPTY : 0, n);
+	return 0;
+}
+
+/*
+ *  hsearch_table_free()
+ *	free a native table
+ */
+static void hsearch_table_free(hsearch_table_t *t)
+{
+	free(t->slots);
+	free(t->tags);
+}
+
+/*
+ *  hsearch_linear_insert()
+ *	insert into the first empty slot of the probe sequence
+ *	of groups, the 7 top bits of the hash are the tag
+ */
+static int hsearch_linear_insert(
+	hsearch_table_t *t,
+	const char *key,
+	const size_t len,
+	const size_t data)
+{
+	const uint64_t h = hsearch_hash(key, len);
+	size_t g = hsearch_reduce(h, t->groups), i;
+
+	for (i = 0; i < t->groups; i++) {
+		uint8_t *group = t->tags + (g * HSEARCH_GROUP);
+		const uint32_t empty = hsearch_match(group, HSEARCH_EMPTY);
+
+		if (empty) {
+			const size_t slot = (g * HSEARCH_GROUP) +
+				(size_t)__builtin_ctz(empty);
+
+			t->tags[slot] = (uint8_t)(h >> 57);
+			t->slots[slot].hash = h;
+			t->slots[slot].key = key;
+			t->slots[slot].data = data;
+			return 0;
+		}
+		if (++g == t->groups)
+			g = 0;
+	}
+	return -1;
+}
+
+/*
+ *  hsearch_linear_find()
+ *	compare a group of tags at a time, stop at the
+ *	first group with an empty slot
+ */
+static inline hsearch_slot_t *hsearch_linear_find(
+	const hsearch_table_t *t,
+	const char *key,
+	const size_t len)
+{
+	const uint64_t h = hsearch_hash(key, len);
+	const uint8_t tag = (uint8_t)(h >> 57);
+	size_t g = hsearch_reduce(h, t->groups), i;
+
+	for (i = 0; i < t->groups; i++) {
+		const uint8_t *group = t->tags + (g * HSEARCH_GROUP);
+		uint32_t match = hsearch_match(group, tag);
+
+		while (match) {
+			hsearch_slot_t *s = &t->slots[(g * HSEARCH_GROUP) +
+				(size_t)__builtin_ctz(match)];
+
+			if ((s->hash == h) && !memcmp(s->key, key, len))
+				return s;
+			match &= match - 1;
+		}
+		if (hsearch_match(group, HSEARCH_EMPTY))
+			return NULL;
+		if (++g == t->groups)
+			g = 0;
+	}
+	return NULL;
+}
+
+/*
+ *  hsearch_robinhood_insert()
+ *	insert, displacing entries that are closer to their
+ *	home slot, tags hold the probe distance + 1, 0 is empty
+ */
+static int hsearch_robinhood_insert(
+	hsearch_table_t *t,
+	const char *key,
+	const size_t len,
+	const size_t data)
+{
+	hsearch_slot_t entry;
+	size_t i = hsearch_reduce(hsearch_hash(key, len), t->n);
+	uint32_t dist = 1;
+
+	entry.hash = hsearch_hash(key, len);
+	entry.key = key;
+	entry.data = data;
+
+	for (;;) {
+		if (!t->tags[i]) {
+			t->tags[i] = (uint8_t)dist;
+			t->slots[i] = entry;
+			return 0;
+		}
+		if (t->tags[i] < dist) {
+			const hsearch_slot_t tmp = t->slots[i];
+			const uint32_t tmp_dist = t->tags[i];
+
+			t->slots[i] = entry;
+			t->tags[i] = (uint8_t)dist;
+			entry = tmp;
+			dist = tmp_dist;
+		}
+		if (++dist > HSEARCH_MAX_DIST)
+			return -1;
+		if (++i == t->n)
+			i = 0;
+	}
+}
+
+/*
+ *  hsearch_robinhood_find()
+ *	a miss is known as soon as the probe is further
+ *	from home than the entry in the slot
+ */
+static inline hsearch_slot_t *hsearch_robinhood_find(
+	const hsearch_table_t *t,
+	const char *key,
+	const size_t len)
+{
+	const uint64_t h = hsearch_hash(key, len);
+	size_t i = hsearch_reduce(h, t->n);
+	uint32_t dist;
+
+	for (dist = 1; dist <= t->tags[i]; dist++) {
+		hsearch_slot_t *s = &t->slots[i];
+
+		if ((t->tags[i] == dist) && (s->hash == h) &&
+		    !memcmp(s->key, key, len))
+			return s;
+		if (++i == t->n)
+			i = 0;
+	}
+	return NULL;
+}
+
+/*
+ *  hsearch_make_keys()
+ *	fill buf with n keys of len characters, a prefix
+ *	character, the hex index and then filler; with a
+ *	corpus the key starts with corpus text and ends with
+ *	the prefix and index so the keys stay unique
+ */
+static char **hsearch_make_keys(
+	char *buf,
+	const size_t n,
+	const size_t len,
+	const char prefix)
+{
+	char **keys;
+	size_t i, j;
+
+	if ((keys = calloc(n, sizeof(char *))) == NULL)
+		return NULL;
+
+	for (i = 0; i < n; i++) {
+		char *key = buf + (i * (len + 1));
+
+		if (hsearch_corpus.data) {
+			stress_corpus_copy(&hsearch_corpus, key, len - 8);
+			for (j = 0; j < len - 8; j++) {
+				if (!key[j])
+					key[j] = ' ';
+			}
+			(void)snprintf(key + len - 8, 9, "%c%07zx", prefix,
+				i & 0xfffffff);
+		} else {
+			(void)snprintf(key, len + 1, "%c%07zx", prefix, i);
+			for (j = 8; j < len; j++)
+				key[j] = 'a' + ((i + j) % 26);
+		}
+		key[len] = '\0';
+		keys[i] = key;
+	}
+	return keys;
 }
 
 /*
  *  stress_hsearch()
- *	stress hsearch
+ *	stress hsearch and native open addressing hash tables
  */
 int stress_hsearch(
 	uint64_t *const counter,
@@ -50,81 +477,193 @@ int stress_hsearch(
 	const uint64_t max_ops,
 	const char *name)
 {
-	size_t i, max;
-	int ret = EXIT_FAILURE;
-	char **keys;
-
-	(void)instance;
+	const size_t len = (size_t)opt_hsearch_key_size;
+	hsearch_stats_t stats[HSEARCH_METHODS];
+	hsearch_table_t tables[HSEARCH_METHODS];
+	bool created[HSEARCH_METHODS];
+	size_t i, max, slots;
+	int ret = EXIT_FAILURE, method;
+	char **keys = NULL, **misses = NULL, *key_buf = NULL, *miss_buf = NULL;
+	const char **queries = NULL;
+	size_t *expect = NULL;
 
 	if (!set_hsearch_size) {
 		if (opt_flags & OPT_FLAGS_MAXIMIZE)
-			opt_hsearch_size = MAX_HSEARCH_SIZE;
+			opt_hsearch_size = MAXIMIZE_HSEARCH_SIZE;
 		if (opt_flags & OPT_FLAGS_MINIMIZE)
 			opt_hsearch_size = MIN_HSEARCH_SIZE;
 	}
 
 	max = (size_t)opt_hsearch_size;
+	/* Slots for the requested load factor */
+	slots = (size_t)(((uint64_t)max * 100) / opt_hsearch_load);
 
-	/* Make hash table with 25% slack */
-	if (!hcreate(max + (max / 4))) {
-		pr_fail_err(name, "hcreate");
-		return EXIT_FAILURE;
-	}
+	memset(stats, 0, sizeof(stats));
+	memset(tables, 0, sizeof(tables));
+	memset(created, 0, sizeof(created));
 
-	if ((keys = calloc(max, sizeof(char *))) == NULL) {
+	key_buf = malloc(max * (len + 1));
+	miss_buf = malloc(max * (len + 1));
+	queries = calloc(max, sizeof(*queries));
+	expect = calloc(max, sizeof(*expect));
+	if (!key_buf || !miss_buf || !queries || !expect) {
+		pr_err(stderr, "%s: cannot allocate keys\n", name);
+		ret = EXIT_NO_RESOURCE;
+		goto free_all;
+	}
+	keys = hsearch_make_keys(key_buf, max, len, 'k');
+	misses = hsearch_make_keys(miss_buf, max, len, 'm');
+	if (!keys || !misses) {
 		pr_err(stderr, "%s: cannot allocate keys\n", name);
-		goto free_hash;
+		ret = EXIT_NO_RESOURCE;
+		goto free_all;
 	}
 
-	/* Populate hash, make it 100% full for worst performance */
+	/* Random lookups, hits and misses mixed by the hit ratio */
 	for (i = 0; i < max; i++) {
-		char buffer[32];
-		ENTRY e;
+		const size_t j = (size_t)(mwc64() % max);
 
-		snprintf(buffer, sizeof(buffer), "%zu", i);
-		keys[i] = strdup(buffer);
-		if (!keys[i]) {
-			pr_err(stderr, "%s: cannot allocate key\n", name);
-			goto free_all;
+		if ((mwc32() % 100) < opt_hsearch_hit) {
+			queries[i] = keys[j];
+			expect[i] = j;
+		} else {
+			queries[i] = misses[j];
+			expect[i] = SIZE_MAX;
 		}
+	}
+
+	for (method = 0; method < HSEARCH_METHODS; method++) {
+		if ((opt_hsearch_method != HSEARCH_METHOD_ALL) &&
+		    (opt_hsearch_method != method))
+			continue;
+
+		if (method == HSEARCH_METHOD_HSEARCH) {
+			if (!hcreate(slots)) {
+				pr_fail_err(name, "hcreate");
+				goto free_all;
+			}
+			created[method] = true;
+			for (i = 0; i < max; i++) {
+				ENTRY e;
+
+				e.key = keys[i];
+				e.data = (void *)i;
 
-		e.key = keys[i];
-		e.data = (void *)i;
+				if (hsearch(e, ENTER) == NULL) {
+					pr_err(stderr, "%s: cannot allocate new hash item\n", name);
+					goto free_all;
+				}
+			}
+			/*
+			 * glibc's hcreate(3) rounds up to the next prime and
+			 * allocates one more entry than that, entries are padded
+			 */
+			stats[method].bytes = (hsearch_hcreate_size(slots) + 1) *
+				sizeof(hsearch_glibc_entry_t);
+			continue;
+		}
 
-		if (hsearch(e, ENTER) == NULL) {
-			pr_err(stderr, "%s: cannot allocate new hash item\n", name);
+		if (hsearch_table_alloc(&tables[method], slots, method) < 0) {
+			pr_err(stderr, "%s: cannot allocate %s hash table\n",
+				name, hsearch_methods[method].name);
+			ret = EXIT_NO_RESOURCE;
 			goto free_all;
 		}
+		created[method] = true;
+		stats[method].bytes = tables[method].n *
+			(sizeof(*tables[method].slots) + sizeof(*tables[method].tags));
+
+		for (i = 0; i < max; i++) {
+			const int rc = (method == HSEARCH_METHOD_LINEAR) ?
+				hsearch_linear_insert(&tables[method], keys[i], len, i) :
+				hsearch_robinhood_insert(&tables[method], keys[i], len, i);
+
+			if (rc < 0) {
+				pr_err(stderr, "%s: cannot insert into %s hash table\n",
+					name, hsearch_methods[method].name);
+				goto free_all;
+			}
+		}
 	}
 
+	method = (opt_hsearch_method == HSEARCH_METHOD_ALL) ?
+		HSEARCH_METHOD_HSEARCH : opt_hsearch_method;
 	do {
+		const hsearch_table_t *t = &tables[method];
+		double duration = time_now();
+
 		for (i = 0; opt_do_run && i < max; i++) {
-			ENTRY e, *ep;
-
-			e.key = keys[i];
-			e.data = NULL;	/* Keep Coverity quiet */
-			ep = hsearch(e, FIND);
-			if (opt_flags & OPT_FLAGS_VERIFY) {
-				if (ep == NULL) {
-					pr_fail(stderr, "%s: cannot find key %s\n", name, keys[i]);
-				} else {
-					if (i != (size_t)ep->data) {
-						pr_fail(stderr, "%s: hash returned incorrect data %zd\n", name, i);
-					}
-				}
+			size_t data = SIZE_MAX;
+
+			if (method == HSEARCH_METHOD_HSEARCH) {
+				ENTRY e, *ep;
+
+				e.key = (char *)queries[i];
+				e.data = NULL;	/* Keep Coverity quiet */
+				ep = hsearch(e, FIND);
+				if (ep)
+					data = (size_t)ep->data;
+			} else {
+				const hsearch_slot_t *s = (method == HSEARCH_METHOD_LINEAR) ?
+					hsearch_linear_find(t, queries[i], len) :
+					hsearch_robinhood_find(t, queries[i], len);
+				if (s)
+					data = s->data;
+			}
+			if ((opt_flags & OPT_FLAGS_VERIFY) && (data != expect[i])) {
+				if (expect[i] == SIZE_MAX)
+					pr_fail(stderr, "%s: %s found missing key %s\n",
+						name, hsearch_methods[method].name, queries[i]);
+				else if (data == SIZE_MAX)
+					pr_fail(stderr, "%s: %s cannot find key %s\n",
+						name, hsearch_methods[method].name, queries[i]);
+				else
+					pr_fail(stderr, "%s: %s hash returned incorrect data %zd\n",
+						name, hsearch_methods[method].name, data);
 			}
 		}
+		stats[method].duration += time_now() - duration;
+		stats[method].lookups += i;
+
 		(*counter)++;
+		if (opt_hsearch_method == HSEARCH_METHOD_ALL)
+			method = (method + 1) % HSEARCH_METHODS;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
 
 	ret = EXIT_SUCCESS;
 
+	if (instance == 0) {
+		for (method = 0; method < HSEARCH_METHODS; method++) {
+			const hsearch_stats_t *s = &stats[method];
+
+			if (!s->lookups || (s->duration <= 0.0))
+				continue;
+			pr_inf(stderr, "%s: %-9s %9.2f M lookups/sec, %7.2f ns/lookup, "
+				"%zu keys, %" PRIu32 "%% load, %" PRIu32 "%% hits, "
+				"%.2f MB table%s\n", name, hsearch_methods[method].name,
+				(double)s->lookups / (s->duration * 1000000.0),
+				(s->duration * 1000000000.0) / (double)s->lookups,
+				max, opt_hsearch_load, opt_hsearch_hit,
+				(double)s->bytes / (double)MB,
+				hsearch_corpus.data ? ", corpus keys" : "");
+		}
+	}
+
 free_all:
-	for (i = 0; i < max; i++)
-		free(keys[i]);
+	for (method = 0; method < HSEARCH_METHODS; method++) {
+		if (!created[method])
+			continue;
+		if (method == HSEARCH_METHOD_HSEARCH)
+			hdestroy();
+		else
+			hsearch_table_free(&tables[method]);
+	}
+	free(misses);
 	free(keys);
-free_hash:
-	hdestroy();
+	free(expect);
+	free(queries);
+	free(miss_buf);
+	free(key_buf);
 
 	return ret;
 }
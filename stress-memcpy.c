@@ -24,10 +24,463 @@
  */
 #include "stress-ng.h"
 
+#if defined(__x86_64__) && NEED_GNUC(4,9,0) && !defined(__clang__)
+#define STRESS_MEMCPY_X86	(1)
+#include <immintrin.h>
+#define TARGET_AVX2	__attribute__((target("avx2")))
+#define TARGET_AVX512	__attribute__((target("avx512f")))
+#endif
+
 #define ALIGN_SIZE	(64)
 
+#define MEMCPY_SWEEP_MIN	(16)		/* smallest copy size */
+#define MEMCPY_SWEEP_MAX	(40)		/* max sweep sizes */
+#define MEMCPY_SWEEP_TIME	(0.01)		/* min seconds per sweep point */
+#define MEMCPY_SWEEP_BATCH	(256 * KB)	/* min bytes between timings */
+#define MEMCPY_SWEEP_PAD	(4096)		/* room for misalignment */
+
+typedef void (*stress_memcpy_func)(void *dst, const void *src, size_t n);
+
+typedef struct {
+	const char *name;		/* method name */
+	const stress_memcpy_func func;	/* copy function */
+	bool (*supported)(void);	/* NULL if always supported */
+} stress_memcpy_method_info_t;
+
+/* source and destination offsets from a 64 byte boundary */
+static const struct {
+	size_t src;
+	size_t dst;
+} memcpy_aligns[] = {
+	{ 0, 0 },
+	{ 1, 0 },
+	{ 0, 1 },
+	{ 7, 3 },
+};
+
 static uint8_t buffer[STR_SHARED_SIZE + ALIGN_SIZE];
 
+/*
+ *  stress_memcpy_libc()
+ *	copy with the C library memcpy
+ */
+static void stress_memcpy_libc(void *dst, const void *src, size_t n)
+{
+	(void)memcpy(dst, src, n);
+}
+
+/*
+ *  stress_memcpy_memmove()
+ *	copy with the C library memmove, the buffers
+ *	never overlap so this measures its forward path
+ */
+static void stress_memcpy_memmove(void *dst, const void *src, size_t n)
+{
+	(void)memmove(dst, src, n);
+}
+
+#if defined(STRESS_MEMCPY_X86)
+/*
+ *  stress_memcpy_rep_movsb()
+ *	copy with rep movsb, fast with ERMS and FSRM
+ */
+static void stress_memcpy_rep_movsb(void *dst, const void *src, size_t n)
+{
+	asm volatile("rep movsb"
+		: "+D" (dst), "+S" (src), "+c" (n)
+		:
+		: "memory");
+}
+
+/*
+ *  stress_memcpy_avx2()
+ *	copy with unaligned 256 bit loads and stores
+ */
+static void TARGET_AVX2 stress_memcpy_avx2(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+
+	while (n >= 128) {
+		const __m256i v0 = _mm256_loadu_si256((const __m256i *)(s + 0));
+		const __m256i v1 = _mm256_loadu_si256((const __m256i *)(s + 32));
+		const __m256i v2 = _mm256_loadu_si256((const __m256i *)(s + 64));
+		const __m256i v3 = _mm256_loadu_si256((const __m256i *)(s + 96));
+
+		_mm256_storeu_si256((__m256i *)(d + 0), v0);
+		_mm256_storeu_si256((__m256i *)(d + 32), v1);
+		_mm256_storeu_si256((__m256i *)(d + 64), v2);
+		_mm256_storeu_si256((__m256i *)(d + 96), v3);
+		s += 128;
+		d += 128;
+		n -= 128;
+	}
+	while (n >= 32) {
+		_mm256_storeu_si256((__m256i *)d,
+			_mm256_loadu_si256((const __m256i *)s));
+		s += 32;
+		d += 32;
+		n -= 32;
+	}
+	if (n)
+		(void)memcpy(d, s, n);
+}
+
+/*
+ *  stress_memcpy_avx512()
+ *	copy with unaligned 512 bit loads and stores
+ */
+static void TARGET_AVX512 stress_memcpy_avx512(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+
+	while (n >= 256) {
+		const __m512i v0 = _mm512_loadu_si512((const void *)(s + 0));
+		const __m512i v1 = _mm512_loadu_si512((const void *)(s + 64));
+		const __m512i v2 = _mm512_loadu_si512((const void *)(s + 128));
+		const __m512i v3 = _mm512_loadu_si512((const void *)(s + 192));
+
+		_mm512_storeu_si512((void *)(d + 0), v0);
+		_mm512_storeu_si512((void *)(d + 64), v1);
+		_mm512_storeu_si512((void *)(d + 128), v2);
+		_mm512_storeu_si512((void *)(d + 192), v3);
+		s += 256;
+		d += 256;
+		n -= 256;
+	}
+	while (n >= 64) {
+		_mm512_storeu_si512((void *)d,
+			_mm512_loadu_si512((const void *)s));
+		s += 64;
+		d += 64;
+		n -= 64;
+	}
+	if (n)
+		(void)memcpy(d, s, n);
+}
+
+/*
+ *  stress_memcpy_nt()
+ *	copy with SSE2 non-temporal stores that bypass the
+ *	cache, the destination is aligned to 16 bytes first
+ */
+static void stress_memcpy_nt(void *dst, const void *src, size_t n)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+	const size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+
+	if (n < 64 + head) {
+		(void)memcpy(d, s, n);
+		return;
+	}
+	if (head) {
+		(void)memcpy(d, s, head);
+		s += head;
+		d += head;
+		n -= head;
+	}
+	while (n >= 64) {
+		const __m128i v0 = _mm_loadu_si128((const __m128i *)(s + 0));
+		const __m128i v1 = _mm_loadu_si128((const __m128i *)(s + 16));
+		const __m128i v2 = _mm_loadu_si128((const __m128i *)(s + 32));
+		const __m128i v3 = _mm_loadu_si128((const __m128i *)(s + 48));
+
+		_mm_stream_si128((__m128i *)(d + 0), v0);
+		_mm_stream_si128((__m128i *)(d + 16), v1);
+		_mm_stream_si128((__m128i *)(d + 32), v2);
+		_mm_stream_si128((__m128i *)(d + 48), v3);
+		s += 64;
+		d += 64;
+		n -= 64;
+	}
+	_mm_sfence();
+	if (n)
+		(void)memcpy(d, s, n);
+}
+
+static bool stress_memcpy_avx2_supported(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+static bool stress_memcpy_avx512_supported(void)
+{
+	return __builtin_cpu_supports("avx512f");
+}
+#endif
+
+static const stress_memcpy_method_info_t memcpy_methods[] = {
+	{ "libc",	stress_memcpy_libc,	NULL },
+	{ "memmove",	stress_memcpy_memmove,	NULL },
+#if defined(STRESS_MEMCPY_X86)
+	{ "rep-movsb",	stress_memcpy_rep_movsb, NULL },
+	{ "avx2",	stress_memcpy_avx2,	stress_memcpy_avx2_supported },
+	{ "avx512",	stress_memcpy_avx512,	stress_memcpy_avx512_supported },
+	{ "nt",		stress_memcpy_nt,	NULL },
+#endif
+	{ NULL,		NULL,			NULL }
+};
+
+static const stress_memcpy_method_info_t *opt_memcpy_method = &memcpy_methods[0];
+
+/*
+ *  stress_set_memcpy_method()
+ *	set the memcpy copy method
+ */
+int stress_set_memcpy_method(const char *name)
+{
+	const stress_memcpy_method_info_t *info;
+
+	for (info = memcpy_methods; info->func; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_memcpy_method = info;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "memcpy-method must be one of:");
+	for (info = memcpy_methods; info->func; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_memcpy_supported()
+ *	can the CPU run a copy method?
+ */
+static inline bool stress_memcpy_supported(const stress_memcpy_method_info_t *info)
+{
+	return !info->supported || info->supported();
+}
+
+/*
+ *  stress_memcpy_ticks()
+ *	read the time stamp counter if there is one
+ */
+static inline uint64_t stress_memcpy_ticks(void)
+{
+#if defined(STRESS_MEMCPY_X86)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/* copies of one size, alignment and method */
+typedef struct {
+	uint64_t bytes;			/* bytes copied */
+	uint64_t copies;		/* number of copies */
+	uint64_t ticks;			/* time stamp counter ticks */
+	double duration;		/* time taken */
+} memcpy_sweep_t;
+
+/*
+ *  stress_memcpy_sweep_size()
+ *	human readable copy size
+ */
+static void stress_memcpy_sweep_size(char *str, const size_t len, const uint64_t size)
+{
+	if (size >= MB)
+		(void)snprintf(str, len, "%" PRIu64 "M", size / (uint64_t)MB);
+	else if (size >= KB)
+		(void)snprintf(str, len, "%" PRIu64 "K", size / (uint64_t)KB);
+	else
+		(void)snprintf(str, len, "%" PRIu64 "B", size);
+}
+
+/*
+ *  stress_memcpy_sweep_report()
+ *	report GB/s and cycles (or ns) per copy for each
+ *	alignment, copy size and method
+ */
+static void stress_memcpy_sweep_report(
+	const char *name,
+	const memcpy_sweep_t *sweep,
+	const uint64_t *sizes,
+	const size_t n_sizes,
+	const size_t n_methods)
+{
+	const bool ticks = (stress_memcpy_ticks() != 0);
+	char buf[16 + 20 * n_methods];
+	size_t a, i, m, len;
+
+	for (a = 0; a < SIZEOF_ARRAY(memcpy_aligns); a++) {
+		pr_inf(stderr, "%s: copy GB/s and %s per copy, source/destination "
+			"offset %zd/%zd bytes:\n", name,
+			ticks ? "TSC cycles" : "ns",
+			memcpy_aligns[a].src, memcpy_aligns[a].dst);
+		len = snprintf(buf, sizeof(buf), "%6s", "size");
+		for (m = 0; (m < n_methods) && (len < sizeof(buf)); m++)
+			len += snprintf(buf + len, sizeof(buf) - len, " %19s",
+				memcpy_methods[m].name);
+		pr_inf(stderr, "%s: %s\n", name, buf);
+
+		for (i = 0; i < n_sizes; i++) {
+			char str[16];
+
+			stress_memcpy_sweep_size(str, sizeof(str), sizes[i]);
+			len = snprintf(buf, sizeof(buf), "%6s", str);
+			/* huge per copy counts truncate the row rather than overflow it */
+			for (m = 0; (m < n_methods) && (len < sizeof(buf)); m++) {
+				const memcpy_sweep_t *sw = &sweep[((a * MEMCPY_SWEEP_MAX) + i) * n_methods + m];
+				double per_copy;
+
+				if (!sw->copies || (sw->duration <= 0.0)) {
+					len += snprintf(buf + len, sizeof(buf) - len,
+						" %8s %10s", "-", "-");
+					continue;
+				}
+				per_copy = ticks ? (double)sw->ticks / sw->copies :
+					(sw->duration * 1000000000.0) / sw->copies;
+				len += snprintf(buf + len, sizeof(buf) - len,
+					" %8.2f %10.1f",
+					(double)sw->bytes / (sw->duration * (double)GB),
+					per_copy);
+			}
+			pr_inf(stderr, "%s: %s\n", name, buf);
+		}
+	}
+}
+
+/*
+ *  stress_memcpy_sweep()
+ *	copy sizes from 16 bytes to twice the last level cache
+ *	for each source/destination misalignment and each copy
+ *	method, one pass over everything per bogo op
+ */
+static int stress_memcpy_sweep(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	const size_t n_methods = SIZEOF_ARRAY(memcpy_methods) - 1;
+	uint64_t sizes[MEMCPY_SWEEP_MAX], LLC = 4 * MB, max_size, size;
+	size_t shmall, freemem, totalmem, n_sizes = 0, a, i, m, sz;
+	memcpy_sweep_t *sweep;
+	uint8_t *src, *dst;
+	int rc = EXIT_NO_RESOURCE;
+
+#if defined(__linux__)
+	{
+		cpus_t *cpu_caches = get_all_cpu_cache_details();
+
+		if (cpu_caches) {
+			const uint16_t level = get_max_cache_level(cpu_caches);
+			const cpu_cache_t *cache = level ?
+				get_cpu_cache(cpu_caches, level) : NULL;
+
+			if (cache && cache->size)
+				LLC = cache->size;
+			free_cpu_caches(cpu_caches);
+		}
+	}
+#endif
+	/* Source and destination use no more than half the free memory */
+	stress_get_memlimits(&shmall, &freemem, &totalmem);
+	max_size = 2 * LLC;
+	if (freemem) {
+		const uint64_t limit = (freemem / 4) /
+			stressor_instances(STRESS_MEMCPY);
+
+		if (max_size > limit)
+			max_size = limit;
+	}
+	for (size = MEMCPY_SWEEP_MIN; (size <= max_size) &&
+	     (n_sizes < MEMCPY_SWEEP_MAX); size <<= 1)
+		sizes[n_sizes++] = size;
+	if (!n_sizes) {
+		pr_inf(stderr, "%s: no copy sizes to sweep\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+
+	sweep = calloc(SIZEOF_ARRAY(memcpy_aligns) * MEMCPY_SWEEP_MAX * n_methods,
+		sizeof(*sweep));
+	if (!sweep) {
+		pr_err(stderr, "%s: cannot allocate sweep results\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+	sz = (size_t)sizes[n_sizes - 1] + MEMCPY_SWEEP_PAD;
+	src = mmap(NULL, sz, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (src == MAP_FAILED) {
+		pr_err(stderr, "%s: cannot allocate %zd byte source buffer\n",
+			name, sz);
+		goto err_src;
+	}
+	dst = mmap(NULL, sz, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (dst == MAP_FAILED) {
+		pr_err(stderr, "%s: cannot allocate %zd byte destination buffer\n",
+			name, sz);
+		goto err_dst;
+	}
+	for (i = 0; i < sz / sizeof(uint64_t); i++)
+		((uint64_t *)src)[i] = mwc64();
+	memset(dst, 0, sz);
+
+	if (instance == 0)
+		pr_dbg(stderr, "%s: sweeping copy sizes %d bytes to %" PRIu64
+			"K\n", name, MEMCPY_SWEEP_MIN, sizes[n_sizes - 1] / (uint64_t)KB);
+
+	do {
+		for (a = 0; a < SIZEOF_ARRAY(memcpy_aligns); a++) {
+			const uint8_t *s = src + memcpy_aligns[a].src;
+			uint8_t *d = dst + memcpy_aligns[a].dst;
+
+			for (i = 0; i < n_sizes; i++) {
+				/* Batch small sizes so time_now() is not measured */
+				const uint64_t batch = (sizes[i] < MEMCPY_SWEEP_BATCH) ?
+					MEMCPY_SWEEP_BATCH / sizes[i] : 1;
+
+				for (m = 0; m < n_methods; m++) {
+					const stress_memcpy_method_info_t *info = &memcpy_methods[m];
+					memcpy_sweep_t *sw = &sweep[((a * MEMCPY_SWEEP_MAX) + i) * n_methods + m];
+					uint64_t t1_ticks;
+					double t1, t2;
+
+					if (!opt_do_run)
+						goto done;
+					if (!stress_memcpy_supported(info))
+						continue;
+
+					/* Warm the caches before timing */
+					info->func(d, s, sizes[i]);
+					t1 = time_now();
+					t1_ticks = stress_memcpy_ticks();
+					do {
+						uint64_t j;
+
+						for (j = 0; j < batch; j++)
+							info->func(d, s, sizes[i]);
+						sw->copies += batch;
+						t2 = time_now();
+					} while ((t2 - t1 < MEMCPY_SWEEP_TIME) && opt_do_run);
+					sw->ticks += stress_memcpy_ticks() - t1_ticks;
+					sw->duration += t2 - t1;
+					sw->bytes = sw->copies * sizes[i];
+				}
+			}
+		}
+		(*counter)++;
+	} while (opt_do_run && (!max_ops || *counter < max_ops));
+done:
+	if (instance == 0)
+		stress_memcpy_sweep_report(name, sweep, sizes, n_sizes, n_methods);
+	rc = EXIT_SUCCESS;
+
+	(void)munmap(dst, sz);
+err_dst:
+	(void)munmap(src, sz);
+err_src:
+	free(sweep);
+	return rc;
+}
+
 /*
  *  stress_memcpy()
  *	stress memory copies
@@ -40,13 +493,22 @@ int stress_memcpy(
 {
 	uint8_t *str_shared = shared->str_shared;
 	uint8_t *aligned_buf = align_address(buffer, ALIGN_SIZE);
+	const stress_memcpy_func func = opt_memcpy_method->func;
+
+	if (opt_flags & OPT_FLAGS_MEMCPY_SWEEP)
+		return stress_memcpy_sweep(counter, instance, max_ops, name);
 
-	(void)instance;
-	(void)name;
+	if (!stress_memcpy_supported(opt_memcpy_method)) {
+		if (instance == 0)
+			pr_inf(stderr, "%s: memcpy method '%s' is not supported "
+				"by this CPU, skipping stressor\n",
+				name, opt_memcpy_method->name);
+		return EXIT_NO_RESOURCE;
+	}
 
 	do {
-		memcpy(aligned_buf, str_shared, STR_SHARED_SIZE);
-		memcpy(str_shared, aligned_buf, STR_SHARED_SIZE);
+		func(aligned_buf, str_shared, STR_SHARED_SIZE);
+		func(str_shared, aligned_buf, STR_SHARED_SIZE);
 		memmove(aligned_buf, aligned_buf + 64, STR_SHARED_SIZE - 64);
 		memmove(aligned_buf + 64, aligned_buf, STR_SHARED_SIZE - 64);
 		memmove(aligned_buf + 1, aligned_buf, STR_SHARED_SIZE - 1);
@@ -152,9 +152,15 @@ static void stress_mmap_child(
 		uint8_t *mappings[pages4k];
 		size_t n;
 		const int rnd = mwc32() % SIZEOF_ARRAY(mmap_flags);
-		const int rnd_flag = mmap_flags[rnd];
+		int rnd_flag = mmap_flags[rnd];
 		uint8_t *buf = NULL;
 
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+		/* Random hugetlb flags would override --vm-hugepage */
+		if (stress_hugepage_enabled())
+			rnd_flag &= ~(MAP_HUGETLB | (MAP_HUGE_MASK << MAP_HUGE_SHIFT));
+#endif
+
 		if (no_mem_retries >= NO_MEM_RETRIES_MAX) {
 			pr_err(stderr, "%s: gave up trying to mmap, no available memory\n",
 				name);
@@ -163,7 +169,7 @@ static void stress_mmap_child(
 
 		if (!opt_do_run)
 			break;
-		buf = (uint8_t *)mmap(NULL, sz,
+		buf = (uint8_t *)stress_hugepage_mmap(NULL, sz,
 			PROT_READ | PROT_WRITE, *flags | rnd_flag, fd, 0);
 		if (buf == MAP_FAILED) {
 			/* Force MAP_POPULATE off, just in case */
@@ -231,7 +237,7 @@ static void stress_mmap_child(
 					 * may fail (it's not the most portable operation), so keep
 					 * track of failed mappings too
 					 */
-					mappings[page] = (uint8_t *)mmap((void *)mappings[page],
+					mappings[page] = (uint8_t *)stress_hugepage_mmap((void *)mappings[page],
 						page_size, PROT_READ | PROT_WRITE, MAP_FIXED | *flags, fd, offset);
 					if (mappings[page] == MAP_FAILED) {
 						mapped[page] = PAGE_MAPPED_FAIL;
@@ -286,7 +292,7 @@ int stress_mmap(
 	const uint64_t max_ops,
 	const char *name)
 {
-	const size_t page_size = stress_get_pagesize();
+	const size_t page_size = stress_hugepage_size();
 	size_t sz, pages4k;
 	const pid_t mypid = getpid();
 	pid_t pid;
@@ -303,8 +309,12 @@ int stress_mmap(
 		if (opt_flags & OPT_FLAGS_MINIMIZE)
 			opt_mmap_bytes = MIN_MMAP_BYTES;
 	}
-	sz = opt_mmap_bytes & ~(page_size - 1);
+	/* hugetlb backed pages are mapped and unmapped a huge page at a time */
+	sz = stress_hugepage_align(opt_mmap_bytes & ~(stress_get_pagesize() - 1));
 	pages4k = sz / page_size;
+	if (instance == 0)
+		pr_dbg(stderr, "%s: using %s page backing, %zu bytes per page\n",
+			name, stress_hugepage_name(), page_size);
 
 	/* Make sure this is killable by OOM killer */
 	set_oom_adjustment(name, true);
@@ -262,6 +262,7 @@ static const stress_t stressors[] = {
 	STRESSOR(pipe, PIPE, CLASS_PIPE_IO | CLASS_MEMORY | CLASS_OS),
 	STRESSOR(poll, POLL, CLASS_SCHEDULER | CLASS_OS),
 	STRESSOR(procfs, PROCFS, CLASS_FILESYSTEM | CLASS_OS),
+	STRESSOR(psort, PSORT, CLASS_CPU_CACHE | CLASS_MEMORY | CLASS_SCHEDULER),
 	STRESSOR(pthread, PTHREAD, CLASS_SCHEDULER | CLASS_OS),
 	STRESSOR(ptrace, PTRACE, CLASS_OS),
 	STRESSOR(pty, PTY, CLASS_OS),
@@ -282,6 +283,7 @@ static const stress_t stressors[] = {
 	STRESSOR(seek, SEEK, CLASS_IO | CLASS_OS),
 	STRESSOR(sem, SEMAPHORE_POSIX, CLASS_OS | CLASS_SCHEDULER),
 	STRESSOR(sem_sysv, SEMAPHORE_SYSV, CLASS_OS | CLASS_SCHEDULER),
+	STRESSOR(sharing, SHARING, CLASS_CPU_CACHE | CLASS_MEMORY),
 	STRESSOR(shm, SHM_POSIX, CLASS_VM | CLASS_OS),
 	STRESSOR(shm_sysv, SHM_SYSV, CLASS_VM | CLASS_OS),
 	STRESSOR(sendfile, SENDFILE, CLASS_PIPE_IO | CLASS_OS),
@@ -366,6 +368,10 @@ static const struct option long_options[] = {
 	{ "aiol",	1,	0,	OPT_AIO_LINUX },
 	{ "aiol-ops",	1,	0,	OPT_AIO_LINUX_OPS },
 	{ "aiol-requests",1,	0,	OPT_AIO_LINUX_REQUESTS },
+	{ "aiol-contexts",1,	0,	OPT_AIO_LINUX_CONTEXTS },
+	{ "aiol-bytes",	1,	0,	OPT_AIO_LINUX_BYTES },
+	{ "aiol-direct",0,	0,	OPT_AIO_LINUX_DIRECT },
+	{ "aiol-reap",	1,	0,	OPT_AIO_LINUX_REAP },
 	{ "all",	1,	0,	OPT_ALL },
 	{ "apparmor",	1,	0,	OPT_APPARMOR },
 	{ "apparmor-ops",1,	0,	OPT_APPARMOR_OPS },
@@ -383,6 +389,7 @@ static const struct option long_options[] = {
 	{ "bsearch",	1,	0,	OPT_BSEARCH },
 	{ "bsearch-ops",1,	0,	OPT_BSEARCH_OPS },
 	{ "bsearch-size",1,	0,	OPT_BSEARCH_SIZE },
+	{ "bsearch-method",1,	0,	OPT_BSEARCH_METHOD },
 	{ "cache",	1,	0, 	OPT_CACHE },
 	{ "cache-ops",	1,	0,	OPT_CACHE_OPS },
 	{ "cache-prefetch",0,	0,	OPT_CACHE_PREFETCH },
@@ -391,6 +398,7 @@ static const struct option long_options[] = {
 	{ "cache-level",1,	0,	OPT_CACHE_LEVEL},
 	{ "cache-ways",1,	0,	OPT_CACHE_WAYS},
 	{ "cache-no-affinity",0,	0,	OPT_CACHE_NO_AFFINITY },
+	{ "cache-pingpong",0,	0,	OPT_CACHE_PINGPONG },
 	{ "cap",	1,	0, 	OPT_CAP },
 	{ "cap-ops",	1,	0, 	OPT_CAP_OPS },
 	{ "chdir",	1,	0, 	OPT_CHDIR },
@@ -492,6 +500,14 @@ static const struct option long_options[] = {
 	{ "hdd-bytes",	1,	0,	OPT_HDD_BYTES },
 	{ "hdd-write-size", 1,	0,	OPT_HDD_WRITE_SIZE },
 	{ "hdd-opts",	1,	0,	OPT_HDD_OPTS },
+	{ "hdd-engine",	1,	0,	OPT_HDD_ENGINE },
+	{ "hdd-iodepth",1,	0,	OPT_HDD_IODEPTH },
+	{ "hdd-batch",	1,	0,	OPT_HDD_BATCH },
+	{ "hdd-uring-opts",1,	0,	OPT_HDD_URING_OPTS },
+	{ "hdd-rwmix",	1,	0,	OPT_HDD_RWMIX },
+	{ "hdd-bssplit",1,	0,	OPT_HDD_BSSPLIT },
+	{ "hdd-dist",	1,	0,	OPT_HDD_DIST },
+	{ "hdd-think-time",1,	0,	OPT_HDD_THINK_TIME },
 	{ "heapsort",	1,	0,	OPT_HEAPSORT },
 	{ "heapsort-ops",1,	0,	OPT_HEAPSORT_OPS },
 	{ "heapsort-size",1,	0,	OPT_HEAPSORT_INTEGERS },
@@ -499,6 +515,11 @@ static const struct option long_options[] = {
 	{ "hsearch",	1,	0,	OPT_HSEARCH },
 	{ "hsearch-ops",1,	0,	OPT_HSEARCH_OPS },
 	{ "hsearch-size",1,	0,	OPT_HSEARCH_SIZE },
+	{ "hsearch-method",1,	0,	OPT_HSEARCH_METHOD },
+	{ "hsearch-corpus",1,	0,	OPT_HSEARCH_CORPUS },
+	{ "hsearch-load",1,	0,	OPT_HSEARCH_LOAD },
+	{ "hsearch-key-size",1,0,	OPT_HSEARCH_KEY_SIZE },
+	{ "hsearch-hit",1,	0,	OPT_HSEARCH_HIT },
 	{ "icache",	1,	0,	OPT_ICACHE },
 	{ "icache-ops",	1,	0,	OPT_ICACHE_OPS },
 	{ "icmp-flood",	1,	0,	OPT_ICMP_FLOOD },
@@ -563,6 +584,8 @@ static const struct option long_options[] = {
 	{ "memcpy",	1,	0,	OPT_MEMCPY },
 	{ "memcpy",	1,	0,	OPT_MEMCPY },
 	{ "memcpy-ops",	1,	0,	OPT_MEMCPY_OPS },
+	{ "memcpy-method",1,	0,	OPT_MEMCPY_METHOD },
+	{ "memcpy-sweep",0,	0,	OPT_MEMCPY_SWEEP },
 	{ "memfd",	1,	0,	OPT_MEMFD },
 	{ "memfd-ops",	1,	0,	OPT_MEMFD_OPS },
 	{ "memfd-bytes",1,	0,	OPT_MEMFD_BYTES },
@@ -629,6 +652,11 @@ static const struct option long_options[] = {
 	{ "poll-ops",	1,	0,	OPT_POLL_OPS },
 	{ "procfs",	1,	0,	OPT_PROCFS },
 	{ "procfs-ops",	1,	0,	OPT_PROCFS_OPS },
+	{ "psort",	1,	0,	OPT_PSORT },
+	{ "psort-ops",	1,	0,	OPT_PSORT_OPS },
+	{ "psort-method",1,	0,	OPT_PSORT_METHOD },
+	{ "psort-size",	1,	0,	OPT_PSORT_SIZE },
+	{ "psort-threads",1,	0,	OPT_PSORT_THREADS },
 	{ "pthread",	1,	0,	OPT_PTHREAD },
 	{ "pthread-ops",1,	0,	OPT_PTHREAD_OPS },
 	{ "pthread-max",1,	0,	OPT_PTHREAD_MAX },
@@ -686,6 +714,10 @@ static const struct option long_options[] = {
 	{ "sendfile-ops",1,	0,	OPT_SENDFILE_OPS },
 	{ "sendfile-size",1,	0,	OPT_SENDFILE_SIZE },
 	{ "sequential",	1,	0,	OPT_SEQUENTIAL },
+	{ "sharing",	1,	0,	OPT_SHARING },
+	{ "sharing-ops",1,	0,	OPT_SHARING_OPS },
+	{ "sharing-mode",1,	0,	OPT_SHARING_MODE },
+	{ "sharing-threads",1,	0,	OPT_SHARING_THREADS },
 	{ "shm",	1,	0,	OPT_SHM_POSIX },
 	{ "shm-ops",	1,	0,	OPT_SHM_POSIX_OPS },
 	{ "shm-bytes",	1,	0,	OPT_SHM_POSIX_BYTES },
@@ -721,6 +753,9 @@ static const struct option long_options[] = {
 	{ "sockfd-port",1,	0,	OPT_SOCKET_FD_PORT },
 	{ "sockpair",	1,	0,	OPT_SOCKET_PAIR },
 	{ "sockpair-ops",1,	0,	OPT_SOCKET_PAIR_OPS },
+	{ "sort-dist",	1,	0,	OPT_SORT_DIST },
+	{ "sort-key",	1,	0,	OPT_SORT_KEY },
+	{ "sort-corpus",1,	0,	OPT_SORT_CORPUS },
 	{ "spawn",	1,	0,	OPT_SPAWN },
 	{ "spawn-ops",	1,	0,	OPT_SPAWN_OPS },
 	{ "splice",	1,	0,	OPT_SPLICE },
@@ -734,10 +769,16 @@ static const struct option long_options[] = {
 	{ "str",	1,	0,	OPT_STR },
 	{ "str-ops",	1,	0,	OPT_STR_OPS },
 	{ "str-method",	1,	0,	OPT_STR_METHOD },
+	{ "str-len",	1,	0,	OPT_STR_LEN },
+	{ "str-len-dist",1,	0,	OPT_STR_LEN_DIST },
+	{ "str-align",	1,	0,	OPT_STR_ALIGN },
+	{ "str-corpus",	1,	0,	OPT_STR_CORPUS },
 	{ "stressors",	0,	0,	OPT_STRESSORS },
 	{ "stream",	1,	0,	OPT_STREAM },
 	{ "stream-ops",	1,	0,	OPT_STREAM_OPS },
 	{ "stream-l3-size" ,1,	0,	OPT_STREAM_L3_SIZE },
+	{ "stream-sweep",0,	0,	OPT_STREAM_SWEEP },
+	{ "stream-threads",1,	0,	OPT_STREAM_THREADS },
 	{ "switch",	1,	0,	OPT_SWITCH },
 	{ "switch-ops",	1,	0,	OPT_SWITCH_OPS },
 	{ "symlink",	1,	0,	OPT_SYMLINK },
@@ -751,6 +792,8 @@ static const struct option long_options[] = {
 	{ "sysfs-ops",1,	0,	OPT_SYSFS_OPS },
 	{ "syslog",	0,	0,	OPT_SYSLOG },
 	{ "taskset",	1,	0,	OPT_TASKSET },
+	{ "target-cpu",	1,	0,	OPT_TARGET_CPU },
+	{ "target-mem",	1,	0,	OPT_TARGET_MEM },
 	{ "tee",	1,	0,	OPT_TEE },
 	{ "tee-ops",	1,	0,	OPT_TEE_OPS },
 	{ "temp-path",	1,	0,	OPT_TEMP_PATH },
@@ -771,6 +814,8 @@ static const struct option long_options[] = {
 	{ "tsearch",	1,	0,	OPT_TSEARCH },
 	{ "tsearch-ops",1,	0,	OPT_TSEARCH_OPS },
 	{ "tsearch-size",1,	0,	OPT_TSEARCH_SIZE },
+	{ "tsearch-method",1,	0,	OPT_TSEARCH_METHOD },
+	{ "tsearch-node-lines",1,0,	OPT_TSEARCH_NODE_LINES },
 	{ "thrash",	0,	0,	OPT_THRASH },
 	{ "times",	0,	0,	OPT_TIMES },
 	{ "tz",		0,	0,	OPT_THERMAL_ZONES },
@@ -803,6 +848,7 @@ static const struct option long_options[] = {
 	{ "vm",		1,	0,	OPT_VM },
 	{ "vm-bytes",	1,	0,	OPT_VM_BYTES },
 	{ "vm-hang",	1,	0,	OPT_VM_HANG },
+	{ "vm-hugepage",1,	0,	OPT_VM_HUGEPAGE },
 	{ "vm-keep",	0,	0,	OPT_VM_KEEP },
 #if defined(MAP_POPULATE)
 	{ "vm-populate",0,	0,	OPT_VM_MMAP_POPULATE },
@@ -821,6 +867,9 @@ static const struct option long_options[] = {
 	{ "wcs",	1,	0,	OPT_WCS},
 	{ "wcs-ops",	1,	0,	OPT_WCS_OPS },
 	{ "wcs-method",	1,	0,	OPT_WCS_METHOD },
+	{ "wcs-len",	1,	0,	OPT_WCS_LEN },
+	{ "wcs-len-dist",1,	0,	OPT_WCS_LEN_DIST },
+	{ "wcs-align",	1,	0,	OPT_WCS_ALIGN },
 	{ "wait",	1,	0,	OPT_WAIT },
 	{ "wait-ops",	1,	0,	OPT_WAIT_OPS },
 	{ "xattr",	1,	0,	OPT_XATTR },
@@ -832,6 +881,13 @@ static const struct option long_options[] = {
 	{ "zero-ops",	1,	0,	OPT_ZERO_OPS },
 	{ "zlib",	1,	0,	OPT_ZLIB },
 	{ "zlib-ops",	1,	0,	OPT_ZLIB_OPS },
+	{ "zlib-level",	1,	0,	OPT_ZLIB_LEVEL },
+	{ "zlib-strategy",1,	0,	OPT_ZLIB_STRATEGY },
+	{ "zlib-window-bits",1,	0,	OPT_ZLIB_WINDOW_BITS },
+	{ "zlib-mem-level",1,	0,	OPT_ZLIB_MEM_LEVEL },
+	{ "zlib-threads",1,	0,	OPT_ZLIB_THREADS },
+	{ "zlib-chunk-size",1,	0,	OPT_ZLIB_CHUNK_SIZE },
+	{ "zlib-corpus",1,	0,	OPT_ZLIB_CORPUS },
 	{ "zombie",	1,	0,	OPT_ZOMBIE },
 	{ "zombie-ops",	1,	0,	OPT_ZOMBIE_OPS },
 	{ "zombie-max",	1,	0,	OPT_ZOMBIE_MAX },
@@ -871,6 +927,8 @@ static const help_t help_generic[] = {
 	{ NULL,		"stressors",		"show available stress tests" },
 	{ NULL,		"syslog",		"log messages to the syslog" },
 	{ NULL,		"taskset",		"use specific CPUs (set CPU affinity)" },
+	{ NULL,		"target-cpu P",		"throttle stressors to hold system CPU use at P%" },
+	{ NULL,		"target-mem P",		"throttle stressors to hold system memory use at P%" },
 	{ NULL,		"temp-path",		"specify path for temporary directories and files" },
 	{ NULL,		"thrash",		"force all pages in causing swap thrashing" },
 	{ "t N",	"timeout N",		"timeout after N seconds" },
@@ -901,7 +959,11 @@ static const help_t help_stressors[] = {
 	{ NULL,		"aio-requests N",	"number of async I/O requests per worker" },
 	{ NULL,		"aiol N",		"start N workers that exercise Linux async I/O" },
 	{ NULL,		"aiol-ops N",		"stop after N bogo Linux aio async I/O requests" },
-	{ NULL,		"aiol-requests N",	"number of Linux aio async I/O requests per worker" },
+	{ NULL,		"aiol-requests N",	"number of Linux aio async I/O requests per context" },
+	{ NULL,		"aiol-contexts N",	"number of Linux aio contexts per worker" },
+	{ NULL,		"aiol-bytes N",		"size of the file each Linux aio worker exercises" },
+	{ NULL,		"aiol-direct",		"use O_DIRECT for Linux aio file I/O" },
+	{ NULL,		"aiol-reap M",		"reap Linux aio completions from the user space ring or via io_getevents" },
 	{ NULL,		"apparmor",		"start N workers exercising AppArmor interfaces" },
 	{ NULL,		"apparmor-ops",		"stop after N bogo AppArmor worker bogo operations" },
 	{ NULL,		"atomic",		"start N workers exercising GCC atomic operations" },
@@ -917,6 +979,7 @@ static const help_t help_stressors[] = {
 	{ NULL,		"bsearch N",		"start N workers that exercise a binary search" },
 	{ NULL,		"bsearch-ops N",	"stop after N binary search bogo operations" },
 	{ NULL,		"bsearch-size N",	"number of 32 bit integers to bsearch" },
+	{ NULL,		"bsearch-method M",	"use libc, branchless, eytzinger, btree or all" },
 	{ "C N",	"cache N",		"start N CPU cache thrashing workers" },
 	{ NULL,		"cache-ops N",		"stop after N cache bogo operations" },
 	{ NULL,		"cache-prefetch",	"prefetch on memory reads/writes" },
@@ -924,6 +987,7 @@ static const help_t help_stressors[] = {
 	{ NULL,		"cache-fence",		"serialize stores" },
 	{ NULL,		"cache-level N",	"only exercise specified cache" },
 	{ NULL,		"cache-ways N",		"only fill specified number of cache ways" },
+	{ NULL,		"cache-pingpong",	"measure CAS cache line round trips between CPU pairs" },
 	{ NULL,		"cap N",		"start N workers exercsing capget" },
 	{ NULL,		"cap-ops N",		"stop cap workers after N bogo capget operations" },
 	{ NULL,		"chdir N",		"start N workers thrashing chdir on many paths" },
@@ -1020,14 +1084,27 @@ static const help_t help_stressors[] = {
 	{ "d N",	"hdd N",		"start N workers spinning on write()/unlink()" },
 	{ NULL,		"hdd-ops N",		"stop after N hdd bogo operations" },
 	{ NULL,		"hdd-bytes N",		"write N bytes per hdd worker (default is 1GB)" },
+	{ NULL,		"hdd-engine E",		"specify hdd I/O engine, sync or io_uring" },
+	{ NULL,		"hdd-iodepth N",	"keep N io_uring I/Os in flight" },
+	{ NULL,		"hdd-batch N",		"submit io_uring I/Os N at a time" },
+	{ NULL,		"hdd-uring-opts list",	"specify list of io_uring engine options" },
+	{ NULL,		"hdd-rwmix N",		"mixed workload of N% reads, rest writes" },
+	{ NULL,		"hdd-bssplit list",	"mixed workload size:weight block sizes" },
+	{ NULL,		"hdd-dist D",		"mixed workload offsets, uniform, zipf or hot-cold" },
+	{ NULL,		"hdd-think-time N",	"sleep N microseconds after each mixed I/O" },
 	{ NULL,		"hdd-opts list",	"specify list of various stressor options" },
 	{ NULL,		"hdd-write-size N",	"set the default write size to N bytes" },
 	{ NULL,		"heapsort N",		"start N workers heap sorting 32 bit random integers" },
 	{ NULL,		"heapsort-ops N",	"stop after N heap sort bogo operations" },
-	{ NULL,		"heapsort-size N",	"number of 32 bit integers to sort" },
+	{ NULL,		"heapsort-size N",	"number of elements to sort" },
 	{ NULL,		"hsearch N",		"start N workers that exercise a hash table search" },
 	{ NULL,		"hsearch-ops N",	"stop afer N hash search bogo operations" },
 	{ NULL,		"hsearch-size N",	"number of integers to insert into hash table" },
+	{ NULL,		"hsearch-method M",	"use hsearch, linear, robinhood or all tables" },
+	{ NULL,		"hsearch-corpus F",	"start the keys with text from file F" },
+	{ NULL,		"hsearch-load N",	"fill hash tables to N percent of their slots" },
+	{ NULL,		"hsearch-key-size N",	"use keys of N characters" },
+	{ NULL,		"hsearch-hit N",		"make N percent of the lookups find their key" },
 	{ NULL,		"icache N",		"start N CPU instruction cache thrashing workers" },
 	{ NULL,		"icache-ops N",		"stop after N icache bogo operations" },
 	{ NULL,		"icmp-flood N",		"start N ICMP packet flood workers" },
@@ -1084,12 +1161,14 @@ static const help_t help_stressors[] = {
 	{ NULL,		"membarrier-ops N",	"stop after N membarrier bogo operations" },
 	{ NULL,		"memcpy N",		"start N workers performing memory copies" },
 	{ NULL,		"memcpy-ops N",		"stop after N memcpy bogo operations" },
+	{ NULL,		"memcpy-method M",	"use memcpy method M: libc, rep-movsb, avx2, avx512 or nt" },
+	{ NULL,		"memcpy-sweep",		"sweep copy sizes, alignments and methods, report GB/s" },
 	{ NULL,		"memfd N",		"start N workers allocating memory with memfd_create" },
 	{ NULL,		"memfd-bytes N",	"allocate N bytes for each stress iteration" },
 	{ NULL,		"memfd-ops N",		"stop after N memfd bogo operations" },
 	{ NULL,		"mergesort N",		"start N workers merge sorting 32 bit random integers" },
 	{ NULL,		"mergesort-ops N",	"stop after N merge sort bogo operations" },
-	{ NULL,		"mergesort-size N",	"number of 32 bit integers to sort" },
+	{ NULL,		"mergesort-size N",	"number of elements to sort" },
 	{ NULL,		"mincore N",		"start N workers exercising mincore" },
 	{ NULL,		"mincore-ops N",	"stop after N mincore bogo operations" },
 	{ NULL,		"mincore-random",	"randomly select pages rather than linear scan" },
@@ -1142,6 +1221,11 @@ static const help_t help_stressors[] = {
 	{ NULL,		"poll-ops N",		"stop after N poll bogo operations" },
 	{ NULL,		"procfs N",		"start N workers reading portions of /proc" },
 	{ NULL,		"procfs-ops N",		"stop procfs workers after N bogo read operations" },
+	{ NULL,		"psort N",		"start N workers sorting an array with a thread pool" },
+	{ NULL,		"psort-ops N",		"stop after N parallel sort bogo operations" },
+	{ NULL,		"psort-method M",	"use mergesort, radix, samplesort or all methods" },
+	{ NULL,		"psort-size N",		"number of 32 bit integers to sort" },
+	{ NULL,		"psort-threads N",	"use up to N sorting threads, 0 = online CPUs" },
 	{ NULL,		"pthread N",		"start N workers that create multiple threads" },
 	{ NULL,		"pthread-ops N",	"stop pthread workers after N bogo threads created" },
 	{ NULL,		"pthread-max P",	"create P threads at a time by each worker" },
@@ -1151,7 +1235,7 @@ static const help_t help_stressors[] = {
 	{ NULL,		"pty-ops N",		"stop pty workers after N pty bogo operations" },
 	{ "Q",		"qsort N",		"start N workers qsorting 32 bit random integers" },
 	{ NULL,		"qsort-ops N",		"stop after N qsort bogo operations" },
-	{ NULL,		"qsort-size N",		"number of 32 bit integers to sort" },
+	{ NULL,		"qsort-size N",		"number of elements to sort" },
 	{ NULL,		"quota N",		"start N workers exercising quotactl commands" },
 	{ NULL,		"quota -ops N",		"stop after N quotactl bogo operations" },
 	{ NULL,		"rdrand N",		"start N workers exercising rdrand (x86 only)" },
@@ -1194,6 +1278,10 @@ static const help_t help_stressors[] = {
 	{ NULL,		"sendfile N",		"start N workers exercising sendfile" },
 	{ NULL,		"sendfile-ops N",	"stop after N bogo sendfile operations" },
 	{ NULL,		"sendfile-size N",	"size of data to be sent with sendfile" },
+	{ NULL,		"sharing N",		"start N workers contending on shared cache lines" },
+	{ NULL,		"sharing-ops N",	"stop after N cache line sharing bogo operations" },
+	{ NULL,		"sharing-mode M",	"use sharing mode M: false, padded, true or all" },
+	{ NULL,		"sharing-threads N",	"use N pinned threads per sharing worker, 0 = all CPUs" },
 	{ NULL,		"shm N",		"start N workers that exercise POSIX shared memory" },
 	{ NULL,		"shm-ops N",		"stop after N POSIX shared memory bogo operations" },
 	{ NULL,		"shm-bytes N",		"allocate/free N bytes of POSIX shared memory" },
@@ -1229,6 +1317,9 @@ static const help_t help_stressors[] = {
 	{ NULL,		"sockfd-port P",	"use socket fd ports P to P + number of workers - 1" },
 	{ NULL,		"sockpair N",		"start N workers exercising socket pair I/O activity" },
 	{ NULL,		"sockpair-ops N",	"stop after N socket pair bogo operations" },
+	{ NULL,		"sort-dist D",		"sort input distribution (random, sorted, reversed, ...)" },
+	{ NULL,		"sort-key K",		"sort key type (int32, int64, double, rec16, rec64)" },
+	{ NULL,		"sort-corpus F",	"take the bytes of the sort elements from file F" },
 	{ NULL,		"spawn",		"start N workers spawning stress-ng using posix_spawn" },
 	{ NULL,		"spawn-ops N",		"stop after N spawn bogo operations" },
 	{ NULL,		"splice N",		"start N workers reading/writing using splice" },
@@ -1241,10 +1332,16 @@ static const help_t help_stressors[] = {
 	{ NULL,		"stackmmap-ops N",	"stop after N bogo stackmmap operations" },
 	{ NULL,		"str N",		"start N workers exercising lib C string functions" },
 	{ NULL,		"str-method func",	"specify the string function to stress" },
+	{ NULL,		"str-len N",		"use strings with a mean length of N chars" },
+	{ NULL,		"str-len-dist D",	"string lengths are fixed, uniform or lognormal" },
+	{ NULL,		"str-align N",		"start strings N bytes after a 64 byte boundary" },
+	{ NULL,		"str-corpus F",		"time the string functions on the lines of file F" },
 	{ NULL,		"str-ops N",		"stop after N bogo string operations" },
 	{ NULL,		"stream N",		"start N workers exercising memory bandwidth" },
 	{ NULL,		"stream-ops N",		"stop after N bogo stream operations" },
 	{ NULL,		"stream-l3-size N",	"specify the L3 cache size of the CPU" },
+	{ NULL,		"stream-sweep",		"sweep triad bandwidth over cache sized working sets" },
+	{ NULL,		"stream-threads N",	"run kernels on N pinned threads per worker, 0 = all CPUs" },
 	{ "s N",	"switch N",		"start N workers doing rapid context switches" },
 	{ NULL,		"switch-ops N",		"stop after N context switch bogo operations" },
 	{ NULL,		"symlink N",		"start N workers creating symbolic links" },
@@ -1273,6 +1370,8 @@ static const help_t help_stressors[] = {
 	{ NULL,		"tsearch N",		"start N workers that exercise a tree search" },
 	{ NULL,		"tsearch-ops N",	"stop after N tree search bogo operations" },
 	{ NULL,		"tsearch-size N",	"number of 32 bit integers to tsearch" },
+	{ NULL,		"tsearch-method M",	"select tree method: tsearch, bptree or all" },
+	{ NULL,		"tsearch-node-lines N",	"B+tree node size in cache lines" },
 	{ NULL,		"udp N",		"start N workers performing UDP send/receives " },
 	{ NULL,		"udp-ops N",		"stop after N udp bogo operations" },
 	{ NULL,		"udp-domain D",		"specify domain, default is ipv4" },
@@ -1298,6 +1397,7 @@ static const help_t help_stressors[] = {
 	{ "m N",	"vm N",			"start N workers spinning on anonymous mmap" },
 	{ NULL,		"vm-bytes N",		"allocate N bytes per vm worker (default 256MB)" },
 	{ NULL,		"vm-hang N",		"sleep N seconds before freeing memory" },
+	{ NULL,		"vm-hugepage P",	"back vm, mmap and stream memory with page type P" },
 	{ NULL,		"vm-keep",		"redirty memory instead of reallocating" },
 	{ NULL,		"vm-ops N",		"stop after N vm bogo operations" },
 #if defined(MAP_LOCKED)
@@ -1315,6 +1415,9 @@ static const help_t help_stressors[] = {
 	{ NULL,		"vm-splice-bytes N",	"number of bytes to transfer per vmsplice call" },
 	{ NULL,		"wcs N",		"start N workers on lib C wide char string functions" },
 	{ NULL,		"wcs-method func",	"specify the wide character string function to stress" },
+	{ NULL,		"wcs-len N",		"use wide strings with a mean length of N chars" },
+	{ NULL,		"wcs-len-dist D",	"wide string lengths are fixed, uniform or lognormal" },
+	{ NULL,		"wcs-align N",		"start wide strings N chars after a 64 byte boundary" },
 	{ NULL,		"wcs-ops N",		"stop after N bogo wide character string operations" },
 	{ NULL,		"wait N",		"start N workers waiting on child being stop/resumed" },
 	{ NULL,		"wait-ops N",		"stop after N bogo wait operations" },
@@ -1326,6 +1429,13 @@ static const help_t help_stressors[] = {
 	{ NULL,		"zero-ops N",		"stop after N /dev/zero bogo read operations" },
 	{ NULL,		"zlib N",		"start N workers compressing data with zlib" },
 	{ NULL,		"zlib-ops N",		"stop after N zlib bogo compression operations" },
+	{ NULL,		"zlib-level N",		"set compression level 0 (none) to 9 (best)" },
+	{ NULL,		"zlib-strategy S",	"set strategy: default, filtered, huffman, rle or fixed" },
+	{ NULL,		"zlib-window-bits N",	"set history window size to 2^N bytes, 9..15" },
+	{ NULL,		"zlib-mem-level N",	"set compression state memory level, 1..9" },
+	{ NULL,		"zlib-threads N",	"compress chunks with N threads, 0 to use a pipe" },
+	{ NULL,		"zlib-chunk-size N",	"size of each chunk compressed by a thread" },
+	{ NULL,		"zlib-corpus F",	"compress the contents of file F" },
 	{ NULL,		"zombie N",		"start N workers that rapidly create and reap zombies" },
 	{ NULL,		"zombie-ops N",		"stop after N bogo zombie fork operations" },
 	{ NULL,		"zombie-max N",		"set upper limit of N zombies per worker" },
@@ -1857,6 +1967,8 @@ again:
 
 					n = (i * max_procs) + j;
 					stats[n].start = stats[n].finish = time_now();
+					bandwidth_init(i, &stats[n]);
+					latency_init(i);
 #if defined(STRESS_PERF_STATS)
 					if (opt_flags & OPT_FLAGS_PERF_STATS)
 						(void)perf_open(&stats[n].sp);
@@ -2399,6 +2511,19 @@ next_opt:
 		case OPT_AIO_LINUX_REQUESTS:
 			stress_set_aio_linux_requests(optarg);
 			break;
+		case OPT_AIO_LINUX_CONTEXTS:
+			stress_set_aio_linux_contexts(optarg);
+			break;
+		case OPT_AIO_LINUX_BYTES:
+			stress_set_aio_linux_bytes(optarg);
+			break;
+		case OPT_AIO_LINUX_DIRECT:
+			opt_flags |= OPT_FLAGS_AIOL_DIRECT;
+			break;
+		case OPT_AIO_LINUX_REAP:
+			if (stress_set_aio_linux_reap(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
 		case OPT_ALL:
 			opt_flags |= (OPT_FLAGS_SET | OPT_FLAGS_ALL);
 			opt_all = get_int32(optarg);
@@ -2423,6 +2548,10 @@ next_opt:
 		case OPT_BSEARCH_SIZE:
 			stress_set_bsearch_size(optarg);
 			break;
+		case OPT_BSEARCH_METHOD:
+			if (stress_set_bsearch_method(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
 		case OPT_CACHE_PREFETCH:
 			opt_flags |= OPT_FLAGS_CACHE_PREFETCH;
 			break;
@@ -2443,6 +2572,9 @@ next_opt:
 		case OPT_CACHE_NO_AFFINITY:
 			opt_flags |= OPT_FLAGS_CACHE_NOAFF;
 			break;
+		case OPT_CACHE_PINGPONG:
+			opt_flags |= OPT_FLAGS_CACHE_PINGPONG;
+			break;
 		case OPT_CACHE_WAYS:
 			mem_cache_ways = atoi(optarg);
 			if (mem_cache_ways <= 0)
@@ -2535,12 +2667,57 @@ next_opt:
 		case OPT_HDD_WRITE_SIZE:
 			stress_set_hdd_write_size(optarg);
 			break;
+		case OPT_HDD_ENGINE:
+			if (stress_set_hdd_engine(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_HDD_IODEPTH:
+			stress_set_hdd_iodepth(optarg);
+			break;
+		case OPT_HDD_BATCH:
+			stress_set_hdd_batch(optarg);
+			break;
+		case OPT_HDD_URING_OPTS:
+			if (stress_hdd_uring_opts(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_HDD_RWMIX:
+			stress_set_hdd_rwmix(optarg);
+			break;
+		case OPT_HDD_BSSPLIT:
+			if (stress_set_hdd_bssplit(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_HDD_DIST:
+			if (stress_set_hdd_dist(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_HDD_THINK_TIME:
+			stress_set_hdd_think_time(optarg);
+			break;
 		case OPT_HEAPSORT_INTEGERS:
 			stress_set_heapsort_size(optarg);
 			break;
 		case OPT_HSEARCH_SIZE:
 			stress_set_hsearch_size(optarg);
 			break;
+		case OPT_HSEARCH_CORPUS:
+			if (stress_set_hsearch_corpus(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_HSEARCH_METHOD:
+			if (stress_set_hsearch_method(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_HSEARCH_LOAD:
+			stress_set_hsearch_load(optarg);
+			break;
+		case OPT_HSEARCH_KEY_SIZE:
+			stress_set_hsearch_key_size(optarg);
+			break;
+		case OPT_HSEARCH_HIT:
+			stress_set_hsearch_hit(optarg);
+			break;
 		case OPT_IGNITE_CPU:
 			opt_flags |= OPT_FLAGS_IGNITE_CPU;
 			break;
@@ -2590,6 +2767,13 @@ next_opt:
 		case OPT_MAXIMIZE:
 			opt_flags |= OPT_FLAGS_MAXIMIZE;
 			break;
+		case OPT_MEMCPY_METHOD:
+			if (stress_set_memcpy_method(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_MEMCPY_SWEEP:
+			opt_flags |= OPT_FLAGS_MEMCPY_SWEEP;
+			break;
 		case OPT_MEMFD_BYTES:
 			stress_set_memfd_bytes(optarg);
 			break;
@@ -2654,6 +2838,16 @@ next_opt:
 			stress_set_pipe_size(optarg);
 			break;
 #endif
+		case OPT_PSORT_METHOD:
+			if (stress_set_psort_method(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_PSORT_SIZE:
+			stress_set_psort_size(optarg);
+			break;
+		case OPT_PSORT_THREADS:
+			stress_set_psort_threads(optarg);
+			break;
 		case OPT_PTHREAD_MAX:
 			stress_set_pthread_max(optarg);
 			break;
@@ -2720,6 +2914,13 @@ next_opt:
 		case OPT_SHM_SYSV_BYTES:
 			stress_set_shm_sysv_bytes(optarg);
 			break;
+		case OPT_SHARING_MODE:
+			if (stress_set_sharing_mode(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_SHARING_THREADS:
+			stress_set_sharing_threads(optarg);
+			break;
 		case OPT_SHM_SYSV_SEGMENTS:
 			stress_set_shm_sysv_segments(optarg);
 			break;
@@ -2740,6 +2941,18 @@ next_opt:
 		case OPT_SOCKET_PORT:
 			stress_set_socket_port(optarg);
 			break;
+		case OPT_SORT_DIST:
+			if (stress_set_sort_dist(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_SORT_CORPUS:
+			if (stress_set_sort_corpus(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_SORT_KEY:
+			if (stress_set_sort_key(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
 		case OPT_SOCKET_TYPE:
 			if (stress_set_socket_type(optarg) < 0)
 				exit(EXIT_FAILURE);
@@ -2757,9 +2970,29 @@ next_opt:
 			if (stress_set_str_method(optarg) < 0)
 				exit(EXIT_FAILURE);
 			break;
+		case OPT_STR_LEN:
+			stress_set_str_len(optarg);
+			break;
+		case OPT_STR_LEN_DIST:
+			if (stress_set_str_len_dist(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_STR_CORPUS:
+			if (stress_set_str_corpus(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_STR_ALIGN:
+			stress_set_str_align(optarg);
+			break;
 		case OPT_STREAM_L3_SIZE:
 			stress_set_stream_L3_size(optarg);
 			break;
+		case OPT_STREAM_SWEEP:
+			opt_flags |= OPT_FLAGS_STREAM_SWEEP;
+			break;
+		case OPT_STREAM_THREADS:
+			stress_set_stream_threads(optarg);
+			break;
 		case OPT_STRESSORS:
 			show_stressors();
 			exit(EXIT_SUCCESS);
@@ -2773,6 +3006,12 @@ next_opt:
 			if (set_cpu_affinity(optarg) < 0)
 				exit(EXIT_FAILURE);
 			break;
+		case OPT_TARGET_CPU:
+			stress_set_target_cpu(optarg);
+			break;
+		case OPT_TARGET_MEM:
+			stress_set_target_mem(optarg);
+			break;
 		case OPT_THRASH:
 			opt_flags |= OPT_FLAGS_THRASH;
 			break;
@@ -2805,6 +3044,13 @@ next_opt:
 		case OPT_TSEARCH_SIZE:
 			stress_set_tsearch_size(optarg);
 			break;
+		case OPT_TSEARCH_METHOD:
+			if (stress_set_tsearch_method(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_TSEARCH_NODE_LINES:
+			stress_set_tsearch_node_lines(optarg);
+			break;
 		case OPT_THERMAL_ZONES:
 			opt_flags |= OPT_FLAGS_THERMAL_ZONES;
 			break;
@@ -2846,6 +3092,10 @@ next_opt:
 		case OPT_VM_HANG:
 			stress_set_vm_hang(optarg);
 			break;
+		case OPT_VM_HUGEPAGE:
+			if (stress_set_vm_hugepage(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
 		case OPT_VM_KEEP:
 			opt_flags |= OPT_FLAGS_VM_KEEP;
 			break;
@@ -2873,9 +3123,42 @@ next_opt:
 			if (stress_set_wcs_method(optarg) < 0)
 				exit(EXIT_FAILURE);
 			break;
+		case OPT_WCS_LEN:
+			stress_set_wcs_len(optarg);
+			break;
+		case OPT_WCS_LEN_DIST:
+			if (stress_set_wcs_len_dist(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_WCS_ALIGN:
+			stress_set_wcs_align(optarg);
+			break;
 		case OPT_YAML:
 			yamlfile = optarg;
 			break;
+		case OPT_ZLIB_LEVEL:
+			stress_set_zlib_level(optarg);
+			break;
+		case OPT_ZLIB_STRATEGY:
+			if (stress_set_zlib_strategy(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_ZLIB_WINDOW_BITS:
+			stress_set_zlib_window_bits(optarg);
+			break;
+		case OPT_ZLIB_MEM_LEVEL:
+			stress_set_zlib_mem_level(optarg);
+			break;
+		case OPT_ZLIB_THREADS:
+			stress_set_zlib_threads(optarg);
+			break;
+		case OPT_ZLIB_CORPUS:
+			if (stress_set_zlib_corpus(optarg) < 0)
+				exit(EXIT_FAILURE);
+			break;
+		case OPT_ZLIB_CHUNK_SIZE:
+			stress_set_zlib_chunk_size(optarg);
+			break;
 		case OPT_ZOMBIE_MAX:
 			stress_set_zombie_max(optarg);
 			break;
@@ -3042,6 +3325,8 @@ next_opt:
 #endif
 #if defined(HAVE_LIB_PTHREAD)
         pthread_spin_init(&shared->warn_once.lock, 0);
+	pthread_spin_init(&shared->bandwidth.lock, 0);
+	pthread_spin_init(&shared->latency.lock, 0);
 #endif
 
 	/*
@@ -3063,6 +3348,7 @@ next_opt:
 	proc_helper(proc_init, SIZEOF_ARRAY(proc_init));
 	if (opt_flags & OPT_FLAGS_THRASH)
 		thrash_start();
+	(void)target_start();
 
 	if (opt_flags & OPT_FLAGS_SEQUENTIAL) {
 		/*
@@ -3098,6 +3384,7 @@ next_opt:
 			shared->stats, &duration, &success, &resource_success);
 	}
 
+	target_stop();
 	if (opt_flags & OPT_FLAGS_THRASH)
 		thrash_stop();
 
@@ -3113,8 +3400,11 @@ next_opt:
 		pr_yaml(yaml, "---\n");
 		pr_yaml_runinfo(yaml);
 	}
-	if (opt_flags & OPT_FLAGS_METRICS)
+	if (opt_flags & OPT_FLAGS_METRICS) {
 		metrics_dump(yaml, max_procs, ticks_per_sec);
+		bandwidth_dump(yaml, stressors, procs, max_procs);
+		latency_dump(yaml, stressors);
+	}
 #if defined(STRESS_PERF_STATS)
 	if (opt_flags & OPT_FLAGS_PERF_STATS)
 		perf_stat_dump(yaml, stressors, procs, max_procs, duration);
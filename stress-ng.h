@@ -211,6 +211,10 @@ typedef unsigned long int __kernel_ulong_t;
 #define OPT_FLAGS_PATHOLOGICAL	0x1000000000000ULL	/* --pathological */
 #define OPT_FLAGS_NO_RAND_SEED	0x2000000000000ULL	/* --no-rand-seed */
 #define OPT_FLAGS_THRASH	0x4000000000000ULL	/* --thrash */
+#define OPT_FLAGS_STREAM_SWEEP	0x8000000000000ULL	/* --stream-sweep */
+#define OPT_FLAGS_CACHE_PINGPONG 0x10000000000000ULL	/* --cache-pingpong */
+#define OPT_FLAGS_MEMCPY_SWEEP	0x20000000000000ULL	/* --memcpy-sweep */
+#define OPT_FLAGS_AIOL_DIRECT	0x40000000000000ULL	/* --aiol-direct */
 
 #define OPT_FLAGS_AGGRESSIVE_MASK \
 	(OPT_FLAGS_AFFINITY_RAND | OPT_FLAGS_UTIME_FSYNC | \
@@ -229,6 +233,8 @@ typedef unsigned long int __kernel_ulong_t;
 #define WARN_ONCE_CACHE_WAY	0x00000008	/* cache way too high */
 #define WARN_ONCE_CACHE_SIZE	0x00000010	/* cache size info */
 #define WARN_ONCE_CACHE_REDUCED	0x00000020	/* reduced cache */
+#define WARN_ONCE_HUGEPAGE	0x00000040	/* no huge pages */
+#define WARN_ONCE_THP_PRIVATE	0x00000080	/* thp mapped private */
 
 
 /* Stressor classes */
@@ -299,12 +305,25 @@ extern void pr_openlog(const char *filename);
 #define MAX_AIO_LINUX_REQUESTS	(4096)
 #define DEFAULT_AIO_LINUX_REQUESTS	(64)
 
+#define MIN_AIO_LINUX_CONTEXTS	(1)
+#define MAX_AIO_LINUX_CONTEXTS	(64)
+#define DEFAULT_AIO_LINUX_CONTEXTS	(1)
+
+#define MIN_AIO_LINUX_BYTES	(1 * MB)
+#define MAX_AIO_LINUX_BYTES	(256ULL * GB)
+#define DEFAULT_AIO_LINUX_BYTES	(256 * MB)
+
 #define MIN_BIGHEAP_GROWTH	(4 * KB)
 #define MAX_BIGHEAP_GROWTH	(64 * MB)
 #define DEFAULT_BIGHEAP_GROWTH	(64 * KB)
 
 #define MIN_BSEARCH_SIZE	(1 * KB)
-#define MAX_BSEARCH_SIZE	(4 * MB)
+#if UINTPTR_MAX == MAX_32
+#define MAX_BSEARCH_SIZE	(16 * MB)
+#else
+#define MAX_BSEARCH_SIZE	(128 * MB)
+#endif
+#define MAXIMIZE_BSEARCH_SIZE	(4 * MB)
 #define DEFAULT_BSEARCH_SIZE	(64 * KB)
 
 #define MIN_CLONES		(1)
@@ -336,6 +355,21 @@ extern void pr_openlog(const char *filename);
 #define MAX_HDD_WRITE_SIZE	(4 * MB)
 #define DEFAULT_HDD_WRITE_SIZE	(64 * 1024)
 
+#define MIN_HDD_IODEPTH		(1)
+#define MAX_HDD_IODEPTH		(4096)
+#define DEFAULT_HDD_IODEPTH	(32)
+
+#define MIN_HDD_BATCH		(1)
+#define MAX_HDD_BATCH		(4096)
+#define DEFAULT_HDD_BATCH	(8)
+
+#define MIN_HDD_RWMIX		(0)
+#define MAX_HDD_RWMIX		(100)
+#define DEFAULT_HDD_RWMIX	(50)
+
+#define MIN_HDD_THINK_TIME	(0)
+#define MAX_HDD_THINK_TIME	(1000000)	/* 1 second */
+
 #define MIN_FALLOCATE_BYTES	(1 * MB)
 #if UINTPTR_MAX == MAX_32
 #define MAX_FALLOCATE_BYTES	(MAX_32)
@@ -376,8 +410,16 @@ extern void pr_openlog(const char *filename);
 #define MAX_FORKS		(16000)
 #define DEFAULT_FORKS		(1)
 
+/* Sort stressors, sizes are in elements */
+#if UINTPTR_MAX == MAX_32
+#define MAX_SORT_SIZE		(64 * MB)
+#else
+#define MAX_SORT_SIZE		(4ULL * GB)
+#endif
+#define MAXIMIZE_SORT_SIZE	(4 * MB)
+
 #define MIN_HEAPSORT_SIZE	(1 * KB)
-#define MAX_HEAPSORT_SIZE	(4 * MB)
+#define MAX_HEAPSORT_SIZE	MAX_SORT_SIZE
 #define DEFAULT_HEAPSORT_SIZE	(256 * KB)
 
 #define MIN_VFORKS		(1)
@@ -385,8 +427,25 @@ extern void pr_openlog(const char *filename);
 #define DEFAULT_VFORKS		(1)
 
 #define MIN_HSEARCH_SIZE	(1 * KB)
-#define MAX_HSEARCH_SIZE	(4 * MB)
+#if UINTPTR_MAX == MAX_32
+#define MAX_HSEARCH_SIZE	(16 * MB)
+#else
+#define MAX_HSEARCH_SIZE	(256 * MB)
+#endif
 #define DEFAULT_HSEARCH_SIZE	(8 * KB)
+#define MAXIMIZE_HSEARCH_SIZE	(4 * MB)
+
+#define MIN_HSEARCH_LOAD	(10)
+#define MAX_HSEARCH_LOAD	(95)
+#define DEFAULT_HSEARCH_LOAD	(80)
+
+#define MIN_HSEARCH_KEY_SIZE	(8)
+#define MAX_HSEARCH_KEY_SIZE	(256)
+#define DEFAULT_HSEARCH_KEY_SIZE (8)
+
+#define MIN_HSEARCH_HIT		(0)
+#define MAX_HSEARCH_HIT		(100)
+#define DEFAULT_HSEARCH_HIT	(100)
 
 #define MIN_LEASE_BREAKERS	(1)
 #define MAX_LEASE_BREAKERS	(64)
@@ -426,7 +485,7 @@ extern void pr_openlog(const char *filename);
 
 
 #define MIN_MERGESORT_SIZE	(1 * KB)
-#define MAX_MERGESORT_SIZE	(4 * MB)
+#define MAX_MERGESORT_SIZE	MAX_SORT_SIZE
 #define DEFAULT_MERGESORT_SIZE	(256 * KB)
 
 #define MIN_MMAP_BYTES		(4 * KB)
@@ -453,12 +512,20 @@ extern void pr_openlog(const char *filename);
 #endif
 #define DEFAULT_MSYNC_BYTES	(256 * MB)
 
+#define MIN_PSORT_SIZE		(1 * KB)
+#define MAX_PSORT_SIZE		MAX_SORT_SIZE
+#define DEFAULT_PSORT_SIZE	(4 * MB)
+
+#define MIN_PSORT_THREADS	(0)
+#define MAX_PSORT_THREADS	(1024)
+#define DEFAULT_PSORT_THREADS	(0)
+
 #define MIN_PTHREAD		(1)
 #define MAX_PTHREAD		(30000)
 #define DEFAULT_PTHREAD		(1024)
 
 #define MIN_QSORT_SIZE		(1 * KB)
-#define MAX_QSORT_SIZE		(4 * MB)
+#define MAX_QSORT_SIZE		MAX_SORT_SIZE
 #define DEFAULT_QSORT_SIZE	(256 * KB)
 
 #define MIN_READAHEAD_BYTES	(1 * MB)
@@ -515,6 +582,10 @@ extern void pr_openlog(const char *filename);
 #define MAX_SOCKET_FD_PORT	(65535)
 #define DEFAULT_SOCKET_FD_PORT	(8000)
 
+#define MIN_SHARING_THREADS	(0)
+#define MAX_SHARING_THREADS	(1024)
+#define DEFAULT_SHARING_THREADS	(0)
+
 #define MIN_SPLICE_BYTES	(1*KB)
 #define MAX_SPLICE_BYTES	(64*MB)
 #define DEFAULT_SPLICE_BYTES	(64*KB)
@@ -527,6 +598,10 @@ extern void pr_openlog(const char *filename);
 #endif
 #define DEFAULT_STREAM_L3_SIZE	(4 * MB)
 
+#define MIN_STREAM_THREADS	(0)
+#define MAX_STREAM_THREADS	(1024)
+#define DEFAULT_STREAM_THREADS	(1)
+
 #define MIN_SYNC_FILE_BYTES	(1 * MB)
 #if UINTPTR_MAX == MAX_32
 #define MAX_SYNC_FILE_BYTES	(MAX_32)
@@ -536,10 +611,20 @@ extern void pr_openlog(const char *filename);
 #define DEFAULT_SYNC_FILE_BYTES	(1 * GB)
 
 
+#define MIN_TARGET_CPU		(1)
+#define MAX_TARGET_CPU		(100)
+
+#define MIN_TARGET_MEM		(1)
+#define MAX_TARGET_MEM		(100)
+
 #define MIN_TSEARCH_SIZE	(1 * KB)
 #define MAX_TSEARCH_SIZE	(4 * MB)
 #define DEFAULT_TSEARCH_SIZE	(64 * KB)
 
+#define MIN_TSEARCH_NODE_LINES	(1)
+#define MAX_TSEARCH_NODE_LINES	(16)
+#define DEFAULT_TSEARCH_NODE_LINES (1)
+
 #define MIN_TIMER_FREQ		(1)
 #define MAX_TIMER_FREQ		(100000000)
 #define DEFAULT_TIMER_FREQ	(1000000)
@@ -584,6 +669,26 @@ extern void pr_openlog(const char *filename);
 #define MAX_VM_SPLICE_BYTES	(64*MB)
 #define DEFAULT_VM_SPLICE_BYTES	(64*KB)
 
+#define MIN_ZLIB_LEVEL		(0)
+#define MAX_ZLIB_LEVEL		(9)
+#define DEFAULT_ZLIB_LEVEL	(9)
+
+#define MIN_ZLIB_WINDOW_BITS	(9)
+#define MAX_ZLIB_WINDOW_BITS	(15)
+#define DEFAULT_ZLIB_WINDOW_BITS (15)
+
+#define MIN_ZLIB_MEM_LEVEL	(1)
+#define MAX_ZLIB_MEM_LEVEL	(9)
+#define DEFAULT_ZLIB_MEM_LEVEL	(8)
+
+#define MIN_ZLIB_THREADS	(0)
+#define MAX_ZLIB_THREADS	(1024)
+#define DEFAULT_ZLIB_THREADS	(0)
+
+#define MIN_ZLIB_CHUNK_SIZE	(4 * KB)
+#define MAX_ZLIB_CHUNK_SIZE	(16 * MB)
+#define DEFAULT_ZLIB_CHUNK_SIZE	(128 * KB)
+
 #define MIN_ZOMBIES		(1)
 #define MAX_ZOMBIES		(1000000)
 #define DEFAULT_ZOMBIES		(8192)
@@ -594,6 +699,28 @@ extern void pr_openlog(const char *filename);
 #define DEFAULT_DIRS		(8192)
 
 #define STR_SHARED_SIZE		(65536 * 32)
+
+/*
+ *  The second string is half the first and both are random
+ *  lower case letters, 16 of them keep a chance match of the
+ *  verify checks' must differ comparisons out of reach
+ */
+#define MIN_STR_LEN		(32)
+#define MAX_STR_LEN		(16 * KB)
+#define DEFAULT_STR_LEN		(256)
+
+#define MIN_STR_ALIGN		(0)
+#define MAX_STR_ALIGN		(63)
+#define DEFAULT_STR_ALIGN	(0)
+
+#define MIN_WCS_ALIGN		(0)
+#define MAX_WCS_ALIGN		(15)
+#define DEFAULT_WCS_ALIGN	(0)
+
+/* string length distributions */
+#define STRESS_LEN_DIST_FIXED		(0)
+#define STRESS_LEN_DIST_UNIFORM		(1)
+#define STRESS_LEN_DIST_LOGNORMAL	(2)
 #define MEM_CACHE_SIZE		(65536 * 32)
 #define DEFAULT_CACHE_LEVEL     3
 #define UNDEFINED		(-1)
@@ -781,6 +908,11 @@ enum {
 	STRESS_PERF_HW_BRANCH_MISSES,
 	STRESS_PERF_HW_BUS_CYCLES,
 	STRESS_PERF_HW_REF_CPU_CYCLES,
+	STRESS_PERF_HW_CACHE_L1D_LOADS,
+	STRESS_PERF_HW_CACHE_L1D_LOAD_MISSES,
+	STRESS_PERF_HW_CACHE_DTLB_LOADS,
+	STRESS_PERF_HW_CACHE_DTLB_LOAD_MISSES,
+	STRESS_PERF_HW_CACHE_DTLB_STORE_MISSES,
 
 	STRESS_PERF_SW_PAGE_FAULTS_MIN,
 	STRESS_PERF_SW_PAGE_FAULTS_MAJ,
@@ -852,12 +984,50 @@ typedef struct {
 } stress_tz_t;
 #endif
 
+#define STRESS_BANDWIDTH_MAX	(64)	/* Max bandwidth accounting methods */
+#define STRESS_BANDWIDTH_NAME	(32)	/* Max bandwidth method name length */
+
+/* Per stressor method memory bandwidth accounting */
+typedef struct {
+	char method[STRESS_BANDWIDTH_NAME];	/* method name, "" = unused */
+	uint32_t stressor;		/* index into stressors table */
+	uint64_t bytes_read;		/* total bytes read */
+	uint64_t bytes_written;		/* total bytes written */
+	double duration;		/* time spent reading and writing */
+} stress_bandwidth_t;
+
+#define STRESS_LATENCY_MAX	(16)	/* Max latency accounting methods */
+#define STRESS_LATENCY_NAME	(32)	/* Max latency method name length */
+#define STRESS_LATENCY_BUCKETS	(976)	/* 61 powers of 2 x 16 sub buckets */
+
+/* Operation latency histogram and totals */
+typedef struct {
+	uint64_t count;			/* number of operations */
+	uint64_t bytes;			/* bytes transferred */
+	uint64_t total_ns;		/* sum of latencies */
+	uint64_t max_ns;		/* worst latency */
+	double duration;		/* time spent doing the operations */
+	uint64_t bucket[STRESS_LATENCY_BUCKETS];	/* log-linear histogram */
+} stress_latency_t;
+
+/* Per stressor method latency accounting */
+typedef struct {
+	char method[STRESS_LATENCY_NAME];	/* method name, "" = unused */
+	uint32_t stressor;		/* index into stressors table */
+	double ops_rate;		/* sum of instance ops per second */
+	double mb_rate;			/* sum of instance MB per second */
+	stress_latency_t lat;		/* merged instance latencies */
+} stress_latency_method_t;
+
 /* Per process statistics and accounting info */
 typedef struct {
 	uint64_t counter;		/* number of bogo ops */
 	struct tms tms;			/* run time stats of process */
 	double start;			/* wall clock start time */
 	double finish;			/* wall clock stop time */
+	uint64_t bytes_read;		/* bytes read, for bandwidth stats */
+	uint64_t bytes_written;		/* bytes written */
+	double bytes_duration;		/* time spent reading and writing */
 #if defined(STRESS_PERF_STATS)
 	stress_perf_t sp;		/* perf counters */
 #endif
@@ -912,6 +1082,28 @@ typedef struct {
 #if defined(STRESS_THERMAL_ZONES)
 	tz_info_t *tz_info;				/* List of valid thermal zones */
 #endif
+	struct {
+#if defined(HAVE_LIB_PTHREAD)
+		pthread_spinlock_t lock;		/* protection lock */
+#endif
+		stress_bandwidth_t method[STRESS_BANDWIDTH_MAX];
+	} bandwidth;					/* Per method bandwidth */
+	struct {
+#if defined(HAVE_LIB_PTHREAD)
+		pthread_spinlock_t lock;		/* protection lock */
+#endif
+		stress_latency_method_t method[STRESS_LATENCY_MAX];
+	} latency;					/* Per method latency */
+	struct {
+		bool cpu;				/* --target-cpu enabled */
+		bool mem;				/* --target-mem enabled */
+		double cpu_duty;			/* CPU duty cycle, 0.0..1.0 */
+		double mem_duty;			/* Fraction of memory to use */
+		double cpu_util;			/* Sum of sampled CPU % */
+		double mem_util;			/* Sum of sampled memory % */
+		uint64_t cpu_samples;			/* Number of CPU samples */
+		uint64_t mem_samples;			/* Number of memory samples */
+	} target;					/* Utilisation controller knobs */
 	proc_stats_t stats[0];				/* Shared statistics */
 } shared_t;
 
@@ -1020,6 +1212,7 @@ typedef enum {
 	STRESS_PIPE,
 	STRESS_POLL,
 	STRESS_PROCFS,
+	STRESS_PSORT,
 	STRESS_PTHREAD,
 	STRESS_PTRACE,
 	STRESS_PTY,
@@ -1041,6 +1234,7 @@ typedef enum {
 	STRESS_SEMAPHORE_POSIX,
 	STRESS_SEMAPHORE_SYSV,
 	STRESS_SENDFILE,
+	STRESS_SHARING,
 	STRESS_SHM_POSIX,
 	STRESS_SHM_SYSV,
 	STRESS_SIGFD,
@@ -1149,6 +1343,10 @@ typedef enum {
 	OPT_AIO_LINUX,
 	OPT_AIO_LINUX_OPS,
 	OPT_AIO_LINUX_REQUESTS,
+	OPT_AIO_LINUX_CONTEXTS,
+	OPT_AIO_LINUX_BYTES,
+	OPT_AIO_LINUX_DIRECT,
+	OPT_AIO_LINUX_REAP,
 
 	OPT_APPARMOR,
 	OPT_APPARMOR_OPS,
@@ -1163,6 +1361,7 @@ typedef enum {
 	OPT_BSEARCH,
 	OPT_BSEARCH_OPS,
 	OPT_BSEARCH_SIZE,
+	OPT_BSEARCH_METHOD,
 
 	OPT_BIGHEAP_OPS,
 	OPT_BIGHEAP_GROWTH,
@@ -1178,6 +1377,7 @@ typedef enum {
 	OPT_CACHE_LEVEL,
 	OPT_CACHE_WAYS,
 	OPT_CACHE_NO_AFFINITY,
+	OPT_CACHE_PINGPONG,
 
 	OPT_CAP,
 	OPT_CAP_OPS,
@@ -1308,6 +1508,14 @@ typedef enum {
 	OPT_HDD_WRITE_SIZE,
 	OPT_HDD_OPS,
 	OPT_HDD_OPTS,
+	OPT_HDD_ENGINE,
+	OPT_HDD_IODEPTH,
+	OPT_HDD_BATCH,
+	OPT_HDD_URING_OPTS,
+	OPT_HDD_RWMIX,
+	OPT_HDD_BSSPLIT,
+	OPT_HDD_DIST,
+	OPT_HDD_THINK_TIME,
 
 	OPT_HEAPSORT,
 	OPT_HEAPSORT_OPS,
@@ -1316,6 +1524,11 @@ typedef enum {
 	OPT_HSEARCH,
 	OPT_HSEARCH_OPS,
 	OPT_HSEARCH_SIZE,
+	OPT_HSEARCH_METHOD,
+	OPT_HSEARCH_CORPUS,
+	OPT_HSEARCH_LOAD,
+	OPT_HSEARCH_KEY_SIZE,
+	OPT_HSEARCH_HIT,
 
 	OPT_ICACHE,
 	OPT_ICACHE_OPS,
@@ -1403,6 +1616,8 @@ typedef enum {
 
 	OPT_MEMCPY,
 	OPT_MEMCPY_OPS,
+	OPT_MEMCPY_METHOD,
+	OPT_MEMCPY_SWEEP,
 
 	OPT_MEMFD,
 	OPT_MEMFD_OPS,
@@ -1491,6 +1706,12 @@ typedef enum {
 	OPT_PROCFS,
 	OPT_PROCFS_OPS,
 
+	OPT_PSORT,
+	OPT_PSORT_OPS,
+	OPT_PSORT_METHOD,
+	OPT_PSORT_SIZE,
+	OPT_PSORT_THREADS,
+
 	OPT_PTHREAD,
 	OPT_PTHREAD_OPS,
 	OPT_PTHREAD_MAX,
@@ -1566,6 +1787,11 @@ typedef enum {
 	OPT_SEMAPHORE_SYSV_OPS,
 	OPT_SEMAPHORE_SYSV_PROCS,
 
+	OPT_SHARING,
+	OPT_SHARING_OPS,
+	OPT_SHARING_MODE,
+	OPT_SHARING_THREADS,
+
 	OPT_SHM_POSIX,
 	OPT_SHM_POSIX_OPS,
 	OPT_SHM_POSIX_BYTES,
@@ -1607,6 +1833,10 @@ typedef enum {
 	OPT_SOCKET_PORT,
 	OPT_SOCKET_TYPE,
 
+	OPT_SORT_DIST,
+	OPT_SORT_KEY,
+	OPT_SORT_CORPUS,
+
 	OPT_SOCKET_FD,
 	OPT_SOCKET_FD_OPS,
 	OPT_SOCKET_FD_PORT,
@@ -1633,10 +1863,16 @@ typedef enum {
 	OPT_STR,
 	OPT_STR_OPS,
 	OPT_STR_METHOD,
+	OPT_STR_LEN,
+	OPT_STR_LEN_DIST,
+	OPT_STR_ALIGN,
+	OPT_STR_CORPUS,
 
 	OPT_STREAM,
 	OPT_STREAM_OPS,
 	OPT_STREAM_L3_SIZE,
+	OPT_STREAM_SWEEP,
+	OPT_STREAM_THREADS,
 
 	OPT_STRESSORS,
 
@@ -1660,6 +1896,9 @@ typedef enum {
 
 	OPT_TASKSET,
 
+	OPT_TARGET_CPU,
+	OPT_TARGET_MEM,
+
 	OPT_TEMP_PATH,
 
 	OPT_THERMAL_ZONES,
@@ -1688,6 +1927,8 @@ typedef enum {
 	OPT_TSEARCH,
 	OPT_TSEARCH_OPS,
 	OPT_TSEARCH_SIZE,
+	OPT_TSEARCH_METHOD,
+	OPT_TSEARCH_NODE_LINES,
 
 	OPT_UDP,
 	OPT_UDP_OPS,
@@ -1723,6 +1964,7 @@ typedef enum {
 
 	OPT_VM_BYTES,
 	OPT_VM_HANG,
+	OPT_VM_HUGEPAGE,
 	OPT_VM_KEEP,
 	OPT_VM_MMAP_POPULATE,
 	OPT_VM_MMAP_LOCKED,
@@ -1743,6 +1985,9 @@ typedef enum {
 	OPT_WCS,
 	OPT_WCS_OPS,
 	OPT_WCS_METHOD,
+	OPT_WCS_LEN,
+	OPT_WCS_LEN_DIST,
+	OPT_WCS_ALIGN,
 
 	OPT_XATTR,
 	OPT_XATTR_OPS,
@@ -1754,6 +1999,13 @@ typedef enum {
 
 	OPT_ZLIB,
 	OPT_ZLIB_OPS,
+	OPT_ZLIB_LEVEL,
+	OPT_ZLIB_STRATEGY,
+	OPT_ZLIB_WINDOW_BITS,
+	OPT_ZLIB_MEM_LEVEL,
+	OPT_ZLIB_THREADS,
+	OPT_ZLIB_CHUNK_SIZE,
+	OPT_ZLIB_CORPUS,
 
 	OPT_ZOMBIE,
 	OPT_ZOMBIE_OPS,
@@ -1797,6 +2049,9 @@ typedef struct cpu_cache {
 	uint64_t           size;      /* bytes */
 	uint32_t           line_size; /* bytes */
 	uint32_t           ways;
+	int32_t            id;        /* cache id, -1 if unknown */
+	uint32_t           shared_count; /* number of CPUs sharing this cache */
+	cpu_set_t          shared_cpus;  /* CPUs sharing this cache */
 } cpu_cache_t;
 
 struct generic_map {
@@ -1807,6 +2062,10 @@ struct generic_map {
 typedef struct cpu {
 	uint32_t       num;
 	bool           online;
+	int32_t        package;   /* physical package id, -1 if unknown */
+	int32_t        core;      /* core id within the package, -1 if unknown */
+	int32_t        node;      /* NUMA node, -1 if unknown */
+	cpu_set_t      siblings;  /* SMT siblings, including this CPU */
 	uint32_t       cache_count;
 	cpu_cache_t   *caches;
 } cpu_t;
@@ -1958,6 +2217,7 @@ extern void perf_init(void);
 #endif
 
 extern double time_now(void);
+extern double time_now_monotonic(void);
 extern const char *duration_to_str(const double duration);
 
 /* Misc settings helpers */
@@ -2003,6 +2263,9 @@ extern void stress_set_timer_slack_ns(const char *optarg);
 extern void stress_set_timer_slack(void);
 extern WARN_UNUSED int stress_set_temp_path(char *path);
 extern void stress_strnrnd(char *str, const size_t len);
+extern int stress_set_len_dist(const char *opt, const char *name);
+extern size_t stress_len_dist(const int dist, const size_t len,
+	const size_t min, const size_t max);
 extern void stress_get_cache_size(uint64_t *l2, uint64_t *l3);
 extern WARN_UNUSED unsigned int stress_get_cpu(void);
 extern WARN_UNUSED int stress_cache_alloc(const char *name);
@@ -2064,10 +2327,70 @@ static inline WARN_UNUSED uint32_t warn_once(const uint32_t flag)
 extern int madvise_random(void *addr, const size_t length);
 extern int mincore_touch_pages(void *buf, const size_t buf_len);
 
+/* Huge page backing */
+extern bool stress_hugepage_enabled(void);
+extern const char *stress_hugepage_name(void);
+extern size_t stress_hugepage_size(void);
+extern size_t stress_hugepage_align(const size_t sz);
+extern void *stress_hugepage_mmap(void *addr, const size_t length,
+	const int prot, int flags, const int fd, const off_t offset);
+
+/* Corpus files used as stressor input */
+typedef struct {
+	const uint8_t *data;		/* the mapped file */
+	size_t size;			/* size of the file */
+	size_t offset;			/* where the next chunk starts */
+	const char *filename;		/* the file */
+} stress_corpus_t;
+
+extern int stress_corpus_open(const char *opt, const char *filename,
+	stress_corpus_t *corpus);
+extern const uint8_t *stress_corpus_next(stress_corpus_t *corpus,
+	const size_t size, size_t *len);
+extern void stress_corpus_copy(stress_corpus_t *corpus, void *buf,
+	const size_t size);
+extern const char *stress_corpus_line(stress_corpus_t *corpus,
+	const size_t max, size_t *len);
+extern void stress_corpus_close(stress_corpus_t *corpus);
+
+/* Sort stressor data */
+typedef int (*stress_sort_cmp_func)(const void *p1, const void *p2);
+extern int stress_set_sort_dist(const char *name);
+extern int stress_set_sort_key(const char *name);
+extern int stress_set_sort_corpus(const char *filename);
+extern size_t stress_sort_size(void);
+extern stress_sort_cmp_func stress_sort_cmp(const bool reverse);
+extern bool stress_sort_int32(void);
+extern void stress_sort_fill(void *data, const size_t n);
+extern void stress_sort_fill_int32(int32_t *data, const size_t n);
+extern const char *stress_sort_dist_name(void);
+extern bool stress_sort_check(const void *data, const size_t n, const bool reverse);
+extern void stress_sort_report(const char *name, const uint64_t elements,
+	const double duration);
+
 /* Mounts */
 extern void mount_free(char *mnts[], const int n);
 extern WARN_UNUSED int mount_get(char *mnts[], const int max);
 
+/* memory bandwidth accounting */
+extern void bandwidth_init(const uint32_t stressor, proc_stats_t *stats);
+extern void bandwidth_add(const char *method, const uint64_t bytes_read,
+	const uint64_t bytes_written, const double duration);
+extern void bandwidth_dump(FILE *yaml, const stress_t stressors[],
+	const proc_info_t procs[STRESS_MAX], const int32_t max_procs);
+
+/* operation latency accounting */
+extern void latency_init(const uint32_t stressor);
+extern uint64_t latency_now(void);
+extern void latency_add(stress_latency_t *lat, const uint64_t ns,
+	const uint64_t bytes);
+extern uint64_t latency_percentile(const stress_latency_t *lat,
+	const double percent);
+extern void latency_report(const char *name, const uint32_t instance,
+	const char *method, const stress_latency_t *lat);
+extern void latency_merge(const char *method, const stress_latency_t *lat);
+extern void latency_dump(FILE *yaml, const stress_t stressors[]);
+
 #if defined(STRESS_THERMAL_ZONES)
 /* thermal zones */
 extern int tz_init(tz_info_t **tz_info_list);
@@ -2102,19 +2425,35 @@ extern cpus_t *get_all_cpu_cache_details(void);
 extern uint16_t get_max_cache_level(const cpus_t *cpus);
 extern cpu_cache_t *get_cpu_cache(const cpus_t *cpus, const uint16_t cache_level);
 extern void free_cpu_caches(cpus_t *cpus);
+extern cpu_t *get_cpu_by_num(const cpus_t *cpus, const uint32_t num);
+extern cpu_cache_t *get_cpu_cache_by_num(const cpus_t *cpus, const uint32_t num,
+	const uint16_t cache_level);
+extern uint32_t get_cpu_cache_count(const cpus_t *cpus, const uint16_t cache_level);
+extern uint64_t get_cpu_cache_total_size(const cpus_t *cpus, const uint16_t cache_level);
+extern uint32_t get_cpu_package_count(const cpus_t *cpus);
+extern uint32_t get_cpu_core_count(const cpus_t *cpus);
+extern uint32_t get_cpu_node_count(const cpus_t *cpus);
+extern void log_cpu_topology(const char *name, const cpus_t *cpus);
 #endif
 
 extern int  thrash_start(void);
 extern void thrash_stop(void);
 
+extern int  target_start(void);
+extern void target_stop(void);
+
 /* Used to set options for specific stressors */
 extern void stress_adjust_pthread_max(uint64_t max);
 extern void stress_adjust_sleep_max(uint64_t max);
 extern int  stress_apparmor_supported(void);
 extern void stress_set_aio_requests(const char *optarg);
 extern void stress_set_aio_linux_requests(const char *optarg);
+extern void stress_set_aio_linux_contexts(const char *optarg);
+extern void stress_set_aio_linux_bytes(const char *optarg);
+extern int stress_set_aio_linux_reap(const char *name);
 extern void stress_set_bigheap_growth(const char *optarg);
 extern void stress_set_bsearch_size(const char *optarg);
+extern int  stress_set_bsearch_method(const char *name);
 extern void stress_set_clone_max(const char *optarg);
 extern void stress_set_copy_file_bytes(const char *optarg);
 extern void stress_set_cpu_load(const char *optarg);
@@ -2137,8 +2476,21 @@ extern void stress_set_fstat_dir(const char *optarg);
 extern void stress_set_hdd_bytes(const char *optarg);
 extern int  stress_hdd_opts(char *opts);
 extern void stress_set_hdd_write_size(const char *optarg);
+extern int  stress_set_hdd_engine(const char *name);
+extern void stress_set_hdd_iodepth(const char *optarg);
+extern void stress_set_hdd_batch(const char *optarg);
+extern int  stress_hdd_uring_opts(char *opts);
+extern void stress_set_hdd_rwmix(const char *optarg);
+extern int  stress_set_hdd_bssplit(char *opts);
+extern int  stress_set_hdd_dist(char *opt);
+extern void stress_set_hdd_think_time(const char *optarg);
 extern void stress_set_heapsort_size(const void *optarg);
 extern void stress_set_hsearch_size(const char *optarg);
+extern int  stress_set_hsearch_method(const char *name);
+extern int  stress_set_hsearch_corpus(const char *filename);
+extern void stress_set_hsearch_load(const char *optarg);
+extern void stress_set_hsearch_key_size(const char *optarg);
+extern void stress_set_hsearch_hit(const char *optarg);
 extern int  stress_icmp_flood_supported(void);
 extern void stress_set_itimer_freq(const char *optarg);
 extern void stress_set_lease_breakers(const char *optarg);
@@ -2148,6 +2500,7 @@ extern void stress_set_malloc_max(const char *optarg);
 extern void stress_set_malloc_threshold(const char *optarg);
 extern int  stress_set_matrix_method(const char *name);
 extern void stress_set_matrix_size(const char *optarg);
+extern int  stress_set_memcpy_method(const char *name);
 extern void stress_set_memfd_bytes(const char *optarg);
 extern void stress_set_mergesort_size(const void *optarg);
 extern void stress_set_mmap_bytes(const char *optarg);
@@ -2156,6 +2509,9 @@ extern void stress_set_mremap_bytes(const char *optarg);
 extern void stress_set_msync_bytes(const char *optarg);
 extern void stress_set_pipe_data_size(const char *optarg);
 extern void stress_set_pipe_size(const char *optarg);
+extern int  stress_set_psort_method(const char *name);
+extern void stress_set_psort_size(const char *optarg);
+extern void stress_set_psort_threads(const char *optarg);
 extern void stress_set_pthread_max(const char *optarg);
 extern void stress_set_qsort_size(const void *optarg);
 extern int  stress_rdrand_supported(void);
@@ -2166,6 +2522,8 @@ extern void stress_set_seek_size(const char *optarg);
 extern void stress_set_sendfile_size(const char *optarg);
 extern void stress_set_semaphore_posix_procs(const char *optarg);
 extern void stress_set_semaphore_sysv_procs(const char *optarg);
+extern int  stress_set_sharing_mode(const char *name);
+extern void stress_set_sharing_threads(const char *optarg);
 extern void stress_set_shm_posix_bytes(const char *optarg);
 extern void stress_set_shm_posix_objects(const char *optarg);
 extern void stress_set_shm_sysv_bytes(const char *optarg);
@@ -2178,13 +2536,25 @@ extern void stress_set_socket_port(const char *optarg);
 extern void stress_set_socket_fd_port(const char *optarg);
 extern void stress_set_splice_bytes(const char *optarg);
 extern int  stress_set_str_method(const char *name);
+extern void stress_set_str_len(const char *optarg);
+extern int  stress_set_str_len_dist(const char *name);
+extern void stress_set_str_align(const char *optarg);
+extern int stress_set_str_corpus(const char *filename);
 extern void stress_set_stream_L3_size(const char *optarg);
+extern void stress_set_stream_threads(const char *optarg);
 extern void stress_set_sync_file_bytes(const char *optarg);
+extern void stress_set_target_cpu(const char *optarg);
+extern void stress_set_target_mem(const char *optarg);
 extern int  stress_set_wcs_method(const char *name);
+extern void stress_set_wcs_len(const char *optarg);
+extern int  stress_set_wcs_len_dist(const char *name);
+extern void stress_set_wcs_align(const char *optarg);
 extern void stress_set_timer_freq(const char *optarg);
 extern void stress_set_timerfd_freq(const char *optarg);
 extern int  stress_tsc_supported(void);
 extern void stress_set_tsearch_size(const char *optarg);
+extern int stress_set_tsearch_method(const char *name);
+extern void stress_set_tsearch_node_lines(const char *optarg);
 extern int  stress_set_udp_domain(const char *name);
 extern void stress_set_udp_port(const char *optarg);
 extern int  stress_set_udp_flood_domain(const char *name);
@@ -2193,9 +2563,17 @@ extern void stress_set_vfork_max(const char *optarg);
 extern void stress_set_vm_bytes(const char *optarg);
 extern void stress_set_vm_flags(const int flag);
 extern void stress_set_vm_hang(const char *optarg);
+extern int  stress_set_vm_hugepage(const char *name);
 extern int  stress_set_vm_method(const char *name);
 extern void stress_set_vm_rw_bytes(const char *optarg);
 extern void stress_set_vm_splice_bytes(const char *optarg);
+extern void stress_set_zlib_level(const char *optarg);
+extern int stress_set_zlib_strategy(const char *name);
+extern void stress_set_zlib_window_bits(const char *optarg);
+extern void stress_set_zlib_mem_level(const char *optarg);
+extern void stress_set_zlib_threads(const char *optarg);
+extern void stress_set_zlib_chunk_size(const char *optarg);
+extern int stress_set_zlib_corpus(const char *filename);
 extern void stress_set_zombie_max(const char *optarg);
 
 /*
@@ -2283,6 +2661,11 @@ extern int shim_mlock2(const void *addr, size_t len, int flags);
 extern int shim_usleep(uint64_t usec);
 extern char *shim_getlogin(void);
 extern int shim_msync(void *addr, size_t length, int flags);
+extern int shim_io_uring_setup(unsigned int entries, void *params);
+extern int shim_io_uring_enter(int fd, unsigned int to_submit,
+	unsigned int min_complete, unsigned int flags);
+extern int shim_io_uring_register(int fd, unsigned int opcode, void *arg,
+	unsigned int nr_args);
 
 #define STRESS(func)							\
 extern int func(uint64_t *const counter, const uint32_t instance,	\
@@ -2386,6 +2769,7 @@ STRESS(stress_personality);
 STRESS(stress_pipe);
 STRESS(stress_poll);
 STRESS(stress_procfs);
+STRESS(stress_psort);
 STRESS(stress_pthread);
 STRESS(stress_ptrace);
 STRESS(stress_pty);
@@ -2407,6 +2791,7 @@ STRESS(stress_seek);
 STRESS(stress_sem);
 STRESS(stress_sem_sysv);
 STRESS(stress_sendfile);
+STRESS(stress_sharing);
 STRESS(stress_shm);
 STRESS(stress_shm_sysv);
 STRESS(stress_sigfd);
@@ -0,0 +1,976 @@
+/*
+ * Copyright (C) 2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+#define PSORT_METHOD_MERGE	(0)		/* parallel mergesort */
+#define PSORT_METHOD_RADIX	(1)		/* parallel LSD radix sort */
+#define PSORT_METHOD_SAMPLE	(2)		/* parallel samplesort */
+#define PSORT_METHODS		(3)
+#define PSORT_METHOD_ALL	(3)		/* cycle through all the methods */
+
+#define PSORT_CUTOFF		(8192)		/* sort sequentially at or below */
+#define PSORT_DEQUE_SIZE	(1024)		/* tasks per worker deque */
+#define PSORT_CHUNKS		(4)		/* data parallel chunks per thread */
+#define PSORT_MAX_BUCKETS	(1024)		/* samplesort bucket limit */
+#define PSORT_OVERSAMPLE	(32)		/* samples per samplesort bucket */
+#define PSORT_RADIX		(256)		/* radix sort digit values */
+#define PSORT_MAX_COUNTS	(16)		/* thread counts measured */
+
+#define PSORT_DIGIT(v, shift)	\
+	((((uint32_t)(v) ^ 0x80000000U) >> (shift)) & (PSORT_RADIX - 1))
+
+typedef struct {
+	const char *name;		/* method name */
+	const int method;		/* PSORT_METHOD_* */
+} psort_method_info_t;
+
+static const psort_method_info_t psort_methods[] = {
+	{ "mergesort",	PSORT_METHOD_MERGE },
+	{ "radix",	PSORT_METHOD_RADIX },
+	{ "samplesort",	PSORT_METHOD_SAMPLE },
+	{ "all",	PSORT_METHOD_ALL },
+	{ NULL,		0 }
+};
+
+static uint64_t opt_psort_size = DEFAULT_PSORT_SIZE;
+static bool set_psort_size = false;
+static uint32_t opt_psort_threads = DEFAULT_PSORT_THREADS;
+static int opt_psort_method = PSORT_METHOD_ALL;
+
+/*
+ *  stress_set_psort_size()
+ *	set the number of elements to sort
+ */
+void stress_set_psort_size(const char *optarg)
+{
+	set_psort_size = true;
+	opt_psort_size = get_uint64_byte(optarg);
+	check_range("psort-size", opt_psort_size,
+		MIN_PSORT_SIZE, MAX_PSORT_SIZE);
+}
+
+/*
+ *  stress_set_psort_threads()
+ *	set the maximum number of sorting threads
+ */
+void stress_set_psort_threads(const char *optarg)
+{
+	opt_psort_threads = get_uint32(optarg);
+	check_range("psort-threads", opt_psort_threads,
+		MIN_PSORT_THREADS, MAX_PSORT_THREADS);
+}
+
+/*
+ *  stress_set_psort_method()
+ *	set the parallel sort method
+ */
+int stress_set_psort_method(const char *name)
+{
+	const psort_method_info_t *info;
+
+	for (info = psort_methods; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_psort_method = info->method;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "psort-method must be one of:");
+	for (info = psort_methods; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+#if defined(HAVE_LIB_PTHREAD)
+
+struct psort_worker;
+struct psort_task;
+struct psort_run;
+
+typedef void (*psort_func_t)(struct psort_worker *w, struct psort_task *task);
+
+/* a unit of work, lives in the frame or run of the task that spawned it */
+typedef struct psort_task {
+	psort_func_t func;		/* work to do */
+	volatile uint32_t *pending;	/* spawner's count of unfinished tasks */
+	struct psort_run *run;		/* the sort this task is part of */
+	int32_t *x, *y, *out;		/* input, second input/scratch, output */
+	size_t nx, ny;			/* number of elements in x and y */
+	size_t lo, hi;			/* chunk range of data parallel tasks */
+	size_t *counts;			/* per chunk histogram / offsets */
+	uint32_t shift;			/* radix digit shift */
+	bool to_y;			/* mergesort result goes in y */
+} psort_task_t;
+
+/* double ended task queue, owner at the bottom, thieves at the top */
+typedef struct {
+	pthread_mutex_t lock;		/* protects the queue */
+	size_t top, bottom;		/* queued tasks are [top, bottom) */
+	psort_task_t *tasks[PSORT_DEQUE_SIZE];
+} psort_deque_t;
+
+typedef struct psort_worker {
+	pthread_t pthread;		/* thread handle, worker 0 is the caller */
+	struct psort_pool *pool;	/* pool the worker belongs to */
+	uint32_t id;			/* index in the pool */
+	uint64_t tasks;			/* tasks run */
+	uint64_t steals;		/* tasks stolen from other workers */
+	psort_deque_t deque;		/* the worker's tasks */
+} psort_worker_t;
+
+typedef struct psort_pool {
+	psort_worker_t *workers;	/* all the workers */
+	uint32_t n;			/* workers in the current run */
+	volatile bool done;		/* workers stop when set */
+	sigset_t set;			/* signals blocked in the workers */
+} psort_pool_t;
+
+/* state shared by the tasks of one sort */
+typedef struct psort_run {
+	int32_t *data;			/* the array to sort */
+	int32_t *tmp;			/* scratch the size of data */
+	size_t n;			/* number of elements */
+	uint32_t chunks;		/* data parallel tasks per phase */
+	uint32_t buckets;		/* samplesort buckets */
+	size_t stride;			/* counts per chunk */
+	psort_task_t *tasks;		/* data parallel tasks */
+	size_t *counts;			/* chunks * stride histograms */
+	size_t *bucket_lo;		/* samplesort bucket starts */
+	int32_t *samples;		/* samplesort samples */
+	int32_t *splitters;		/* samplesort splitters */
+} psort_run_t;
+
+/* best results of one method at one thread count */
+typedef struct {
+	double duration;		/* fastest sort */
+	uint64_t tasks;			/* tasks run over all sorts */
+	uint64_t steals;		/* tasks stolen over all sorts */
+} psort_stats_t;
+
+/*
+ *  psort_cmp()
+ *	qsort comparison - sort on int32 values
+ */
+static int psort_cmp(const void *p1, const void *p2)
+{
+	const int32_t *i1 = (const int32_t *)p1;
+	const int32_t *i2 = (const int32_t *)p2;
+
+	if (*i1 > *i2)
+		return 1;
+	else if (*i1 < *i2)
+		return -1;
+	else
+		return 0;
+}
+
+/*
+ *  psort_push()
+ *	queue a task at the bottom of the worker's deque,
+ *	returns false if the deque is full
+ */
+static bool psort_push(psort_worker_t *w, psort_task_t *task)
+{
+	psort_deque_t *dq = &w->deque;
+	bool ok = false;
+
+	(void)pthread_mutex_lock(&dq->lock);
+	if (dq->bottom - dq->top < PSORT_DEQUE_SIZE) {
+		dq->tasks[dq->bottom % PSORT_DEQUE_SIZE] = task;
+		dq->bottom++;
+		ok = true;
+	}
+	(void)pthread_mutex_unlock(&dq->lock);
+
+	return ok;
+}
+
+/*
+ *  psort_pop()
+ *	take the most recently queued task from the bottom
+ *	of the deque, the owner works depth first
+ */
+static psort_task_t *psort_pop(psort_worker_t *w)
+{
+	psort_deque_t *dq = &w->deque;
+	psort_task_t *task = NULL;
+
+	(void)pthread_mutex_lock(&dq->lock);
+	if (dq->bottom != dq->top) {
+		dq->bottom--;
+		task = dq->tasks[dq->bottom % PSORT_DEQUE_SIZE];
+	}
+	(void)pthread_mutex_unlock(&dq->lock);
+
+	return task;
+}
+
+/*
+ *  psort_steal()
+ *	take the oldest task from the top of the deque,
+ *	thieves get the largest pieces of work
+ */
+static psort_task_t *psort_steal(psort_worker_t *w)
+{
+	psort_deque_t *dq = &w->deque;
+	psort_task_t *task = NULL;
+
+	(void)pthread_mutex_lock(&dq->lock);
+	if (dq->bottom != dq->top) {
+		task = dq->tasks[dq->top % PSORT_DEQUE_SIZE];
+		dq->top++;
+	}
+	(void)pthread_mutex_unlock(&dq->lock);
+
+	return task;
+}
+
+/*
+ *  psort_next()
+ *	find a task, our own first then steal from the
+ *	other workers in turn
+ */
+static psort_task_t *psort_next(psort_worker_t *w)
+{
+	psort_pool_t *pool = w->pool;
+	psort_task_t *task;
+	uint32_t i;
+
+	if ((task = psort_pop(w)) != NULL)
+		return task;
+
+	for (i = 1; i < pool->n; i++) {
+		psort_worker_t *victim = &pool->workers[(w->id + i) % pool->n];
+
+		if ((task = psort_steal(victim)) != NULL) {
+			w->steals++;
+			return task;
+		}
+	}
+	return NULL;
+}
+
+/*
+ *  psort_run_task()
+ *	run a task and tell the spawner it has finished,
+ *	the task may be gone once pending is decremented
+ */
+static void psort_run_task(psort_worker_t *w, psort_task_t *task)
+{
+	volatile uint32_t *pending = task->pending;
+
+	task->func(w, task);
+	w->tasks++;
+	(void)__sync_fetch_and_sub(pending, 1);
+}
+
+/*
+ *  psort_spawn()
+ *	make a task available to the pool, run it
+ *	straight away if the deque is full
+ */
+static void psort_spawn(psort_worker_t *w, psort_task_t *task)
+{
+	if (!psort_push(w, task))
+		psort_run_task(w, task);
+}
+
+/*
+ *  psort_join()
+ *	wait for spawned tasks to finish, running our own
+ *	or stolen tasks in the meantime
+ */
+static void psort_join(psort_worker_t *w, volatile uint32_t *pending)
+{
+	while (*pending) {
+		psort_task_t *task = psort_next(w);
+
+		if (task)
+			psort_run_task(w, task);
+		else
+			(void)shim_sched_yield();
+	}
+}
+
+/*
+ *  psort_worker()
+ *	pool thread, run tasks until the sort is done
+ */
+static void *psort_worker(void *arg)
+{
+	static void *nowt = NULL;
+	psort_worker_t *w = (psort_worker_t *)arg;
+	psort_pool_t *pool = w->pool;
+
+	(void)sigprocmask(SIG_BLOCK, &pool->set, NULL);
+
+	while (!pool->done) {
+		psort_task_t *task = psort_next(w);
+
+		if (task)
+			psort_run_task(w, task);
+		else
+			(void)shim_sched_yield();
+	}
+	return &nowt;
+}
+
+/*
+ *  psort_chunks()
+ *	run func over the data in parallel chunks and wait
+ *	for them all to finish
+ */
+static void psort_chunks(
+	psort_worker_t *w,
+	psort_run_t *run,
+	const psort_func_t func,
+	int32_t *x,
+	int32_t *out,
+	const uint32_t shift)
+{
+	volatile uint32_t pending = run->chunks;
+	uint32_t i;
+
+	for (i = 0; i < run->chunks; i++) {
+		psort_task_t *task = &run->tasks[i];
+
+		task->func = func;
+		task->pending = &pending;
+		task->run = run;
+		task->x = x;
+		task->out = out;
+		task->lo = (size_t)(((uint64_t)run->n * i) / run->chunks);
+		task->hi = (size_t)(((uint64_t)run->n * (i + 1)) / run->chunks);
+		task->counts = run->counts + (i * run->stride);
+		task->shift = shift;
+		psort_spawn(w, task);
+	}
+	psort_join(w, &pending);
+}
+
+/*
+ *  psort_merge_seq()
+ *	merge sorted x and y into out
+ */
+static void psort_merge_seq(
+	const int32_t *x,
+	size_t nx,
+	const int32_t *y,
+	size_t ny,
+	int32_t *out)
+{
+	while (nx && ny) {
+		if (*y < *x) {
+			*out++ = *y++;
+			ny--;
+		} else {
+			*out++ = *x++;
+			nx--;
+		}
+	}
+	(void)memcpy(out, x, nx * sizeof(*x));
+	(void)memcpy(out + nx, y, ny * sizeof(*y));
+}
+
+/*
+ *  psort_merge()
+ *	merge sorted x and y into out, splitting the larger
+ *	input at its median and the other where the median
+ *	would go so both halves can be merged in parallel
+ */
+static void psort_merge(psort_worker_t *w, psort_task_t *task)
+{
+	int32_t *x = task->x, *y = task->y;
+	size_t nx = task->nx, ny = task->ny;
+	size_t mx, my, lo, hi;
+	volatile uint32_t pending = 1;
+	psort_task_t left = *task, right = *task;
+
+	if (nx < ny) {
+		int32_t *tp = x;
+		size_t tn = nx;
+
+		x = y;
+		y = tp;
+		nx = ny;
+		ny = tn;
+	}
+	if (nx + ny <= PSORT_CUTOFF) {
+		psort_merge_seq(x, nx, y, ny, task->out);
+		return;
+	}
+
+	mx = nx / 2;
+	for (lo = 0, hi = ny; lo < hi; ) {
+		const size_t mid = lo + (hi - lo) / 2;
+
+		if (y[mid] < x[mx])
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	my = lo;
+	task->out[mx + my] = x[mx];
+
+	left.pending = &pending;
+	left.x = x;
+	left.nx = mx;
+	left.y = y;
+	left.ny = my;
+	right.x = x + mx + 1;
+	right.nx = nx - mx - 1;
+	right.y = y + my;
+	right.ny = ny - my;
+	right.out = task->out + mx + my + 1;
+
+	psort_spawn(w, &left);
+	psort_merge(w, &right);
+	psort_join(w, &pending);
+}
+
+/*
+ *  psort_msort()
+ *	sort the nx elements of x using y as scratch, halves
+ *	are sorted into the buffer the result is not going in
+ *	so the merge never needs an extra copy
+ */
+static void psort_msort(psort_worker_t *w, psort_task_t *task)
+{
+	int32_t *a = task->x, *b = task->y;
+	const size_t n = task->nx, h = n / 2;
+	volatile uint32_t pending = 1;
+	psort_task_t left = *task, right = *task, merge = *task;
+
+	if (n <= PSORT_CUTOFF) {
+		qsort(a, n, sizeof(*a), psort_cmp);
+		if (task->to_y)
+			(void)memcpy(b, a, n * sizeof(*a));
+		return;
+	}
+
+	left.pending = &pending;
+	left.nx = h;
+	left.to_y = !task->to_y;
+	right.x = a + h;
+	right.y = b + h;
+	right.nx = n - h;
+	right.to_y = !task->to_y;
+
+	psort_spawn(w, &left);
+	psort_msort(w, &right);
+	psort_join(w, &pending);
+
+	merge.func = psort_merge;
+	merge.x = task->to_y ? a : b;
+	merge.nx = h;
+	merge.y = merge.x + h;
+	merge.ny = n - h;
+	merge.out = task->to_y ? b : a;
+	psort_merge(w, &merge);
+}
+
+/*
+ *  psort_mergesort()
+ *	parallel mergesort of the whole array
+ */
+static void psort_mergesort(psort_worker_t *w, psort_task_t *task)
+{
+	psort_task_t root = *task;
+
+	root.func = psort_msort;
+	root.x = task->run->data;
+	root.y = task->run->tmp;
+	root.nx = task->run->n;
+	root.to_y = false;
+	psort_msort(w, &root);
+}
+
+/*
+ *  psort_radix_hist()
+ *	count the digits in a chunk
+ */
+static void psort_radix_hist(psort_worker_t *w, psort_task_t *task)
+{
+	const int32_t *x = task->x;
+	size_t *counts = task->counts;
+	const uint32_t shift = task->shift;
+	size_t i;
+
+	(void)w;
+
+	(void)memset(counts, 0, PSORT_RADIX * sizeof(*counts));
+	for (i = task->lo; i < task->hi; i++)
+		counts[PSORT_DIGIT(x[i], shift)]++;
+}
+
+/*
+ *  psort_radix_scatter()
+ *	move a chunk to the output offsets of its digits
+ */
+static void psort_radix_scatter(psort_worker_t *w, psort_task_t *task)
+{
+	const int32_t *x = task->x;
+	int32_t *out = task->out;
+	size_t *offsets = task->counts;
+	const uint32_t shift = task->shift;
+	size_t i;
+
+	(void)w;
+
+	for (i = task->lo; i < task->hi; i++) {
+		const int32_t v = x[i];
+
+		out[offsets[PSORT_DIGIT(v, shift)]++] = v;
+	}
+}
+
+/*
+ *  psort_radix()
+ *	parallel LSD radix sort, 8 bits a pass, passes where
+ *	all the elements have the same digit are skipped
+ */
+static void psort_radix(psort_worker_t *w, psort_task_t *task)
+{
+	psort_run_t *run = task->run;
+	int32_t *src = run->data, *dst = run->tmp;
+	uint32_t shift;
+
+	for (shift = 0; shift < 32; shift += 8) {
+		size_t sum = 0;
+		uint32_t c, d;
+		bool skip = false;
+
+		psort_chunks(w, run, psort_radix_hist, src, dst, shift);
+
+		/* exclusive prefix sum, digit major then chunk */
+		for (d = 0; d < PSORT_RADIX; d++) {
+			size_t total = 0;
+
+			for (c = 0; c < run->chunks; c++) {
+				size_t *count = &run->counts[(c * run->stride) + d];
+				const size_t tmp = *count;
+
+				*count = sum;
+				sum += tmp;
+				total += tmp;
+			}
+			if (total == run->n) {
+				skip = true;
+				break;
+			}
+		}
+		if (skip)
+			continue;
+
+		psort_chunks(w, run, psort_radix_scatter, src, dst, shift);
+		src = dst;
+		dst = (src == run->data) ? run->tmp : run->data;
+	}
+	if (src != run->data)
+		(void)memcpy(run->data, src, run->n * sizeof(*src));
+}
+
+/*
+ *  psort_bucket()
+ *	samplesort bucket of v, the index of the first
+ *	splitter greater than v
+ */
+static inline uint32_t psort_bucket(
+	const int32_t *splitters,
+	const uint32_t n,
+	const int32_t v)
+{
+	uint32_t lo = 0, hi = n;
+
+	while (lo < hi) {
+		const uint32_t mid = (lo + hi) / 2;
+
+		if (splitters[mid] <= v)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ *  psort_sample_hist()
+ *	count the elements of a chunk in each bucket
+ */
+static void psort_sample_hist(psort_worker_t *w, psort_task_t *task)
+{
+	const psort_run_t *run = task->run;
+	const int32_t *x = task->x;
+	size_t *counts = task->counts;
+	size_t i;
+
+	(void)w;
+
+	(void)memset(counts, 0, run->buckets * sizeof(*counts));
+	for (i = task->lo; i < task->hi; i++)
+		counts[psort_bucket(run->splitters, run->buckets - 1, x[i])]++;
+}
+
+/*
+ *  psort_sample_scatter()
+ *	move a chunk to the output offsets of its buckets
+ */
+static void psort_sample_scatter(psort_worker_t *w, psort_task_t *task)
+{
+	const psort_run_t *run = task->run;
+	const int32_t *x = task->x;
+	int32_t *out = task->out;
+	size_t *offsets = task->counts;
+	size_t i;
+
+	(void)w;
+
+	for (i = task->lo; i < task->hi; i++) {
+		const int32_t v = x[i];
+
+		out[offsets[psort_bucket(run->splitters, run->buckets - 1, v)]++] = v;
+	}
+}
+
+/*
+ *  psort_sample_bucket()
+ *	sort a bucket and copy it back into place
+ */
+static void psort_sample_bucket(psort_worker_t *w, psort_task_t *task)
+{
+	const psort_run_t *run = task->run;
+	const size_t n = task->hi - task->lo;
+
+	(void)w;
+
+	qsort(run->tmp + task->lo, n, sizeof(int32_t), psort_cmp);
+	(void)memcpy(run->data + task->lo, run->tmp + task->lo, n * sizeof(int32_t));
+}
+
+/*
+ *  psort_samplesort()
+ *	parallel samplesort, pick splitters from a random
+ *	sample, scatter the elements into buckets and sort
+ *	the buckets in parallel
+ */
+static void psort_samplesort(psort_worker_t *w, psort_task_t *task)
+{
+	psort_run_t *run = task->run;
+	const uint32_t samples = run->buckets * PSORT_OVERSAMPLE;
+	volatile uint32_t pending = run->buckets;
+	size_t sum = 0;
+	uint32_t b, c;
+
+	for (b = 0; b < samples; b++)
+		run->samples[b] = run->data[mwc64() % run->n];
+	qsort(run->samples, samples, sizeof(int32_t), psort_cmp);
+	for (b = 0; b < run->buckets - 1; b++)
+		run->splitters[b] = run->samples[(b + 1) * PSORT_OVERSAMPLE];
+
+	psort_chunks(w, run, psort_sample_hist, run->data, run->tmp, 0);
+
+	/* exclusive prefix sum, bucket major then chunk */
+	for (b = 0; b < run->buckets; b++) {
+		run->bucket_lo[b] = sum;
+		for (c = 0; c < run->chunks; c++) {
+			size_t *count = &run->counts[(c * run->stride) + b];
+			const size_t tmp = *count;
+
+			*count = sum;
+			sum += tmp;
+		}
+	}
+	run->bucket_lo[run->buckets] = sum;
+
+	psort_chunks(w, run, psort_sample_scatter, run->data, run->tmp, 0);
+
+	for (b = 0; b < run->buckets; b++) {
+		psort_task_t *t = &run->tasks[b];
+
+		t->func = psort_sample_bucket;
+		t->pending = &pending;
+		t->run = run;
+		t->lo = run->bucket_lo[b];
+		t->hi = run->bucket_lo[b + 1];
+		psort_spawn(w, t);
+	}
+	psort_join(w, &pending);
+}
+
+static const psort_func_t psort_funcs[PSORT_METHODS] = {
+	psort_mergesort,
+	psort_radix,
+	psort_samplesort,
+};
+
+/*
+ *  psort_pool_run()
+ *	sort the run's data with the given method and number
+ *	of threads, the caller is worker 0 and runs the root
+ *	task, returns -1 if the threads could not be started
+ */
+static int psort_pool_run(
+	const char *name,
+	psort_pool_t *pool,
+	psort_run_t *run,
+	const int method,
+	const uint32_t threads,
+	psort_stats_t *stats)
+{
+	volatile uint32_t pending = 1;
+	psort_task_t root;
+	uint32_t i, started;
+	double t;
+
+	run->chunks = threads * PSORT_CHUNKS;
+	run->buckets = STRESS_MINIMUM(threads * PSORT_CHUNKS, PSORT_MAX_BUCKETS);
+
+	pool->n = threads;
+	pool->done = false;
+	for (i = 0; i < threads; i++) {
+		pool->workers[i].deque.top = 0;
+		pool->workers[i].deque.bottom = 0;
+		pool->workers[i].tasks = 0;
+		pool->workers[i].steals = 0;
+	}
+
+	for (started = 1; started < threads; started++) {
+		if (pthread_create(&pool->workers[started].pthread, NULL,
+		    psort_worker, &pool->workers[started]))
+			break;
+	}
+	if (started < threads) {
+		pr_fail_err(name, "pthread_create");
+		pool->done = true;
+		for (i = 1; i < started; i++)
+			(void)pthread_join(pool->workers[i].pthread, NULL);
+		return -1;
+	}
+
+	memset(&root, 0, sizeof(root));
+	root.func = psort_funcs[method];
+	root.pending = &pending;
+	root.run = run;
+
+	t = time_now();
+	psort_run_task(&pool->workers[0], &root);
+	t = time_now() - t;
+
+	pool->done = true;
+	for (i = 1; i < threads; i++)
+		(void)pthread_join(pool->workers[i].pthread, NULL);
+
+	if ((stats->duration <= 0.0) || (t < stats->duration))
+		stats->duration = t;
+	for (i = 0; i < threads; i++) {
+		stats->tasks += pool->workers[i].tasks;
+		stats->steals += pool->workers[i].steals;
+	}
+	return 0;
+}
+
+/*
+ *  psort_check()
+ *	check data is in order and has not lost any elements
+ */
+static bool psort_check(const int32_t *data, const size_t n, const int64_t sum)
+{
+	int64_t s = data[0];
+	size_t i;
+
+	for (i = 1; i < n; i++) {
+		if (data[i - 1] > data[i])
+			return false;
+		s += data[i];
+	}
+	return s == sum;
+}
+
+/*
+ *  stress_psort()
+ *	stress memory bandwidth and scheduler balance by
+ *	sorting one large array with a pool of work stealing
+ *	threads, comparing the throughput against qsort
+ */
+int stress_psort(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	psort_stats_t stats[PSORT_METHODS][PSORT_MAX_COUNTS];
+	psort_stats_t baseline;
+	uint32_t counts[PSORT_MAX_COUNTS];
+	psort_pool_t pool;
+	psort_run_t run;
+	int32_t *orig;
+	int64_t sum = 0;
+	uint32_t i, max_threads, ncounts = 0, max_chunks;
+	int method, rc = EXIT_NO_RESOURCE;
+	size_t n;
+
+	if (!set_psort_size) {
+		if (opt_flags & OPT_FLAGS_MAXIMIZE)
+			opt_psort_size = MAXIMIZE_SORT_SIZE;
+		if (opt_flags & OPT_FLAGS_MINIMIZE)
+			opt_psort_size = MIN_PSORT_SIZE;
+	}
+	n = (size_t)opt_psort_size;
+
+	max_threads = opt_psort_threads ? opt_psort_threads :
+		(uint32_t)stress_get_processors_online();
+	if (max_threads < 1)
+		max_threads = 1;
+	/* 1, 2, 4, .. threads and the maximum */
+	for (i = 1; (i < max_threads) && (ncounts < PSORT_MAX_COUNTS - 1); i <<= 1)
+		counts[ncounts++] = i;
+	counts[ncounts++] = max_threads;
+
+	if (!stress_sort_int32() && !instance)
+		pr_inf(stderr, "%s: only sorts int32 keys, ignoring --sort-key\n",
+			name);
+
+	memset(&run, 0, sizeof(run));
+	memset(&pool, 0, sizeof(pool));
+	memset(stats, 0, sizeof(stats));
+	memset(&baseline, 0, sizeof(baseline));
+	run.n = n;
+	max_chunks = max_threads * PSORT_CHUNKS;
+	run.stride = STRESS_MAXIMUM((size_t)PSORT_RADIX,
+		STRESS_MINIMUM((size_t)max_chunks, (size_t)PSORT_MAX_BUCKETS));
+
+	orig = calloc(n, sizeof(*orig));
+	run.data = calloc(n, sizeof(*run.data));
+	run.tmp = calloc(n, sizeof(*run.tmp));
+	run.tasks = calloc(STRESS_MAXIMUM(max_chunks, PSORT_MAX_BUCKETS),
+		sizeof(*run.tasks));
+	run.counts = calloc((size_t)max_chunks * run.stride, sizeof(*run.counts));
+	run.bucket_lo = calloc(PSORT_MAX_BUCKETS + 1, sizeof(*run.bucket_lo));
+	run.samples = calloc(PSORT_MAX_BUCKETS * PSORT_OVERSAMPLE,
+		sizeof(*run.samples));
+	run.splitters = calloc(PSORT_MAX_BUCKETS, sizeof(*run.splitters));
+	pool.workers = calloc(max_threads, sizeof(*pool.workers));
+	if (!orig || !run.data || !run.tmp || !run.tasks || !run.counts ||
+	    !run.bucket_lo || !run.samples || !run.splitters || !pool.workers) {
+		pr_err(stderr, "%s: cannot allocate %zu element arrays\n",
+			name, n);
+		goto tidy;
+	}
+	for (i = 0; i < max_threads; i++) {
+		pool.workers[i].pool = &pool;
+		pool.workers[i].id = i;
+		(void)pthread_mutex_init(&pool.workers[i].deque.lock, NULL);
+	}
+	(void)sigfillset(&pool.set);
+
+	stress_sort_fill_int32(orig, n);
+	for (i = 0; i < n; i++)
+		sum += orig[i];
+
+	rc = EXIT_SUCCESS;
+	method = (opt_psort_method == PSORT_METHOD_ALL) ?
+		PSORT_METHOD_MERGE : opt_psort_method;
+	do {
+		double t;
+
+		/* single threaded baseline */
+		(void)memcpy(run.data, orig, n * sizeof(*orig));
+		t = time_now();
+		qsort(run.data, n, sizeof(*run.data), psort_cmp);
+		t = time_now() - t;
+		if ((baseline.duration <= 0.0) || (t < baseline.duration))
+			baseline.duration = t;
+
+		for (i = 0; (i < ncounts) && opt_do_run; i++) {
+			(void)memcpy(run.data, orig, n * sizeof(*orig));
+			if (psort_pool_run(name, &pool, &run, method,
+			    counts[i], &stats[method][i]) < 0) {
+				rc = EXIT_FAILURE;
+				break;
+			}
+			if ((opt_flags & OPT_FLAGS_VERIFY) &&
+			    !psort_check(run.data, n, sum))
+				pr_fail(stderr, "%s: %s with %" PRIu32 " threads "
+					"did not sort the data correctly\n", name,
+					psort_methods[method].name, counts[i]);
+		}
+		if (rc != EXIT_SUCCESS)
+			break;
+
+		(*counter)++;
+		if (opt_psort_method == PSORT_METHOD_ALL)
+			method = (method + 1) % PSORT_METHODS;
+	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+	if ((instance == 0) && (baseline.duration > 0.0)) {
+		const double mega = 1000000.0;
+
+		pr_inf(stderr, "%s: %zu %s elements, qsort baseline %.2f M "
+			"elements/sec\n", name, n, stress_sort_dist_name(),
+			(double)n / (baseline.duration * mega));
+		for (method = 0; method < PSORT_METHODS; method++) {
+			for (i = 0; i < ncounts; i++) {
+				const psort_stats_t *s = &stats[method][i];
+
+				if (s->duration <= 0.0)
+					continue;
+				pr_inf(stderr, "%s: %-10s %4" PRIu32 " threads "
+					"%9.2f M elements/sec, %6.2fx qsort, "
+					"%5.1f%% of tasks stolen\n", name,
+					psort_methods[method].name, counts[i],
+					(double)n / (s->duration * mega),
+					baseline.duration / s->duration,
+					s->tasks ? 100.0 * s->steals / s->tasks : 0.0);
+			}
+		}
+	}
+
+	for (i = 0; i < max_threads; i++)
+		(void)pthread_mutex_destroy(&pool.workers[i].deque.lock);
+tidy:
+	free(pool.workers);
+	free(run.splitters);
+	free(run.samples);
+	free(run.bucket_lo);
+	free(run.counts);
+	free(run.tasks);
+	free(run.tmp);
+	free(run.data);
+	free(orig);
+
+	return rc;
+}
+#else
+int stress_psort(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	return stress_not_implemented(counter, instance, max_ops, name);
+}
+#endif
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+#define SHARING_INCS		(1 << 20)	/* increments per thread per round */
+#define SHARING_PAD		(128)		/* padding, keeps off adjacent lines */
+#define SHARING_MODES		(3)
+
+#define SHARING_MODE_FALSE	(0)		/* counters packed together */
+#define SHARING_MODE_PADDED	(1)		/* counters in separate lines */
+#define SHARING_MODE_TRUE	(2)		/* all threads on the same word */
+#define SHARING_MODE_ALL	(3)		/* cycle through all the modes */
+
+typedef struct {
+	const char *name;		/* mode name */
+	const int mode;			/* SHARING_MODE_* */
+} sharing_mode_info_t;
+
+static const sharing_mode_info_t sharing_modes[] = {
+	{ "false",	SHARING_MODE_FALSE },
+	{ "padded",	SHARING_MODE_PADDED },
+	{ "true",	SHARING_MODE_TRUE },
+	{ "all",	SHARING_MODE_ALL },
+	{ NULL,		0 }
+};
+
+static uint32_t opt_sharing_threads = DEFAULT_SHARING_THREADS;
+static int opt_sharing_mode = SHARING_MODE_ALL;
+
+void stress_set_sharing_threads(const char *optarg)
+{
+	opt_sharing_threads = get_uint32(optarg);
+	check_range("sharing-threads", opt_sharing_threads,
+		MIN_SHARING_THREADS, MAX_SHARING_THREADS);
+}
+
+/*
+ *  stress_set_sharing_mode()
+ *	set the cache line sharing mode
+ */
+int stress_set_sharing_mode(const char *name)
+{
+	const sharing_mode_info_t *info;
+
+	for (info = sharing_modes; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_sharing_mode = info->mode;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "sharing-mode must be one of:");
+	for (info = sharing_modes; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+#if defined(__linux__) && defined(HAVE_LIB_PTHREAD)
+
+/* per thread state */
+typedef struct {
+	pthread_t pthread;		/* thread handle */
+	uint32_t cpu;			/* CPU the thread is pinned to */
+	volatile uint64_t *counter;	/* counter the thread increments */
+	double duration;		/* time taken for the current round */
+	double total_duration[SHARING_MODES];	/* time taken per mode */
+	uint64_t total_incs[SHARING_MODES];	/* increments per mode */
+} sharing_thread_t;
+
+/* per mode totals */
+typedef struct {
+	uint64_t rounds;		/* rounds run in this mode */
+	double duration;		/* wall clock time of all rounds */
+#if defined(STRESS_PERF_STATS)
+	uint64_t cache_misses;		/* perf cache misses */
+	uint64_t l1d_load_misses;	/* perf L1D load misses */
+	bool perf;			/* perf counters were read */
+#endif
+} sharing_stats_t;
+
+static struct {
+	int mode;			/* mode of the current round */
+	volatile bool start;		/* threads may start incrementing */
+	volatile bool abort;		/* threads must give up the round */
+	sigset_t set;			/* signals blocked in the threads */
+} sharing;
+
+/*
+ *  stress_sharing_thread()
+ *	pin to a CPU and increment the thread's counter, the
+ *	counters of the false and padded modes are private to
+ *	each thread, in the true mode they are the same word
+ */
+static void *stress_sharing_thread(void *arg)
+{
+	static void *nowt = NULL;
+	sharing_thread_t *st = (sharing_thread_t *)arg;
+	volatile uint64_t *counter = st->counter;
+	cpu_set_t mask;
+	double t;
+	register uint32_t i;
+
+	(void)sigprocmask(SIG_BLOCK, &sharing.set, NULL);
+
+	CPU_ZERO(&mask);
+	CPU_SET(st->cpu, &mask);
+	(void)sched_setaffinity(0, sizeof(mask), &mask);
+
+	while (!sharing.start) {
+		if (sharing.abort)
+			return &nowt;
+		(void)shim_sched_yield();
+	}
+
+	t = time_now();
+	if (sharing.mode == SHARING_MODE_TRUE) {
+		for (i = 0; i < SHARING_INCS; i++)
+			(void)__sync_fetch_and_add(counter, 1);
+	} else {
+		for (i = 0; i < SHARING_INCS; i++)
+			(*counter)++;
+	}
+	st->duration = time_now() - t;
+
+	return &nowt;
+}
+
+/*
+ *  stress_sharing_round()
+ *	run one round of all the threads in the given mode,
+ *	returns the number of threads that ran
+ */
+static uint32_t stress_sharing_round(
+	const char *name,
+	const int mode,
+	uint8_t *buf,
+	sharing_thread_t *threads,
+	const uint32_t n,
+	sharing_stats_t *stats)
+{
+	const size_t stride = (mode == SHARING_MODE_FALSE) ? sizeof(uint64_t) :
+			      (mode == SHARING_MODE_PADDED) ? SHARING_PAD : 0;
+	uint32_t i, started;
+	double t;
+#if defined(STRESS_PERF_STATS)
+	stress_perf_t sp;
+	bool perf = (opt_flags & OPT_FLAGS_PERF_STATS) &&
+		    (perf_open(&sp) == 0);
+
+	if (perf)
+		(void)perf_enable(&sp);
+#endif
+	memset(buf, 0, (size_t)n * SHARING_PAD);
+	sharing.mode = mode;
+	sharing.start = false;
+	sharing.abort = false;
+
+	for (started = 0; started < n; started++) {
+		threads[started].counter = (uint64_t *)(buf + (started * stride));
+		if (pthread_create(&threads[started].pthread, NULL,
+		    stress_sharing_thread, &threads[started]))
+			break;
+	}
+	if (started < n) {
+		/* release the threads that did start and give up */
+		pr_fail_err(name, "pthread_create");
+		sharing.abort = true;
+		for (i = 0; i < started; i++)
+			(void)pthread_join(threads[i].pthread, NULL);
+		started = 0;
+		goto done;
+	}
+
+	t = time_now();
+	sharing.start = true;
+	for (i = 0; i < n; i++)
+		(void)pthread_join(threads[i].pthread, NULL);
+	stats->duration += time_now() - t;
+	stats->rounds++;
+
+	for (i = 0; i < n; i++) {
+		threads[i].total_duration[mode] += threads[i].duration;
+		threads[i].total_incs[mode] += SHARING_INCS;
+	}
+
+	if (opt_flags & OPT_FLAGS_VERIFY) {
+		for (i = 0; i < n; i++) {
+			const uint64_t expected = (mode == SHARING_MODE_TRUE) ?
+				(uint64_t)n * SHARING_INCS : SHARING_INCS;
+
+			if (*threads[i].counter != expected)
+				pr_fail(stderr, "%s: %s sharing counter %" PRIu32
+					" is %" PRIu64 ", expected %" PRIu64 "\n",
+					name, sharing_modes[mode].name, i,
+					*threads[i].counter, expected);
+		}
+	}
+
+done:
+#if defined(STRESS_PERF_STATS)
+	if (perf) {
+		uint64_t counter;
+		int index;
+
+		(void)perf_disable(&sp);
+		(void)perf_close(&sp);
+		if (started &&
+		    (perf_get_counter_by_id(&sp, STRESS_PERF_HW_CACHE_MISSES,
+			&counter, &index) == 0) &&
+		    (counter != STRESS_PERF_INVALID)) {
+			stats->cache_misses += counter;
+			stats->perf = true;
+		}
+		if (started &&
+		    (perf_get_counter_by_id(&sp, STRESS_PERF_HW_CACHE_L1D_LOAD_MISSES,
+			&counter, &index) == 0) &&
+		    (counter != STRESS_PERF_INVALID)) {
+			stats->l1d_load_misses += counter;
+			stats->perf = true;
+		}
+	}
+#endif
+	return started;
+}
+
+/*
+ *  stress_sharing_report()
+ *	report the per thread and total increment rates of
+ *	each mode along with the coherence miss counts
+ */
+static void stress_sharing_report(
+	const char *name,
+	const int mode,
+	sharing_thread_t *threads,
+	const uint32_t n,
+	const sharing_stats_t *stats)
+{
+	char buf[16 + 10 * n];
+	size_t len = 0;
+	uint32_t i;
+	const double incs = (double)stats->rounds * n * SHARING_INCS;
+
+	if (!stats->rounds || (stats->duration <= 0.0))
+		return;
+
+	buf[0] = '\0';
+	for (i = 0; i < n; i++) {
+		const double rate = (threads[i].total_duration[mode] > 0.0) ?
+			threads[i].total_incs[mode] /
+			threads[i].total_duration[mode] : 0.0;
+
+		len += snprintf(buf + len, sizeof(buf) - len, " %9.2f",
+			rate / 1000000.0);
+	}
+	pr_inf(stderr, "%s: %-6s %9.2f M incs/sec total, per thread M incs/sec:%s\n",
+		name, sharing_modes[mode].name,
+		incs / (stats->duration * 1000000.0), buf);
+#if defined(STRESS_PERF_STATS)
+	if (stats->perf)
+		pr_inf(stderr, "%s: %-6s %9.4f cache misses, %9.4f L1D load "
+			"misses per increment\n", name, sharing_modes[mode].name,
+			(double)stats->cache_misses / incs,
+			(double)stats->l1d_load_misses / incs);
+#endif
+}
+
+/*
+ *  stress_sharing()
+ *	stress cache coherency with threads incrementing
+ *	counters that share a cache line but not the data,
+ *	are in separate cache lines, or are the same data
+ */
+int stress_sharing(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	const uint32_t cpus = stress_get_processors_configured();
+	sharing_stats_t stats[SHARING_MODES];
+	sharing_thread_t *threads;
+	cpu_set_t proc_mask;
+	uint32_t i, n, cpu = 0;
+	int mode;
+	void *buf;
+
+	if (sched_getaffinity(0, sizeof(proc_mask), &proc_mask) < 0) {
+		pr_fail_err(name, "sched_getaffinity");
+		return EXIT_FAILURE;
+	}
+	n = opt_sharing_threads ? opt_sharing_threads :
+		(uint32_t)CPU_COUNT(&proc_mask);
+	if (n < 1)
+		n = 1;
+
+	threads = calloc(n, sizeof(*threads));
+	if (!threads) {
+		pr_err(stderr, "%s: cannot allocate thread state\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+	if (posix_memalign(&buf, SHARING_PAD, (size_t)n * SHARING_PAD)) {
+		pr_err(stderr, "%s: cannot allocate counters\n", name);
+		free(threads);
+		return EXIT_NO_RESOURCE;
+	}
+
+	/* spread the threads over the allowed CPUs */
+	for (i = 0; i < n; i++) {
+		while (!CPU_ISSET(cpu % cpus, &proc_mask))
+			cpu++;
+		threads[i].cpu = cpu % cpus;
+		cpu++;
+	}
+	memset(stats, 0, sizeof(stats));
+	(void)sigfillset(&sharing.set);
+
+	mode = (opt_sharing_mode == SHARING_MODE_ALL) ?
+		SHARING_MODE_FALSE : opt_sharing_mode;
+	do {
+		if (!stress_sharing_round(name, mode, buf, threads, n, &stats[mode]))
+			break;
+		(*counter)++;
+		if (opt_sharing_mode == SHARING_MODE_ALL)
+			mode = (mode + 1) % SHARING_MODES;
+	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+	if (instance == 0) {
+		for (mode = 0; mode < SHARING_MODES; mode++)
+			stress_sharing_report(name, mode, threads, n, &stats[mode]);
+	}
+
+	free(buf);
+	free(threads);
+
+	return EXIT_SUCCESS;
+}
+#else
+int stress_sharing(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	return stress_not_implemented(counter, instance, max_ops, name);
+}
+#endif
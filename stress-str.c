@@ -25,6 +25,9 @@
 #include "stress-ng.h"
 
 #include <strings.h>
+#if defined(__GLIBC__)
+#include <gnu/libc-version.h>
+#endif
 #if defined(HAVE_LIB_BSD)
 #include <bsd/string.h>
 #define HAVE_STRLCPY
@@ -46,15 +49,80 @@ typedef void (*stress_str_func)(
 	const size_t len2);
 
 
+#define STR_POOL	(32)		/* strings timed per bench pass */
+#define STR_BENCH_CALLS	(256)		/* min libc calls timed per bogo op */
+#define STR_ALIGN	(64)		/* alignment of each string slot */
+
+/* strings used to time the libc functions */
+typedef struct {
+	char	*s1[STR_POOL];		/* random strings */
+	char	*s2[STR_POOL];		/* s1 with a different last char */
+	size_t	len[STR_POOL];		/* length of each string */
+	char	*dst;			/* destination buffer */
+	size_t	dst_len;		/* size of the destination buffer */
+	uint64_t chars;			/* total length of all the strings */
+} str_pool_t;
+
+typedef void (*stress_str_bench_func)(
+	const void *libc_func,
+	str_pool_t *pool);
+
 typedef struct {
 	const char 		*name;	/* human readable form of stressor */
 	const stress_str_func	func;	/* the stressor function */
 	const void 		*libc_func;
+	const stress_str_bench_func bench; /* times one libc call per pool string */
 } stress_str_stressor_info_t;
 
+/* libc call timings of a method */
+typedef struct {
+	uint64_t calls;			/* libc calls timed */
+	uint64_t chars;			/* characters processed */
+	double duration;		/* time taken */
+} str_stats_t;
+
 static const stress_str_stressor_info_t *opt_str_stressor;
 static const stress_str_stressor_info_t str_methods[];
 
+static size_t opt_str_len = DEFAULT_STR_LEN;
+static int opt_str_len_dist = STRESS_LEN_DIST_FIXED;
+static size_t opt_str_align = DEFAULT_STR_ALIGN;
+static stress_corpus_t str_corpus;
+
+void stress_set_str_len(const char *optarg)
+{
+	uint64_t len;
+
+	len = get_uint64_byte(optarg);
+	check_range("str-len", len, MIN_STR_LEN, MAX_STR_LEN);
+	opt_str_len = (size_t)len;
+}
+
+int stress_set_str_len_dist(const char *name)
+{
+	const int dist = stress_set_len_dist("str-len-dist", name);
+
+	if (dist < 0)
+		return -1;
+	opt_str_len_dist = dist;
+	return 0;
+}
+
+void stress_set_str_align(const char *optarg)
+{
+	uint64_t align;
+
+	align = get_uint64(optarg);
+	check_range("str-align", align, MIN_STR_ALIGN, MAX_STR_ALIGN);
+	opt_str_align = (size_t)align;
+}
+
+int stress_set_str_corpus(const char *filename)
+{
+	stress_corpus_close(&str_corpus);
+	return stress_corpus_open("str-corpus", filename, &str_corpus);
+}
+
 static inline void strchk(
 	const char *name,
 	const int ok,
@@ -540,6 +608,135 @@ static void stress_strxfrm(
 }
 
 
+/*
+ *  stress_str_bench_chr()
+ *	time strchr style searches for a char not in the string
+ */
+static void stress_str_bench_chr(const void *libc_func, str_pool_t *pool)
+{
+	char *(*__strchr)(const char *s, int c) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++)
+		(void)__strchr(pool->s1[i], 'Z');
+}
+
+/*
+ *  stress_str_bench_cmp()
+ *	time strcmp style compares that differ at the last char
+ */
+static void stress_str_bench_cmp(const void *libc_func, str_pool_t *pool)
+{
+	int (*__strcmp)(const char *s1, const char *s2) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++)
+		(void)__strcmp(pool->s1[i], pool->s2[i]);
+}
+
+/*
+ *  stress_str_bench_ncmp()
+ *	time strncmp style compares that differ at the last char
+ */
+static void stress_str_bench_ncmp(const void *libc_func, str_pool_t *pool)
+{
+	int (*__strncmp)(const char *s1, const char *s2, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++)
+		(void)__strncmp(pool->s1[i], pool->s2[i], pool->len[i] + 1);
+}
+
+/*
+ *  stress_str_bench_len()
+ *	time strlen
+ */
+static void stress_str_bench_len(const void *libc_func, str_pool_t *pool)
+{
+	size_t (*__strlen)(const char *s) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++)
+		(void)__strlen(pool->s1[i]);
+}
+
+#if !defined(HAVE_STRLCPY)
+/*
+ *  stress_str_bench_cpy()
+ *	time strcpy
+ */
+static void stress_str_bench_cpy(const void *libc_func, str_pool_t *pool)
+{
+	char *(*__strcpy)(char *dest, const char *src) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++)
+		(void)__strcpy(pool->dst, pool->s1[i]);
+}
+#endif
+
+#if !defined(HAVE_STRLCAT)
+/*
+ *  stress_str_bench_cat()
+ *	time strcat onto an empty string
+ */
+static void stress_str_bench_cat(const void *libc_func, str_pool_t *pool)
+{
+	char *(*__strcat)(char *dest, const char *src) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++) {
+		*pool->dst = '\0';
+		(void)__strcat(pool->dst, pool->s1[i]);
+	}
+}
+#endif
+
+/*
+ *  stress_str_bench_ncat()
+ *	time strncat onto an empty string
+ */
+static void stress_str_bench_ncat(const void *libc_func, str_pool_t *pool)
+{
+	char *(*__strncat)(char *dest, const char *src, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++) {
+		*pool->dst = '\0';
+		(void)__strncat(pool->dst, pool->s1[i], pool->len[i]);
+	}
+}
+
+/*
+ *  stress_str_bench_lcpy()
+ *	time strlcpy and strxfrm style copies
+ */
+static void stress_str_bench_lcpy(const void *libc_func, str_pool_t *pool)
+{
+	size_t (*__strlcpy)(char *dest, const char *src, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++)
+		(void)__strlcpy(pool->dst, pool->s1[i], pool->dst_len);
+}
+
+#if defined(HAVE_STRLCAT)
+/*
+ *  stress_str_bench_lcat()
+ *	time strlcat onto an empty string
+ */
+static void stress_str_bench_lcat(const void *libc_func, str_pool_t *pool)
+{
+	size_t (*__strlcat)(char *dest, const char *src, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < STR_POOL; i++) {
+		*pool->dst = '\0';
+		(void)__strlcat(pool->dst, pool->s1[i], pool->dst_len);
+	}
+}
+#endif
+
 /*
  *  stress_str_all()
  *	iterate over all string stressors
@@ -566,31 +763,31 @@ static void stress_str_all(
  * Table of string stress methods
  */
 static const stress_str_stressor_info_t str_methods[] = {
-	{ "all",		stress_str_all,		NULL },	/* Special "all test */
+	{ "all",		stress_str_all,		NULL,		NULL },	/* Special "all test */
 
-	{ "index",		stress_index,		index },
-	{ "rindex",		stress_rindex,		rindex  },
-	{ "strcasecmp",		stress_strcasecmp,	strcasecmp },
+	{ "index",		stress_index,		index,		stress_str_bench_chr },
+	{ "rindex",		stress_rindex,		rindex,		stress_str_bench_chr },
+	{ "strcasecmp",		stress_strcasecmp,	strcasecmp,	stress_str_bench_cmp },
 #if defined(HAVE_STRLCAT)
-	{ "strlcat",		stress_strlcat,		strlcat },
+	{ "strlcat",		stress_strlcat,		strlcat,	stress_str_bench_lcat },
 #else
-	{ "strcat",		stress_strcat,		strcat },
+	{ "strcat",		stress_strcat,		strcat,		stress_str_bench_cat },
 #endif
-	{ "strchr",		stress_strchr,		strchr },
-	{ "strcoll",		stress_strcoll,		strcoll },
-	{ "strcmp",		stress_strcmp,		strcmp },
+	{ "strchr",		stress_strchr,		strchr,		stress_str_bench_chr },
+	{ "strcoll",		stress_strcoll,		strcoll,	stress_str_bench_cmp },
+	{ "strcmp",		stress_strcmp,		strcmp,		stress_str_bench_cmp },
 #if defined(HAVE_STRLCPY)
-	{ "strlcpy",		stress_strlcpy,		strlcpy },
+	{ "strlcpy",		stress_strlcpy,		strlcpy,	stress_str_bench_lcpy },
 #else
-	{ "strcpy",		stress_strcpy,		strcpy },
+	{ "strcpy",		stress_strcpy,		strcpy,		stress_str_bench_cpy },
 #endif
-	{ "strlen",		stress_strlen,		strlen },
-	{ "strncasecmp",	stress_strncasecmp,	strncasecmp },
-	{ "strncat",		stress_strncat,		strncat },
-	{ "strncmp",		stress_strncmp,		strncmp },
-	{ "strrchr",		stress_strrchr,		strrchr },
-	{ "strxfrm",		stress_strxfrm,		strxfrm },
-	{ NULL,			NULL,			NULL }
+	{ "strlen",		stress_strlen,		strlen,		stress_str_bench_len },
+	{ "strncasecmp",	stress_strncasecmp,	strncasecmp,	stress_str_bench_ncmp },
+	{ "strncat",		stress_strncat,		strncat,	stress_str_bench_ncat },
+	{ "strncmp",		stress_strncmp,		strncmp,	stress_str_bench_ncmp },
+	{ "strrchr",		stress_strrchr,		strrchr,	stress_str_bench_chr },
+	{ "strxfrm",		stress_strxfrm,		strxfrm,	stress_str_bench_lcpy },
+	{ NULL,			NULL,			NULL,		NULL }
 };
 
 /*
@@ -618,6 +815,99 @@ int stress_set_str_method(const char *name)
 	return -1;
 }
 
+/*
+ *  stress_str_pool_fill()
+ *	fill the pool with random strings with lengths drawn
+ *	from the length distribution, or with the lines of
+ *	the corpus, as long as they are, if there is one
+ */
+static void stress_str_pool_fill(str_pool_t *pool)
+{
+	size_t i;
+
+	pool->chars = 0;
+	for (i = 0; i < STR_POOL; i++) {
+		size_t len = 0;
+
+		if (str_corpus.data) {
+			/* the strings need a terminator, so copy the line */
+			const char *line = stress_corpus_line(&str_corpus,
+				pool->dst_len - 1, &len);
+
+			(void)memcpy(pool->s1[i], line, len);
+			pool->s1[i][len] = '\0';
+			len = strlen(pool->s1[i]);
+		}
+		if (!len) {
+			len = stress_len_dist(opt_str_len_dist,
+				opt_str_len, 1, pool->dst_len - 1);
+			stress_strnrnd(pool->s1[i], len + 1);
+		}
+		(void)memcpy(pool->s2[i], pool->s1[i], len + 1);
+		pool->s2[i][len - 1] = 'Z';
+		pool->len[i] = len;
+		pool->chars += len;
+	}
+}
+
+/*
+ *  stress_str_bench()
+ *	time at least STR_BENCH_CALLS calls of a method's libc
+ *	function over the string pool
+ */
+static void stress_str_bench(
+	const stress_str_stressor_info_t *info,
+	str_pool_t *pool,
+	str_stats_t *stats)
+{
+	uint64_t calls = 0;
+	double t;
+
+	t = time_now();
+	do {
+		info->bench(info->libc_func, pool);
+		calls += STR_POOL;
+	} while (calls < STR_BENCH_CALLS);
+	stats->duration += time_now() - t;
+	stats->calls += calls;
+	stats->chars += (calls / STR_POOL) * pool->chars;
+}
+
+/*
+ *  stress_str_report()
+ *	report the ns per call and per char of each method
+ */
+static void stress_str_report(const char *name, const str_stats_t *stats)
+{
+	static const char *dists[] = { "fixed", "uniform", "lognormal" };
+	size_t i;
+
+#if defined(__GLIBC__)
+	pr_inf(stderr, "%s: glibc %s, %s lengths with mean %zd, "
+		"alignment %zd\n", name, gnu_get_libc_version(),
+		dists[opt_str_len_dist], opt_str_len, opt_str_align);
+#else
+	pr_inf(stderr, "%s: %s lengths with mean %zd, alignment %zd\n",
+		name, dists[opt_str_len_dist], opt_str_len, opt_str_align);
+#endif
+	if (str_corpus.data)
+		pr_inf(stderr, "%s: strings are the lines of %s\n",
+			name, str_corpus.filename);
+	pr_inf(stderr, "%s: %-12s %10s %10s %12s\n", name,
+		"function", "ns/call", "ns/char", "calls");
+	for (i = 1; str_methods[i].func; i++) {
+		const str_stats_t *st = &stats[i];
+
+		if (!st->calls || !st->chars)
+			continue;
+		pr_inf(stderr, "%s: %-12s %10.2f %10.4f %12" PRIu64 "\n",
+			name, str_methods[i].name,
+			(st->duration * 1000000000.0) / st->calls,
+			(st->duration * 1000000000.0) / st->chars,
+			st->calls);
+	}
+}
+
 /*
  *  stress_str()
  *	stress CPU by doing various string operations
@@ -628,19 +918,56 @@ int stress_str(
 	const uint64_t max_ops,
 	const char *name)
 {
-	stress_str_func func = opt_str_stressor->func;
-	const void *libc_func = opt_str_stressor->libc_func;
-
-	(void)instance;
+	/* "all" is handled here so each call can be timed per method */
+	const bool all = (opt_str_stressor == &str_methods[0]);
+	const stress_str_stressor_info_t *info = all ? &str_methods[1] : opt_str_stressor;
+	/* the longest length any distribution can draw, plus the NUL */
+	const size_t max_len = (opt_str_len_dist == STRESS_LEN_DIST_FIXED) ?
+		opt_str_len + 1 : (8 * opt_str_len) + 1;
+	const size_t slot = (opt_str_align + max_len + STR_ALIGN - 1) & ~(STR_ALIGN - 1);
+	str_stats_t stats[SIZEOF_ARRAY(str_methods)];
+	str_pool_t pool;
+	char *buf, *str1, *str2;
+	size_t i;
+
+	if (posix_memalign((void **)&buf, STR_ALIGN, slot * ((2 * STR_POOL) + 3))) {
+		pr_err(stderr, "%s: cannot allocate string buffers\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+	str1 = buf + opt_str_align;
+	str2 = buf + slot + opt_str_align;
+	for (i = 0; i < STR_POOL; i++) {
+		pool.s1[i] = buf + ((2 + i) * slot) + opt_str_align;
+		pool.s2[i] = buf + ((2 + STR_POOL + i) * slot) + opt_str_align;
+	}
+	pool.dst = buf + ((2 + (2 * STR_POOL)) * slot) + opt_str_align;
+	pool.dst_len = max_len;
+	memset(stats, 0, sizeof(stats));
 
 	do {
-		char str1[256], str2[128];
+		const size_t len1 = stress_len_dist(opt_str_len_dist,
+			opt_str_len, MIN_STR_LEN, max_len - 1) + 1;
+		const size_t len2 = (len1 / 2) + 1;
+
+		stress_strnrnd(str1, len1);
+		stress_strnrnd(str2, len2);
 
-		stress_strnrnd(str1, sizeof(str1));
-		stress_strnrnd(str2, sizeof(str2));
+		(void)info->func(info->libc_func, name, str1, len1, str2, len2);
 
-		(void)func(libc_func, name, str1, sizeof(str1), str2, sizeof(str2));
+		stress_str_pool_fill(&pool);
+		stress_str_bench(info, &pool, &stats[info - str_methods]);
+
+		if (all) {
+			info++;
+			if (!info->func)
+				info = &str_methods[1];
+		}
 		(*counter)++;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+	if (instance == 0)
+		stress_str_report(name, stats);
+
+	free(buf);
 	return EXIT_SUCCESS;
 }
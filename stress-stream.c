@@ -35,8 +35,57 @@
  */
 #include "stress-ng.h"
 
+#include <float.h>
+
+#define STREAM_KERNELS	(4)
+#define STREAM_SWEEP_TIME	(0.05)	/* min seconds per sweep point per pass */
+#define STREAM_SWEEP_MAX	(32)	/* max sweep points */
+#define STREAM_SWEEP_ALIGN	(64)	/* array length alignment in bytes */
+#define STREAM_SWEEP_BATCH	(4 * MB)/* min bytes of triads between timings */
+
+/* per thread kernel timings */
+typedef struct {
+#if defined(HAVE_LIB_PTHREAD)
+	pthread_t pthread;		/* thread handle */
+#endif
+	uint32_t cpu;			/* CPU the thread is pinned to */
+	unsigned node;			/* NUMA node the thread ran on */
+	uint32_t node_index;		/* index into the per node table */
+	uint64_t start;			/* first element of the thread's slice */
+	uint64_t end;			/* end of the thread's slice */
+	double t_start;			/* start time of the current kernel */
+	double t_end;			/* end time of the current kernel */
+	mwc_t mwc;			/* thread's own random state */
+} stream_thread_t;
+
+/* per NUMA node kernel timings */
+typedef struct {
+	unsigned node;			/* NUMA node */
+	uint64_t elements;		/* elements processed per kernel */
+	double t_start;			/* earliest start of the current kernel */
+	double t_end;			/* latest end of the current kernel */
+	double duration[STREAM_KERNELS];/* time spent in each kernel */
+} stream_node_t;
+
+static const char *stream_kernels[STREAM_KERNELS] = {
+	"copy", "scale", "add", "triad"
+};
+
+/* triad bandwidth at one working set size */
+typedef struct {
+	uint64_t size;			/* working set size of the 3 arrays */
+	char level[8];			/* smallest cache level it fits in */
+	uint64_t bytes;			/* bytes read and written */
+	double duration;		/* time taken */
+} stream_sweep_t;
+
+/* doubles read and written per array element by each kernel */
+static const uint64_t stream_reads[STREAM_KERNELS] = { 1, 1, 2, 2 };
+static const uint64_t stream_writes[STREAM_KERNELS] = { 1, 1, 1, 1 };
+
 static uint64_t opt_stream_L3_size = DEFAULT_STREAM_L3_SIZE;
 static bool     set_stream_L3_size = false;
+static uint32_t opt_stream_threads = DEFAULT_STREAM_THREADS;
 
 void stress_set_stream_L3_size(const char *optarg)
 {
@@ -46,6 +95,13 @@ void stress_set_stream_L3_size(const char *optarg)
 		MIN_STREAM_L3_SIZE, MAX_STREAM_L3_SIZE);
 }
 
+void stress_set_stream_threads(const char *optarg)
+{
+	opt_stream_threads = get_uint32(optarg);
+	check_range("stream-threads", opt_stream_threads,
+		MIN_STREAM_THREADS, MAX_STREAM_THREADS);
+}
+
 static inline void OPTIMIZE3 stress_stream_copy(
 	double *RESTRICT c,
 	const double *RESTRICT a,
@@ -94,25 +150,76 @@ static inline void OPTIMIZE3 stress_stream_triad(
 		a[i] = b[i] + (c[i] * q);
 }
 
+/*
+ *  stress_stream_mwc32()
+ *	mwc32() on a given random state, so threads
+ *	do not race on the global one
+ */
+static inline uint32_t stress_stream_mwc32(mwc_t *mwc)
+{
+	mwc->z = 36969 * (mwc->z & 65535) + (mwc->z >> 16);
+	mwc->w = 18000 * (mwc->w & 65535) + (mwc->w >> 16);
+	return (mwc->z << 16) + mwc->w;
+}
+
 static void stress_stream_init_data(
 	double *RESTRICT data,
-	const uint64_t n)
+	const uint64_t n,
+	mwc_t *mwc)
 {
 	uint64_t i;
 
-	for (i = 0; i < n; i++)
-		data[i] = (double)mwc32() / (double)mwc64();
+	for (i = 0; i < n; i++) {
+		const uint32_t r = stress_stream_mwc32(mwc);
+		const uint64_t d = ((uint64_t)stress_stream_mwc32(mwc) << 32) |
+			stress_stream_mwc32(mwc);
+
+		data[i] = (double)r / (double)d;
+	}
+}
+
+/*
+ *  stress_stream_kernel()
+ *	run STREAM kernel k over n elements
+ */
+static inline void stress_stream_kernel(
+	const int k,
+	double *RESTRICT a,
+	double *RESTRICT b,
+	double *RESTRICT c,
+	const double q,
+	const uint64_t n)
+{
+	switch (k) {
+	case 0:
+		stress_stream_copy(c, a, n);
+		break;
+	case 1:
+		stress_stream_scale(b, c, q, n);
+		break;
+	case 2:
+		stress_stream_add(c, b, a, n);
+		break;
+	default:
+		stress_stream_triad(a, b, c, q, n);
+		break;
+	}
 }
 
-static inline void *stress_stream_mmap(const char *name, uint64_t sz)
+static inline void *stress_stream_mmap(
+	const char *name,
+	const uint64_t sz,
+	const bool populate)
 {
 	void *ptr;
 
-	ptr = mmap(NULL, (size_t)sz, PROT_READ | PROT_WRITE,
+	ptr = stress_hugepage_mmap(NULL, stress_hugepage_align((size_t)sz),
+		PROT_READ | PROT_WRITE,
 #if defined(MAP_POPULATE)
-		MAP_POPULATE |
+		(populate ? MAP_POPULATE : 0) |
 #endif
 		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	(void)populate;
 	/* Coverity Scan believes NULL can be returned, doh */
 	if (!ptr || (ptr == MAP_FAILED)) {
 		pr_err(stderr, "%s: cannot allocate %" PRIu64 " bytes\n",
@@ -121,12 +228,23 @@ static inline void *stress_stream_mmap(const char *name, uint64_t sz)
 	}
 	return ptr;
 }
-
+/*
+ *  stream_L3_size()
+ *	size of the last level cache of the CPU we are running on,
+ *	and the number and total size of the last level caches in
+ *	the system, which is more than one on multi-package and
+ *	chiplet CPUs and can differ in size on hybrid CPUs
+ */
 static inline uint64_t stream_L3_size(
 	const char *name,
-	const uint32_t instance)
+	const uint32_t instance,
+	uint32_t *count,
+	uint64_t *total)
 {
 	uint64_t cache_size = MEM_CACHE_SIZE;
+
+	*count = 1;
+	*total = cache_size;
 #if defined(__linux__)
 	cpus_t *cpu_caches;
 	cpu_cache_t *cache = NULL;
@@ -160,6 +278,12 @@ static inline uint64_t stream_L3_size(
 		return cache_size;
 	}
 	cache_size = cache->size;
+	*count = get_cpu_cache_count(cpu_caches, max_cache_level);
+	if (!*count)
+		*count = 1;
+	*total = get_cpu_cache_total_size(cpu_caches, max_cache_level);
+	if (!*total)
+		*total = cache_size;
 
 	free_cpu_caches(cpu_caches);
 #else
@@ -170,6 +294,482 @@ static inline uint64_t stream_L3_size(
 	return cache_size;
 }
 
+/*
+ *  stress_stream_sweep_sizes()
+ *	fill in working set sizes at 1/4, 1/2 and 3/4 of each
+ *	detected cache level and at 2 and 4 times the last level
+ *	cache, returns the number of sizes
+ */
+static size_t stress_stream_sweep_sizes(
+	stream_sweep_t *sweep,
+	const uint64_t LLC,
+	const uint64_t max_size)
+{
+	uint64_t sizes[4];
+	uint16_t i, levels = 0, cache_levels[4], llc_level = 3;
+	size_t j, n = 0;
+#if defined(__linux__)
+	cpus_t *cpu_caches;
+
+	cpu_caches = get_all_cpu_cache_details();
+	if (cpu_caches) {
+		const uint16_t max_level = get_max_cache_level(cpu_caches);
+
+		for (i = 1; (i < max_level) && (levels < 3); i++) {
+			const cpu_cache_t *cache = get_cpu_cache(cpu_caches, i);
+
+			if (cache && cache->size && (cache->size < LLC)) {
+				cache_levels[levels] = cache->level;
+				sizes[levels++] = cache->size;
+			}
+		}
+		if (max_level)
+			llc_level = max_level;
+		free_cpu_caches(cpu_caches);
+	}
+#endif
+	cache_levels[levels] = llc_level;
+	sizes[levels++] = LLC;
+
+	for (i = 0; i < levels; i++) {
+		static const uint64_t fractions[] = { 1, 2, 3 };
+
+		for (j = 0; j < SIZEOF_ARRAY(fractions); j++) {
+			stream_sweep_t *sw = &sweep[n];
+
+			sw->size = (sizes[i] * fractions[j]) / 4;
+			if (sw->size < 3 * STREAM_SWEEP_ALIGN)
+				continue;
+			if (sw->size > max_size)
+				return n;
+			(void)snprintf(sw->level, sizeof(sw->level),
+				"L%" PRIu16, cache_levels[i]);
+			n++;
+		}
+	}
+	for (j = 2; j <= 4; j <<= 1) {
+		stream_sweep_t *sw = &sweep[n];
+
+		sw->size = LLC * j;
+		if (sw->size > max_size)
+			break;
+		(void)snprintf(sw->level, sizeof(sw->level), "mem");
+		n++;
+	}
+	return n;
+}
+
+/*
+ *  stress_stream_sweep_report()
+ *	report triad bandwidth versus working set size
+ */
+static void stress_stream_sweep_report(
+	const char *name,
+	const stream_sweep_t *sweep,
+	const size_t n)
+{
+	size_t i;
+
+	pr_inf(stderr, "%s: triad bandwidth versus working set size:\n", name);
+	pr_inf(stderr, "%s: %5s %12s %10s\n", name, "level",
+		"working set", "GB/s");
+	for (i = 0; i < n; i++) {
+		const stream_sweep_t *sw = &sweep[i];
+		char str[32];
+
+		if (sw->size >= MB)
+			(void)snprintf(str, sizeof(str), "%.1fM",
+				(double)sw->size / (double)MB);
+		else
+			(void)snprintf(str, sizeof(str), "%" PRIu64 "K",
+				sw->size / (uint64_t)KB);
+		/* sizes the run ended before reaching were not measured */
+		if ((sw->duration > 0.0) && sw->bytes)
+			pr_inf(stderr, "%s: %5s %12s %10.3f\n", name, sw->level, str,
+				((double)sw->bytes / sw->duration) / (double)GB);
+		else
+			pr_inf(stderr, "%s: %5s %12s %10s\n", name, sw->level, str, "-");
+	}
+}
+
+/*
+ *  stress_stream_sweep()
+ *	run the triad over working sets sized from the cache
+ *	hierarchy, one pass over all the sizes per bogo op
+ */
+static int stress_stream_sweep(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name,
+	const uint64_t LLC)
+{
+	stream_sweep_t sweep[STREAM_SWEEP_MAX];
+	size_t i, n_sweep, shmall, freemem, totalmem;
+	uint64_t max_size, sz;
+	double *a, *b, *c;
+	const double q = 3.0;
+	int rc = EXIT_FAILURE;
+
+	/* Don't use more than half the free memory across all instances */
+	stress_get_memlimits(&shmall, &freemem, &totalmem);
+	max_size = 4 * LLC;
+	if (freemem) {
+		const uint64_t limit = (freemem / 2) /
+			stressor_instances(STRESS_STREAM);
+
+		if (max_size > limit)
+			max_size = limit;
+	}
+	memset(sweep, 0, sizeof(sweep));
+	n_sweep = stress_stream_sweep_sizes(sweep, LLC, max_size);
+	if (!n_sweep) {
+		pr_inf(stderr, "%s: no working set sizes to sweep\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+
+	sz = (sweep[n_sweep - 1].size / 3) & ~(uint64_t)(STREAM_SWEEP_ALIGN - 1);
+	a = stress_stream_mmap(name, sz, true);
+	if (a == MAP_FAILED)
+		goto err_a;
+	b = stress_stream_mmap(name, sz, true);
+	if (b == MAP_FAILED)
+		goto err_b;
+	c = stress_stream_mmap(name, sz, true);
+	if (c == MAP_FAILED)
+		goto err_c;
+
+	stress_stream_init_data(a, sz / sizeof(double), &__mwc);
+	stress_stream_init_data(b, sz / sizeof(double), &__mwc);
+	stress_stream_init_data(c, sz / sizeof(double), &__mwc);
+
+	do {
+		for (i = 0; (i < n_sweep) && opt_do_run; i++) {
+			stream_sweep_t *sw = &sweep[i];
+			const uint64_t n = ((sw->size / 3) &
+				~(uint64_t)(STREAM_SWEEP_ALIGN - 1)) / sizeof(double);
+			/* Batch small sizes so time_now() is not measured */
+			const uint64_t batch = (sw->size < STREAM_SWEEP_BATCH) ?
+				STREAM_SWEEP_BATCH / sw->size : 1;
+			double t1, t2;
+
+			/* Warm the caches before timing */
+			stress_stream_triad(a, b, c, q, n);
+			t1 = time_now();
+			do {
+				uint64_t j;
+
+				for (j = 0; j < batch; j++)
+					stress_stream_triad(a, b, c, q, n);
+				sw->bytes += batch * n * sizeof(double) *
+					(stream_reads[3] + stream_writes[3]);
+				t2 = time_now();
+			} while ((t2 - t1 < STREAM_SWEEP_TIME) && opt_do_run);
+			sw->duration += t2 - t1;
+		}
+		(*counter)++;
+	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+	if (instance == 0)
+		stress_stream_sweep_report(name, sweep, n_sweep);
+	rc = EXIT_SUCCESS;
+
+	(void)munmap((void *)c, stress_hugepage_align((size_t)sz));
+err_c:
+	(void)munmap((void *)b, stress_hugepage_align((size_t)sz));
+err_b:
+	(void)munmap((void *)a, stress_hugepage_align((size_t)sz));
+err_a:
+	return rc;
+}
+
+#if defined(HAVE_LIB_PTHREAD) && defined(__linux__)
+
+/* state shared by the stream threads of an instance */
+static struct {
+	double *a, *b, *c;		/* STREAM arrays */
+	double q;			/* scalar */
+	pthread_barrier_t barrier;	/* start of each round and kernel */
+	pthread_mutex_t start;		/* held until all threads are created */
+	volatile bool run;		/* false to end the rounds */
+	sigset_t set;			/* signals blocked by the threads */
+} stream;
+
+/*
+ *  stress_stream_thread()
+ *	pin to a CPU, first-touch the thread's slice of the arrays
+ *	so the pages land on the thread's node, then run the kernels
+ *	over the slice in lock step with the other threads
+ */
+static void *stress_stream_thread(void *arg)
+{
+	static void *nowt = NULL;
+	stream_thread_t *t = (stream_thread_t *)arg;
+	double *a, *b, *c;
+	uint64_t n;
+	cpu_set_t mask;
+	unsigned cpu = 0;
+
+	(void)sigprocmask(SIG_BLOCK, &stream.set, NULL);
+
+	CPU_ZERO(&mask);
+	CPU_SET(t->cpu, &mask);
+	(void)sched_setaffinity(0, sizeof(mask), &mask);
+	if (shim_getcpu(&cpu, &t->node, NULL) < 0)
+		t->node = 0;
+
+	/* Wait until all the threads and the barrier are set up */
+	(void)pthread_mutex_lock(&stream.start);
+	(void)pthread_mutex_unlock(&stream.start);
+	if (!stream.run)
+		return &nowt;
+
+	n = t->end - t->start;
+	a = stream.a + t->start;
+	b = stream.b + t->start;
+	c = stream.c + t->start;
+	stress_stream_init_data(a, n, &t->mwc);
+	stress_stream_init_data(b, n, &t->mwc);
+	stress_stream_init_data(c, n, &t->mwc);
+
+	for (;;) {
+		int k;
+
+		(void)pthread_barrier_wait(&stream.barrier);
+		if (!stream.run)
+			break;
+		for (k = 0; k < STREAM_KERNELS; k++) {
+			t->t_start = time_now();
+			stress_stream_kernel(k, a, b, c, stream.q, n);
+			t->t_end = time_now();
+			(void)pthread_barrier_wait(&stream.barrier);
+		}
+	}
+	return &nowt;
+}
+
+/*
+ *  stress_stream_nodes_add()
+ *	accumulate the time from the first thread starting
+ *	to the last thread finishing kernel k on each node
+ */
+static void stress_stream_nodes_add(
+	const stream_thread_t *threads,
+	const uint32_t n_threads,
+	stream_node_t *nodes,
+	const uint32_t n_nodes,
+	const int k)
+{
+	uint32_t i;
+
+	for (i = 0; i < n_nodes; i++) {
+		nodes[i].t_start = DBL_MAX;
+		nodes[i].t_end = 0.0;
+	}
+	for (i = 0; i < n_threads; i++) {
+		stream_node_t *node = &nodes[threads[i].node_index];
+
+		if (node->t_start > threads[i].t_start)
+			node->t_start = threads[i].t_start;
+		if (node->t_end < threads[i].t_end)
+			node->t_end = threads[i].t_end;
+		if (k == 0)
+			node->elements += threads[i].end - threads[i].start;
+	}
+	for (i = 0; i < n_nodes; i++) {
+		if (nodes[i].t_end > nodes[i].t_start)
+			nodes[i].duration[k] += nodes[i].t_end - nodes[i].t_start;
+	}
+}
+
+/*
+ *  stress_stream_threads_report()
+ *	report GB/s per kernel for each NUMA node and for all nodes
+ */
+static void stress_stream_threads_report(
+	const char *name,
+	const uint32_t n_threads,
+	const stream_node_t *nodes,
+	const uint32_t n_nodes,
+	const uint64_t elements,
+	const double wall[STREAM_KERNELS])
+{
+	double rates[STREAM_KERNELS];
+	uint32_t i;
+	int k;
+
+	pr_inf(stderr, "%s: %" PRIu32 " threads on %" PRIu32 " node%s, "
+		"GB/s per kernel:\n", name, n_threads, n_nodes,
+		n_nodes == 1 ? "" : "s");
+	pr_inf(stderr, "%s: %6s %10s %10s %10s %10s\n", name, "node",
+		stream_kernels[0], stream_kernels[1],
+		stream_kernels[2], stream_kernels[3]);
+	for (i = 0; i < n_nodes; i++) {
+		for (k = 0; k < STREAM_KERNELS; k++) {
+			const double bytes = (double)nodes[i].elements *
+				sizeof(double) * (stream_reads[k] + stream_writes[k]);
+
+			rates[k] = (nodes[i].duration[k] > 0.0) ?
+				(bytes / nodes[i].duration[k]) / (double)GB : 0.0;
+		}
+		pr_inf(stderr, "%s: %6u %10.3f %10.3f %10.3f %10.3f\n",
+			name, nodes[i].node, rates[0], rates[1],
+			rates[2], rates[3]);
+	}
+	for (k = 0; k < STREAM_KERNELS; k++) {
+		const double bytes = (double)elements *
+			sizeof(double) * (stream_reads[k] + stream_writes[k]);
+
+		rates[k] = (wall[k] > 0.0) ? (bytes / wall[k]) / (double)GB : 0.0;
+	}
+	pr_inf(stderr, "%s: %6s %10.3f %10.3f %10.3f %10.3f\n",
+		name, "all", rates[0], rates[1], rates[2], rates[3]);
+}
+
+/*
+ *  stress_stream_threads()
+ *	run the STREAM kernels across threads pinned to the CPUs
+ *	this instance may run on, accumulating the wall clock time
+ *	of each kernel, returns -1 if no threads could be started
+ */
+static int stress_stream_threads(
+	uint64_t *const counter,
+	const uint64_t max_ops,
+	const char *name,
+	double *a,
+	double *b,
+	double *c,
+	const double q,
+	const uint64_t n,
+	double wall[STREAM_KERNELS])
+{
+	cpu_set_t mask;
+	uint32_t cpus[CPU_SETSIZE];
+	uint32_t i, n_cpus = 0, n_threads, created = 0;
+	stream_thread_t *threads;
+	stream_node_t *nodes;
+	uint32_t n_nodes = 0;
+	uint64_t slice;
+	int k, ret;
+
+	if (sched_getaffinity(0, sizeof(mask), &mask) < 0) {
+		pr_fail_err(name, "sched_getaffinity");
+		return -1;
+	}
+	for (i = 0; i < CPU_SETSIZE; i++)
+		if (CPU_ISSET(i, &mask))
+			cpus[n_cpus++] = i;
+	if (!n_cpus)
+		return -1;
+
+	n_threads = opt_stream_threads ? opt_stream_threads : n_cpus;
+	threads = calloc(n_threads, sizeof(*threads));
+	nodes = calloc(n_threads, sizeof(*nodes));
+	if (!threads || !nodes) {
+		pr_err(stderr, "%s: cannot allocate thread info\n", name);
+		free(nodes);
+		free(threads);
+		return -1;
+	}
+
+	/* Slices are page multiples so first-touch places whole pages */
+	slice = (n / n_threads) & ~((uint64_t)(stress_get_pagesize() / sizeof(double)) - 1);
+	for (i = 0; i < n_threads; i++) {
+		threads[i].cpu = cpus[i % n_cpus];
+		threads[i].start = i * slice;
+		threads[i].end = (i == n_threads - 1) ? n : (i + 1) * slice;
+		threads[i].mwc.w = mwc32() | 1;
+		threads[i].mwc.z = mwc32() | 1;
+	}
+
+	stream.a = a;
+	stream.b = b;
+	stream.c = c;
+	stream.q = q;
+	stream.run = true;
+	(void)sigfillset(&stream.set);
+	(void)pthread_mutex_init(&stream.start, NULL);
+	(void)pthread_mutex_lock(&stream.start);
+
+	for (i = 0; i < n_threads; i++) {
+		ret = pthread_create(&threads[i].pthread, NULL,
+			stress_stream_thread, &threads[i]);
+		if (ret) {
+			pr_fail_errno(name, "pthread create", ret);
+			break;
+		}
+		created++;
+	}
+	/* Stretch the last slice if not all the threads could be created */
+	if (created)
+		threads[created - 1].end = n;
+	ret = pthread_barrier_init(&stream.barrier, NULL, created + 1);
+	if (ret) {
+		pr_fail_errno(name, "pthread_barrier_init", ret);
+		stream.run = false;
+	}
+	(void)pthread_mutex_unlock(&stream.start);
+
+	if (!created || !stream.run) {
+		for (i = 0; i < created; i++)
+			(void)pthread_join(threads[i].pthread, NULL);
+		if (!ret)
+			(void)pthread_barrier_destroy(&stream.barrier);
+		(void)pthread_mutex_destroy(&stream.start);
+		free(nodes);
+		free(threads);
+		return -1;
+	}
+
+	for (;;) {
+		double t1;
+
+		stream.run = opt_do_run && (!max_ops || *counter < max_ops);
+		(void)pthread_barrier_wait(&stream.barrier);
+		if (!stream.run)
+			break;
+
+		/* All threads have found their nodes by the first round */
+		if (!n_nodes) {
+			for (i = 0; i < created; i++) {
+				uint32_t j;
+
+				for (j = 0; j < n_nodes; j++)
+					if (nodes[j].node == threads[i].node)
+						break;
+				if (j == n_nodes)
+					nodes[n_nodes++].node = threads[i].node;
+				threads[i].node_index = j;
+			}
+		}
+		t1 = time_now();
+		for (k = 0; k < STREAM_KERNELS; k++) {
+			double t2;
+
+			(void)pthread_barrier_wait(&stream.barrier);
+			t2 = time_now();
+			wall[k] += t2 - t1;
+			t1 = t2;
+			stress_stream_nodes_add(threads, created, nodes, n_nodes, k);
+		}
+		(*counter)++;
+	}
+
+	for (i = 0; i < created; i++)
+		(void)pthread_join(threads[i].pthread, NULL);
+
+	stress_stream_threads_report(name, created, nodes, n_nodes,
+		*counter * n, wall);
+
+	(void)pthread_barrier_destroy(&stream.barrier);
+	(void)pthread_mutex_destroy(&stream.start);
+	free(nodes);
+	free(threads);
+
+	return 0;
+}
+#endif
+
 /*
  *  stress_stream()
  *	stress cache/memory/CPU with stream stressors
@@ -184,16 +784,23 @@ int stress_stream(
 	double *a, *b, *c;
 	const double q = 3.0;
 	double mb_rate, mb, fp_rate, fp, t1, t2, dt;
-	uint64_t L3, sz, n;
+	double wall[STREAM_KERNELS];
+	uint64_t L3, L3_total, sz, n;
+	uint32_t L3_count = 1;
 	bool guess = false;
+	const bool threaded = (opt_stream_threads != 1);
+	int k;
 
-	L3 = (set_stream_L3_size) ? opt_stream_L3_size : stream_L3_size(name, instance);
+	L3 = (set_stream_L3_size) ? opt_stream_L3_size :
+		stream_L3_size(name, instance, &L3_count, &L3_total);
 
 	/* Have to take a hunch and badly guess size */
 	if (!L3) {
 		guess = true;
 		L3 = stress_get_processors_configured() * DEFAULT_STREAM_L3_SIZE;
 	}
+	if (set_stream_L3_size || guess)
+		L3_total = L3 * L3_count;
 
 	if (instance == 0) {
 		pr_inf(stderr, "%s: stressor loosely based on a variant of the "
@@ -210,8 +817,18 @@ int stress_stream(
 		}
 	}
 
-	/* ..and shared amongst all the STREAM stressor instances */
-	L3 /= stressor_instances(STRESS_STREAM);
+	/* The sweep characterizes the whole of each cache level */
+	if (opt_flags & OPT_FLAGS_STREAM_SWEEP)
+		return stress_stream_sweep(counter, instance, max_ops, name, L3);
+
+	/*
+	 *  ..all the last level caches of the system are
+	 *  shared amongst all the STREAM stressor instances
+	 */
+	if ((instance == 0) && (L3_count > 1))
+		pr_inf(stderr, "%s: %" PRIu32 " last level caches, %"
+			PRIu64 "K in total\n", name, L3_count, L3_total / 1024);
+	L3 = L3_total / stressor_instances(STRESS_STREAM);
 
 	/*
 	 *  Each array must be at least 4 x the
@@ -220,39 +837,60 @@ int stress_stream(
 	sz = (L3 * 4);
 	n = sz / sizeof(double);
 
-	a = stress_stream_mmap(name, sz);
+	/*
+	 *  Threads first-touch their own slices, so
+	 *  don't populate the pages on this CPU's node
+	 */
+	a = stress_stream_mmap(name, sz, !threaded);
 	if (a == MAP_FAILED)
 		goto err_a;
-	b = stress_stream_mmap(name, sz);
+	b = stress_stream_mmap(name, sz, !threaded);
 	if (b == MAP_FAILED)
 		goto err_b;
-	c = stress_stream_mmap(name, sz);
+	c = stress_stream_mmap(name, sz, !threaded);
 	if (c == MAP_FAILED)
 		goto err_c;
 
-	stress_stream_init_data(a, n);
-	stress_stream_init_data(b, n);
-	stress_stream_init_data(c, n);
+	memset(wall, 0, sizeof(wall));
+#if defined(HAVE_LIB_PTHREAD) && defined(__linux__)
+	if (threaded && (stress_stream_threads(counter, max_ops,
+			name, a, b, c, q, n, wall) == 0))
+		goto done;
+#endif
+	stress_stream_init_data(a, n, &__mwc);
+	stress_stream_init_data(b, n, &__mwc);
+	stress_stream_init_data(c, n, &__mwc);
 
 	t1 = time_now();
 	do {
-		stress_stream_copy(c, a, n);
-		stress_stream_scale(b, c, q, n);
-		stress_stream_add(c, b, a, n);
-		stress_stream_triad(a, b, c, q, n);
+		for (k = 0; k < STREAM_KERNELS; k++) {
+			stress_stream_kernel(k, a, b, c, q, n);
+			t2 = time_now();
+			wall[k] += t2 - t1;
+			t1 = t2;
+		}
 		(*counter)++;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
-	t2 = time_now();
 
+#if defined(HAVE_LIB_PTHREAD) && defined(__linux__)
+done:
+#endif
+	dt = 0.0;
+	for (k = 0; k < STREAM_KERNELS; k++) {
+		const uint64_t bytes = *counter * n * sizeof(double);
+
+		bandwidth_add(stream_kernels[k], bytes * stream_reads[k],
+			bytes * stream_writes[k], wall[k]);
+		dt += wall[k];
+	}
 	mb = ((double)((*counter) * 10) * (double)sz) / (double)MB;
 	fp = ((double)((*counter) * 4) * (double)sz) / (double)MB;
-	dt = t2 - t1;
 	if (dt >= 4.5) {
 		mb_rate = mb / (dt);
 		fp_rate = fp / (dt);
 		pr_inf(stderr, "%s: memory rate: %.2f MB/sec, %.2f Mflop/sec"
-			" (instance %" PRIu32 ")\n",
-			name, mb_rate, fp_rate, instance);
+			" (instance %" PRIu32 ", %s page backing)\n",
+			name, mb_rate, fp_rate, instance, stress_hugepage_name());
 	} else {
 		if (instance == 0)
 			pr_inf(stderr, "%s: run too short to determine memory rate\n", name);
@@ -260,11 +898,11 @@ int stress_stream(
 
 	rc = EXIT_SUCCESS;
 
-	(void)munmap((void *)c, sz);
+	(void)munmap((void *)c, stress_hugepage_align((size_t)sz));
 err_c:
-	(void)munmap((void *)b, sz);
+	(void)munmap((void *)b, stress_hugepage_align((size_t)sz));
 err_b:
-	(void)munmap((void *)a, sz);
+	(void)munmap((void *)a, stress_hugepage_align((size_t)sz));
 err_a:
 
 	return rc;
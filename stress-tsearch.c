@@ -24,9 +24,69 @@
  */
 #include "stress-ng.h"
 #include <search.h>
+#if defined(__GLIBC__) && NEED_GLIBC(2,33,0)
+#include <malloc.h>
+#define STRESS_TSEARCH_MALLINFO	(1)
+#endif
+
+#define TSEARCH_METHOD_TSEARCH	(0)		/* libc tsearch(3) */
+#define TSEARCH_METHOD_BPTREE	(1)		/* arena B+tree */
+#define TSEARCH_METHODS		(2)
+#define TSEARCH_METHOD_ALL	(2)		/* cycle through all the methods */
+
+#define BPTREE_NIL		(UINT32_MAX)	/* no node */
+#define BPTREE_HDR		(8)		/* node header bytes */
+#define BPTREE_MAX_KEYS		(1024)		/* keys in the largest node */
+#define BPTREE_LINE		(64)		/* line size if unknown */
+
+typedef struct {
+	const char *name;		/* method name */
+	const int method;		/* TSEARCH_METHOD_* */
+} tsearch_method_info_t;
+
+static const tsearch_method_info_t tsearch_methods[] = {
+	{ "tsearch",	TSEARCH_METHOD_TSEARCH },
+	{ "bptree",	TSEARCH_METHOD_BPTREE },
+	{ "all",	TSEARCH_METHOD_ALL },
+	{ NULL,		0 }
+};
+
+/*
+ *  B+tree node, a whole number of cache lines. Leaves hold
+ *  keys, internal nodes hold keys then the child indices.
+ *  Nodes are referenced by 32 bit arena indices rather than
+ *  pointers so more keys fit in a line.
+ */
+typedef struct {
+	uint16_t count;			/* keys in the node */
+	uint16_t leaf;			/* true for leaves */
+	uint32_t next;			/* next leaf, leaves only */
+	int32_t keys[];			/* keys, then children */
+} bptree_node_t;
+
+typedef struct {
+	uint8_t *arena;			/* all the nodes */
+	size_t node_size;		/* bytes per node */
+	uint32_t capacity;		/* nodes in the arena */
+	uint32_t used;			/* nodes handed out from the arena */
+	uint32_t free_list;		/* freed nodes, linked by next */
+	uint32_t nodes;			/* nodes in the tree */
+	uint32_t root;			/* root node */
+	uint32_t leaf_keys;		/* maximum keys in a leaf */
+	uint32_t internal_keys;		/* maximum keys in an internal node */
+} bptree_t;
+
+/* per method totals */
+typedef struct {
+	uint64_t ops;			/* inserts, finds and deletes */
+	double duration;		/* time taken by the ops */
+	double bytes_per_key;		/* memory used per key when full */
+} tsearch_stats_t;
 
 static uint64_t opt_tsearch_size = DEFAULT_TSEARCH_SIZE;
 static bool set_tsearch_size = false;
+static uint32_t opt_tsearch_node_lines = DEFAULT_TSEARCH_NODE_LINES;
+static int opt_tsearch_method = TSEARCH_METHOD_TSEARCH;
 
 /*
  *  stress_set_tsearch_size()
@@ -40,6 +100,40 @@ void stress_set_tsearch_size(const char *optarg)
 		MIN_TSEARCH_SIZE, MAX_TSEARCH_SIZE);
 }
 
+/*
+ *  stress_set_tsearch_node_lines()
+ *	set the B+tree node size in cache lines
+ */
+void stress_set_tsearch_node_lines(const char *optarg)
+{
+	opt_tsearch_node_lines = get_uint32(optarg);
+	check_range("tsearch-node-lines", opt_tsearch_node_lines,
+		MIN_TSEARCH_NODE_LINES, MAX_TSEARCH_NODE_LINES);
+}
+
+/*
+ *  stress_set_tsearch_method()
+ *	set the tree implementation
+ */
+int stress_set_tsearch_method(const char *name)
+{
+	const tsearch_method_info_t *info;
+
+	for (info = tsearch_methods; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_tsearch_method = info->method;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "tsearch-method must be one of:");
+	for (info = tsearch_methods; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
 /*
  *  cmp()
  *	sort on int32 values
@@ -57,6 +151,543 @@ static int cmp(const void *p1, const void *p2)
 		return 0;
 }
 
+/*
+ *  bptree_node()
+ *	node of an arena index
+ */
+static inline bptree_node_t *bptree_node(const bptree_t *t, const uint32_t idx)
+{
+	return (bptree_node_t *)(t->arena + ((size_t)idx * t->node_size));
+}
+
+/*
+ *  bptree_children()
+ *	child indices of an internal node
+ */
+static inline uint32_t *bptree_children(const bptree_t *t, bptree_node_t *node)
+{
+	return (uint32_t *)(node->keys + t->internal_keys);
+}
+
+/*
+ *  bptree_alloc()
+ *	take a node from the free list or the arena
+ */
+static uint32_t bptree_alloc(bptree_t *t, const bool leaf)
+{
+	uint32_t idx;
+	bptree_node_t *node;
+
+	if (t->free_list != BPTREE_NIL) {
+		idx = t->free_list;
+		t->free_list = bptree_node(t, idx)->next;
+	} else if (t->used < t->capacity) {
+		idx = t->used++;
+	} else {
+		return BPTREE_NIL;
+	}
+	node = bptree_node(t, idx);
+	node->count = 0;
+	node->leaf = leaf;
+	node->next = BPTREE_NIL;
+	t->nodes++;
+
+	return idx;
+}
+
+/*
+ *  bptree_free()
+ *	return a node to the free list
+ */
+static void bptree_free(bptree_t *t, const uint32_t idx)
+{
+	bptree_node(t, idx)->next = t->free_list;
+	t->free_list = idx;
+	t->nodes--;
+}
+
+/*
+ *  bptree_init()
+ *	size the nodes to whole cache lines and allocate an
+ *	arena big enough for n keys with half full nodes
+ */
+static int bptree_init(bptree_t *t, const size_t n, const size_t line_size)
+{
+	uint32_t leaves;
+
+	t->node_size = line_size * opt_tsearch_node_lines;
+	t->leaf_keys = STRESS_MINIMUM((t->node_size - BPTREE_HDR) / sizeof(int32_t),
+		BPTREE_MAX_KEYS);
+	/* keys and one more child than keys */
+	t->internal_keys = STRESS_MINIMUM((t->node_size - BPTREE_HDR -
+		sizeof(uint32_t)) / (sizeof(int32_t) + sizeof(uint32_t)),
+		BPTREE_MAX_KEYS);
+	if ((t->leaf_keys < 4) || (t->internal_keys < 4))
+		return -1;
+
+	leaves = (uint32_t)(n / (t->leaf_keys / 2)) + 1;
+	t->capacity = (2 * leaves) + 16;
+	t->arena = calloc(t->capacity, t->node_size);
+	if (!t->arena)
+		return -1;
+	t->used = 0;
+	t->nodes = 0;
+	t->free_list = BPTREE_NIL;
+	t->root = bptree_alloc(t, true);
+
+	return 0;
+}
+
+/*
+ *  bptree_lower()
+ *	index of the first key >= key
+ */
+static inline uint32_t bptree_lower(const int32_t *keys, uint32_t n, const int32_t key)
+{
+	uint32_t lo = 0;
+
+	while (lo < n) {
+		const uint32_t mid = (lo + n) / 2;
+
+		if (keys[mid] < key)
+			lo = mid + 1;
+		else
+			n = mid;
+	}
+	return lo;
+}
+
+/*
+ *  bptree_upper()
+ *	index of the first key > key, the child to descend
+ */
+static inline uint32_t bptree_upper(const int32_t *keys, uint32_t n, const int32_t key)
+{
+	uint32_t lo = 0;
+
+	while (lo < n) {
+		const uint32_t mid = (lo + n) / 2;
+
+		if (keys[mid] <= key)
+			lo = mid + 1;
+		else
+			n = mid;
+	}
+	return lo;
+}
+
+/*
+ *  bptree_find()
+ *	descend to the leaf that could hold key
+ */
+static const int32_t *bptree_find(const bptree_t *t, const int32_t key)
+{
+	bptree_node_t *node = bptree_node(t, t->root);
+	uint32_t i;
+
+	while (!node->leaf) {
+		i = bptree_upper(node->keys, node->count, key);
+		node = bptree_node(t, bptree_children(t, node)[i]);
+	}
+	i = bptree_lower(node->keys, node->count, key);
+
+	return ((i < node->count) && (node->keys[i] == key)) ? &node->keys[i] : NULL;
+}
+
+/*
+ *  bptree_insert_node()
+ *	insert key below node idx, if the node splits the
+ *	separator and new right hand node are returned,
+ *	returns -1 if the arena is exhausted
+ */
+static int bptree_insert_node(
+	bptree_t *t,
+	const uint32_t idx,
+	const int32_t key,
+	int32_t *sep,
+	uint32_t *right)
+{
+	bptree_node_t *node = bptree_node(t, idx), *rnode;
+	int32_t keys[BPTREE_MAX_KEYS + 1];
+	uint32_t children[BPTREE_MAX_KEYS + 2];
+	uint32_t i, n, half, ridx;
+
+	*right = BPTREE_NIL;
+
+	if (node->leaf) {
+		i = bptree_lower(node->keys, node->count, key);
+		if ((i < node->count) && (node->keys[i] == key))
+			return 0;
+		if (node->count < t->leaf_keys) {
+			(void)memmove(&node->keys[i + 1], &node->keys[i],
+				(node->count - i) * sizeof(int32_t));
+			node->keys[i] = key;
+			node->count++;
+			return 0;
+		}
+		/* full, split into two half full leaves */
+		if ((ridx = bptree_alloc(t, true)) == BPTREE_NIL)
+			return -1;
+		rnode = bptree_node(t, ridx);
+		n = node->count;
+		(void)memcpy(keys, node->keys, i * sizeof(int32_t));
+		keys[i] = key;
+		(void)memcpy(&keys[i + 1], &node->keys[i], (n - i) * sizeof(int32_t));
+		n++;
+		half = n / 2;
+		(void)memcpy(node->keys, keys, half * sizeof(int32_t));
+		node->count = half;
+		(void)memcpy(rnode->keys, &keys[half], (n - half) * sizeof(int32_t));
+		rnode->count = n - half;
+		rnode->next = node->next;
+		node->next = ridx;
+
+		*sep = rnode->keys[0];
+		*right = ridx;
+		return 0;
+	} else {
+		int32_t csep;
+		uint32_t cright, *nc;
+
+		i = bptree_upper(node->keys, node->count, key);
+		if (bptree_insert_node(t, bptree_children(t, node)[i], key,
+		    &csep, &cright) < 0)
+			return -1;
+		if (cright == BPTREE_NIL)
+			return 0;
+
+		nc = bptree_children(t, node);
+		if (node->count < t->internal_keys) {
+			(void)memmove(&node->keys[i + 1], &node->keys[i],
+				(node->count - i) * sizeof(int32_t));
+			(void)memmove(&nc[i + 2], &nc[i + 1],
+				(node->count - i) * sizeof(uint32_t));
+			node->keys[i] = csep;
+			nc[i + 1] = cright;
+			node->count++;
+			return 0;
+		}
+		/* full, split and push the middle key up */
+		if ((ridx = bptree_alloc(t, false)) == BPTREE_NIL)
+			return -1;
+		rnode = bptree_node(t, ridx);
+		n = node->count;
+		(void)memcpy(keys, node->keys, i * sizeof(int32_t));
+		keys[i] = csep;
+		(void)memcpy(&keys[i + 1], &node->keys[i], (n - i) * sizeof(int32_t));
+		(void)memcpy(children, nc, (i + 1) * sizeof(uint32_t));
+		children[i + 1] = cright;
+		(void)memcpy(&children[i + 2], &nc[i + 1], (n - i) * sizeof(uint32_t));
+		n++;
+		half = n / 2;
+		(void)memcpy(node->keys, keys, half * sizeof(int32_t));
+		(void)memcpy(nc, children, (half + 1) * sizeof(uint32_t));
+		node->count = half;
+		(void)memcpy(rnode->keys, &keys[half + 1],
+			(n - half - 1) * sizeof(int32_t));
+		(void)memcpy(bptree_children(t, rnode), &children[half + 1],
+			(n - half) * sizeof(uint32_t));
+		rnode->count = n - half - 1;
+
+		*sep = keys[half];
+		*right = ridx;
+		return 0;
+	}
+}
+
+/*
+ *  bptree_insert()
+ *	insert key, growing a new root if the root splits
+ */
+static int bptree_insert(bptree_t *t, const int32_t key)
+{
+	int32_t sep;
+	uint32_t right, idx;
+	bptree_node_t *root;
+
+	if (bptree_insert_node(t, t->root, key, &sep, &right) < 0)
+		return -1;
+	if (right == BPTREE_NIL)
+		return 0;
+
+	if ((idx = bptree_alloc(t, false)) == BPTREE_NIL)
+		return -1;
+	root = bptree_node(t, idx);
+	root->count = 1;
+	root->keys[0] = sep;
+	bptree_children(t, root)[0] = t->root;
+	bptree_children(t, root)[1] = right;
+	t->root = idx;
+
+	return 0;
+}
+
+/*
+ *  bptree_rebalance()
+ *	child i of parent p is under half full, borrow a key
+ *	from a sibling that can spare one or merge with it
+ */
+static void bptree_rebalance(bptree_t *t, bptree_node_t *p, const uint32_t i)
+{
+	uint32_t *pc = bptree_children(t, p);
+	bptree_node_t *c = bptree_node(t, pc[i]);
+	const uint32_t min = c->leaf ? t->leaf_keys / 2 : t->internal_keys / 2;
+	bptree_node_t *l = (i > 0) ? bptree_node(t, pc[i - 1]) : NULL;
+	bptree_node_t *r = (i < p->count) ? bptree_node(t, pc[i + 1]) : NULL;
+	bptree_node_t *a, *b;
+	uint32_t s;
+
+	if (l && (l->count > min)) {
+		/* borrow the last key of the left sibling */
+		(void)memmove(&c->keys[1], &c->keys[0], c->count * sizeof(int32_t));
+		if (c->leaf) {
+			c->keys[0] = l->keys[l->count - 1];
+			p->keys[i - 1] = c->keys[0];
+		} else {
+			uint32_t *cc = bptree_children(t, c);
+
+			(void)memmove(&cc[1], &cc[0], (c->count + 1) * sizeof(uint32_t));
+			c->keys[0] = p->keys[i - 1];
+			cc[0] = bptree_children(t, l)[l->count];
+			p->keys[i - 1] = l->keys[l->count - 1];
+		}
+		l->count--;
+		c->count++;
+		return;
+	}
+	if (r && (r->count > min)) {
+		/* borrow the first key of the right sibling */
+		if (c->leaf) {
+			c->keys[c->count] = r->keys[0];
+			(void)memmove(&r->keys[0], &r->keys[1],
+				(r->count - 1) * sizeof(int32_t));
+			p->keys[i] = r->keys[0];
+		} else {
+			uint32_t *rc = bptree_children(t, r);
+
+			c->keys[c->count] = p->keys[i];
+			bptree_children(t, c)[c->count + 1] = rc[0];
+			p->keys[i] = r->keys[0];
+			(void)memmove(&r->keys[0], &r->keys[1],
+				(r->count - 1) * sizeof(int32_t));
+			(void)memmove(&rc[0], &rc[1], r->count * sizeof(uint32_t));
+		}
+		r->count--;
+		c->count++;
+		return;
+	}
+
+	/* merge b into a, s is the separator between them */
+	if (l) {
+		a = l;
+		b = c;
+		s = i - 1;
+	} else {
+		a = c;
+		b = r;
+		s = i;
+	}
+	if (a->leaf) {
+		(void)memcpy(&a->keys[a->count], b->keys, b->count * sizeof(int32_t));
+		a->count += b->count;
+		a->next = b->next;
+	} else {
+		a->keys[a->count] = p->keys[s];
+		(void)memcpy(&a->keys[a->count + 1], b->keys,
+			b->count * sizeof(int32_t));
+		(void)memcpy(&bptree_children(t, a)[a->count + 1],
+			bptree_children(t, b), (b->count + 1) * sizeof(uint32_t));
+		a->count += b->count + 1;
+	}
+	bptree_free(t, pc[s + 1]);
+	(void)memmove(&p->keys[s], &p->keys[s + 1],
+		(p->count - s - 1) * sizeof(int32_t));
+	(void)memmove(&pc[s + 1], &pc[s + 2], (p->count - s - 1) * sizeof(uint32_t));
+	p->count--;
+}
+
+/*
+ *  bptree_delete_node()
+ *	delete key below node idx, returns true if found
+ */
+static bool bptree_delete_node(bptree_t *t, const uint32_t idx, const int32_t key)
+{
+	bptree_node_t *node = bptree_node(t, idx), *child;
+	uint32_t i;
+
+	if (node->leaf) {
+		i = bptree_lower(node->keys, node->count, key);
+		if ((i == node->count) || (node->keys[i] != key))
+			return false;
+		(void)memmove(&node->keys[i], &node->keys[i + 1],
+			(node->count - i - 1) * sizeof(int32_t));
+		node->count--;
+		return true;
+	}
+
+	i = bptree_upper(node->keys, node->count, key);
+	if (!bptree_delete_node(t, bptree_children(t, node)[i], key))
+		return false;
+	child = bptree_node(t, bptree_children(t, node)[i]);
+	if (child->count < (child->leaf ? t->leaf_keys / 2 : t->internal_keys / 2))
+		bptree_rebalance(t, node, i);
+	return true;
+}
+
+/*
+ *  bptree_delete()
+ *	delete key, shrinking the tree when the root empties
+ */
+static bool bptree_delete(bptree_t *t, const int32_t key)
+{
+	bptree_node_t *root;
+
+	if (!bptree_delete_node(t, t->root, key))
+		return false;
+
+	root = bptree_node(t, t->root);
+	if (!root->leaf && (root->count == 0)) {
+		const uint32_t idx = t->root;
+
+		t->root = bptree_children(t, root)[0];
+		bptree_free(t, idx);
+	}
+	return true;
+}
+
+/*
+ *  stress_tsearch_libc()
+ *	insert, find and delete n keys with tsearch(3),
+ *	returns -1 if a node could not be allocated
+ */
+static int stress_tsearch_libc(
+	const char *name,
+	int32_t *data,
+	const size_t n,
+	uint64_t *ops,
+	double *bytes_per_key)
+{
+	void *root = NULL;
+	size_t i;
+#if defined(STRESS_TSEARCH_MALLINFO)
+	const size_t before = mallinfo2().uordblks;
+#endif
+
+	/* Step #1, populate tree */
+	for (i = 0; i < n; i++) {
+		if (tsearch(&data[i], &root, cmp) == NULL) {
+			size_t j;
+
+			pr_err(stderr, "%s: cannot allocate new "
+				"tree node\n", name);
+			for (j = 0; j < i; j++)
+				tdelete(&data[j], &root, cmp);
+			return -1;
+		}
+	}
+	*ops += n;
+#if defined(STRESS_TSEARCH_MALLINFO)
+	*bytes_per_key = (double)(mallinfo2().uordblks - before) / (double)n;
+#else
+	*bytes_per_key = 0.0;
+#endif
+
+	/* Step #2, find */
+	for (i = 0; opt_do_run && i < n; i++) {
+		void **result;
+
+		result = tfind(&data[i], &root, cmp);
+		if (opt_flags & OPT_FLAGS_VERIFY) {
+			if (result == NULL)
+				pr_fail(stderr, "%s: element %zu "
+					"could not be found\n",
+					name, i);
+			else {
+				int32_t *val;
+				val = *result;
+				if (*val != data[i])
+					pr_fail(stderr, "%s: element "
+						"%zu found %" PRIu32
+						", expecting %" PRIu32 "\n",
+						name, i, *val, data[i]);
+			}
+		}
+	}
+	*ops += i;
+
+	/* Step #3, delete */
+	for (i = 0; i < n; i++) {
+		void **result;
+
+		result = tdelete(&data[i], &root, cmp);
+		if ((opt_flags & OPT_FLAGS_VERIFY) && (result == NULL))
+			pr_fail(stderr, "%s: element %zu could not "
+				"be found\n", name, i);
+	}
+	*ops += n;
+
+	return 0;
+}
+
+/*
+ *  stress_tsearch_bptree()
+ *	insert, find and delete n keys with the B+tree,
+ *	returns -1 if the arena ran out of nodes
+ */
+static int stress_tsearch_bptree(
+	const char *name,
+	bptree_t *t,
+	const int32_t *data,
+	const size_t n,
+	uint64_t *ops,
+	double *bytes_per_key)
+{
+	size_t i;
+
+	/* Step #1, populate tree */
+	for (i = 0; i < n; i++) {
+		if (bptree_insert(t, data[i]) < 0) {
+			pr_err(stderr, "%s: B+tree arena is full\n", name);
+			return -1;
+		}
+	}
+	*ops += n;
+	*bytes_per_key = (double)((size_t)t->nodes * t->node_size) / (double)n;
+
+	/* Step #2, find */
+	for (i = 0; opt_do_run && i < n; i++) {
+		const int32_t *result = bptree_find(t, data[i]);
+
+		if (opt_flags & OPT_FLAGS_VERIFY) {
+			if (result == NULL)
+				pr_fail(stderr, "%s: element %zu "
+					"could not be found\n",
+					name, i);
+			else if (*result != data[i])
+				pr_fail(stderr, "%s: element "
+					"%zu found %" PRIu32
+					", expecting %" PRIu32 "\n",
+					name, i, *result, data[i]);
+		}
+	}
+	*ops += i;
+
+	/* Step #3, delete */
+	for (i = 0; i < n; i++) {
+		if (!bptree_delete(t, data[i]) && (opt_flags & OPT_FLAGS_VERIFY))
+			pr_fail(stderr, "%s: element %zu could not "
+				"be found\n", name, i);
+	}
+	*ops += n;
+
+	if ((opt_flags & OPT_FLAGS_VERIFY) &&
+	    ((t->nodes != 1) || (bptree_node(t, t->root)->count != 0)))
+		pr_fail(stderr, "%s: B+tree not empty after deleting all "
+			"the elements, %" PRIu32 " nodes left\n", name, t->nodes);
+
+	return 0;
+}
+
 /*
  *  stress_tsearch()
  *	stress tsearch
@@ -67,10 +698,11 @@ int stress_tsearch(
 	const uint64_t max_ops,
 	const char *name)
 {
+	tsearch_stats_t stats[TSEARCH_METHODS];
+	bptree_t tree;
 	int32_t *data;
-	size_t i, n;
-
-	(void)instance;
+	size_t i, n, line_size = BPTREE_LINE;
+	int method, ret = EXIT_SUCCESS;
 
 	if (!set_tsearch_size) {
 		if (opt_flags & OPT_FLAGS_MAXIMIZE)
@@ -85,56 +717,72 @@ int stress_tsearch(
 		return EXIT_FAILURE;
 	}
 
+#if defined(__linux__)
+	{
+		cpus_t *cpu_caches = get_all_cpu_cache_details();
+
+		if (cpu_caches) {
+			const cpu_cache_t *cache = get_cpu_cache(cpu_caches, 1);
+
+			if (cache && cache->line_size)
+				line_size = cache->line_size;
+			free_cpu_caches(cpu_caches);
+		}
+	}
+#endif
+	memset(&tree, 0, sizeof(tree));
+	if (bptree_init(&tree, n, line_size) < 0) {
+		pr_err(stderr, "%s: cannot allocate B+tree arena\n", name);
+		free(data);
+		return EXIT_NO_RESOURCE;
+	}
+	memset(stats, 0, sizeof(stats));
+
+	method = (opt_tsearch_method == TSEARCH_METHOD_ALL) ?
+		TSEARCH_METHOD_TSEARCH : opt_tsearch_method;
 	do {
-		void *root = NULL;
+		double t;
+		int rc;
 
-		/* Step #1, populate tree */
-		for (i = 0; i < n; i++) {
+		for (i = 0; i < n; i++)
 			data[i] = ((mwc32() & 0xfff) << 20) ^ i;
-			if (tsearch(&data[i], &root, cmp) == NULL) {
-				size_t j;
-
-				pr_err(stderr, "%s: cannot allocate new "
-					"tree node\n", name);
-				for (j = 0; j < i; j++)
-					tdelete(&data[j], &root, cmp);
-				goto abort;
-			}
-		}
-		/* Step #2, find */
-		for (i = 0; opt_do_run && i < n; i++) {
-			void **result;
-
-			result = tfind(&data[i], &root, cmp);
-			if (opt_flags & OPT_FLAGS_VERIFY) {
-				if (result == NULL)
-					pr_fail(stderr, "%s: element %zu "
-						"could not be found\n",
-						name, i);
-				else {
-					int32_t *val;
-					val = *result;
-					if (*val != data[i])
-						pr_fail(stderr, "%s: element "
-							"%zu found %" PRIu32
-							", expecting %" PRIu32 "\n",
-							name, i, *val, data[i]);
-				}
-			}
-		}
-		/* Step #3, delete */
-		for (i = 0; i < n; i++) {
-			void **result;
-
-			result = tdelete(&data[i], &root, cmp);
-			if ((opt_flags & OPT_FLAGS_VERIFY) && (result == NULL))
-				pr_fail(stderr, "%s: element %zu could not "
-					"be found\n", name, i);
+
+		t = time_now();
+		if (method == TSEARCH_METHOD_BPTREE)
+			rc = stress_tsearch_bptree(name, &tree, data, n,
+				&stats[method].ops, &stats[method].bytes_per_key);
+		else
+			rc = stress_tsearch_libc(name, data, n,
+				&stats[method].ops, &stats[method].bytes_per_key);
+		stats[method].duration += time_now() - t;
+		if (rc < 0) {
+			ret = EXIT_NO_RESOURCE;
+			break;
 		}
+
 		(*counter)++;
+		if (opt_tsearch_method == TSEARCH_METHOD_ALL)
+			method = (method + 1) % TSEARCH_METHODS;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
 
-abort:
+	if (instance == 0) {
+		pr_inf(stderr, "%s: B+tree nodes of %zu bytes, %" PRIu32
+			" keys per leaf, %" PRIu32 " keys per internal node\n",
+			name, tree.node_size, tree.leaf_keys, tree.internal_keys);
+		for (method = 0; method < TSEARCH_METHODS; method++) {
+			const tsearch_stats_t *s = &stats[method];
+
+			if (!s->ops || (s->duration <= 0.0))
+				continue;
+			pr_inf(stderr, "%s: %-8s %9.2f M ops/sec, %7.2f ns/op, "
+				"%6.2f bytes/key\n", name, tsearch_methods[method].name,
+				(double)s->ops / (s->duration * 1000000.0),
+				(s->duration * 1000000000.0) / (double)s->ops,
+				s->bytes_per_key);
+		}
+	}
+
+	free(tree.arena);
 	free(data);
-	return EXIT_SUCCESS;
+	return ret;
 }
@@ -24,7 +24,17 @@
  */
 #include "stress-ng.h"
 
+#if defined(__x86_64__) && NEED_GNUC(5,0,0) && !defined(__clang__)
+#define STRESS_VM_X86		(1)
+#include <emmintrin.h>
+#endif
+
 #define VM_BOGO_SHIFT		(12)
+#define VM_CHUNK_SIZE		(256)	/* Bytes per bogo op in read/write methods */
+#define VM_CHASE_LOADS		(1 << 22)	/* Pointer chase loads per size */
+#define VM_CHASE_MIN_SIZE	(4 * KB)	/* Smallest working set size */
+#define VM_CHASE_SIZES		(48)		/* Max working set sizes */
+#define VM_CACHE_LINE		(64)		/* Pointer chase line size */
 #define VM_ROWHAMMER_LOOPS	(1000000)
 
 #define NO_MEM_RETRIES_MAX	(100)
@@ -40,6 +50,12 @@ typedef struct {
 	const stress_vm_func func;
 } stress_vm_stressor_info_t;
 
+/* Pointer chase latency per working set size */
+typedef struct {
+	double duration;		/* time spent chasing pointers */
+	uint64_t loads;			/* number of dependent loads */
+} stress_vm_chase_t;
+
 static uint64_t opt_vm_hang = DEFAULT_VM_HANG;
 static size_t   opt_vm_bytes = DEFAULT_VM_BYTES;
 static bool	set_vm_bytes = false;
@@ -48,6 +64,10 @@ static int      opt_vm_flags = 0;                      /* VM mmap flags */
 static const stress_vm_stressor_info_t *opt_vm_stressor;
 static const stress_vm_stressor_info_t vm_methods[];
 
+/* Shared with the parent so the results survive the child being killed */
+static stress_vm_chase_t *vm_chase_line;
+static stress_vm_chase_t *vm_chase_page;
+
 void stress_set_vm_hang(const char *optarg)
 {
 	opt_vm_hang = get_uint64_byte(optarg);
@@ -189,6 +209,19 @@ static inline size_t stress_vm_count_bits(uint64_t v)
 	return n;
 }
 
+static uint64_t vm_bytes_read;
+static uint64_t vm_bytes_written;
+
+/*
+ *  stress_vm_account()
+ *	account memory bytes read and written by a method
+ */
+static inline void stress_vm_account(const uint64_t rd, const uint64_t wr)
+{
+	vm_bytes_read += rd;
+	vm_bytes_written += wr;
+}
+
 /*
  *  stress_vm_moving_inversion()
  *	work sequentially through memory setting 8 bytes at at a time
@@ -278,6 +311,7 @@ static size_t stress_vm_moving_inversion(
 			goto abort;
 	}
 
+	stress_vm_account(4 * sz, 4 * sz);
 abort:
 	stress_vm_check("moving inversion", bit_errors);
 	*counter = c;
@@ -344,6 +378,7 @@ static size_t stress_vm_modulo_x(
 		}
 	}
 
+	stress_vm_account(sz, stride * sz);
 abort:
 	stress_vm_check("modulo X", bit_errors);
 	*counter = c;
@@ -365,7 +400,7 @@ static size_t stress_vm_walking_one_data(
 	size_t bit_errors = 0;
 	volatile uint8_t *ptr;
 	uint8_t *buf_end = buf + sz;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	for (ptr = buf; ptr < buf_end; ptr++) {
 		SET_AND_TEST(ptr, 0x01, bit_errors);
@@ -382,6 +417,7 @@ static size_t stress_vm_walking_one_data(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account((c - c_start) * 8, (c - c_start) * 8);
 	stress_vm_check("walking one (data)", bit_errors);
 	*counter = c;
 
@@ -402,7 +438,7 @@ static size_t stress_vm_walking_zero_data(
 	size_t bit_errors = 0;
 	volatile uint8_t *ptr;
 	uint8_t *buf_end = buf + sz;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	for (ptr = buf; ptr < buf_end; ptr++) {
 		SET_AND_TEST(ptr, 0xfe, bit_errors);
@@ -419,6 +455,7 @@ static size_t stress_vm_walking_zero_data(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account((c - c_start) * 8, (c - c_start) * 8);
 	stress_vm_check("walking zero (data)", bit_errors);
 	*counter = c;
 
@@ -442,7 +479,7 @@ static size_t stress_vm_walking_one_addr(
 	uint8_t d1 = 0, d2 = ~d1;
 	size_t bit_errors = 0;
 	size_t tests = 0;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	memset(buf, d1, sz);
 	for (ptr = buf; ptr < buf_end; ptr += 256) {
@@ -469,6 +506,7 @@ static size_t stress_vm_walking_one_addr(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(tests, sz + (c - c_start) + tests);
 	stress_vm_check("walking one (address)", bit_errors);
 	*counter = c;
 
@@ -493,7 +531,7 @@ static size_t stress_vm_walking_zero_addr(
 	size_t bit_errors = 0;
 	size_t tests = 0;
 	uint64_t sz_mask;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	for (sz_mask = 1; sz_mask < sz; sz_mask <<= 1)
 		;
@@ -523,6 +561,7 @@ static size_t stress_vm_walking_zero_addr(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(tests, sz + (c - c_start) + tests);
 	stress_vm_check("walking zero (address)", bit_errors);
 	*counter = c;
 
@@ -545,7 +584,7 @@ static size_t stress_vm_gray(
 	uint8_t v, *buf_end = buf + sz;
 	volatile uint8_t *ptr;
 	size_t bit_errors = 0;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	for (v = val, ptr = buf; ptr < buf_end; ptr++, v++) {
 		if (!opt_do_run)
@@ -566,6 +605,7 @@ static size_t stress_vm_gray(
 	}
 	val++;
 
+	stress_vm_account(sz, c - c_start);
 	stress_vm_check("gray code", bit_errors);
 	*counter = c;
 
@@ -589,7 +629,7 @@ static size_t stress_vm_incdec(
 	uint8_t *buf_end = buf + sz;
 	volatile uint8_t *ptr;
 	size_t bit_errors = 0;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	val++;
 	memset(buf, 0x00, sz);
@@ -614,6 +654,7 @@ static size_t stress_vm_incdec(
 			bit_errors++;
 	}
 
+	stress_vm_account((c - c_start) + sz, sz + (c - c_start));
 	stress_vm_check("incdec code", bit_errors);
 	*counter = c;
 
@@ -637,7 +678,7 @@ static size_t stress_vm_prime_incdec(
 	volatile uint8_t *ptr = buf;
 	size_t bit_errors = 0, i;
 	const uint64_t prime = PRIME_64;
-	uint64_t j, c = *counter;
+	uint64_t j, c = *counter, c_start = c;
 
 #if SIZE_MAX > UINT32_MAX
 	/* Unlikely.. */
@@ -672,6 +713,7 @@ static size_t stress_vm_prime_incdec(
 			bit_errors++;
 	}
 
+	stress_vm_account((c - c_start) + sz, sz + (c - c_start));
 	stress_vm_check("prime-incdec", bit_errors);
 	*counter = c;
 
@@ -771,6 +813,7 @@ static size_t stress_vm_swap(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(5 * sz, 5 * sz);
 abort:
 	free(swaps);
 	stress_vm_check("swap bytes", bit_errors);
@@ -837,6 +880,7 @@ static size_t stress_vm_rand_set(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(sz, sz);
 abort:
 	stress_vm_check("rand-set", bit_errors);
 	*counter = c;
@@ -922,6 +966,7 @@ static size_t stress_vm_ror(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(2 * sz, 2 * sz);
 abort:
 	stress_vm_check("ror", bit_errors);
 	*counter = c;
@@ -1024,6 +1069,7 @@ static size_t stress_vm_flip(
 			break;
 	}
 
+	stress_vm_account(9 * sz, 9 * sz);
 abort:
 	stress_vm_check("flip", bit_errors);
 	*counter = c;
@@ -1086,6 +1132,7 @@ static size_t stress_vm_zero_one(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(2 * sz, 2 * sz);
 abort:
 	stress_vm_check("zero-one", bit_errors);
 	*counter = c;
@@ -1109,7 +1156,7 @@ static size_t stress_vm_galpat_zero(
 	uint64_t *buf_end = (uint64_t *)(buf + sz);
 	size_t i, bit_errors = 0, bits_set = 0;
 	size_t bits_bad = sz / 4096;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	memset(buf, 0x00, sz);
 
@@ -1149,6 +1196,7 @@ static size_t stress_vm_galpat_zero(
 	if (bits_set != bits_bad)
 		bit_errors += UNSIGNED_ABS(bits_set, bits_bad);
 
+	stress_vm_account(sz + (c - c_start), sz + (c - c_start));
 	stress_vm_check("galpat-zero", bit_errors);
 	*counter = c;
 
@@ -1171,7 +1219,7 @@ static size_t stress_vm_galpat_one(
 	uint64_t *buf_end = (uint64_t *)(buf + sz);
 	size_t i, bit_errors = 0, bits_set = 0;
 	size_t bits_bad = sz / 4096;
-	uint64_t c = *counter;
+	uint64_t c = *counter, c_start = c;
 
 	memset(buf, 0xff, sz);
 
@@ -1210,6 +1258,7 @@ static size_t stress_vm_galpat_one(
 	if (bits_set != bits_bad)
 		bit_errors += UNSIGNED_ABS(bits_set, bits_bad);
 
+	stress_vm_account(sz + (c - c_start), sz + (c - c_start));
 	stress_vm_check("galpat-one", bit_errors);
 	*counter = c;
 
@@ -1285,6 +1334,7 @@ static size_t stress_vm_inc_nybble(
 			break;
 	}
 
+	stress_vm_account(3 * sz, 3 * sz);
 abort:
 	stress_vm_check("inc-nybble", bit_errors);
 	*counter = c;
@@ -1346,6 +1396,7 @@ static size_t stress_vm_rand_sum(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(sz, sz);
 abort:
 	stress_vm_check("rand-sum", bit_errors);
 	*counter = c;
@@ -1403,6 +1454,7 @@ static size_t stress_vm_prime_zero(
 		bit_errors += stress_vm_count_bits(buf[i]);
 	}
 
+	stress_vm_account(9 * sz, 9 * sz);
 abort:
 	stress_vm_check("prime-zero", bit_errors);
 	*counter = c;
@@ -1461,6 +1513,7 @@ static size_t stress_vm_prime_one(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(9 * sz, 9 * sz);
 abort:
 	stress_vm_check("prime-one", bit_errors);
 	*counter = c;
@@ -1528,6 +1581,7 @@ static size_t stress_vm_prime_gray_zero(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(3 * sz, 3 * sz);
 abort:
 	stress_vm_check("prime-gray-zero", bit_errors);
 	*counter = c;
@@ -1596,6 +1650,7 @@ static size_t stress_vm_prime_gray_one(
 		if (!opt_do_run)
 			break;
 	}
+	stress_vm_account(3 * sz, 3 * sz);
 abort:
 	stress_vm_check("prime-gray-one", bit_errors);
 	*counter = c;
@@ -1660,6 +1715,7 @@ static size_t stress_vm_write64(
 	}
 	*counter += i;
 	val++;
+	stress_vm_account(0, i * sizeof(uint64_t) * 32);
 
 	return 0;
 }
@@ -1719,10 +1775,431 @@ static size_t stress_vm_read64(
 			break;
 	}
 	*counter += i;
+	stress_vm_account(i * sizeof(uint64_t) * 32, 0);
+
+	return 0;
+}
+
+#if defined(HAVE_VECMATH)
+typedef uint64_t stress_vm_v128_t __attribute__ ((vector_size(16)));
+typedef uint64_t stress_vm_v256_t __attribute__ ((vector_size(32)));
+typedef uint64_t stress_vm_v512_t __attribute__ ((vector_size(64)));
+
+/*
+ *  STRESS_VM_VEC_RW()
+ *	generate sequential vector read and write loops of a specific
+ *	vector width, each loop touches VM_CHUNK_SIZE bytes so the bogo
+ *	op counts are comparable with the read64 and write64 methods
+ */
+#define STRESS_VM_VEC_RW(name, type, attr)				\
+static size_t attr name ## _read(					\
+	uint8_t *buf,							\
+	const size_t sz,						\
+	uint64_t *counter,						\
+	const uint64_t max_ops)						\
+{									\
+	volatile type *ptr = (type *)buf;				\
+	register size_t i = 0, n = sz / VM_CHUNK_SIZE;			\
+									\
+	while (i < n) {							\
+		register size_t j;					\
+									\
+		for (j = 0; j < VM_CHUNK_SIZE / sizeof(type); j++)	\
+			(void)*(ptr++);					\
+		i++;							\
+		if (!opt_do_run || (max_ops && i >= max_ops))		\
+			break;						\
+	}								\
+	*counter += i;							\
+	stress_vm_account(i * VM_CHUNK_SIZE, 0);			\
+									\
+	return 0;							\
+}									\
+									\
+static size_t attr name ## _write(					\
+	uint8_t *buf,							\
+	const size_t sz,						\
+	uint64_t *counter,						\
+	const uint64_t max_ops)						\
+{									\
+	static uint64_t val;						\
+	type *ptr = (type *)buf;					\
+	const type v = ((type){ 0 }) + val;				\
+	register size_t i = 0, n = sz / VM_CHUNK_SIZE;			\
+									\
+	while (i < n) {							\
+		register size_t j;					\
+									\
+		for (j = 0; j < VM_CHUNK_SIZE / sizeof(type); j++)	\
+			*(ptr++) = v;					\
+		i++;							\
+		if (!opt_do_run || (max_ops && i >= max_ops))		\
+			break;						\
+	}								\
+	*counter += i;							\
+	val++;								\
+	stress_vm_account(0, i * VM_CHUNK_SIZE);			\
+									\
+	return 0;							\
+}
+
+STRESS_VM_VEC_RW(stress_vm_v128, stress_vm_v128_t, )
+STRESS_VM_VEC_RW(stress_vm_v256, stress_vm_v256_t, )
+STRESS_VM_VEC_RW(stress_vm_v512, stress_vm_v512_t, )
+#if defined(STRESS_VM_X86)
+STRESS_VM_VEC_RW(stress_vm_v256_avx, stress_vm_v256_t, __attribute__((target("avx"))))
+STRESS_VM_VEC_RW(stress_vm_v512_avx512, stress_vm_v512_t, __attribute__((target("avx512f"))))
+#endif
+
+/*
+ *  stress_vm_read128()
+ *	sequential 128 bit vector reads
+ */
+static size_t stress_vm_read128(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	return stress_vm_v128_read(buf, sz, counter, max_ops);
+}
+
+/*
+ *  stress_vm_write128()
+ *	sequential 128 bit vector writes, no read check
+ */
+static size_t stress_vm_write128(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	return stress_vm_v128_write(buf, sz, counter, max_ops);
+}
+
+/*
+ *  stress_vm_read256()
+ *	sequential 256 bit vector reads, uses AVX if available
+ */
+static size_t stress_vm_read256(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+#if defined(STRESS_VM_X86)
+	if (__builtin_cpu_supports("avx"))
+		return stress_vm_v256_avx_read(buf, sz, counter, max_ops);
+#endif
+	return stress_vm_v256_read(buf, sz, counter, max_ops);
+}
+
+/*
+ *  stress_vm_write256()
+ *	sequential 256 bit vector writes, uses AVX if available
+ */
+static size_t stress_vm_write256(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+#if defined(STRESS_VM_X86)
+	if (__builtin_cpu_supports("avx"))
+		return stress_vm_v256_avx_write(buf, sz, counter, max_ops);
+#endif
+	return stress_vm_v256_write(buf, sz, counter, max_ops);
+}
+
+/*
+ *  stress_vm_read512()
+ *	sequential 512 bit vector reads, uses AVX-512 if available
+ */
+static size_t stress_vm_read512(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+#if defined(STRESS_VM_X86)
+	if (__builtin_cpu_supports("avx512f"))
+		return stress_vm_v512_avx512_read(buf, sz, counter, max_ops);
+#endif
+	return stress_vm_v512_read(buf, sz, counter, max_ops);
+}
+
+/*
+ *  stress_vm_write512()
+ *	sequential 512 bit vector writes, uses AVX-512 if available
+ */
+static size_t stress_vm_write512(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+#if defined(STRESS_VM_X86)
+	if (__builtin_cpu_supports("avx512f"))
+		return stress_vm_v512_avx512_write(buf, sz, counter, max_ops);
+#endif
+	return stress_vm_v512_write(buf, sz, counter, max_ops);
+}
+#endif
+
+/*
+ *  stress_vm_write_nt()
+ *	sequential 128 bit non-temporal streaming writes that
+ *	bypass the cache, no read check
+ */
+static size_t stress_vm_write_nt(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	static uint64_t val;
+	register size_t i = 0, n = sz / VM_CHUNK_SIZE;
+#if defined(STRESS_VM_X86)
+	__m128i *ptr = (__m128i *)buf;
+	const __m128i v = _mm_set1_epi64x((long long)val);
+
+	while (i < n) {
+		register size_t j;
+
+		for (j = 0; j < VM_CHUNK_SIZE / sizeof(__m128i); j++)
+			_mm_stream_si128(ptr++, v);
+		i++;
+		if (!opt_do_run || (max_ops && i >= max_ops))
+			break;
+	}
+	_mm_sfence();
+#else
+	/* No streaming stores, fall back to regular 64 bit writes */
+	uint64_t *ptr = (uint64_t *)buf;
+	register uint64_t v = val;
+
+	while (i < n) {
+		register size_t j;
+
+		for (j = 0; j < VM_CHUNK_SIZE / sizeof(uint64_t); j++)
+			*(ptr++) = v;
+		i++;
+		if (!opt_do_run || (max_ops && i >= max_ops))
+			break;
+	}
+#endif
+	*counter += i;
+	val++;
+	stress_vm_account(0, i * VM_CHUNK_SIZE);
+
+	return 0;
+}
+
+/*
+ *  stress_vm_memset()
+ *	write only memset of the buffer a page at a time, this
+ *	uses the C library's optimised memset to find the peak
+ *	write bandwidth, no read check
+ */
+static size_t stress_vm_memset(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	static uint8_t val;
+	const size_t page_size = stress_get_pagesize();
+	const size_t chunks = page_size / VM_CHUNK_SIZE;
+	register size_t i = 0, n = sz / VM_CHUNK_SIZE;
+	uint8_t *ptr = buf;
+
+	while (i + chunks <= n) {
+		(void)memset(ptr, val, page_size);
+		ptr += page_size;
+		i += chunks;
+		if (!opt_do_run || (max_ops && i >= max_ops))
+			break;
+	}
+	*counter += i;
+	val++;
+	stress_vm_account(0, i * VM_CHUNK_SIZE);
+
+	return 0;
+}
+
+/*
+ *  stress_vm_chase_slot()
+ *	address of the Nth pointer chase slot, slots larger than
+ *	a cache line are staggered by a cache line each so they
+ *	do not all land in the same cache set
+ */
+static inline void **stress_vm_chase_slot(
+	uint8_t *buf,
+	const size_t n,
+	const size_t stride)
+{
+	const size_t offset = (stride > VM_CACHE_LINE) ?
+		(n * VM_CACHE_LINE) % stride : 0;
+
+	return (void **)(buf + (n * stride) + offset);
+}
+
+/*
+ *  stress_vm_chase()
+ *	sweep working set sizes from 4K up to the buffer size,
+ *	for each size build a random cyclic chain of pointers,
+ *	one per stride bytes, and time a chain of dependent loads
+ */
+static size_t stress_vm_chase(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops,
+	const size_t stride,
+	stress_vm_chase_t *chase)
+{
+	size_t i, size;
+	uint64_t c = *counter;
+
+	for (i = 0, size = VM_CHASE_MIN_SIZE;
+	     (size <= sz) && (i < VM_CHASE_SIZES); i++, size <<= 1) {
+		const size_t n = size / stride;
+		register void **ptr;
+		register uint64_t loads;
+		size_t j;
+		double t;
+
+		if (n < 2)
+			continue;
+
+		/*
+		 *  The second word of each slot holds a random
+		 *  permutation of the slots (Fisher-Yates), the
+		 *  first word is linked to the next slot in the
+		 *  permutation to form one cycle over all slots
+		 */
+		for (j = 0; j < n; j++)
+			stress_vm_chase_slot(buf, j, stride)[1] = (void *)j;
+		for (j = n - 1; j > 0; j--) {
+			void **a = stress_vm_chase_slot(buf, j, stride);
+			void **b = stress_vm_chase_slot(buf, mwc64() % (j + 1), stride);
+			void *tmp = a[1];
+
+			a[1] = b[1];
+			b[1] = tmp;
+		}
+		for (j = 0; j < n; j++) {
+			const size_t from = (size_t)stress_vm_chase_slot(buf, j, stride)[1];
+			const size_t to = (size_t)stress_vm_chase_slot(buf, (j + 1) % n, stride)[1];
+
+			*stress_vm_chase_slot(buf, from, stride) =
+				(void *)stress_vm_chase_slot(buf, to, stride);
+		}
+		if (!opt_do_run)
+			break;
+
+		ptr = stress_vm_chase_slot(buf, 0, stride);
+		t = time_now_monotonic();
+		for (loads = 0; loads < VM_CHASE_LOADS; loads += 16) {
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+			ptr = (void **)*ptr;
+		}
+		t = time_now_monotonic() - t;
+		uint64_put((uint64_t)(uintptr_t)ptr);
+
+		if (chase) {
+			chase[i].duration += t;
+			chase[i].loads += loads;
+		}
+		c += loads;
+		stress_vm_account(loads * sizeof(void *), n * 2 * sizeof(void *));
+		if (!opt_do_run || (max_ops && c >= max_ops))
+			break;
+	}
+	*counter = c;
 
 	return 0;
 }
 
+/*
+ *  stress_vm_ptr_chase()
+ *	pointer chase latency, one pointer per cache line
+ */
+static size_t stress_vm_ptr_chase(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	return stress_vm_chase(buf, sz, counter, max_ops,
+		VM_CACHE_LINE, vm_chase_line);
+}
+
+/*
+ *  stress_vm_ptr_chase_page()
+ *	pointer chase latency, one pointer per page
+ */
+static size_t stress_vm_ptr_chase_page(
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	return stress_vm_chase(buf, sz, counter, max_ops,
+		stress_get_pagesize(), vm_chase_page);
+}
+
+/*
+ *  stress_vm_chase_report()
+ *	report the pointer chase latency curve
+ */
+static void stress_vm_chase_report(
+	const char *name,
+	const char *method,
+	const stress_vm_chase_t *chase)
+{
+	size_t i, size;
+	bool heading = false;
+
+	if (!chase)
+		return;
+
+	for (i = 0, size = VM_CHASE_MIN_SIZE; i < VM_CHASE_SIZES; i++, size <<= 1) {
+		char str[32];
+
+		if (!chase[i].loads)
+			continue;
+		if (!heading) {
+			pr_inf(stderr, "%s: %s latency, working set size vs "
+				"nanoseconds per load:\n", name, method);
+			heading = true;
+		}
+		if (size >= GB)
+			snprintf(str, sizeof(str), "%zuG", (size_t)(size / GB));
+		else if (size >= MB)
+			snprintf(str, sizeof(str), "%zuM", (size_t)(size / MB));
+		else
+			snprintf(str, sizeof(str), "%zuK", (size_t)(size / KB));
+		pr_inf(stderr, "%s: %8s %10.2f ns\n", name, str,
+			(chase[i].duration * 1000000000.0) / (double)chase[i].loads);
+	}
+}
+
 /*
  *  stress_vm_rowhammer()
  *
@@ -1786,6 +2263,8 @@ static size_t stress_vm_rowhammer(
 			"%p and %p\n", errors, addr0, addr1);
 	}
 	(*counter) += VM_ROWHAMMER_LOOPS;
+	stress_vm_account(sz + (VM_ROWHAMMER_LOOPS * 2 * sizeof(uint32_t)),
+		n * sizeof(uint32_t));
 	val = (val >> 31) | (val << 1);
 
 	stress_vm_check("rowhammer", bit_errors);
@@ -1793,6 +2272,33 @@ static size_t stress_vm_rowhammer(
 	return bit_errors;
 }
 
+/*
+ *  stress_vm_exercise()
+ *	run a vm method and account the memory bandwidth
+ *	of the passes that it completed
+ */
+static size_t stress_vm_exercise(
+	const stress_vm_stressor_info_t *info,
+	uint8_t *buf,
+	const size_t sz,
+	uint64_t *counter,
+	const uint64_t max_ops)
+{
+	const uint64_t rd = vm_bytes_read, wr = vm_bytes_written;
+	const double t = time_now_monotonic();
+	size_t bit_errors;
+
+	bit_errors = info->func(buf, sz, counter, max_ops);
+
+	/* "all" is accounted by the methods it calls */
+	if ((info != &vm_methods[0]) &&
+	    ((vm_bytes_read != rd) || (vm_bytes_written != wr)))
+		bandwidth_add(info->name, vm_bytes_read - rd,
+			vm_bytes_written - wr, time_now_monotonic() - t);
+
+	return bit_errors;
+}
+
 /*
  *  stress_vm_all()
  *	work through all vm stressors sequentially
@@ -1806,7 +2312,7 @@ static size_t stress_vm_all(
 	static int i = 1;
 	size_t bit_errors = 0;
 
-	bit_errors = vm_methods[i].func(buf, sz, counter, max_ops);
+	bit_errors = stress_vm_exercise(&vm_methods[i], buf, sz, counter, max_ops);
 	i++;
 	if (vm_methods[i].func == NULL)
 		i = 1;
@@ -1825,7 +2331,13 @@ static const stress_vm_stressor_info_t vm_methods[] = {
 	{ "inc-nybble",	stress_vm_inc_nybble },
 	{ "rand-set",	stress_vm_rand_set },
 	{ "rand-sum",	stress_vm_rand_sum },
+	{ "memset",	stress_vm_memset },
 	{ "read64",	stress_vm_read64 },
+#if defined(HAVE_VECMATH)
+	{ "read128",	stress_vm_read128 },
+	{ "read256",	stress_vm_read256 },
+	{ "read512",	stress_vm_read512 },
+#endif
 	{ "ror",	stress_vm_ror },
 	{ "swap",	stress_vm_swap },
 	{ "move-inv",	stress_vm_moving_inversion },
@@ -1835,11 +2347,19 @@ static const stress_vm_stressor_info_t vm_methods[] = {
 	{ "prime-gray-0",stress_vm_prime_gray_zero },
 	{ "prime-gray-1",stress_vm_prime_gray_one },
 	{ "prime-incdec",stress_vm_prime_incdec },
+	{ "ptr-chase",	stress_vm_ptr_chase },
+	{ "ptr-chase-page",stress_vm_ptr_chase_page },
 	{ "walk-0d",	stress_vm_walking_zero_data },
 	{ "walk-1d",	stress_vm_walking_one_data },
 	{ "walk-0a",	stress_vm_walking_zero_addr },
 	{ "walk-1a",	stress_vm_walking_one_addr },
 	{ "write64",	stress_vm_write64 },
+#if defined(HAVE_VECMATH)
+	{ "write128",	stress_vm_write128 },
+	{ "write256",	stress_vm_write256 },
+	{ "write512",	stress_vm_write512 },
+#endif
+	{ "write-nt",	stress_vm_write_nt },
 	{ "zero-one",	stress_vm_zero_one },
 	{ NULL,		NULL  }
 };
@@ -1869,6 +2389,26 @@ int stress_set_vm_method(const char *name)
 }
 
 
+/*
+ *  stress_vm_release()
+ *	release the backing pages of part of a shared
+ *	anonymous mapping back to the system
+ */
+static int stress_vm_release(uint8_t *addr, const size_t len)
+{
+#if defined(MADV_REMOVE)
+	if (madvise((void *)addr, len, MADV_REMOVE) == 0)
+		return 0;
+#endif
+#if defined(MADV_DONTNEED)
+	return madvise((void *)addr, len, MADV_DONTNEED);
+#else
+	(void)addr;
+	(void)len;
+	return 0;
+#endif
+}
+
 /*
  *  stress_vm()
  *	stress virtual memory
@@ -1881,10 +2421,11 @@ int stress_vm(
 {
 	uint32_t restarts = 0, nomems = 0;
 	uint8_t *buf = NULL;
-	pid_t pid;
+	pid_t pid = -1;
 	const bool keep = (opt_flags & OPT_FLAGS_VM_KEEP);
-	const stress_vm_func func = opt_vm_stressor->func;
         const size_t page_size = stress_get_pagesize();
+	const size_t chase_sz = sizeof(stress_vm_chase_t) * VM_CHASE_SIZES * 2;
+	stress_vm_chase_t *chase;
 	size_t buf_sz;
 
 	if (!set_vm_bytes) {
@@ -1893,11 +2434,21 @@ int stress_vm(
 		if (opt_flags & OPT_FLAGS_MINIMIZE)
 			opt_vm_bytes = MIN_VM_BYTES;
 	}
-	buf_sz = opt_vm_bytes & ~(page_size - 1);
+	buf_sz = stress_hugepage_align(opt_vm_bytes & ~(page_size - 1));
+	if (instance == 0)
+		pr_dbg(stderr, "%s: using %s page backing, %zu bytes per page\n",
+			name, stress_hugepage_name(), stress_hugepage_size());
+
+	chase = (stress_vm_chase_t *)mmap(NULL, chase_sz, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (chase != MAP_FAILED) {
+		vm_chase_line = chase;
+		vm_chase_page = chase + VM_CHASE_SIZES;
+	}
 
 again:
 	if (!opt_do_run)
-		return EXIT_SUCCESS;
+		goto finish;
 	pid = fork();
 	if (pid < 0) {
 		if (errno == EAGAIN)
@@ -1948,8 +2499,8 @@ again:
 			}
 			if (!keep || (buf == NULL)) {
 				if (!opt_do_run)
-					return EXIT_SUCCESS;
-				buf = (uint8_t *)mmap(NULL, buf_sz,
+					break;
+				buf = (uint8_t *)stress_hugepage_mmap(NULL, buf_sz,
 					PROT_READ | PROT_WRITE,
 					MAP_SHARED | MAP_ANONYMOUS |
 					opt_vm_flags, -1, 0);
@@ -1963,8 +2514,30 @@ again:
 			}
 
 			no_mem_retries = 0;
-			(void)mincore_touch_pages(buf, buf_sz);
-			(void)func(buf, buf_sz, counter, max_ops << VM_BOGO_SHIFT);
+			if (shared->target.mem) {
+				size_t sz;
+
+				/*
+				 *  Only use the fraction of the buffer
+				 *  allowed by the --target-mem controller
+				 *  and give the rest back to the system
+				 */
+				sz = (size_t)((double)buf_sz * shared->target.mem_duty);
+				sz &= ~(stress_hugepage_size() - 1);
+				if (sz < buf_sz)
+					(void)stress_vm_release(buf + sz, buf_sz - sz);
+				if (sz) {
+					(void)mincore_touch_pages(buf, sz);
+					(void)stress_vm_exercise(opt_vm_stressor, buf, sz,
+						counter, max_ops << VM_BOGO_SHIFT);
+				} else {
+					(void)shim_usleep(100000);
+				}
+			} else {
+				(void)mincore_touch_pages(buf, buf_sz);
+				(void)stress_vm_exercise(opt_vm_stressor, buf, buf_sz,
+					counter, max_ops << VM_BOGO_SHIFT);
+			}
 
 			if (opt_vm_hang == 0) {
 				for (;;) {
@@ -1985,6 +2558,14 @@ again:
 	}
 	*counter >>= VM_BOGO_SHIFT;
 
+finish:
+	if (pid > 0) {
+		stress_vm_chase_report(name, "ptr-chase", vm_chase_line);
+		stress_vm_chase_report(name, "ptr-chase-page", vm_chase_page);
+	}
+	if (chase != MAP_FAILED)
+		(void)munmap((void *)chase, chase_sz);
+
 	if (restarts + nomems > 0)
 		pr_dbg(stderr, "%s: OOM restarts: %" PRIu32
 			", out of memory restarts: %" PRIu32 ".\n",
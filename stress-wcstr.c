@@ -41,8 +41,13 @@
 #undef HAVE_WCSCASECMP
 #endif
 
-#define STR1LEN 256
-#define STR2LEN 128
+#if defined(__GLIBC__)
+#include <gnu/libc-version.h>
+#endif
+
+#define WCS_POOL	(32)		/* strings timed per bench pass */
+#define WCS_BENCH_CALLS	(256)		/* min libc calls timed per bogo op */
+#define WCS_ALIGN	(64)		/* alignment of each string slot */
 
 /*
  *  the wide string stress test has different classes of stressors
@@ -55,15 +60,69 @@ typedef void (*stress_wcs_func)(
 	wchar_t *str2,
 	const size_t len2);
 
+/* wide strings used to time the libc functions */
+typedef struct {
+	wchar_t	*s1[WCS_POOL];		/* random strings */
+	wchar_t	*s2[WCS_POOL];		/* s1 with a different last char */
+	size_t	len[WCS_POOL];		/* length of each string */
+	wchar_t	*dst;			/* destination buffer */
+	size_t	dst_len;		/* size of the destination buffer */
+	uint64_t chars;			/* total length of all the strings */
+} wcs_pool_t;
+
+typedef void (*stress_wcs_bench_func)(
+	const void *libc_func,
+	wcs_pool_t *pool);
+
 typedef struct {
 	const char		*name;	/* human readable form of stressor */
 	const stress_wcs_func	func;	/* the stressor function */
 	const void		*libc_func;
+	const stress_wcs_bench_func bench; /* times one libc call per pool string */
 } stress_wcs_stressor_info_t;
 
+/* libc call timings of a method */
+typedef struct {
+	uint64_t calls;			/* libc calls timed */
+	uint64_t chars;			/* characters processed */
+	double duration;		/* time taken */
+} wcs_stats_t;
+
 static const stress_wcs_stressor_info_t *opt_wcs_stressor;
 static const stress_wcs_stressor_info_t wcs_methods[];
 
+static size_t opt_wcs_len = DEFAULT_STR_LEN;
+static int opt_wcs_len_dist = STRESS_LEN_DIST_FIXED;
+static size_t opt_wcs_align = DEFAULT_WCS_ALIGN;
+
+void stress_set_wcs_len(const char *optarg)
+{
+	uint64_t len;
+
+	len = get_uint64_byte(optarg);
+	check_range("wcs-len", len, MIN_STR_LEN, MAX_STR_LEN);
+	opt_wcs_len = (size_t)len;
+}
+
+int stress_set_wcs_len_dist(const char *name)
+{
+	const int dist = stress_set_len_dist("wcs-len-dist", name);
+
+	if (dist < 0)
+		return -1;
+	opt_wcs_len_dist = dist;
+	return 0;
+}
+
+void stress_set_wcs_align(const char *optarg)
+{
+	uint64_t align;
+
+	align = get_uint64(optarg);
+	check_range("wcs-align", align, MIN_WCS_ALIGN, MAX_WCS_ALIGN);
+	opt_wcs_align = (size_t)align;
+}
+
 /*
  *  stress_wcs_fill
  */
@@ -511,6 +570,135 @@ static void stress_wcsxfrm(
 }
 
 
+/*
+ *  stress_wcs_bench_chr()
+ *	time wcschr style searches for a char not in the string
+ */
+static void stress_wcs_bench_chr(const void *libc_func, wcs_pool_t *pool)
+{
+	wchar_t *(*__wcschr)(const wchar_t *s, wchar_t c) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++)
+		(void)__wcschr(pool->s1[i], L'Z');
+}
+
+/*
+ *  stress_wcs_bench_cmp()
+ *	time wcscmp style compares that differ at the last char
+ */
+static void stress_wcs_bench_cmp(const void *libc_func, wcs_pool_t *pool)
+{
+	int (*__wcscmp)(const wchar_t *s1, const wchar_t *s2) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++)
+		(void)__wcscmp(pool->s1[i], pool->s2[i]);
+}
+
+/*
+ *  stress_wcs_bench_ncmp()
+ *	time wcsncmp style compares that differ at the last char
+ */
+static void stress_wcs_bench_ncmp(const void *libc_func, wcs_pool_t *pool)
+{
+	int (*__wcsncmp)(const wchar_t *s1, const wchar_t *s2, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++)
+		(void)__wcsncmp(pool->s1[i], pool->s2[i], pool->len[i] + 1);
+}
+
+/*
+ *  stress_wcs_bench_len()
+ *	time wcslen
+ */
+static void stress_wcs_bench_len(const void *libc_func, wcs_pool_t *pool)
+{
+	size_t (*__wcslen)(const wchar_t *s) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++)
+		(void)__wcslen(pool->s1[i]);
+}
+
+#if !defined(HAVE_WCSLCPY)
+/*
+ *  stress_wcs_bench_cpy()
+ *	time wcscpy
+ */
+static void stress_wcs_bench_cpy(const void *libc_func, wcs_pool_t *pool)
+{
+	wchar_t *(*__wcscpy)(wchar_t *dest, const wchar_t *src) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++)
+		(void)__wcscpy(pool->dst, pool->s1[i]);
+}
+#endif
+
+#if !defined(HAVE_WCSLCAT)
+/*
+ *  stress_wcs_bench_cat()
+ *	time wcscat onto an empty string
+ */
+static void stress_wcs_bench_cat(const void *libc_func, wcs_pool_t *pool)
+{
+	wchar_t *(*__wcscat)(wchar_t *dest, const wchar_t *src) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++) {
+		*pool->dst = L'\0';
+		(void)__wcscat(pool->dst, pool->s1[i]);
+	}
+}
+#endif
+
+/*
+ *  stress_wcs_bench_ncat()
+ *	time wcsncat onto an empty string
+ */
+static void stress_wcs_bench_ncat(const void *libc_func, wcs_pool_t *pool)
+{
+	wchar_t *(*__wcsncat)(wchar_t *dest, const wchar_t *src, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++) {
+		*pool->dst = L'\0';
+		(void)__wcsncat(pool->dst, pool->s1[i], pool->len[i]);
+	}
+}
+
+/*
+ *  stress_wcs_bench_lcpy()
+ *	time wcslcpy and wcsxfrm style copies
+ */
+static void stress_wcs_bench_lcpy(const void *libc_func, wcs_pool_t *pool)
+{
+	size_t (*__wcslcpy)(wchar_t *dest, const wchar_t *src, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++)
+		(void)__wcslcpy(pool->dst, pool->s1[i], pool->dst_len);
+}
+
+#if defined(HAVE_WCSLCAT)
+/*
+ *  stress_wcs_bench_lcat()
+ *	time wcslcat onto an empty string
+ */
+static void stress_wcs_bench_lcat(const void *libc_func, wcs_pool_t *pool)
+{
+	size_t (*__wcslcat)(wchar_t *dest, const wchar_t *src, size_t n) = libc_func;
+	register size_t i;
+
+	for (i = 0; i < WCS_POOL; i++) {
+		*pool->dst = L'\0';
+		(void)__wcslcat(pool->dst, pool->s1[i], pool->dst_len);
+	}
+}
+#endif
+
 /*
  *  stress_wcs_all()
  *	iterate over all wcs stressors
@@ -537,33 +725,33 @@ static void stress_wcs_all(
  * Table of wcs stress methods
  */
 static const stress_wcs_stressor_info_t wcs_methods[] = {
-	{ "all",		stress_wcs_all,		NULL },	/* Special "all" test */
+	{ "all",		stress_wcs_all,		NULL,		NULL },	/* Special "all" test */
 
 #if defined(WCSCASECMP)
-	{ "wcscasecmp",		stress_wcscasecmp,	wcscasecmp },
+	{ "wcscasecmp",		stress_wcscasecmp,	wcscasecmp,	stress_wcs_bench_cmp },
 #endif
 #if defined(HAVE_WCSLCAT)
-	{ "wcslcat",		stress_wcslcat,		wcslcat },
+	{ "wcslcat",		stress_wcslcat,		wcslcat,	stress_wcs_bench_lcat },
 #else
-	{ "wcscat",		stress_wcscat,		wcscat },
+	{ "wcscat",		stress_wcscat,		wcscat,		stress_wcs_bench_cat },
 #endif
-	{ "wcschr",		stress_wcschr,		wcschr },
-	{ "wcscmp",		stress_wcscmp,		wcscmp },
+	{ "wcschr",		stress_wcschr,		wcschr,		stress_wcs_bench_chr },
+	{ "wcscmp",		stress_wcscmp,		wcscmp,		stress_wcs_bench_cmp },
 #if defined(HAVE_WCSLCPY)
-	{ "wcslcpy",		stress_wcslcpy,		wcslcpy },
+	{ "wcslcpy",		stress_wcslcpy,		wcslcpy,	stress_wcs_bench_lcpy },
 #else
-	{ "wcscpy",		stress_wcscpy,		wcscpy },
+	{ "wcscpy",		stress_wcscpy,		wcscpy,		stress_wcs_bench_cpy },
 #endif
-	{ "wcslen",		stress_wcslen,		wcslen },
+	{ "wcslen",		stress_wcslen,		wcslen,		stress_wcs_bench_len },
 #if defined(HAVE_WCSNCASECMP)
-	{ "wcsncasecmp",	stress_wcsncasecmp,	wcsncasecmp },
+	{ "wcsncasecmp",	stress_wcsncasecmp,	wcsncasecmp,	stress_wcs_bench_ncmp },
 #endif
-	{ "wcsncat",		stress_wcsncat,		wcsncat },
-	{ "wcsncmp",		stress_wcsncmp,		wcsncmp },
-	{ "wcsrchr",		stress_wcsrchr,		wcschr },
-	{ "wcscoll",		stress_wcscoll,		wcscoll },
-	{ "wcsxfrm",		stress_wcsxfrm,		wcsxfrm },
-	{ NULL,			NULL,			NULL }
+	{ "wcsncat",		stress_wcsncat,		wcsncat,	stress_wcs_bench_ncat },
+	{ "wcsncmp",		stress_wcsncmp,		wcsncmp,	stress_wcs_bench_ncmp },
+	{ "wcsrchr",		stress_wcsrchr,		wcschr,		stress_wcs_bench_chr },
+	{ "wcscoll",		stress_wcscoll,		wcscoll,	stress_wcs_bench_cmp },
+	{ "wcsxfrm",		stress_wcsxfrm,		wcsxfrm,	stress_wcs_bench_lcpy },
+	{ NULL,			NULL,			NULL,		NULL }
 };
 
 /*
@@ -591,6 +779,84 @@ int stress_set_wcs_method(const char *name)
 	return -1;
 }
 
+/*
+ *  stress_wcs_pool_fill()
+ *	fill the pool with random wide strings with lengths
+ *	drawn from the length distribution
+ */
+static void stress_wcs_pool_fill(wcs_pool_t *pool)
+{
+	size_t i;
+
+	pool->chars = 0;
+	for (i = 0; i < WCS_POOL; i++) {
+		const size_t len = stress_len_dist(opt_wcs_len_dist,
+			opt_wcs_len, 1, pool->dst_len - 1);
+
+		stress_wcs_fill(pool->s1[i], len + 1);
+		(void)memcpy(pool->s2[i], pool->s1[i], (len + 1) * sizeof(wchar_t));
+		pool->s2[i][len - 1] = L'Z';
+		pool->len[i] = len;
+		pool->chars += len;
+	}
+}
+
+/*
+ *  stress_wcs_bench()
+ *	time at least WCS_BENCH_CALLS calls of a method's libc
+ *	function over the wide string pool
+ */
+static void stress_wcs_bench(
+	const stress_wcs_stressor_info_t *info,
+	wcs_pool_t *pool,
+	wcs_stats_t *stats)
+{
+	uint64_t calls = 0;
+	double t;
+
+	t = time_now();
+	do {
+		info->bench(info->libc_func, pool);
+		calls += WCS_POOL;
+	} while (calls < WCS_BENCH_CALLS);
+	stats->duration += time_now() - t;
+	stats->calls += calls;
+	stats->chars += (calls / WCS_POOL) * pool->chars;
+}
+
+/*
+ *  stress_wcs_report()
+ *	report the ns per call and per wide char of each method
+ */
+static void stress_wcs_report(const char *name, const wcs_stats_t *stats)
+{
+	static const char *dists[] = { "fixed", "uniform", "lognormal" };
+	size_t i;
+
+#if defined(__GLIBC__)
+	pr_inf(stderr, "%s: glibc %s, %s lengths with mean %zd, "
+		"alignment %zd wide chars\n", name, gnu_get_libc_version(),
+		dists[opt_wcs_len_dist], opt_wcs_len, opt_wcs_align);
+#else
+	pr_inf(stderr, "%s: %s lengths with mean %zd, alignment %zd "
+		"wide chars\n", name, dists[opt_wcs_len_dist],
+		opt_wcs_len, opt_wcs_align);
+#endif
+	pr_inf(stderr, "%s: %-12s %10s %10s %12s\n", name,
+		"function", "ns/call", "ns/char", "calls");
+	for (i = 1; wcs_methods[i].func; i++) {
+		const wcs_stats_t *st = &stats[i];
+
+		if (!st->calls || !st->chars)
+			continue;
+		pr_inf(stderr, "%s: %-12s %10.2f %10.4f %12" PRIu64 "\n",
+			name, wcs_methods[i].name,
+			(st->duration * 1000000000.0) / st->calls,
+			(st->duration * 1000000000.0) / st->chars,
+			st->calls);
+	}
+}
+
 /*
  *  stress_wcs()
  *	stress CPU by doing wide character string ops
@@ -601,19 +867,59 @@ int stress_wcs(
 	const uint64_t max_ops,
 	const char *name)
 {
-	stress_wcs_func func = opt_wcs_stressor->func;
-	const void *libc_func = opt_wcs_stressor->libc_func;
-
-	(void)instance;
+	/* "all" is handled here so each call can be timed per method */
+	const bool all = (opt_wcs_stressor == &wcs_methods[0]);
+	const stress_wcs_stressor_info_t *info = all ? &wcs_methods[1] : opt_wcs_stressor;
+	/* the longest length any distribution can draw, plus the NUL */
+	const size_t max_len = (opt_wcs_len_dist == STRESS_LEN_DIST_FIXED) ?
+		opt_wcs_len + 1 : (8 * opt_wcs_len) + 1;
+	const size_t offset = opt_wcs_align * sizeof(wchar_t);
+	const size_t slot = (offset + (max_len * sizeof(wchar_t)) + WCS_ALIGN - 1) &
+		~(WCS_ALIGN - 1);
+	wcs_stats_t stats[SIZEOF_ARRAY(wcs_methods)];
+	wcs_pool_t pool;
+	uint8_t *buf;
+	wchar_t *str1, *str2;
+	size_t i;
+
+	if (posix_memalign((void **)&buf, WCS_ALIGN, slot * ((2 * WCS_POOL) + 3))) {
+		pr_err(stderr, "%s: cannot allocate string buffers\n", name);
+		return EXIT_NO_RESOURCE;
+	}
+	str1 = (wchar_t *)(buf + offset);
+	str2 = (wchar_t *)(buf + slot + offset);
+	for (i = 0; i < WCS_POOL; i++) {
+		pool.s1[i] = (wchar_t *)(buf + ((2 + i) * slot) + offset);
+		pool.s2[i] = (wchar_t *)(buf + ((2 + WCS_POOL + i) * slot) + offset);
+	}
+	pool.dst = (wchar_t *)(buf + ((2 + (2 * WCS_POOL)) * slot) + offset);
+	pool.dst_len = max_len;
+	memset(stats, 0, sizeof(stats));
 
 	do {
-		wchar_t str1[STR1LEN], str2[STR2LEN];
+		const size_t len1 = stress_len_dist(opt_wcs_len_dist,
+			opt_wcs_len, MIN_STR_LEN, max_len - 1) + 1;
+		const size_t len2 = (len1 / 2) + 1;
+
+		stress_wcs_fill(str1, len1);
+		stress_wcs_fill(str2, len2);
+
+		(void)info->func(info->libc_func, name, str1, len1, str2, len2);
 
-		stress_wcs_fill(str1, STR1LEN);
-		stress_wcs_fill(str2, STR2LEN);
+		stress_wcs_pool_fill(&pool);
+		stress_wcs_bench(info, &pool, &stats[info - wcs_methods]);
 
-		(void)func(libc_func, name, str1, STR1LEN, str2, STR2LEN);
+		if (all) {
+			info++;
+			if (!info->func)
+				info = &wcs_methods[1];
+		}
 		(*counter)++;
 	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+	if (instance == 0)
+		stress_wcs_report(name, stats);
+
+	free(buf);
 	return EXIT_SUCCESS;
 }
@@ -24,11 +24,156 @@
  */
 #include "stress-ng.h"
 
+#define ZLIB_STRATEGY_DEFAULT	(0)
+#define ZLIB_STRATEGY_FILTERED	(1)
+#define ZLIB_STRATEGY_HUFFMAN	(2)
+#define ZLIB_STRATEGY_RLE	(3)
+#define ZLIB_STRATEGY_FIXED	(4)
+
+typedef struct {
+	const char *name;		/* strategy name */
+	const int strategy;		/* ZLIB_STRATEGY_* */
+} zlib_strategy_info_t;
+
+static const zlib_strategy_info_t zlib_strategies[] = {
+	{ "default",	ZLIB_STRATEGY_DEFAULT },
+	{ "filtered",	ZLIB_STRATEGY_FILTERED },
+	{ "huffman",	ZLIB_STRATEGY_HUFFMAN },
+	{ "rle",	ZLIB_STRATEGY_RLE },
+	{ "fixed",	ZLIB_STRATEGY_FIXED },
+	{ NULL,		0 }
+};
+
+static int opt_zlib_level = DEFAULT_ZLIB_LEVEL;
+static int opt_zlib_strategy = ZLIB_STRATEGY_DEFAULT;
+static int opt_zlib_window_bits = DEFAULT_ZLIB_WINDOW_BITS;
+static int opt_zlib_mem_level = DEFAULT_ZLIB_MEM_LEVEL;
+static uint32_t opt_zlib_threads = DEFAULT_ZLIB_THREADS;
+static uint64_t opt_zlib_chunk_size = DEFAULT_ZLIB_CHUNK_SIZE;
+static stress_corpus_t zlib_corpus;
+
+/*
+ *  stress_set_zlib_level()
+ *	set the deflate compression level
+ */
+void stress_set_zlib_level(const char *optarg)
+{
+	uint32_t zlib_level;
+
+	zlib_level = get_uint32(optarg);
+	check_range("zlib-level", zlib_level,
+		MIN_ZLIB_LEVEL, MAX_ZLIB_LEVEL);
+	opt_zlib_level = (int)zlib_level;
+}
+
+/*
+ *  stress_set_zlib_strategy()
+ *	set the deflate compression strategy
+ */
+int stress_set_zlib_strategy(const char *name)
+{
+	const zlib_strategy_info_t *info;
+
+	for (info = zlib_strategies; info->name; info++) {
+		if (!strcmp(info->name, name)) {
+			opt_zlib_strategy = info->strategy;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "zlib-strategy must be one of:");
+	for (info = zlib_strategies; info->name; info++)
+		fprintf(stderr, " %s", info->name);
+	fprintf(stderr, "\n");
+
+	return -1;
+}
+
+/*
+ *  stress_set_zlib_window_bits()
+ *	set the base two logarithm of the history window size
+ */
+void stress_set_zlib_window_bits(const char *optarg)
+{
+	uint32_t zlib_window_bits;
+
+	zlib_window_bits = get_uint32(optarg);
+	check_range("zlib-window-bits", zlib_window_bits,
+		MIN_ZLIB_WINDOW_BITS, MAX_ZLIB_WINDOW_BITS);
+	opt_zlib_window_bits = (int)zlib_window_bits;
+}
+
+/*
+ *  stress_set_zlib_mem_level()
+ *	set the deflate internal state memory level
+ */
+void stress_set_zlib_mem_level(const char *optarg)
+{
+	uint32_t zlib_mem_level;
+
+	zlib_mem_level = get_uint32(optarg);
+	check_range("zlib-mem-level", zlib_mem_level,
+		MIN_ZLIB_MEM_LEVEL, MAX_ZLIB_MEM_LEVEL);
+	opt_zlib_mem_level = (int)zlib_mem_level;
+}
+
+/*
+ *  stress_set_zlib_threads()
+ *	set the number of threads compressing chunks,
+ *	0 uses the deflate to inflate pipe
+ */
+void stress_set_zlib_threads(const char *optarg)
+{
+	opt_zlib_threads = get_uint32(optarg);
+	check_range("zlib-threads", opt_zlib_threads,
+		MIN_ZLIB_THREADS, MAX_ZLIB_THREADS);
+}
+
+/*
+ *  stress_set_zlib_chunk_size()
+ *	set the size of each chunk compressed by a thread
+ */
+void stress_set_zlib_chunk_size(const char *optarg)
+{
+	opt_zlib_chunk_size = get_uint64_byte(optarg);
+	check_range("zlib-chunk-size", opt_zlib_chunk_size,
+		MIN_ZLIB_CHUNK_SIZE, MAX_ZLIB_CHUNK_SIZE);
+}
+
+/*
+ *  stress_set_zlib_corpus()
+ *	compress the contents of a file rather than random data
+ */
+int stress_set_zlib_corpus(const char *filename)
+{
+	stress_corpus_close(&zlib_corpus);
+	return stress_corpus_open("zlib-corpus", filename, &zlib_corpus);
+}
+
 #if defined(HAVE_LIB_Z)
 
 #include "zlib.h"
 
 #define DATA_SIZE 	(65536)		/* Must be a multiple of 8 bytes */
+#define ZLIB_CHUNKS	(16)		/* minimum chunks per round */
+#define ZLIB_CHUNKS_PER_THREAD (4)	/* chunks per thread per round */
+
+/* ZLIB_STRATEGY_* to zlib strategies */
+static const int zlib_strategy_map[] = {
+	Z_DEFAULT_STRATEGY,
+	Z_FILTERED,
+	Z_HUFFMAN_ONLY,
+	Z_RLE,
+	Z_FIXED
+};
+
+/* deflate and inflate totals */
+typedef struct {
+	uint64_t deflate_bytes;		/* uncompressed bytes deflated */
+	double deflate_duration;	/* time spent deflating */
+	uint64_t inflate_bytes;		/* uncompressed bytes inflated */
+	double inflate_duration;	/* time spent inflating */
+} zlib_stats_t;
 
 typedef void (*stress_rand_data_func)(uint32_t *data, const int size);
 
@@ -216,13 +361,40 @@ static const char *stress_zlib_err(const int zlib_err)
 	}
 }
 
+/*
+ *  stress_zlib_rate()
+ *	bytes over a duration in MB per second
+ */
+static double stress_zlib_rate(const uint64_t bytes, const double duration)
+{
+	return (duration > 0.0) ? (double)bytes / (duration * (double)MB) : 0.0;
+}
+
+/*
+ *  stress_zlib_deflate_init()
+ *	initialise a deflate stream with the level, strategy,
+ *	window size and memory level options, negative window
+ *	bits select a raw deflate stream
+ */
+static int stress_zlib_deflate_init(z_stream *stream, const int window_bits)
+{
+	stream->zalloc = Z_NULL;
+	stream->zfree = Z_NULL;
+	stream->opaque = Z_NULL;
+
+	return deflateInit2(stream, opt_zlib_level, Z_DEFLATED, window_bits,
+		opt_zlib_mem_level, zlib_strategy_map[opt_zlib_strategy]);
+}
 
 /*
  *  stress_zlib_inflate()
  *	inflate compressed data out of the read
  *	end of a pipe fd
  */
-static int stress_zlib_inflate(const char *name, const int fd)
+static int stress_zlib_inflate(
+	const char *name,
+	const int fd,
+	zlib_stats_t *stats)
 {
 	int ret;
 	z_stream stream_inf;
@@ -231,7 +403,7 @@ static int stress_zlib_inflate(const char *name, const int fd)
 	stream_inf.zfree = Z_NULL;
 	stream_inf.opaque = Z_NULL;
 
-	ret = inflateInit(&stream_inf);
+	ret = inflateInit2(&stream_inf, opt_zlib_window_bits);
 	if (ret != Z_OK) {
 		pr_fail(stderr, "%s: zlib inflateInit error: %s\n",
 			name, stress_zlib_err(ret));
@@ -250,11 +422,15 @@ static int stress_zlib_inflate(const char *name, const int fd)
 
 		do {
 			unsigned char out[DATA_SIZE];
+			double t;
 
 			stream_inf.avail_out = DATA_SIZE;
 			stream_inf.next_out = out;
 
+			t = time_now();
 			ret = inflate(&stream_inf, Z_NO_FLUSH);
+			stats->inflate_duration += time_now() - t;
+			stats->inflate_bytes += DATA_SIZE - stream_inf.avail_out;
 		} while ((ret == Z_OK) && (stream_inf.avail_out == 0));
 	}
 	(void)inflateEnd(&stream_inf);
@@ -273,18 +449,15 @@ static int stress_zlib_deflate(
 	const int fd,
 	const uint32_t instance,
 	const uint64_t max_ops,
-	uint64_t *counter)
+	uint64_t *counter,
+	zlib_stats_t *stats)
 {
 	int ret;
 	bool do_run;
 	z_stream stream_def;
 	uint64_t bytes_in = 0, bytes_out = 0;
 
-	stream_def.zalloc = Z_NULL;
-	stream_def.zfree = Z_NULL;
-	stream_def.opaque = Z_NULL;
-
-	ret = deflateInit(&stream_def, Z_BEST_COMPRESSION);
+	ret = stress_zlib_deflate_init(&stream_def, opt_zlib_window_bits);
 	if (ret != Z_OK) {
 		pr_fail(stderr, "%s: zlib deflateInit error: %s\n",
 			name, stress_zlib_err(ret));
@@ -294,22 +467,34 @@ static int stress_zlib_deflate(
 	do {
 		uint32_t in[DATA_SIZE / sizeof(uint32_t)];
 
-		rand_data_funcs[mwc32() % SIZEOF_ARRAY(rand_data_funcs)](in, DATA_SIZE);
-		stream_def.avail_in = DATA_SIZE;
-		stream_def.next_in = (unsigned char *)in;
+		if (zlib_corpus.data) {
+			size_t len;
+
+			/* deflate straight out of the mapped corpus */
+			stream_def.next_in = (unsigned char *)
+				stress_corpus_next(&zlib_corpus, DATA_SIZE, &len);
+			stream_def.avail_in = len;
+		} else {
+			rand_data_funcs[mwc32() % SIZEOF_ARRAY(rand_data_funcs)](in, DATA_SIZE);
+			stream_def.avail_in = DATA_SIZE;
+			stream_def.next_in = (unsigned char *)in;
+		}
 
 		do_run = opt_do_run && (!max_ops || *counter < max_ops);
 
-		bytes_in += DATA_SIZE;
+		bytes_in += stream_def.avail_in;
 
 		do {
 			unsigned char out[DATA_SIZE];
 			int def_size, rc;
 			int flush = do_run ? Z_NO_FLUSH : Z_FINISH;
+			double t;
 
 			stream_def.avail_out = DATA_SIZE;
 			stream_def.next_out = out;
+			t = time_now();
 			rc = deflate(&stream_def, flush);
+			stats->deflate_duration += time_now() - t;
 
 			if ((rc != Z_OK) && (rc != Z_STREAM_END)) {
 				pr_fail(stderr, "%s: zlib deflate error: %s\n",
@@ -332,6 +517,7 @@ static int stress_zlib_deflate(
 			(*counter)++;
 		} while (do_run && stream_def.avail_out == 0);
 	} while (do_run);
+	stats->deflate_bytes = bytes_in - stream_def.avail_in;
 
 	pr_inf(stderr, "%s: instance %" PRIu32 ": compression ratio: %5.2f%%\n",
 		name, instance, 100.0 * (double)bytes_out / (double)bytes_in);
@@ -341,14 +527,16 @@ static int stress_zlib_deflate(
 }
 
 /*
- *  stress_zlib()
- *	stress cpu with compression and decompression
+ *  stress_zlib_pipe()
+ *	deflate in this process and inflate in a child
+ *	process, the compressed data goes down a pipe
  */
-int stress_zlib(
+static int stress_zlib_pipe(
 	uint64_t *const counter,
 	const uint32_t instance,
 	const uint64_t max_ops,
-	const char *name)
+	const char *name,
+	zlib_stats_t *stats)
 {
 	int ret, fds[2], status;
 	pid_t pid;
@@ -371,17 +559,393 @@ int stress_zlib(
 		stress_parent_died_alarm();
 
 		(void)close(fds[1]);
-		ret = stress_zlib_inflate(name, fds[0]);
+		ret = stress_zlib_inflate(name, fds[0], stats);
 		(void)close(fds[0]);
 
 		exit(ret);
 	} else {
 		(void)close(fds[0]);
-		ret = stress_zlib_deflate(name, fds[1], instance, max_ops, counter);
+		ret = stress_zlib_deflate(name, fds[1], instance, max_ops,
+			counter, stats);
 		(void)close(fds[1]);
 	}
-	(void)kill(pid, SIGKILL);
-	(void)waitpid(pid, &status, 0);
+	/*
+	 *  Closing the pipe ends the inflater once it has drained
+	 *  the pipe, so wait for it to fill in the inflate stats
+	 */
+	if (waitpid(pid, &status, 0) < 0) {
+		(void)kill(pid, SIGKILL);
+		(void)waitpid(pid, &status, 0);
+	}
+
+	return ret;
+}
+
+#if defined(HAVE_LIB_PTHREAD)
+
+/* one round of chunked compression */
+typedef struct {
+	const char *name;		/* stressor name */
+	const uint8_t *in;		/* data to compress */
+	size_t size;			/* bytes to compress */
+	size_t chunk_size;		/* bytes per chunk */
+	size_t chunks;			/* number of chunks */
+	size_t chunk_bound;		/* compressed chunk slot size */
+	uint8_t *out;			/* compressed chunk slots */
+	size_t *out_size;		/* compressed size of each chunk */
+	size_t next;			/* next chunk to compress */
+	pthread_mutex_t lock;		/* protects next */
+	pthread_barrier_t barrier;	/* start and end of each round */
+	pthread_mutex_t start;		/* held until all threads are created */
+	volatile bool run;		/* false to end the rounds */
+	volatile bool failed;		/* a chunk failed to compress */
+	sigset_t set;			/* signals blocked by the threads */
+} zlib_chunks_t;
+
+/*
+ *  stress_zlib_chunk_deflate()
+ *	compress chunk i to a raw deflate block sequence, as pigz
+ *	the window before the chunk is used as a dictionary and all
+ *	but the last chunk end with a sync flush so the compressed
+ *	chunks concatenate to one raw deflate stream
+ */
+static int stress_zlib_chunk_deflate(
+	zlib_chunks_t *zc,
+	z_stream *stream,
+	const size_t i)
+{
+	const size_t offset = i * zc->chunk_size;
+	const size_t window = (size_t)1 << opt_zlib_window_bits;
+	const size_t dict = STRESS_MINIMUM(offset, window);
+	const bool last = (i == zc->chunks - 1);
+	int rc;
+
+	if ((rc = deflateReset(stream)) != Z_OK)
+		return rc;
+	if (dict) {
+		rc = deflateSetDictionary(stream, zc->in + offset - dict, dict);
+		if (rc != Z_OK)
+			return rc;
+	}
+	stream->next_in = (unsigned char *)zc->in + offset;
+	stream->avail_in = STRESS_MINIMUM(zc->chunk_size, zc->size - offset);
+	stream->next_out = zc->out + (i * zc->chunk_bound);
+	stream->avail_out = zc->chunk_bound;
+
+	rc = deflate(stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+	if ((rc != Z_OK) && (rc != Z_STREAM_END))
+		return rc;
+	/* a full output slot may leave flushed output pending */
+	if (stream->avail_in || !stream->avail_out)
+		return Z_BUF_ERROR;
+	zc->out_size[i] = zc->chunk_bound - stream->avail_out;
+
+	return Z_OK;
+}
+
+/*
+ *  stress_zlib_chunk_worker()
+ *	each round, compress chunks until there are none left;
+ *	the thread and its deflate state live for all the rounds
+ *	so neither is set up inside the timed part of a round
+ */
+static void *stress_zlib_chunk_worker(void *arg)
+{
+	static void *nowt = NULL;
+	zlib_chunks_t *zc = (zlib_chunks_t *)arg;
+	z_stream stream;
+	bool ok;
+	int rc;
+
+	(void)sigprocmask(SIG_BLOCK, &zc->set, NULL);
+
+	/* Wait until all the threads and the barrier are set up */
+	(void)pthread_mutex_lock(&zc->start);
+	(void)pthread_mutex_unlock(&zc->start);
+	if (!zc->run)
+		return &nowt;
+
+	rc = stress_zlib_deflate_init(&stream, -opt_zlib_window_bits);
+	ok = (rc == Z_OK);
+	if (!ok) {
+		pr_fail(stderr, "%s: zlib deflateInit error: %s\n",
+			zc->name, stress_zlib_err(rc));
+		zc->failed = true;
+	}
+
+	for (;;) {
+		(void)pthread_barrier_wait(&zc->barrier);
+		if (!zc->run)
+			break;
+
+		while (ok && !zc->failed && opt_do_run) {
+			size_t i;
+
+			(void)pthread_mutex_lock(&zc->lock);
+			i = zc->next++;
+			(void)pthread_mutex_unlock(&zc->lock);
+			if (i >= zc->chunks)
+				break;
+
+			rc = stress_zlib_chunk_deflate(zc, &stream, i);
+			if (rc != Z_OK) {
+				pr_fail(stderr, "%s: zlib deflate error: %s\n",
+					zc->name, stress_zlib_err(rc));
+				zc->failed = true;
+			}
+		}
+		(void)pthread_barrier_wait(&zc->barrier);
+	}
+	if (ok)
+		(void)deflateEnd(&stream);
+
+	return &nowt;
+}
+
+/*
+ *  stress_zlib_chunk_inflate()
+ *	inflate the concatenated chunks as one stream, like
+ *	a single threaded decompressor would
+ */
+static int stress_zlib_chunk_inflate(
+	zlib_chunks_t *zc,
+	uint8_t *out)
+{
+	z_stream stream;
+	size_t i;
+	int rc;
+
+	stream.zalloc = Z_NULL;
+	stream.zfree = Z_NULL;
+	stream.opaque = Z_NULL;
+	stream.next_in = Z_NULL;
+	stream.avail_in = 0;
+
+	rc = inflateInit2(&stream, -opt_zlib_window_bits);
+	if (rc != Z_OK)
+		return rc;
+
+	stream.next_out = out;
+	stream.avail_out = zc->size;
+	for (rc = Z_OK, i = 0; (rc == Z_OK) && (i < zc->chunks); i++) {
+		stream.next_in = zc->out + (i * zc->chunk_bound);
+		stream.avail_in = zc->out_size[i];
+		rc = inflate(&stream, Z_NO_FLUSH);
+	}
+	(void)inflateEnd(&stream);
+
+	if (rc != Z_STREAM_END)
+		return (rc == Z_OK) ? Z_DATA_ERROR : rc;
+	return (stream.avail_out == 0) ? Z_OK : Z_DATA_ERROR;
+}
+
+/*
+ *  stress_zlib_chunks()
+ *	compress a large buffer in chunks with a pool of threads,
+ *	in the style of pigz, then inflate it in one stream
+ */
+static int stress_zlib_chunks(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name,
+	zlib_stats_t *stats)
+{
+	const uint32_t threads = opt_zlib_threads;
+	zlib_chunks_t zc;
+	pthread_t *pthreads;
+	uint8_t *in = NULL, *out;
+	uint64_t bytes_out = 0, bytes_in = 0, chunks = 0, rounds = 0;
+	uint32_t started;
+	size_t i, max_chunks, max_size;
+	int ret = EXIT_NO_RESOURCE, rc;
+
+	memset(&zc, 0, sizeof(zc));
+	zc.name = name;
+	/* the random data fillers work in multiples of 8 bytes */
+	zc.chunk_size = (size_t)opt_zlib_chunk_size & ~(size_t)7;
+	max_chunks = STRESS_MAXIMUM(ZLIB_CHUNKS,
+		(size_t)threads * ZLIB_CHUNKS_PER_THREAD);
+	max_size = zc.chunk_size * max_chunks;
+	/*
+	 *  The bound depends on the memory level, add room for the
+	 *  dictionary free raw stream's sync flush marker and end
+	 */
+	{
+		z_stream stream;
+
+		if (stress_zlib_deflate_init(&stream, -opt_zlib_window_bits) != Z_OK) {
+			pr_err(stderr, "%s: zlib deflateInit failed\n", name);
+			return EXIT_FAILURE;
+		}
+		zc.chunk_bound = (size_t)deflateBound(&stream, zc.chunk_size) + 64;
+		(void)deflateEnd(&stream);
+	}
+
+	pthreads = calloc(threads, sizeof(*pthreads));
+	/* a corpus is compressed in place in its mapping */
+	if (!zlib_corpus.data)
+		in = malloc(max_size);
+	out = malloc(max_size);
+	zc.out = malloc(max_chunks * zc.chunk_bound);
+	zc.out_size = calloc(max_chunks, sizeof(*zc.out_size));
+	if (!pthreads || (!in && !zlib_corpus.data) || !out ||
+	    !zc.out || !zc.out_size) {
+		pr_err(stderr, "%s: cannot allocate %zu byte buffers\n",
+			name, max_size);
+		goto tidy;
+	}
+	(void)pthread_mutex_init(&zc.lock, NULL);
+	(void)sigfillset(&zc.set);
+	(void)pthread_mutex_init(&zc.start, NULL);
+	(void)pthread_mutex_lock(&zc.start);
+	zc.run = true;
+
+	for (started = 0; started < threads; started++) {
+		rc = pthread_create(&pthreads[started], NULL,
+			stress_zlib_chunk_worker, &zc);
+		if (rc) {
+			pr_fail_errno(name, "pthread_create", rc);
+			zc.run = false;
+			break;
+		}
+	}
+	if (zc.run) {
+		rc = pthread_barrier_init(&zc.barrier, NULL, started + 1);
+		if (rc) {
+			pr_fail_errno(name, "pthread_barrier_init", rc);
+			zc.run = false;
+		}
+	}
+	(void)pthread_mutex_unlock(&zc.start);
+	if (!zc.run) {
+		for (i = 0; i < started; i++)
+			(void)pthread_join(pthreads[i], NULL);
+		(void)pthread_mutex_destroy(&zc.start);
+		(void)pthread_mutex_destroy(&zc.lock);
+		ret = EXIT_FAILURE;
+		goto tidy;
+	}
+	ret = EXIT_SUCCESS;
+
+	do {
+		double t;
+
+		if (zlib_corpus.data) {
+			zc.in = stress_corpus_next(&zlib_corpus, max_size, &zc.size);
+		} else {
+			for (i = 0; i < max_size; i += DATA_SIZE)
+				rand_data_funcs[mwc32() % SIZEOF_ARRAY(rand_data_funcs)](
+					(uint32_t *)(in + i),
+					(int)STRESS_MINIMUM(DATA_SIZE, max_size - i));
+			zc.in = in;
+			zc.size = max_size;
+		}
+		zc.chunks = (zc.size + zc.chunk_size - 1) / zc.chunk_size;
+		zc.next = 0;
+
+		t = time_now();
+		(void)pthread_barrier_wait(&zc.barrier);
+		(void)pthread_barrier_wait(&zc.barrier);
+		t = time_now() - t;
+		if (zc.failed) {
+			ret = EXIT_FAILURE;
+			break;
+		}
+		/* stopped part way through the round */
+		if (zc.next < zc.chunks)
+			break;
+		stats->deflate_duration += t;
+		stats->deflate_bytes += zc.size;
+		bytes_in += zc.size;
+		for (i = 0; i < zc.chunks; i++)
+			bytes_out += zc.out_size[i];
+		chunks += zc.chunks;
+		rounds++;
+
+		t = time_now();
+		rc = stress_zlib_chunk_inflate(&zc, out);
+		stats->inflate_duration += time_now() - t;
+		stats->inflate_bytes += zc.size;
+		if (rc != Z_OK) {
+			pr_fail(stderr, "%s: zlib inflate error: %s\n",
+				name, stress_zlib_err(rc));
+			ret = EXIT_FAILURE;
+			break;
+		}
+		if ((opt_flags & OPT_FLAGS_VERIFY) && memcmp(zc.in, out, zc.size)) {
+			pr_fail(stderr, "%s: inflated data does not match "
+				"the deflated data\n", name);
+			ret = EXIT_FAILURE;
+			break;
+		}
+		*counter += zc.chunks;
+	} while (opt_do_run && (!max_ops || *counter < max_ops));
+
+	/* Release the threads from the start of the next round */
+	zc.run = false;
+	(void)pthread_barrier_wait(&zc.barrier);
+	for (i = 0; i < started; i++)
+		(void)pthread_join(pthreads[i], NULL);
+	(void)pthread_barrier_destroy(&zc.barrier);
+	(void)pthread_mutex_destroy(&zc.start);
+
+	if (bytes_in)
+		pr_inf(stderr, "%s: instance %" PRIu32 ": compression ratio: "
+			"%5.2f%%, %" PRIu32 " threads, %.1f chunks of %zu "
+			"bytes per round\n",
+			name, instance, 100.0 * (double)bytes_out / (double)bytes_in,
+			threads, (double)chunks / (double)rounds, zc.chunk_size);
+	(void)pthread_mutex_destroy(&zc.lock);
+tidy:
+	free(zc.out_size);
+	free(zc.out);
+	free(out);
+	free(in);
+	free(pthreads);
+
+	return ret;
+}
+#endif
+
+/*
+ *  stress_zlib()
+ *	stress cpu with compression and decompression
+ */
+int stress_zlib(
+	uint64_t *const counter,
+	const uint32_t instance,
+	const uint64_t max_ops,
+	const char *name)
+{
+	zlib_stats_t *stats;
+	int ret;
+
+	/* shared so the inflate child can report back */
+	stats = mmap(NULL, sizeof(*stats), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (stats == MAP_FAILED) {
+		pr_err(stderr, "%s: mmap failed, errno=%d (%s)\n",
+			name, errno, strerror(errno));
+		return EXIT_NO_RESOURCE;
+	}
+	memset(stats, 0, sizeof(*stats));
+
+#if defined(HAVE_LIB_PTHREAD)
+	if (opt_zlib_threads)
+		ret = stress_zlib_chunks(counter, instance, max_ops, name, stats);
+	else
+#endif
+		ret = stress_zlib_pipe(counter, instance, max_ops, name, stats);
+
+	pr_inf(stderr, "%s: instance %" PRIu32 ": deflate %.2f MB/s, "
+		"inflate %.2f MB/s (level %d, strategy %s)\n",
+		name, instance,
+		stress_zlib_rate(stats->deflate_bytes, stats->deflate_duration),
+		stress_zlib_rate(stats->inflate_bytes, stats->inflate_duration),
+		opt_zlib_level, zlib_strategies[opt_zlib_strategy].name);
+
+	(void)munmap((void *)stats, sizeof(*stats));
 
 	return ret;
 }
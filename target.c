@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2013-2016 Canonical, Ltd.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * This code is a complete clean re-write of the stress tool by
+ * Colin Ian King <colin.king@canonical.com> and attempts to be
+ * backwardly compatible with the stress tool by Amos Waterland
+ * <apw@rossby.metr.ou.edu> but has more stress tests and more
+ * functionality.
+ *
+ */
+#include "stress-ng.h"
+
+#define TARGET_PERIOD		(250000)	/* controller period in usecs */
+#define TARGET_GAIN		(0.5)		/* CPU integral gain per period */
+#define TARGET_MEM_GAIN		(0.1)		/* memory integral gain per period */
+#define TARGET_SETTLE		(8)		/* periods ignored in the report */
+
+static int32_t opt_target_cpu = -1;
+static int32_t opt_target_mem = -1;
+
+#if defined(__linux__)
+static pid_t target_pid;
+#endif
+
+void stress_set_target_cpu(const char *optarg)
+{
+	opt_target_cpu = get_int32(optarg);
+	check_range("target-cpu", opt_target_cpu,
+		MIN_TARGET_CPU, MAX_TARGET_CPU);
+}
+
+void stress_set_target_mem(const char *optarg)
+{
+	opt_target_mem = get_int32(optarg);
+	check_range("target-mem", opt_target_mem,
+		MIN_TARGET_MEM, MAX_TARGET_MEM);
+}
+
+#if defined(__linux__)
+
+/*
+ *  target_cpu_read()
+ *	read the aggregate busy and total jiffies from /proc/stat
+ */
+static int target_cpu_read(uint64_t *busy, uint64_t *total)
+{
+	FILE *fp;
+	char buffer[256];
+	uint64_t user, nice, sys, idle, iowait, irq, softirq, steal;
+	int n = 0;
+
+	fp = fopen("/proc/stat", "r");
+	if (!fp)
+		return -1;
+	if (fgets(buffer, sizeof(buffer), fp))
+		n = sscanf(buffer, "cpu %" SCNu64 " %" SCNu64 " %" SCNu64
+			" %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+			" %" SCNu64, &user, &nice, &sys, &idle,
+			&iowait, &irq, &softirq, &steal);
+	(void)fclose(fp);
+
+	if (n < 4)
+		return -1;
+	if (n < 8)
+		steal = 0;
+	if (n < 7)
+		softirq = 0;
+	if (n < 6)
+		irq = 0;
+	if (n < 5)
+		iowait = 0;
+
+	*busy = user + nice + sys + irq + softirq + steal;
+	*total = *busy + idle + iowait;
+
+	return 0;
+}
+
+/*
+ *  target_mem_read()
+ *	read the percentage of memory in use from /proc/meminfo,
+ *	reclaimable page cache is treated as available memory
+ */
+static int target_mem_read(double *used)
+{
+	FILE *fp;
+	char buffer[256];
+	uint64_t total = 0, avail = 0, mem_free = 0, buffers = 0, cached = 0;
+	bool got_avail = false;
+
+	fp = fopen("/proc/meminfo", "r");
+	if (!fp)
+		return -1;
+	while (fgets(buffer, sizeof(buffer), fp)) {
+		if (sscanf(buffer, "MemTotal: %" SCNu64, &total) == 1)
+			continue;
+		if (sscanf(buffer, "MemAvailable: %" SCNu64, &avail) == 1) {
+			got_avail = true;
+			continue;
+		}
+		if (sscanf(buffer, "MemFree: %" SCNu64, &mem_free) == 1)
+			continue;
+		if (sscanf(buffer, "Buffers: %" SCNu64, &buffers) == 1)
+			continue;
+		(void)sscanf(buffer, "Cached: %" SCNu64, &cached);
+	}
+	(void)fclose(fp);
+
+	if (!total)
+		return -1;
+	if (!got_avail)
+		avail = mem_free + buffers + cached;
+	if (avail > total)
+		avail = total;
+	*used = 100.0 * (double)(total - avail) / (double)total;
+
+	return 0;
+}
+
+/*
+ *  target_adjust()
+ *	integral controller step, nudge the duty cycle knob
+ *	towards the target and clamp it to 0.0..1.0
+ */
+static double target_adjust(
+	const double duty,
+	const double gain,
+	const int32_t target,
+	const double actual)
+{
+	double new_duty = duty + (gain * ((double)target - actual) / 100.0);
+
+	if (new_duty < 0.0)
+		new_duty = 0.0;
+	if (new_duty > 1.0)
+		new_duty = 1.0;
+	return new_duty;
+}
+
+/*
+ *  target_controller()
+ *	background process that samples system wide utilisation
+ *	and adjusts the shared duty cycle knobs that the stressors
+ *	use to throttle themselves
+ */
+static void target_controller(void)
+{
+	uint64_t busy_prev = 0, total_prev = 0;
+	uint64_t periods = 0;
+	const int32_t cpus = stress_get_processors_online();
+	const int32_t instances = stressor_instances(STRESS_CPU);
+	double cpu_gain = TARGET_GAIN;
+
+	/*
+	 *  The CPU duty cycle applies to each cpu stressor instance,
+	 *  so scale the gain by the fraction of the system they cover
+	 */
+	if ((cpus > 0) && (instances > 0))
+		cpu_gain = TARGET_GAIN * (double)cpus / (double)instances;
+
+	(void)target_cpu_read(&busy_prev, &total_prev);
+
+	while (opt_do_run) {
+		(void)shim_usleep(TARGET_PERIOD);
+		periods++;
+
+		if (shared->target.cpu) {
+			uint64_t busy, total;
+
+			if ((target_cpu_read(&busy, &total) == 0) &&
+			    (total > total_prev)) {
+				const double util = 100.0 *
+					(double)(busy - busy_prev) /
+					(double)(total - total_prev);
+
+				shared->target.cpu_duty = target_adjust(
+					shared->target.cpu_duty, cpu_gain,
+					opt_target_cpu, util);
+				pr_dbg(stderr, "target: CPU %.2f%%, duty cycle %.3f\n",
+					util, shared->target.cpu_duty);
+				if (periods > TARGET_SETTLE) {
+					shared->target.cpu_util += util;
+					shared->target.cpu_samples++;
+				}
+				busy_prev = busy;
+				total_prev = total;
+			}
+		}
+		if (shared->target.mem) {
+			double used;
+
+			if (target_mem_read(&used) == 0) {
+				shared->target.mem_duty = target_adjust(
+					shared->target.mem_duty, TARGET_MEM_GAIN,
+					opt_target_mem, used);
+				pr_dbg(stderr, "target: memory %.2f%%, duty cycle %.3f\n",
+					used, shared->target.mem_duty);
+				if (periods > TARGET_SETTLE) {
+					shared->target.mem_util += used;
+					shared->target.mem_samples++;
+				}
+			}
+		}
+	}
+}
+
+/*
+ *  target_start()
+ *	start the system wide utilisation controller if
+ *	--target-cpu or --target-mem has been specified
+ */
+int target_start(void)
+{
+	shared->target.cpu = (opt_target_cpu > 0);
+	shared->target.mem = (opt_target_mem > 0);
+	if (!shared->target.cpu && !shared->target.mem)
+		return 0;
+
+	/* Start CPU throttled to the target, grow memory gradually */
+	shared->target.cpu_duty = (double)opt_target_cpu / 100.0;
+	shared->target.mem_duty = 0.0;
+
+	if (target_pid) {
+		pr_err(stderr, "target controller process already started\n");
+		return -1;
+	}
+	target_pid = fork();
+	if (target_pid < 0) {
+		pr_err(stderr, "target controller process failed to fork: %d (%s)\n",
+			errno, strerror(errno));
+		target_pid = 0;
+		shared->target.cpu = false;
+		shared->target.mem = false;
+		return -1;
+	} else if (target_pid == 0) {
+		stress_parent_died_alarm();
+		target_controller();
+		_exit(0);
+	}
+	return 0;
+}
+
+/*
+ *  target_stop()
+ *	stop the controller and report the utilisation achieved
+ */
+void target_stop(void)
+{
+	int status;
+
+	if (!target_pid)
+		return;
+
+	(void)kill(target_pid, SIGKILL);
+	(void)waitpid(target_pid, &status, 0);
+	target_pid = 0;
+
+	if (shared->target.cpu && shared->target.cpu_samples)
+		pr_inf(stdout, "target: requested CPU utilisation %" PRId32
+			"%%, achieved %.2f%%\n", opt_target_cpu,
+			shared->target.cpu_util /
+			(double)shared->target.cpu_samples);
+	if (shared->target.mem && shared->target.mem_samples)
+		pr_inf(stdout, "target: requested memory utilisation %" PRId32
+			"%%, achieved %.2f%%\n", opt_target_mem,
+			shared->target.mem_util /
+			(double)shared->target.mem_samples);
+}
+#else
+int target_start(void)
+{
+	if ((opt_target_cpu > 0) || (opt_target_mem > 0))
+		pr_inf(stderr, "--target-cpu and --target-mem are only "
+			"supported on Linux, ignoring them\n");
+	return 0;
+}
+
+void target_stop(void)
+{
+}
+#endif
@@ -43,6 +43,24 @@ double time_now(void)
 	return timeval_to_double(&now);
 }
 
+/*
+ *  time_now_monotonic()
+ *	monotonic time in seconds as a double, this has
+ *	nanosecond resolution and does not jump when the
+ *	wall clock is adjusted. Falls back to time_now()
+ *	if there is no monotonic clock.
+ */
+double time_now_monotonic(void)
+{
+#if defined(HAVE_LIB_RT) && defined(CLOCK_MONOTONIC)
+	struct timespec now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now) == 0)
+		return (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0);
+#endif
+	return time_now();
+}
+
 /*
  *  format_time()
  *	format a unit of time into human readable format